@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    This file contains the FIFO that carries the processor's output to the
+    editor's analysis display
+
+  ==============================================================================
+*/
+
+#include "AnalysisFifo.h"
+
+//==============================================================================
+AnalysisFifo::AnalysisFifo()
+    : m_mid(capacity), m_side(capacity)
+{
+}
+
+void AnalysisFifo::prepare(double sampleRate)
+{
+    // 88.2k and up are averaged down, the display has no use for ultrasonics
+    m_decimation = juce::jmax(1, (int)std::ceil(sampleRate / 48000.0 - 0.01));
+    m_analysisRate.store(sampleRate / m_decimation);
+
+    m_decimationPhase = 0;
+    m_midSum = m_sideSum = 0.0f;
+}
+
+template <typename SampleType>
+void AnalysisFifo::push(const SampleType* left, const SampleType* right, int numSamples)
+{
+    if (!isEnabled())
+        return;
+
+    // Decimated in chunks on the stack, then copied in
+    enum { chunkSize = 256 };
+    float mid[chunkSize], side[chunkSize];
+    int numDecimated = 0;
+
+    const float scale = 1.0f / (float)m_decimation;
+
+    for (int n = 0; n < numSamples; ++n)
+    {
+        m_midSum += (float)(left[n] + right[n]) * 0.5f;
+        m_sideSum += (float)(left[n] - right[n]) * 0.5f;
+
+        if (++m_decimationPhase < m_decimation)
+            continue;
+
+        mid[numDecimated] = m_midSum * scale;
+        side[numDecimated] = m_sideSum * scale;
+        m_decimationPhase = 0;
+        m_midSum = m_sideSum = 0.0f;
+
+        if (++numDecimated == chunkSize)
+        {
+            write(mid, side, numDecimated);
+            numDecimated = 0;
+        }
+    }
+
+    write(mid, side, numDecimated);
+}
+
+void AnalysisFifo::write(const float* mid, const float* side, int numSamples)
+{
+    int start1, size1, start2, size2;
+    m_fifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+
+    std::copy(mid, mid + size1, m_mid.data() + start1);
+    std::copy(side, side + size1, m_side.data() + start1);
+    std::copy(mid + size1, mid + size1 + size2, m_mid.data() + start2);
+    std::copy(side + size1, side + size1 + size2, m_side.data() + start2);
+
+    m_fifo.finishedWrite(size1 + size2);
+}
+
+int AnalysisFifo::pull(float* mid, float* side, int maxSamples)
+{
+    int start1, size1, start2, size2;
+    m_fifo.prepareToRead(maxSamples, start1, size1, start2, size2);
+
+    std::copy(m_mid.data() + start1, m_mid.data() + start1 + size1, mid);
+    std::copy(m_side.data() + start1, m_side.data() + start1 + size1, side);
+    std::copy(m_mid.data() + start2, m_mid.data() + start2 + size2, mid + size1);
+    std::copy(m_side.data() + start2, m_side.data() + start2 + size2, side + size1);
+
+    m_fifo.finishedRead(size1 + size2);
+    return size1 + size2;
+}
+
+template void AnalysisFifo::push<float>(const float*, const float*, int);
+template void AnalysisFifo::push<double>(const double*, const double*, int);
@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    This file contains the FIFO that carries the processor's output to the
+    editor's analysis display
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Single producer, single consumer FIFO of mid/side samples. The audio
+    thread pushes its output, decimated to at most 48kHz, and the editor pulls
+    it on its timer. Both sides are lock-free and the storage is allocated up
+    front, so pushing never allocates, locks or waits: when the editor falls
+    behind, new samples are dropped instead.
+
+    Nothing is pushed while no editor has enabled it.
+*/
+class AnalysisFifo
+{
+public:
+    enum { capacity = 16384 };
+
+    AnalysisFifo();
+
+    // Call while the audio thread is stopped. Samples still queued are kept,
+    // as the editor may be reading them
+    void prepare(double sampleRate);
+
+    // Set by the editor while it shows the analysis
+    void setEnabled(bool enabled)       { m_enabled.store(enabled); }
+    bool isEnabled() const              { return m_enabled.load(); }
+
+    // Rate of the pulled samples
+    double getAnalysisRate() const      { return m_analysisRate.load(); }
+
+    // Audio thread
+    template <typename SampleType>
+    void push(const SampleType* left, const SampleType* right, int numSamples);
+
+    // Editor, returns the number of samples read
+    int pull(float* mid, float* side, int maxSamples);
+
+private:
+    void write(const float* mid, const float* side, int numSamples);
+
+    juce::AbstractFifo m_fifo { capacity };
+    std::vector<float> m_mid, m_side;
+
+    std::atomic<bool> m_enabled { false };
+    std::atomic<double> m_analysisRate { 48000.0 };
+
+    // Decimation by averaging, state kept across blocks
+    int m_decimation = 1, m_decimationPhase = 0;
+    float m_midSum = 0.0f, m_sideSum = 0.0f;
+
+    JUCE_DECLARE_NON_COPYABLE(AnalysisFifo)
+};
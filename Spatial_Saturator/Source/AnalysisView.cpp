@@ -0,0 +1,229 @@
+/*
+  ==============================================================================
+
+    This file contains the editor's mid/side spectrum and stereo image display
+
+  ==============================================================================
+*/
+
+#include "AnalysisView.h"
+
+static const float minDecibels = -100.0f;
+
+//==============================================================================
+AnalysisView::AnalysisView(AnalysisFifo& fifo)
+    : m_fifo(fifo),
+      m_pulledMid(AnalysisFifo::capacity), m_pulledSide(AnalysisFifo::capacity),
+      m_historyMid(fftSize), m_historySide(fftSize),
+      m_window(fftSize), m_real(fftSize), m_imag(fftSize),
+      m_midLevels(fftSize / 2, minDecibels), m_sideLevels(fftSize / 2, minDecibels)
+{
+    m_fft.prepare(fftOrder);
+
+    for (int n = 0; n < fftSize; ++n)
+        m_window[(size_t)n] = 0.5f - 0.5f * std::cos(2.0f * juce::MathConstants<float>::pi * (float)n / (float)fftSize);
+
+    // Whatever is queued from an earlier editor is stale
+    m_fifo.setEnabled(true);
+    while (m_fifo.pull(m_pulledMid.data(), m_pulledSide.data(), AnalysisFifo::capacity) > 0) {}
+
+    setOpaque(true);
+    startTimerHz(refreshRateHz);
+}
+
+AnalysisView::~AnalysisView()
+{
+    stopTimer();
+    m_fifo.setEnabled(false);
+}
+
+//==============================================================================
+void AnalysisView::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colours::black);
+    g.drawImageAt(m_spectrumImage, m_spectrumArea.getX(), m_spectrumArea.getY());
+    g.drawImageAt(m_goniometerImage, m_goniometerArea.getX(), m_goniometerArea.getY());
+}
+
+void AnalysisView::resized()
+{
+    auto area = getLocalBounds();
+    m_spectrumArea = area.removeFromTop(area.getHeight() / 2).reduced(4);
+    m_goniometerArea = area.reduced(4);
+
+    m_spectrumImage = juce::Image(juce::Image::RGB, juce::jmax(1, m_spectrumArea.getWidth()), juce::jmax(1, m_spectrumArea.getHeight()), true);
+    m_goniometerImage = juce::Image(juce::Image::RGB, juce::jmax(1, m_goniometerArea.getWidth()), juce::jmax(1, m_goniometerArea.getHeight()), true);
+
+    renderSpectrum();
+    renderGoniometer();
+}
+
+void AnalysisView::timerCallback()
+{
+    const int numPulled = m_fifo.pull(m_pulledMid.data(), m_pulledSide.data(), AnalysisFifo::capacity);
+
+    // Nothing new (silence is still pushed, so this means stopped): keep the images
+    if (numPulled == 0)
+        return;
+
+    for (int n = juce::jmax(0, numPulled - fftSize); n < numPulled; ++n)
+    {
+        m_historyMid[(size_t)m_historyPosition] = m_pulledMid[(size_t)n];
+        m_historySide[(size_t)m_historyPosition] = m_pulledSide[(size_t)n];
+        m_historyPosition = (m_historyPosition + 1) & (fftSize - 1);
+    }
+
+    updateSpectra();
+    updateCorrelation();
+
+    renderSpectrum();
+    renderGoniometer();
+    repaint();
+}
+
+//==============================================================================
+void AnalysisView::updateSpectra()
+{
+    for (int n = 0; n < fftSize; ++n)
+    {
+        const int i = (m_historyPosition + n) & (fftSize - 1);
+        m_real[(size_t)n] = m_historyMid[(size_t)i] * m_window[(size_t)n];
+        m_imag[(size_t)n] = m_historySide[(size_t)i] * m_window[(size_t)n];
+    }
+
+    // Mid as the real and side as the imaginary part, split afterwards
+    m_fft.forward(m_real.data(), m_imag.data());
+
+    // A full scale sine reads 0dB through the Hann window
+    const float scale = 2.0f / (0.5f * (float)fftSize);
+    const float decayPerFrame = 45.0f / (float)refreshRateHz;
+
+    for (int k = 1; k < fftSize / 2; ++k)
+    {
+        const int mirror = fftSize - k;
+
+        const float midReal = 0.5f * (m_real[(size_t)k] + m_real[(size_t)mirror]);
+        const float midImag = 0.5f * (m_imag[(size_t)k] - m_imag[(size_t)mirror]);
+        const float sideReal = 0.5f * (m_imag[(size_t)k] + m_imag[(size_t)mirror]);
+        const float sideImag = 0.5f * (m_real[(size_t)mirror] - m_real[(size_t)k]);
+
+        const float midLevel = 20.0f * std::log10(juce::jmax(1.0e-5f, scale * std::sqrt(midReal * midReal + midImag * midImag)));
+        const float sideLevel = 20.0f * std::log10(juce::jmax(1.0e-5f, scale * std::sqrt(sideReal * sideReal + sideImag * sideImag)));
+
+        m_midLevels[(size_t)k] = juce::jmax(midLevel, m_midLevels[(size_t)k] - decayPerFrame);
+        m_sideLevels[(size_t)k] = juce::jmax(sideLevel, m_sideLevels[(size_t)k] - decayPerFrame);
+    }
+}
+
+void AnalysisView::updateCorrelation()
+{
+    double lr = 0.0, ll = 0.0, rr = 0.0;
+
+    for (int n = 0; n < fftSize; ++n)
+    {
+        const double left = (double)m_historyMid[(size_t)n] + (double)m_historySide[(size_t)n];
+        const double right = (double)m_historyMid[(size_t)n] - (double)m_historySide[(size_t)n];
+
+        lr += left * right;
+        ll += left * left;
+        rr += right * right;
+    }
+
+    m_correlation = ll * rr > 1.0e-12 ? (float)(lr / std::sqrt(ll * rr)) : 0.0f;
+}
+
+//==============================================================================
+void AnalysisView::renderSpectrum()
+{
+    juce::Graphics g(m_spectrumImage);
+    g.fillAll(juce::Colours::black);
+
+    const float width = (float)m_spectrumImage.getWidth();
+    const float height = (float)m_spectrumImage.getHeight();
+    const float nyquist = (float)m_fifo.getAnalysisRate() * 0.5f;
+
+    // 20Hz to 20kHz on a log scale, 0 to -100dB
+    auto getX = [width](float frequency) { return width * std::log10(frequency / 20.0f) / 3.0f; };
+    auto getY = [height](float level) { return height * juce::jlimit(0.0f, 1.0f, level / minDecibels); };
+
+    g.setColour(juce::Colours::darkgrey);
+
+    for (float frequency : { 100.0f, 1000.0f, 10000.0f })
+        g.drawVerticalLine((int)getX(frequency), 0.0f, height);
+
+    for (float level : { -20.0f, -40.0f, -60.0f, -80.0f })
+        g.drawHorizontalLine((int)getY(level), 0.0f, width);
+
+    auto drawLevels = [&](const std::vector<float>& levels, juce::Colour colour)
+    {
+        juce::Path path;
+        bool started = false;
+
+        for (int k = 1; k < fftSize / 2; ++k)
+        {
+            const float frequency = nyquist * (float)k / (float)(fftSize / 2);
+            if (frequency < 20.0f)
+                continue;
+
+            const float x = getX(frequency), y = getY(levels[(size_t)k]);
+
+            if (started)
+                path.lineTo(x, y);
+            else
+                path.startNewSubPath(x, y);
+
+            started = true;
+        }
+
+        g.setColour(colour);
+        g.strokePath(path, juce::PathStrokeType(1.5f));
+    };
+
+    drawLevels(m_midLevels, juce::Colours::orange);
+    drawLevels(m_sideLevels, juce::Colours::cyan);
+
+    g.setColour(juce::Colours::orange);
+    g.drawText("Mid", 4, 2, 40, 16, juce::Justification::centredLeft);
+    g.setColour(juce::Colours::cyan);
+    g.drawText("Side", 44, 2, 40, 16, juce::Justification::centredLeft);
+}
+
+void AnalysisView::renderGoniometer()
+{
+    juce::Graphics g(m_goniometerImage);
+    g.fillAll(juce::Colours::black);
+
+    const int barHeight = 16;
+    const float width = (float)m_goniometerImage.getWidth();
+    const float height = (float)juce::jmax(1, m_goniometerImage.getHeight() - barHeight - 4);
+
+    // Mid up, side across: mono is a vertical line, out of phase a horizontal one
+    const float radius = 0.5f * juce::jmin(width, height);
+    const float centreX = 0.5f * width, centreY = 0.5f * height;
+
+    g.setColour(juce::Colours::darkgrey);
+    g.drawLine(centreX, centreY - radius, centreX, centreY + radius);
+    g.drawLine(centreX - radius, centreY, centreX + radius, centreY);
+
+    g.setColour(juce::Colours::green);
+
+    for (int n = fftSize - numScopePoints; n < fftSize; ++n)
+    {
+        const int i = (m_historyPosition + n) & (fftSize - 1);
+        const float x = centreX + radius * juce::jlimit(-1.0f, 1.0f, m_historySide[(size_t)i]);
+        const float y = centreY - radius * juce::jlimit(-1.0f, 1.0f, m_historyMid[(size_t)i]);
+
+        g.fillRect(x, y, 1.5f, 1.5f);
+    }
+
+    // Correlation from -1 (left) to +1 (right)
+    const float barY = (float)m_goniometerImage.getHeight() - (float)barHeight;
+    const float markerX = 0.5f * (m_correlation + 1.0f) * width;
+
+    g.setColour(juce::Colours::darkgrey);
+    g.fillRect(0.0f, barY, width, (float)barHeight);
+    g.setColour(m_correlation < 0.0f ? juce::Colours::red : juce::Colours::green);
+    g.fillRect(juce::jmin(markerX, 0.5f * width), barY, std::abs(markerX - 0.5f * width), (float)barHeight);
+    g.setColour(juce::Colours::white);
+    g.drawText("Correlation " + juce::String(m_correlation, 2), 0, (int)barY, (int)width, barHeight, juce::Justification::centred);
+}
@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+    This file contains the editor's mid/side spectrum and stereo image display
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "AnalysisFifo.h"
+#include "SpatialSaturatorLinearPhase.h"
+
+//==============================================================================
+/**
+    Spectra of the mid and side output, a goniometer (mid up, side across)
+    and the L/R correlation.
+
+    A timer drains the processor's AnalysisFifo and redraws two cached images
+    only when new samples came in, so paint() just blits them and a silent
+    or stopped processor costs the message thread nothing.
+*/
+class AnalysisView : public juce::Component, private juce::Timer
+{
+public:
+    explicit AnalysisView(AnalysisFifo& fifo);
+    ~AnalysisView() override;
+
+    void paint(juce::Graphics&) override;
+    void resized() override;
+
+private:
+    enum
+    {
+        fftOrder = 11,
+        fftSize = 1 << fftOrder,
+        numScopePoints = 1024,
+        refreshRateHz = 30
+    };
+
+    void timerCallback() override;
+
+    // From the last fftSize samples
+    void updateSpectra();
+    void updateCorrelation();
+
+    void renderSpectrum();
+    void renderGoniometer();   // with the correlation bar under it
+
+    AnalysisFifo& m_fifo;
+
+    std::vector<float> m_pulledMid, m_pulledSide;
+
+    // The last fftSize samples, oldest at m_historyPosition
+    std::vector<float> m_historyMid, m_historySide;
+    int m_historyPosition = 0;
+
+    FFT m_fft;
+    std::vector<float> m_window, m_real, m_imag;
+
+    // dB per bin, falling slowly from their peaks
+    std::vector<float> m_midLevels, m_sideLevels;
+    float m_correlation = 0.0f;
+
+    juce::Rectangle<int> m_spectrumArea, m_goniometerArea;
+    juce::Image m_spectrumImage, m_goniometerImage;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AnalysisView)
+};
@@ -0,0 +1,121 @@
+/*
+  ==============================================================================
+
+    This file contains the editor's input and output level meters
+
+  ==============================================================================
+*/
+
+#include "MeterView.h"
+
+// Bars cover -60 to 0 LUFS / dBTP
+static const float meterRangeDecibels = 60.0f;
+
+//==============================================================================
+MeterView::MeterView(SpatialSaturatorAudioProcessor& processor)
+    : m_processor(processor), m_inputMeter(processor.getInputMeter()), m_outputMeter(processor.getOutputMeter())
+{
+    // The processor only measures while a view shows the readings
+    m_processor.setMeteringEnabled(true);
+
+    m_input = m_inputMeter.getReadings();
+    m_output = m_outputMeter.getReadings();
+    m_surround = m_processor.isProcessingSurround();
+
+    setOpaque(true);
+    startTimerHz(refreshRateHz);
+}
+
+MeterView::~MeterView()
+{
+    stopTimer();
+    m_processor.setMeteringEnabled(false);
+}
+
+//==============================================================================
+void MeterView::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colours::black);
+
+    auto area = getLocalBounds().reduced(4);
+
+    if (m_surround)
+    {
+        g.setColour(juce::Colours::grey);
+        g.drawFittedText("Meters follow\nstereo and\nmono buses only", area, juce::Justification::centred, 3);
+        return;
+    }
+
+    auto inputArea = area.removeFromLeft(area.getWidth() / 2);
+
+    drawMeter(g, inputArea.reduced(2, 0), "In", m_input);
+    drawMeter(g, area.reduced(2, 0), "Out", m_output);
+}
+
+void MeterView::timerCallback()
+{
+    const bool surround = m_processor.isProcessingSurround();
+
+    if (surround != m_surround)
+    {
+        m_surround = surround;
+        repaint();
+    }
+
+    if (m_surround)
+        return;
+
+    const auto input = m_inputMeter.getReadings();
+    const auto output = m_outputMeter.getReadings();
+
+    // Plain floats and no padding, so the bytes compare like the values
+    if (std::memcmp(&input, &m_input, sizeof(input)) == 0 && std::memcmp(&output, &m_output, sizeof(output)) == 0)
+        return;
+
+    m_input = input;
+    m_output = output;
+    repaint();
+}
+
+void MeterView::drawMeter(juce::Graphics& g, juce::Rectangle<int> area, const juce::String& title, const LoudnessMeter::Readings& readings) const
+{
+    const int textHeight = 14;
+
+    g.setColour(juce::Colours::white);
+    g.drawText(title, area.removeFromTop(textHeight), juce::Justification::centred);
+
+    auto truePeakArea = area.removeFromBottom(textHeight);
+    auto shortTermArea = area.removeFromBottom(textHeight);
+    auto labelArea = area.removeFromBottom(textHeight);
+
+    const float stereoPeak = juce::jmax(readings.truePeak[LoudnessMeter::left], readings.truePeak[LoudnessMeter::right]);
+
+    g.drawText("S " + juce::String(readings.shortTermStereo, 1), shortTermArea, juce::Justification::centred);
+    g.setColour(stereoPeak > 0.0f ? juce::Colours::red : juce::Colours::white);
+    g.drawText("TP " + juce::String(stereoPeak, 1), truePeakArea, juce::Justification::centred);
+
+    const char* names[] = { "L", "R", "M", "S" };
+    const int barWidth = area.getWidth() / LoudnessMeter::numChannels;
+    const float height = (float)area.getHeight();
+
+    auto getY = [&](float decibels) { return (float)area.getY() + height * juce::jlimit(0.0f, 1.0f, -decibels / meterRangeDecibels); };
+
+    for (int channel = 0; channel < LoudnessMeter::numChannels; ++channel)
+    {
+        auto bar = juce::Rectangle<int>(area.getX() + channel * barWidth, area.getY(), barWidth, area.getHeight()).reduced(2, 0);
+
+        g.setColour(juce::Colours::darkgrey);
+        g.fillRect(bar);
+
+        const float top = getY(readings.momentary[channel]);
+        g.setColour(channel < LoudnessMeter::mid ? juce::Colours::green : channel == LoudnessMeter::mid ? juce::Colours::orange : juce::Colours::cyan);
+        g.fillRect((float)bar.getX(), top, (float)bar.getWidth(), (float)bar.getBottom() - top);
+
+        const float peak = getY(readings.truePeak[channel]);
+        g.setColour(readings.truePeak[channel] > 0.0f ? juce::Colours::red : juce::Colours::white);
+        g.fillRect((float)bar.getX(), peak, (float)bar.getWidth(), 2.0f);
+
+        g.setColour(juce::Colours::white);
+        g.drawText(names[channel], labelArea.getX() + channel * barWidth, labelArea.getY(), barWidth, textHeight, juce::Justification::centred);
+    }
+}
@@ -0,0 +1,49 @@
+/*
+  ==============================================================================
+
+    This file contains the editor's input and output level meters
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+//==============================================================================
+/**
+    Input and output meters side by side. Each has a bar per channel (left,
+    right, mid, side) showing the momentary loudness with a tick at the true
+    peak, and under them the stereo short-term loudness and the highest true
+    peak of left and right.
+
+    The readings come from the processor's LoudnessMeters, which only run
+    while a MeterView is open and publish them every 100ms; the timer only
+    repaints when they changed. Surround beds have no meters, so while the
+    processor runs one the view says so instead.
+*/
+class MeterView : public juce::Component, private juce::Timer
+{
+public:
+    explicit MeterView(SpatialSaturatorAudioProcessor& processor);
+    ~MeterView() override;
+
+    void paint(juce::Graphics&) override;
+
+private:
+    enum { refreshRateHz = 15 };
+
+    void timerCallback() override;
+
+    void drawMeter(juce::Graphics& g, juce::Rectangle<int> area, const juce::String& title, const LoudnessMeter::Readings& readings) const;
+
+    SpatialSaturatorAudioProcessor& m_processor;
+    const LoudnessMeter& m_inputMeter;
+    const LoudnessMeter& m_outputMeter;
+
+    LoudnessMeter::Readings m_input {}, m_output {};
+    bool m_surround = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MeterView)
+};
@@ -0,0 +1,161 @@
+/*
+  ==============================================================================
+
+    This file contains the compact binary format for the plug-in state
+
+  ==============================================================================
+*/
+
+#include "ParameterState.h"
+#include <cstring>
+
+//==============================================================================
+ParameterState::ParameterState(juce::AudioProcessor& processor)
+{
+    for (auto* parameter : processor.getParameters())
+    {
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+        {
+            const auto hash = hashParameterID(ranged->getParameterID());
+
+            // Two IDs with one hash could not be told apart in a state
+            jassert(indexOf(hash) < 0);
+
+            m_parameters.push_back(ranged);
+            m_hashes.push_back(hash);
+        }
+    }
+}
+
+juce::uint32 ParameterState::hashParameterID(const juce::String& parameterID)
+{
+    juce::uint32 hash = 2166136261u;
+
+    for (auto* c = parameterID.toRawUTF8(); *c != 0; ++c)
+        hash = (hash ^ (juce::uint8)*c) * 16777619u;
+
+    return hash;
+}
+
+int ParameterState::indexOf(juce::uint32 hash) const
+{
+    for (size_t i = 0; i < m_hashes.size(); ++i)
+        if (m_hashes[i] == hash)
+            return (int)i;
+
+    return -1;
+}
+
+//==============================================================================
+float ParameterState::getValue(int index) const
+{
+    auto* parameter = m_parameters[(size_t)index];
+    return parameter->convertFrom0to1(parameter->getValue());
+}
+
+void ParameterState::setValue(int index, float value) const
+{
+    auto* parameter = m_parameters[(size_t)index];
+    parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+}
+
+void ParameterState::setToDefault(int index) const
+{
+    auto* parameter = m_parameters[(size_t)index];
+    parameter->setValueNotifyingHost(parameter->getDefaultValue());
+}
+
+float ParameterState::getDefaultValue(int index) const
+{
+    auto* parameter = m_parameters[(size_t)index];
+    return parameter->convertFrom0to1(parameter->getDefaultValue());
+}
+
+std::vector<float> ParameterState::getValues() const
+{
+    std::vector<float> values;
+
+    for (int i = 0; i < getNumParameters(); ++i)
+        values.push_back(getValue(i));
+
+    return values;
+}
+
+//==============================================================================
+float ParameterState::readFloat(const char* bytes)
+{
+    const juce::uint32 bits = readUInt32(bytes);
+
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void ParameterState::writeUInt32(char* bytes, juce::uint32 value)
+{
+    value = juce::ByteOrder::swapIfBigEndian(value);
+    std::memcpy(bytes, &value, sizeof(value));
+}
+
+void ParameterState::writeFloat(char* bytes, float value)
+{
+    juce::uint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    writeUInt32(bytes, bits);
+}
+
+//==============================================================================
+void ParameterState::write(juce::MemoryBlock& destData) const
+{
+    const int numParameters = getNumParameters();
+
+    destData.setSize((size_t)(headerBytes + entryBytes * numParameters));
+    auto* bytes = static_cast<char*>(destData.getData());
+
+    writeUInt32(bytes, stateMagic);
+    writeUInt32(bytes + 4, currentVersion);
+    writeUInt32(bytes + 8, (juce::uint32)numParameters);
+
+    for (int i = 0; i < numParameters; ++i)
+    {
+        char* entry = bytes + headerBytes + entryBytes * i;
+        writeUInt32(entry, m_hashes[(size_t)i]);
+        writeFloat(entry + 4, getValue(i));
+    }
+}
+
+bool ParameterState::read(const void* data, int sizeInBytes) const
+{
+    auto* bytes = static_cast<const char*>(data);
+
+    if (bytes == nullptr || sizeInBytes < headerBytes || readUInt32(bytes) != stateMagic)
+        return false;
+
+    // Only one layout so far; an older one would be migrated here, a newer one
+    // is left alone rather than read as this one
+    if (readUInt32(bytes + 4) != currentVersion)
+        return false;
+
+    // Added parameters only add entries, so the entries read as far as they go
+    const juce::uint32 numEntries = juce::jmin(readUInt32(bytes + 8), (juce::uint32)((sizeInBytes - headerBytes) / entryBytes));
+
+    std::vector<bool> restored((size_t)getNumParameters(), false);
+
+    for (juce::uint32 i = 0; i < numEntries; ++i)
+    {
+        const char* entry = bytes + headerBytes + entryBytes * i;
+        const int index = indexOf(readUInt32(entry));
+
+        if (index >= 0)
+        {
+            setValue(index, readFloat(entry + 4));
+            restored[(size_t)index] = true;
+        }
+    }
+
+    for (int i = 0; i < getNumParameters(); ++i)
+        if (!restored[(size_t)i])
+            setToDefault(i);
+
+    return true;
+}
@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    This file contains the compact binary format for the plug-in state
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+//==============================================================================
+/**
+    Every ranged parameter of a processor, in the processor's order, with a
+    32-bit hash of its ID. The binary state is
+
+        "SSST", version, number of entries      (3 little endian uint32)
+        per entry: ID hash, raw value           (uint32, float)
+
+    so a host restoring a session reads 12 + 8 * n bytes instead of parsing
+    XML. Entries are matched by ID hash, not position: IDs the processor no
+    longer has are skipped and parameters the data lacks go to their defaults,
+    so states with more or fewer parameters both load. A version other than
+    currentVersion may lay the entries out differently, so it is not read.
+*/
+class ParameterState
+{
+public:
+    enum : juce::uint32
+    {
+        stateMagic = 0x54535353,    // "SSST"
+        currentVersion = 1
+    };
+
+    enum { headerBytes = 12, entryBytes = 8 };
+
+    explicit ParameterState(juce::AudioProcessor& processor);
+
+    // FNV-1a of the UTF-8 ID, stable across builds and platforms
+    static juce::uint32 hashParameterID(const juce::String& parameterID);
+
+    void write(juce::MemoryBlock& destData) const;
+
+    // False if the data is not a binary state (an old XML session) or is one
+    // of a version this build does not know, in which case nothing was changed
+    bool read(const void* data, int sizeInBytes) const;
+
+    int getNumParameters() const                    { return (int)m_parameters.size(); }
+    juce::uint32 getHash(int index) const           { return m_hashes[(size_t)index]; }
+
+    // Index of the parameter with that ID hash, or -1
+    int indexOf(juce::uint32 hash) const;
+
+    // Raw (not normalised) values, setValue() notifies the host
+    float getValue(int index) const;
+    void setValue(int index, float value) const;
+    void setToDefault(int index) const;
+    float getDefaultValue(int index) const;
+
+    // Raw values of every parameter, in order
+    std::vector<float> getValues() const;
+
+    static juce::uint32 readUInt32(const char* bytes)                 { return juce::ByteOrder::littleEndianInt(bytes); }
+    static float readFloat(const char* bytes);
+    static void writeUInt32(char* bytes, juce::uint32 value);
+    static void writeFloat(char* bytes, float value);
+
+private:
+    std::vector<juce::RangedAudioParameter*> m_parameters;
+    std::vector<juce::uint32> m_hashes;
+
+    JUCE_DECLARE_NON_COPYABLE(ParameterState)
+};
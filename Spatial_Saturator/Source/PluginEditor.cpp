@@ -19,7 +19,8 @@
 
 //==============================================================================
 SpatialSaturatorAudioProcessorEditor::SpatialSaturatorAudioProcessorEditor(SpatialSaturatorAudioProcessor& p, juce::AudioProcessorValueTreeState& vts)
-    : AudioProcessorEditor(&p), audioProcessor(p), treeState(vts)
+    : AudioProcessorEditor(&p), audioProcessor(p), treeState(vts), analysisView(p.getAnalysisFifo()),
+      meterView(p)
 {
     midGainSlider.setTextValueSuffix(" dB ");
     addAndMakeVisible(midGainSlider);
@@ -56,6 +57,13 @@ SpatialSaturatorAudioProcessorEditor::SpatialSaturatorAudioProcessorEditor(Spati
     sideFreqUpperSliderLabel.setText("Higher side Frequency", juce::dontSendNotification);
     sideFreqUpperSliderLabel.attachToComponent(&sideFreqUpperSlider, true);
 
+    filterModeBox.addItemList({ "Biquad", "Linear Phase", "SVF" }, 1);
+    addAndMakeVisible(filterModeBox);
+    filterModeBoxAttachment.reset(new ComboBoxAttachment(treeState, "filterModeID", filterModeBox));
+    addAndMakeVisible(filterModeBoxLabel);
+    filterModeBoxLabel.setText("Filter Mode", juce::dontSendNotification);
+    filterModeBoxLabel.attachToComponent(&filterModeBox, true);
+
     tanhAmplitudeSlider.setTextValueSuffix(" ");
     addAndMakeVisible(tanhAmplitudeSlider);
     tanhSlopeSliderAttachment.reset(new SliderAttachment(treeState, "tanhAmplitudeID", tanhAmplitudeSlider));
@@ -86,7 +94,7 @@ SpatialSaturatorAudioProcessorEditor::SpatialSaturatorAudioProcessorEditor(Spati
 
     sinFrequencySlider.setTextValueSuffix(" Hz ");
     addAndMakeVisible(sinFrequencySlider);
-    sinFrequencySliderAttachment.reset(new SliderAttachment(treeState, "sinFreqID", sinAmplitudeSlider));
+    sinFrequencySliderAttachment.reset(new SliderAttachment(treeState, "sinFrequencyID", sinFrequencySlider));
     addAndMakeVisible(sinFrequencySliderLabel);
     sinFrequencySliderLabel.setText("Sin Frequency", juce::dontSendNotification);
     sinFrequencySliderLabel.attachToComponent(&sinFrequencySlider, true);
@@ -98,9 +106,139 @@ SpatialSaturatorAudioProcessorEditor::SpatialSaturatorAudioProcessorEditor(Spati
     makeUpGainSliderLabel.setText("Make Up Gain", juce::dontSendNotification);
     makeUpGainSliderLabel.attachToComponent(&makeUpGainSlider, true);
 
+    oversamplingBox.addItemList({ "1x", "2x", "4x", "8x" }, 1);
+    addAndMakeVisible(oversamplingBox);
+    oversamplingBoxAttachment.reset(new ComboBoxAttachment(treeState, "oversamplingID", oversamplingBox));
+    addAndMakeVisible(oversamplingBoxLabel);
+    oversamplingBoxLabel.setText("Oversampling", juce::dontSendNotification);
+    oversamplingBoxLabel.attachToComponent(&oversamplingBox, true);
+
+    oversamplingPhaseBox.addItemList({ "Minimum Phase", "Linear Phase" }, 1);
+    addAndMakeVisible(oversamplingPhaseBox);
+    oversamplingPhaseBoxAttachment.reset(new ComboBoxAttachment(treeState, "oversamplingPhaseID", oversamplingPhaseBox));
+    addAndMakeVisible(oversamplingPhaseBoxLabel);
+    oversamplingPhaseBoxLabel.setText("Oversampling Phase", juce::dontSendNotification);
+    oversamplingPhaseBoxLabel.attachToComponent(&oversamplingPhaseBox, true);
+
+    qualityBox.addItemList({ "Draft", "High", "Full" }, 1);
+    addAndMakeVisible(qualityBox);
+    qualityBoxAttachment.reset(new ComboBoxAttachment(treeState, "qualityID", qualityBox));
+    addAndMakeVisible(qualityBoxLabel);
+    qualityBoxLabel.setText("Quality", juce::dontSendNotification);
+    qualityBoxLabel.attachToComponent(&qualityBox, true);
+
+    antiAliasingBox.addItemList({ "Oversampling", "ADAA 1st Order", "ADAA 2nd Order" }, 1);
+    addAndMakeVisible(antiAliasingBox);
+    antiAliasingBoxAttachment.reset(new ComboBoxAttachment(treeState, "antiAliasingID", antiAliasingBox));
+    addAndMakeVisible(antiAliasingBoxLabel);
+    antiAliasingBoxLabel.setText("Anti-Aliasing", juce::dontSendNotification);
+    antiAliasingBoxLabel.attachToComponent(&antiAliasingBox, true);
+
+    limiterEnabledButton.setButtonText("On");
+    addAndMakeVisible(limiterEnabledButton);
+    limiterEnabledButtonAttachment.reset(new ButtonAttachment(treeState, "limiterEnabledID", limiterEnabledButton));
+    addAndMakeVisible(limiterEnabledButtonLabel);
+    limiterEnabledButtonLabel.setText("Limiter", juce::dontSendNotification);
+    limiterEnabledButtonLabel.attachToComponent(&limiterEnabledButton, true);
+
+    limiterCeilingSlider.setTextValueSuffix(" dBTP ");
+    addAndMakeVisible(limiterCeilingSlider);
+    limiterCeilingSliderAttachment.reset(new SliderAttachment(treeState, "limiterCeilingID", limiterCeilingSlider));
+    addAndMakeVisible(limiterCeilingSliderLabel);
+    limiterCeilingSliderLabel.setText("Limiter Ceiling", juce::dontSendNotification);
+    limiterCeilingSliderLabel.attachToComponent(&limiterCeilingSlider, true);
+
+    limiterLookaheadSlider.setTextValueSuffix(" ms ");
+    addAndMakeVisible(limiterLookaheadSlider);
+    limiterLookaheadSliderAttachment.reset(new SliderAttachment(treeState, "limiterLookaheadID", limiterLookaheadSlider));
+    addAndMakeVisible(limiterLookaheadSliderLabel);
+    limiterLookaheadSliderLabel.setText("Limiter Look-ahead", juce::dontSendNotification);
+    limiterLookaheadSliderLabel.attachToComponent(&limiterLookaheadSlider, true);
+
+    limiterReleaseSlider.setTextValueSuffix(" ms ");
+    addAndMakeVisible(limiterReleaseSlider);
+    limiterReleaseSliderAttachment.reset(new SliderAttachment(treeState, "limiterReleaseID", limiterReleaseSlider));
+    addAndMakeVisible(limiterReleaseSliderLabel);
+    limiterReleaseSliderLabel.setText("Limiter Release", juce::dontSendNotification);
+    limiterReleaseSliderLabel.attachToComponent(&limiterReleaseSlider, true);
+
+    bandsBox.addItemList({ "Off", "2 Bands", "3 Bands", "4 Bands" }, 1);
+    addAndMakeVisible(bandsBox);
+    bandsBoxAttachment.reset(new ComboBoxAttachment(treeState, "bandsID", bandsBox));
+    addAndMakeVisible(bandsBoxLabel);
+    bandsBoxLabel.setText("Multiband", juce::dontSendNotification);
+    bandsBoxLabel.attachToComponent(&bandsBox, true);
+
+    for (int i = 0; i < Waveshaper::maxBands - 1; ++i)
+    {
+        const juce::String number(i + 1);
+
+        crossoverSliders[i].setTextValueSuffix(" Hz ");
+        addAndMakeVisible(crossoverSliders[i]);
+        crossoverSliderAttachments[i].reset(new SliderAttachment(treeState, "crossover" + number + "ID", crossoverSliders[i]));
+        addAndMakeVisible(crossoverSliderLabels[i]);
+        crossoverSliderLabels[i].setText("Crossover " + number, juce::dontSendNotification);
+        crossoverSliderLabels[i].attachToComponent(&crossoverSliders[i], true);
+    }
+
+    for (int band = 0; band < Waveshaper::maxBands; ++band)
+    {
+        const juce::String number(band + 1);
+
+        bandDriveSliders[band].setTextValueSuffix(" dB ");
+        addAndMakeVisible(bandDriveSliders[band]);
+        bandDriveSliderAttachments[band].reset(new SliderAttachment(treeState, "band" + number + "DriveID", bandDriveSliders[band]));
+        addAndMakeVisible(bandDriveSliderLabels[band]);
+        bandDriveSliderLabels[band].setText("Band " + number + " Drive", juce::dontSendNotification);
+        bandDriveSliderLabels[band].attachToComponent(&bandDriveSliders[band], true);
+
+        bandMixSliders[band].setTextValueSuffix(" ");
+        addAndMakeVisible(bandMixSliders[band]);
+        bandMixSliderAttachments[band].reset(new SliderAttachment(treeState, "band" + number + "MixID", bandMixSliders[band]));
+        addAndMakeVisible(bandMixSliderLabels[band]);
+        bandMixSliderLabels[band].setText("Band " + number + " Mix", juce::dontSendNotification);
+        bandMixSliderLabels[band].attachToComponent(&bandMixSliders[band], true);
+    }
+
+    surroundPairingBox.addItemList({ "Left/Right Pairs", "Front Pair Only", "All Mid Only" }, 1);
+    addAndMakeVisible(surroundPairingBox);
+    surroundPairingBoxAttachment.reset(new ComboBoxAttachment(treeState, "surroundPairingID", surroundPairingBox));
+    addAndMakeVisible(surroundPairingBoxLabel);
+    surroundPairingBoxLabel.setText("Surround Pairing", juce::dontSendNotification);
+    surroundPairingBoxLabel.attachToComponent(&surroundPairingBox, true);
+
+    surroundLimiterLinkButton.setButtonText("Linked");
+    addAndMakeVisible(surroundLimiterLinkButton);
+    surroundLimiterLinkButtonAttachment.reset(new ButtonAttachment(treeState, "surroundLimiterLinkID", surroundLimiterLinkButton));
+    addAndMakeVisible(surroundLimiterLinkButtonLabel);
+    surroundLimiterLinkButtonLabel.setText("Surround Limiter", juce::dontSendNotification);
+    surroundLimiterLinkButtonLabel.attachToComponent(&surroundLimiterLinkButton, true);
+
+    // Names come straight from the mapped bank, so even large banks list quickly
+    const auto& presetBank = audioProcessor.getPresetBank();
+
+    for (int i = 0; i < presetBank.getNumPresets(); ++i)
+        presetBox.addItem(presetBank.getName(i), i + 1);
+
+    presetBox.setTextWhenNothingSelected(presetBank.getNumPresets() > 0 ? "Choose a preset" : "No presets");
+    presetBox.onChange = [this] { audioProcessor.setCurrentProgram(presetBox.getSelectedItemIndex()); };
+    addAndMakeVisible(presetBox);
+    addAndMakeVisible(presetBoxLabel);
+    presetBoxLabel.setText("Preset", juce::dontSendNotification);
+    presetBoxLabel.attachToComponent(&presetBox, true);
+
+    addAndMakeVisible(analysisView);
+    addAndMakeVisible(meterView);
+
+    if (auto* profiler = audioProcessor.getStageProfiler())
+    {
+        profilerView = std::make_unique<ProfilerView>(*profiler);
+        addAndMakeVisible(*profilerView);
+    }
+
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
-    setSize(800, 600);
+    setSize(1250, 900);
 }
 
 SpatialSaturatorAudioProcessorEditor::~SpatialSaturatorAudioProcessorEditor()
@@ -123,19 +261,57 @@ void SpatialSaturatorAudioProcessorEditor::resized()
     auto sliderLeft = 250;
     auto sliderHeight = 20;
 
-    int numSliders = 11;
+    // Controls on the left, then the meters, analysis on the right
+    auto controlsWidth = getWidth() - 450;
+    meterView.setBounds(controlsWidth, 0, 150, getHeight());
+
+    // Stage timings under the analysis, when there are any
+    auto analysisHeight = getHeight();
+
+    if (profilerView != nullptr)
+    {
+        analysisHeight -= 140;
+        profilerView->setBounds(controlsWidth + 150, analysisHeight, getWidth() - controlsWidth - 150, getHeight() - analysisHeight);
+    }
+
+    analysisView.setBounds(controlsWidth + 150, 0, getWidth() - controlsWidth - 150, analysisHeight);
+
+    int numSliders = 35;
     int N = 1;
     int step = (getHeight() / (numSliders + 1));
 
-    midGainSlider.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), getWidth() - sliderLeft * 1.5, sliderHeight);
-    midFreqSlider.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), getWidth() - sliderLeft * 1.5, sliderHeight);
-    sideGainSlider.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), getWidth() - sliderLeft * 1.5, sliderHeight);
-    sideFreqLowerSlider.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), getWidth() - sliderLeft * 1.5, sliderHeight);
-    sideFreqUpperSlider.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), getWidth() - sliderLeft * 1.5, sliderHeight);
-    tanhAmplitudeSlider.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), getWidth() - sliderLeft * 1.5, sliderHeight);
-    tanhSlopeSlider.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), getWidth() - sliderLeft * 1.5, sliderHeight);
-    saturatorMixSlider.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), getWidth() - sliderLeft * 1.5, sliderHeight);
-    sinAmplitudeSlider.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), getWidth() - sliderLeft * 1.5, sliderHeight);
-    sinFrequencySlider.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), getWidth() - sliderLeft * 1.5, sliderHeight);
-    makeUpGainSlider.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), getWidth() - sliderLeft * 1.5, sliderHeight);
+    presetBox.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), controlsWidth - sliderLeft * 1.5, sliderHeight);
+    midGainSlider.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), controlsWidth - sliderLeft * 1.5, sliderHeight);
+    midFreqSlider.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), controlsWidth - sliderLeft * 1.5, sliderHeight);
+    sideGainSlider.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), controlsWidth - sliderLeft * 1.5, sliderHeight);
+    sideFreqLowerSlider.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), controlsWidth - sliderLeft * 1.5, sliderHeight);
+    sideFreqUpperSlider.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), controlsWidth - sliderLeft * 1.5, sliderHeight);
+    filterModeBox.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), 150, sliderHeight);
+    tanhAmplitudeSlider.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), controlsWidth - sliderLeft * 1.5, sliderHeight);
+    tanhSlopeSlider.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), controlsWidth - sliderLeft * 1.5, sliderHeight);
+    saturatorMixSlider.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), controlsWidth - sliderLeft * 1.5, sliderHeight);
+    sinAmplitudeSlider.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), controlsWidth - sliderLeft * 1.5, sliderHeight);
+    sinFrequencySlider.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), controlsWidth - sliderLeft * 1.5, sliderHeight);
+    makeUpGainSlider.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), controlsWidth - sliderLeft * 1.5, sliderHeight);
+    oversamplingBox.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), 150, sliderHeight);
+    oversamplingPhaseBox.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), 150, sliderHeight);
+    qualityBox.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), 150, sliderHeight);
+    antiAliasingBox.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), 150, sliderHeight);
+    limiterEnabledButton.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), 150, sliderHeight);
+    limiterCeilingSlider.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), controlsWidth - sliderLeft * 1.5, sliderHeight);
+    limiterLookaheadSlider.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), controlsWidth - sliderLeft * 1.5, sliderHeight);
+    limiterReleaseSlider.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), controlsWidth - sliderLeft * 1.5, sliderHeight);
+    bandsBox.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), 150, sliderHeight);
+
+    for (auto& slider : crossoverSliders)
+        slider.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), controlsWidth - sliderLeft * 1.5, sliderHeight);
+
+    for (int band = 0; band < Waveshaper::maxBands; ++band)
+    {
+        bandDriveSliders[band].setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), controlsWidth - sliderLeft * 1.5, sliderHeight);
+        bandMixSliders[band].setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), controlsWidth - sliderLeft * 1.5, sliderHeight);
+    }
+
+    surroundPairingBox.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), 150, sliderHeight);
+    surroundLimiterLinkButton.setBounds(sliderLeft, (N++ * step) - (sliderHeight / 2), 150, sliderHeight);
 }
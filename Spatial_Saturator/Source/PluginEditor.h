@@ -11,6 +11,9 @@
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
 #include "SpatialSaturatorFilter.h"
+#include "AnalysisView.h"
+#include "MeterView.h"
+#include "ProfilerView.h"
 
 typedef juce::AudioProcessorValueTreeState::SliderAttachment SliderAttachment;
 typedef juce::AudioProcessorValueTreeState::ButtonAttachment ButtonAttachment;
@@ -62,6 +65,11 @@ private:
     juce::Label sideFreqUpperSliderLabel;
     std::unique_ptr<SliderAttachment> sideFreqUpperSliderAttachment;
 
+    // Filter Mode Box
+    juce::ComboBox filterModeBox;
+    juce::Label filterModeBoxLabel;
+    std::unique_ptr<ComboBoxAttachment> filterModeBoxAttachment;
+
     // Tanh amplitude Slider
     juce::Slider tanhAmplitudeSlider;
     juce::Label tanhAmplitudeSliderLabel;
@@ -92,5 +100,85 @@ private:
     juce::Label makeUpGainSliderLabel;
     std::unique_ptr<SliderAttachment> makeUpGainSliderAttachment;
 
+    // Oversampling Factor Box
+    juce::ComboBox oversamplingBox;
+    juce::Label oversamplingBoxLabel;
+    std::unique_ptr<ComboBoxAttachment> oversamplingBoxAttachment;
+
+    // Oversampling Phase Box
+    juce::ComboBox oversamplingPhaseBox;
+    juce::Label oversamplingPhaseBoxLabel;
+    std::unique_ptr<ComboBoxAttachment> oversamplingPhaseBoxAttachment;
+
+    // Saturator Quality Box
+    juce::ComboBox qualityBox;
+    juce::Label qualityBoxLabel;
+    std::unique_ptr<ComboBoxAttachment> qualityBoxAttachment;
+
+    // Anti-Aliasing Mode Box
+    juce::ComboBox antiAliasingBox;
+    juce::Label antiAliasingBoxLabel;
+    std::unique_ptr<ComboBoxAttachment> antiAliasingBoxAttachment;
+
+    // Limiter On/Off Button
+    juce::ToggleButton limiterEnabledButton;
+    juce::Label limiterEnabledButtonLabel;
+    std::unique_ptr<ButtonAttachment> limiterEnabledButtonAttachment;
+
+    // Limiter Ceiling Slider
+    juce::Slider limiterCeilingSlider;
+    juce::Label limiterCeilingSliderLabel;
+    std::unique_ptr<SliderAttachment> limiterCeilingSliderAttachment;
+
+    // Limiter Look-ahead Slider
+    juce::Slider limiterLookaheadSlider;
+    juce::Label limiterLookaheadSliderLabel;
+    std::unique_ptr<SliderAttachment> limiterLookaheadSliderAttachment;
+
+    // Limiter Release Slider
+    juce::Slider limiterReleaseSlider;
+    juce::Label limiterReleaseSliderLabel;
+    std::unique_ptr<SliderAttachment> limiterReleaseSliderAttachment;
+
+    // Multiband Box, crossovers and per band drive and mix
+    juce::ComboBox bandsBox;
+    juce::Label bandsBoxLabel;
+    std::unique_ptr<ComboBoxAttachment> bandsBoxAttachment;
+
+    juce::Slider crossoverSliders[Waveshaper::maxBands - 1];
+    juce::Label crossoverSliderLabels[Waveshaper::maxBands - 1];
+    std::unique_ptr<SliderAttachment> crossoverSliderAttachments[Waveshaper::maxBands - 1];
+
+    juce::Slider bandDriveSliders[Waveshaper::maxBands];
+    juce::Label bandDriveSliderLabels[Waveshaper::maxBands];
+    std::unique_ptr<SliderAttachment> bandDriveSliderAttachments[Waveshaper::maxBands];
+
+    juce::Slider bandMixSliders[Waveshaper::maxBands];
+    juce::Label bandMixSliderLabels[Waveshaper::maxBands];
+    std::unique_ptr<SliderAttachment> bandMixSliderAttachments[Waveshaper::maxBands];
+
+    // Surround Pairing Box, only used on buses wider than stereo
+    juce::ComboBox surroundPairingBox;
+    juce::Label surroundPairingBoxLabel;
+    std::unique_ptr<ComboBoxAttachment> surroundPairingBoxAttachment;
+
+    // Surround Limiter Link Button, only used on buses wider than stereo
+    juce::ToggleButton surroundLimiterLinkButton;
+    juce::Label surroundLimiterLinkButtonLabel;
+    std::unique_ptr<ButtonAttachment> surroundLimiterLinkButtonAttachment;
+
+    // Preset Box, filled from the processor's preset bank
+    juce::ComboBox presetBox;
+    juce::Label presetBoxLabel;
+
+    // Mid/side spectra, goniometer and correlation
+    AnalysisView analysisView;
+
+    // Input and output loudness and true peak
+    MeterView meterView;
+
+    // Stage timings, only in builds with SPATIAL_SATURATOR_PROFILING
+    std::unique_ptr<ProfilerView> profilerView;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpatialSaturatorAudioProcessorEditor)
 };
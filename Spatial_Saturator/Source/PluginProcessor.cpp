@@ -27,8 +27,39 @@ SpatialSaturatorAudioProcessor::SpatialSaturatorAudioProcessor()
     m_tanhSlope = m_state.getRawParameterValue("tanhSlopeID");
     m_saturatorMix = m_state.getRawParameterValue("saturatorMixID");
     m_sinAmplitude = m_state.getRawParameterValue("sinAmplitudeID");
-    m_sinFreq = m_state.getRawParameterValue("sinFreqID");
+    m_sinFreq = m_state.getRawParameterValue("sinFrequencyID");
     m_makeUpGain = m_state.getRawParameterValue("makeUpGainID");
+    m_filterMode = m_state.getRawParameterValue("filterModeID");
+    m_oversampling = m_state.getRawParameterValue("oversamplingID");
+    m_oversamplingPhase = m_state.getRawParameterValue("oversamplingPhaseID");
+    m_quality = m_state.getRawParameterValue("qualityID");
+    m_antiAliasing = m_state.getRawParameterValue("antiAliasingID");
+    m_limiterEnabled = m_state.getRawParameterValue("limiterEnabledID");
+    m_limiterCeiling = m_state.getRawParameterValue("limiterCeilingID");
+    m_limiterLookahead = m_state.getRawParameterValue("limiterLookaheadID");
+    m_limiterRelease = m_state.getRawParameterValue("limiterReleaseID");
+    m_bands = m_state.getRawParameterValue("bandsID");
+    m_surroundPairing = m_state.getRawParameterValue("surroundPairingID");
+    m_surroundLimiterLink = m_state.getRawParameterValue("surroundLimiterLinkID");
+
+    for (int i = 0; i < Waveshaper::maxBands - 1; ++i)
+        m_crossoverFreqs[i] = m_state.getRawParameterValue("crossover" + juce::String(i + 1) + "ID");
+
+    for (int band = 0; band < Waveshaper::maxBands; ++band)
+    {
+        m_bandDrives[band] = m_state.getRawParameterValue("band" + juce::String(band + 1) + "DriveID");
+        m_bandMixes[band] = m_state.getRawParameterValue("band" + juce::String(band + 1) + "MixID");
+    }
+
+    // Only one of the engines runs at a time, so they can share it
+    if (StageProfiler::isEnabled)
+    {
+        m_profiler = std::make_unique<StageProfiler>();
+        engine.setProfiler(m_profiler.get());
+        m_surroundEngine.setProfiler(m_profiler.get());
+    }
+
+    loadPresetBank(PresetBank::getDefaultFile());
 }
 
 SpatialSaturatorAudioProcessor::~SpatialSaturatorAudioProcessor()
@@ -72,6 +103,69 @@ juce::AudioProcessorValueTreeState::ParameterLayout SpatialSaturatorAudioProcess
     auto makeUpGain = std::make_unique<juce::AudioParameterFloat>("makeUpGainID", "Make Up Gain (dB)", juce::NormalisableRange<float>(-12.0f, 12.0f, 0.5f), 0.0f);
     params.push_back(std::move(makeUpGain));
 
+    // 1x by default, so sessions saved before oversampling existed reopen with no added latency or cost
+    auto oversampling = std::make_unique<juce::AudioParameterChoice>("oversamplingID", "Oversampling", juce::StringArray{ "1x", "2x", "4x", "8x" }, 0);
+    params.push_back(std::move(oversampling));
+
+    auto oversamplingPhase = std::make_unique<juce::AudioParameterChoice>("oversamplingPhaseID", "Oversampling Phase", juce::StringArray{ "Minimum Phase", "Linear Phase" }, 0);
+    params.push_back(std::move(oversamplingPhase));
+
+    // Saturator precision: tanh/sin approximations within 1e-3, 1e-5, or exact
+    auto quality = std::make_unique<juce::AudioParameterChoice>("qualityID", "Quality", juce::StringArray{ "Draft", "High", "Full" }, 2);
+    params.push_back(std::move(quality));
+
+    // Antiderivative anti-aliasing runs the saturator at the base rate instead of oversampling
+    auto antiAliasing = std::make_unique<juce::AudioParameterChoice>("antiAliasingID", "Anti-Aliasing", juce::StringArray{ "Oversampling", "ADAA 1st Order", "ADAA 2nd Order" }, 0);
+    params.push_back(std::move(antiAliasing));
+
+    // Off by default, so sessions saved before the limiter existed reopen sounding as they did
+    auto limiterEnabled = std::make_unique<juce::AudioParameterBool>("limiterEnabledID", "Limiter", false);
+    params.push_back(std::move(limiterEnabled));
+
+    auto limiterCeiling = std::make_unique<juce::AudioParameterFloat>("limiterCeilingID", "Limiter Ceiling (dBTP)", juce::NormalisableRange<float>(-12.0f, 0.0f, 0.1f), -1.0f);
+    params.push_back(std::move(limiterCeiling));
+
+    auto limiterLookahead = std::make_unique<juce::AudioParameterFloat>("limiterLookaheadID", "Limiter Look-ahead (ms)", juce::NormalisableRange<float>(0.5f, (float)Limiter::maxLookaheadMs, 0.1f), 2.0f);
+    params.push_back(std::move(limiterLookahead));
+
+    auto limiterRelease = std::make_unique<juce::AudioParameterFloat>("limiterReleaseID", "Limiter Release (ms)", juce::NormalisableRange<float>(1.0f, 1000.0f, 1.0f), 100.0f);
+    params.push_back(std::move(limiterRelease));
+
+    // Linear phase runs the same filter magnitudes as a long FIR, at the cost of latency
+    auto filterMode = std::make_unique<juce::AudioParameterChoice>("filterModeID", "Filter Mode", juce::StringArray{ "Biquad", "Linear Phase", "SVF" }, 0);
+    params.push_back(std::move(filterMode));
+
+    // Multiband saturation: "Off" shapes the full band, otherwise 2 to 4 Linkwitz-Riley bands
+    auto bands = std::make_unique<juce::AudioParameterChoice>("bandsID", "Bands", juce::StringArray{ "Off", "2 Bands", "3 Bands", "4 Bands" }, 0);
+    params.push_back(std::move(bands));
+
+    const float crossoverDefaults[] = { 150.0f, 1000.0f, 5000.0f };
+
+    for (int i = 0; i < Waveshaper::maxBands - 1; ++i)
+    {
+        const juce::String number(i + 1);
+        auto crossover = std::make_unique<juce::AudioParameterFloat>("crossover" + number + "ID", "Crossover " + number + " (Hz)", juce::NormalisableRange<float>(20.0f, 20000.0f, 1.0f, 0.25f), crossoverDefaults[i]);
+        params.push_back(std::move(crossover));
+    }
+
+    for (int band = 0; band < Waveshaper::maxBands; ++band)
+    {
+        const juce::String number(band + 1);
+        auto bandDrive = std::make_unique<juce::AudioParameterFloat>("band" + number + "DriveID", "Band " + number + " Drive (dB)", juce::NormalisableRange<float>(0.0f, 24.0f, 0.5f), 0.0f);
+        params.push_back(std::move(bandDrive));
+
+        auto bandMix = std::make_unique<juce::AudioParameterFloat>("band" + number + "MixID", "Band " + number + " Mix", juce::NormalisableRange<float>(0.0f, 100.0f, 1.0f), 100.0f);
+        params.push_back(std::move(bandMix));
+    }
+
+    // Which speakers of a surround bus are widened as M/S pairs; the rest only get the mid processing
+    auto surroundPairing = std::make_unique<juce::AudioParameterChoice>("surroundPairingID", "Surround Pairing", juce::StringArray{ "Left/Right Pairs", "Front Pair Only", "All Mid Only" }, 0);
+    params.push_back(std::move(surroundPairing));
+
+    // One limiter gain for the whole surround bed, so a peak in one speaker does not move the image
+    auto surroundLimiterLink = std::make_unique<juce::AudioParameterBool>("surroundLimiterLinkID", "Surround Limiter Link", true);
+    params.push_back(std::move(surroundLimiterLink));
+
     return { params.begin(), params.end() };
 }
 
@@ -110,27 +204,63 @@ bool SpatialSaturatorAudioProcessor::isMidiEffect() const
 
 double SpatialSaturatorAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    return m_tailLengthSeconds.load(std::memory_order_relaxed);
+}
+
+void SpatialSaturatorAudioProcessor::updateTailLength()
+{
+    if (m_sampleRate <= 0.0)
+        return;
+
+    int tail = 0;
+
+    // Streams may be regrouped or ramping apart, so the longest of them
+    if (m_surround)
+    {
+        for (int stream = 0; stream < m_surroundEngine.getNumActiveStreams(); ++stream)
+            tail = std::max(tail, m_surroundEngine.getTailLengthInSamples(stream));
+    }
+    else
+    {
+        tail = engine.getTailLengthInSamples();
+    }
+
+    m_tailLengthSeconds.store(tail / m_sampleRate, std::memory_order_relaxed);
 }
 
 int SpatialSaturatorAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
+    // NB: some hosts don't cope very well if you tell them there are 0 programs,
     // so this should be at least 1, even if you're not really implementing programs.
+    return juce::jmax(1, m_presetBank.getNumPresets());
 }
 
 int SpatialSaturatorAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return m_currentProgram;
 }
 
 void SpatialSaturatorAudioProcessor::setCurrentProgram(int index)
 {
+    if (index < 0 || index >= m_presetBank.getNumPresets())
+        return;
+
+    m_currentProgram = index;
+    m_presetBank.apply(index);
 }
 
 const juce::String SpatialSaturatorAudioProcessor::getProgramName(int index)
 {
-    return {};
+    return m_presetBank.getName(index);
+}
+
+bool SpatialSaturatorAudioProcessor::loadPresetBank(const juce::File& file)
+{
+    m_currentProgram = 0;
+    const bool opened = m_presetBank.open(file, m_parameterState);
+
+    updateHostDisplay();
+    return opened;
 }
 
 void SpatialSaturatorAudioProcessor::changeProgramName(int index, const juce::String& newName)
@@ -143,11 +273,65 @@ void SpatialSaturatorAudioProcessor::prepareToPlay(double sampleRate, int sample
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
 
-    // Set sample rate for all filter instances
-    midShelfFilter.setSampleRate(static_cast<float>(sampleRate));
-    sideShelfFilter.setSampleRate(static_cast<float>(sampleRate));
-    sideHpFilter.setSampleRate(static_cast<float>(sampleRate));
+    m_sampleRate = sampleRate;
+
+    // Sets the filter sample rate and allocates the oversampling stages and the
+    // longest look-ahead, so both can change while playing
+    engine.prepare(sampleRate, samplesPerBlock);
+
+    // Coefficient tables covering every step of the filter parameter ranges
+    std::shared_ptr<const CoefficientTables> tables;
+
+    if (m_useCoefficientTables)
+    {
+        auto midFreqRange = m_state.getParameterRange("midFreqID");
+        auto sideFreqLowerRange = m_state.getParameterRange("sideFreqLowerID");
+        auto sideFreqUpperRange = m_state.getParameterRange("sideFreqUpperID");
+        auto midGainRange = m_state.getParameterRange("midGainID");
+        auto sideGainRange = m_state.getParameterRange("sideGainID");
+
+        // All frequency (and all gain) parameters share a step size, so one table covers them
+        jassert(midFreqRange.interval == sideFreqLowerRange.interval && midFreqRange.interval == sideFreqUpperRange.interval);
+        jassert(midGainRange.interval == sideGainRange.interval);
+
+        tables = CoefficientTables::getShared(static_cast<float>(sampleRate),
+            juce::jmin(midFreqRange.start, sideFreqLowerRange.start, sideFreqUpperRange.start),
+            juce::jmax(midFreqRange.end, sideFreqLowerRange.end, sideFreqUpperRange.end),
+            midFreqRange.interval,
+            juce::jmin(midGainRange.start, sideGainRange.start),
+            juce::jmax(midGainRange.end, sideGainRange.end),
+            midGainRange.interval);
+    }
+
+    engine.setCoefficientTables(tables);
+    engine.setParameters(getEngineParameters());
 
+    // Buses wider than stereo run through the multi-stream engine, one stream per pair or mid-only channel
+    const auto layout = getChannelLayoutOfBus(false, 0);
+    m_surround = layout.size() > 2;
+    m_surroundActive.store(m_surround, std::memory_order_relaxed);
+
+    if (m_surround)
+    {
+        m_surroundRouter.prepare(layout, samplesPerBlock);
+        m_surroundRouter.setPairing((SurroundRouter::Pairing)(int)*m_surroundPairing);
+
+        m_surroundEngine.prepare(sampleRate, samplesPerBlock, m_surroundRouter.getMaxStreams());
+        m_surroundEngine.setNumActiveStreams(m_surroundRouter.getNumStreams());
+        m_surroundEngine.setCoefficientTables(tables);
+        m_surroundEngine.setLimiterLinked(*m_surroundLimiterLink > 0.5f);
+
+        // Every stream a later pairing may use, so regrouping finds them set
+        m_surroundParameters = getEngineParameters();
+
+        for (int stream = 0; stream < m_surroundEngine.getNumStreams(); ++stream)
+            m_surroundEngine.setParameters(stream, m_surroundParameters);
+    }
+
+    setLatencySamples(getCurrentLatency());
+    updateTailLength();
+
+    m_analysisFifo.prepare(sampleRate);
 }
 
 void SpatialSaturatorAudioProcessor::releaseResources()
@@ -156,17 +340,42 @@ void SpatialSaturatorAudioProcessor::releaseResources()
     // spare memory, etc.
 }
 
+void SpatialSaturatorAudioProcessor::reset()
+{
+    engine.reset();
+
+    if (m_surround)
+        m_surroundEngine.reset();
+}
+
 #ifndef JucePlugin_PreferredChannelConfigurations
 bool SpatialSaturatorAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const
 {
     const juce::AudioChannelSet& mainInput = layouts.getMainInputChannelSet();
     const juce::AudioChannelSet& mainOutput = layouts.getMainOutputChannelSet();
 
-    return mainInput.size() == 2 && mainOutput.size() == 2;
+    // Mono, stereo, or a speaker bed of the same layout in and out
+    return mainInput == mainOutput && (mainOutput == juce::AudioChannelSet::mono() || SurroundRouter::isSupported(mainOutput));
 }
 #endif
 
+bool SpatialSaturatorAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
 void SpatialSaturatorAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processSamples(buffer);
+}
+
+void SpatialSaturatorAudioProcessor::processBlock(juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processSamples(buffer);
+}
+
+template <typename SampleType>
+void SpatialSaturatorAudioProcessor::processSamples(juce::AudioBuffer<SampleType>& buffer)
 {
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels = getTotalNumInputChannels();
@@ -188,44 +397,121 @@ void SpatialSaturatorAudioProcessor::processBlock(juce::AudioBuffer<float>& buff
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear(i, 0, buffer.getNumSamples());
 
-    // Two Output channels
-    auto channelDataL = buffer.getWritePointer(0);
-    auto channelDataR = buffer.getWritePointer(1);
+    // Filters, waveshaper and limiter, with the current parameter values
+    const auto parameters = getEngineParameters();
+    engine.setParameters(parameters);
 
-    // Process L+R into mids & sides
-    processMidsSides(buffer, midiMessages, numSamples);
+    // Only while an editor shows the meters
+    engine.setMeteringEnabled(m_meteringEnabled.load());
 
-    // Apply mid low shelf to mids
-    midShelfFilter.processFilter(buffer, midiMessages, numSamples, m_midFreq, m_midGain);
+    if (m_surround)
+    {
+        processSurround(buffer, parameters);
+    }
+    else if (buffer.getNumChannels() == 1)
+    {
+        // A mono bus has no side, so the side filters and the second channel never run
+        engine.processMono(buffer.getWritePointer(0), numSamples);
 
-    // Apply side high pass to sides
-    sideHpFilter.processFilter(buffer, midiMessages, numSamples, m_sideFreqLower);
+        m_analysisFifo.push(buffer.getReadPointer(0), buffer.getReadPointer(0), numSamples);
+    }
+    else
+    {
+        // Silent input sleeps once the tail has rung out, so idle tracks cost a scan and a clear;
+        // input with equal channels runs one channel once the side has rung out
+        engine.process(buffer.getWritePointer(0), buffer.getWritePointer(1), numSamples);
 
-    // Apply side low-shelf to sides 
-    sideShelfFilter.processFilter(buffer, midiMessages, numSamples, m_sideFreqUpper, m_sideGain);
+        // Only copies anything while an editor shows the analysis
+        m_analysisFifo.push(buffer.getReadPointer(0), buffer.getReadPointer(1), numSamples);
+    }
 
-    // Process mids+sides back to L&R
-    processLeftRight(buffer, midiMessages, numSamples);
+    // Report the new latency if the oversampling, anti-aliasing or limiter settings changed
+    if (getCurrentLatency() != getLatencySamples())
+        setLatencySamples(getCurrentLatency());
 
-    double input;
+    updateTailLength();
+}
 
-    // Waveshaper Saturator and Limiter
-    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
+template <typename SampleType>
+void SpatialSaturatorAudioProcessor::processSurround(juce::AudioBuffer<SampleType>& buffer, const SpatialSaturatorEngine::Parameters& parameters)
+{
+    // A new pairing regroups the channels, so the old stream states belong to other speakers
+    if (m_surroundRouter.setPairing((SurroundRouter::Pairing)(int)*m_surroundPairing))
+    {
+        m_surroundEngine.setNumActiveStreams(m_surroundRouter.getNumStreams());
+        m_surroundEngine.reset();
+    }
+
+    m_surroundEngine.setLimiterLinked(*m_surroundLimiterLink > 0.5f);
+
+    // The streams ramp to new values on their own, so they only need to hear of changes
+    if (parameters != m_surroundParameters)
     {
-        for (auto n = numSamples; n < numSamples; ++n)
-        {
-            input = (double)buffer.getSample(i, n);
+        m_surroundParameters = parameters;
 
-            // waveshaper saturator 
-            input = ((double)*m_tanhAmplitude*0.01) * tanh(input * (double)*m_tanhSlope) + ((double)*m_sinAmplitude*0.01) * sin(input * (double)*m_sinFreq);
+        for (int stream = 0; stream < m_surroundEngine.getNumStreams(); ++stream)
+            m_surroundEngine.setParameters(stream, parameters);
+    }
 
-            // Mixer Processing
-            input = input * (double)*m_saturatorMix;
+    m_surroundRouter.process(m_surroundEngine, buffer);
 
-            // Limiter (To be developed)
+    // The display shows the front pair, when there is one
+    const int left = m_surroundRouter.getFrontLeftChannel();
+    const int right = m_surroundRouter.getFrontRightChannel();
 
-        }
+    if (left >= 0 && right >= 0)
+        m_analysisFifo.push(buffer.getReadPointer(left), buffer.getReadPointer(right), buffer.getNumSamples());
+}
+
+int SpatialSaturatorAudioProcessor::getCurrentLatency() const
+{
+    // Every stream has the same settings, so the same latency
+    if (m_surround)
+        return m_surroundEngine.getNumStreams() > 0 ? m_surroundEngine.getLatencyInSamples(0) : 0;
+
+    return engine.getLatencyInSamples();
+}
+
+SpatialSaturatorEngine::Parameters SpatialSaturatorAudioProcessor::getEngineParameters() const
+{
+    SpatialSaturatorEngine::Parameters parameters;
+
+    parameters.midGain = *m_midGain;
+    parameters.midFreq = *m_midFreq;
+    parameters.sideGain = *m_sideGain;
+    parameters.sideFreqLower = *m_sideFreqLower;
+    parameters.sideFreqUpper = *m_sideFreqUpper;
+    parameters.makeUpGain = *m_makeUpGain;
+    parameters.filterMode = (SpatialSaturatorEngine::FilterMode)(int)*m_filterMode;
+
+    parameters.tanhAmplitude = *m_tanhAmplitude;
+    parameters.tanhSlope = *m_tanhSlope;
+    parameters.saturatorMix = *m_saturatorMix;
+    parameters.sinAmplitude = *m_sinAmplitude;
+    parameters.sinFrequency = *m_sinFreq;
+
+    parameters.oversamplingFactorLog2 = (int)*m_oversampling;
+    parameters.oversamplingPhase = (Oversampler::Phase)(int)*m_oversamplingPhase;
+    parameters.quality = (FastMath::Precision)(int)*m_quality;
+    parameters.antiAliasing = (Waveshaper::AntiAliasing)(int)*m_antiAliasing;
+
+    parameters.limiterEnabled = *m_limiterEnabled > 0.5f;
+    parameters.limiterCeiling = *m_limiterCeiling;
+    parameters.limiterLookahead = *m_limiterLookahead;
+    parameters.limiterRelease = *m_limiterRelease;
+
+    parameters.numBands = (int)*m_bands + 1;
+
+    for (int i = 0; i < Waveshaper::maxBands - 1; ++i)
+        parameters.crossoverFrequencies[i] = *m_crossoverFreqs[i];
+
+    for (int band = 0; band < Waveshaper::maxBands; ++band)
+    {
+        parameters.bandDrives[band] = *m_bandDrives[band];
+        parameters.bandMixes[band] = *m_bandMixes[band];
     }
+
+    return parameters;
 }
 
 //==============================================================================
@@ -242,18 +528,18 @@ juce::AudioProcessorEditor* SpatialSaturatorAudioProcessor::createEditor()
 //==============================================================================
 void SpatialSaturatorAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
-    auto state = m_state.copyState();
-    std::unique_ptr<juce::XmlElement>xml(state.createXml());
-    copyXmlToBinary(*xml, destData);
+    // Binary: 8 bytes per parameter, and nothing to parse when a session reopens
+    m_parameterState.write(destData);
 }
 
 void SpatialSaturatorAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
     // You should use this method to restore your parameters from this memory block,
     // whose contents will have been created by the getStateInformation() call.
+    if (m_parameterState.read(data, sizeInBytes))
+        return;
+
+    // Sessions saved before the binary format hold the XML of the whole tree
     std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
 
     if (xmlState.get() != nullptr)
@@ -261,37 +547,6 @@ void SpatialSaturatorAudioProcessor::setStateInformation(const void* data, int s
             m_state.replaceState(juce::ValueTree::fromXml(*xmlState));
 }
 
-void SpatialSaturatorAudioProcessor::processMidsSides(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages, int numberSamples)
-{
-    for (int n = 0; n < numberSamples; ++n)
-    {
-        // process mids
-        double mids = ((double)buffer.getSample(0, n) + (double)buffer.getSample(1, n)) / 2;
-        // process sides
-        double sides = ((double)buffer.getSample(0, n) - (double)buffer.getSample(1, n)) / 2;
-
-        // Set output
-        buffer.setSample(0, n, mids);
-        buffer.setSample(1, n, sides);
-
-    }
-}
-
-void SpatialSaturatorAudioProcessor::processLeftRight(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages, int numberSamples)
-{
-    for (int n = 0; n < numberSamples; ++n)
-    {
-        // process left
-        double left = ((double)buffer.getSample(0, n) + (double)buffer.getSample(1, n)) * juce::Decibels::decibelsToGain((float)*m_makeUpGain);
-        // process right
-        double right = ((double)buffer.getSample(0, n) - (double)buffer.getSample(1, n)) * juce::Decibels::decibelsToGain((float)*m_makeUpGain);
-
-        // Set output
-        buffer.setSample(0, n, left);
-        buffer.setSample(1, n, right);
-    }
-}
-
 //==============================================================================
 // This creates new instances of the plugin..
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
@@ -9,7 +9,12 @@
 #pragma once
 
 #include <JuceHeader.h>
-#include "SpatialSaturatorFilter.h"
+#include "AnalysisFifo.h"
+#include "ParameterState.h"
+#include "PresetBank.h"
+#include "SpatialSaturatorEngine.h"
+#include "SpatialSaturatorMultiStream.h"
+#include "SurroundRouter.h"
 
 //==============================================================================
 /**
@@ -30,11 +35,18 @@ public:
     void prepareToPlay(double sampleRate, int samplesPerBlock) override;
     void releaseResources() override;
 
+    // Clears every filter, oversampler and look-ahead state, as after prepareToPlay
+    void reset() override;
+
 #ifndef JucePlugin_PreferredChannelConfigurations
     bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
 #endif
 
     void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock(juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+
+    // The whole chain runs natively on 64-bit buffers
+    bool supportsDoublePrecisionProcessing() const override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -67,11 +79,55 @@ public:
     std::atomic<float>* m_sideFreqLower = nullptr;
     std::atomic<float>* m_sideFreqUpper = nullptr;
     std::atomic<float>* m_makeUpGain = nullptr;
+    std::atomic<float>* m_filterMode = nullptr;
     std::atomic<float>* m_tanhAmplitude = nullptr;
     std::atomic<float>* m_tanhSlope = nullptr;
     std::atomic<float>* m_saturatorMix = nullptr;
     std::atomic<float>* m_sinAmplitude = nullptr;
     std::atomic<float>* m_sinFreq = nullptr;
+    std::atomic<float>* m_oversampling = nullptr;
+    std::atomic<float>* m_oversamplingPhase = nullptr;
+    std::atomic<float>* m_quality = nullptr;
+    std::atomic<float>* m_antiAliasing = nullptr;
+    std::atomic<float>* m_limiterEnabled = nullptr;
+    std::atomic<float>* m_limiterCeiling = nullptr;
+    std::atomic<float>* m_limiterLookahead = nullptr;
+    std::atomic<float>* m_limiterRelease = nullptr;
+    std::atomic<float>* m_bands = nullptr;
+    std::atomic<float>* m_crossoverFreqs[Waveshaper::maxBands - 1] = {};
+    std::atomic<float>* m_bandDrives[Waveshaper::maxBands] = {};
+    std::atomic<float>* m_bandMixes[Waveshaper::maxBands] = {};
+    std::atomic<float>* m_surroundPairing = nullptr;
+    std::atomic<float>* m_surroundLimiterLink = nullptr;
+
+    // Build filter coefficient tables in prepareToPlay, so parameter changes become table lookups
+    bool m_useCoefficientTables = true;
+
+    // Decimated mid/side output for the editor's analysis display
+    AnalysisFifo& getAnalysisFifo() { return m_analysisFifo; }
+
+    // Loudness, RMS and true peak before and after the chain, readable from
+    // any thread. Stereo and mono buses only: a surround bed runs the
+    // multi-stream engine, which has no meters, so these stay at rest
+    const LoudnessMeter& getInputMeter() const { return engine.getInputMeter(); }
+    const LoudnessMeter& getOutputMeter() const { return engine.getOutputMeter(); }
+
+    // Set by the editor while it shows the meters; off, the engine skips the
+    // K-weighting and true-peak work. The audio thread applies it each block
+    void setMeteringEnabled(bool enabled) { m_meteringEnabled.store(enabled); }
+
+    // True while the bus is a surround bed (from prepareToPlay), readable from any thread
+    bool isProcessingSurround() const { return m_surroundActive.load(std::memory_order_relaxed); }
+
+    // Stage timings of whichever engine runs, for the editor and the tools to
+    // collect(); null unless built with SPATIAL_SATURATOR_PROFILING
+    StageProfiler* getStageProfiler() { return m_profiler.get(); }
+
+    // Presets are the host's programs. The bank at PresetBank::getDefaultFile()
+    // is opened on creation; another one replaces it
+    bool loadPresetBank(const juce::File& file);
+    const PresetBank& getPresetBank() const { return m_presetBank; }
+    const ParameterState& getParameterState() const { return m_parameterState; }
 
 private:
 
@@ -79,13 +135,46 @@ private:
 
     double m_sampleRate{};
 
-    void processMidsSides(juce::AudioBuffer<float>&, juce::MidiBuffer&, int numberSamples);
-    void processLeftRight(juce::AudioBuffer<float>&, juce::MidiBuffer&, int numberSamples);
+    // Tail of whichever engine runs the bus for the host, updated on the audio
+    // thread with the parameters
+    std::atomic<double> m_tailLengthSeconds{ 0.0 };
+    void updateTailLength();
+
+    // Reads every parameter once, for the engine
+    SpatialSaturatorEngine::Parameters getEngineParameters() const;
+
+    // Shared by the float and double processBlock
+    template <typename SampleType>
+    void processSamples(juce::AudioBuffer<SampleType>& buffer);
+
+    // Surround buses: every stream gets the same parameters
+    template <typename SampleType>
+    void processSurround(juce::AudioBuffer<SampleType>& buffer, const SpatialSaturatorEngine::Parameters& parameters);
+
+    // Of whichever engine runs the current bus
+    int getCurrentLatency() const;
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpatialSaturatorAudioProcessor)
 
-    MidShelfFilter midShelfFilter;
-    SideShelfFilter sideShelfFilter;
-    SideHpFilter sideHpFilter;
+    SpatialSaturatorEngine engine;
+    AnalysisFifo m_analysisFifo;
+    std::atomic<bool> m_meteringEnabled{ false };
+
+    // Surround and immersive beds: biquad filters, no meters
+    bool m_surround = false;
+    std::atomic<bool> m_surroundActive{ false };
+    SurroundRouter m_surroundRouter;
+    MultiStreamEngine m_surroundEngine;
+
+    // What every stream of the surround engine was last given, so unchanged
+    // parameters are not pushed to each stream every block
+    SpatialSaturatorEngine::Parameters m_surroundParameters;
+
+    std::unique_ptr<StageProfiler> m_profiler;
+
+    // After m_state, whose parameters it lists
+    ParameterState m_parameterState{ *this };
+    PresetBank m_presetBank;
+    int m_currentProgram = 0;
 };
@@ -0,0 +1,193 @@
+/*
+  ==============================================================================
+
+    This file contains the memory-mapped preset bank
+
+  ==============================================================================
+*/
+
+#include "PresetBank.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+//==============================================================================
+bool PresetBank::write(const juce::File& file, const ParameterState& state, const std::vector<Preset>& presets)
+{
+    const int numValues = state.getNumParameters();
+    const size_t recordBytes = nameBytes + sizeof(float) * (size_t)numValues;
+    const size_t recordsStart = headerBytes + sizeof(juce::uint32) * (size_t)numValues;
+
+    juce::MemoryBlock data;
+    data.setSize(recordsStart + recordBytes * presets.size(), true);
+    auto* bytes = static_cast<char*>(data.getData());
+
+    ParameterState::writeUInt32(bytes, bankMagic);
+    ParameterState::writeUInt32(bytes + 4, currentVersion);
+    ParameterState::writeUInt32(bytes + 8, (juce::uint32)numValues);
+    ParameterState::writeUInt32(bytes + 12, (juce::uint32)presets.size());
+
+    for (int i = 0; i < numValues; ++i)
+        ParameterState::writeUInt32(bytes + headerBytes + sizeof(juce::uint32) * (size_t)i, state.getHash(i));
+
+    for (size_t p = 0; p < presets.size(); ++p)
+    {
+        char* record = bytes + recordsStart + recordBytes * p;
+
+        // Always leaves a terminating zero
+        auto* name = presets[p].name.toRawUTF8();
+        std::memcpy(record, name, juce::jmin(std::strlen(name), (size_t)nameBytes - 1));
+
+        for (int i = 0; i < numValues && i < (int)presets[p].values.size(); ++i)
+            ParameterState::writeFloat(record + nameBytes + sizeof(float) * (size_t)i, presets[p].values[(size_t)i]);
+    }
+
+    return file.replaceWithData(data.getData(), data.getSize());
+}
+
+bool PresetBank::addPreset(const juce::File& file, const ParameterState& state, const juce::String& name)
+{
+    std::vector<Preset> presets;
+
+    if (file.existsAsFile())
+    {
+        PresetBank bank;
+
+        if (!bank.open(file, state))
+            return false;
+
+        for (int i = 0; i < bank.getNumPresets(); ++i)
+            presets.push_back(bank.getPreset(i));
+
+        // Unmapped before the file is replaced
+        bank.close();
+    }
+
+    Preset preset{ name, state.getValues() };
+
+    auto existing = std::find_if(presets.begin(), presets.end(), [&name](const Preset& p) { return p.name == name; });
+
+    if (existing != presets.end())
+        *existing = std::move(preset);
+    else
+        presets.push_back(std::move(preset));
+
+    return file.getParentDirectory().createDirectory().wasOk() && write(file, state, presets);
+}
+
+juce::File PresetBank::getDefaultFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+        .getChildFile("Spatial Saturator")
+        .getChildFile("Presets.sspb");
+}
+
+//==============================================================================
+bool PresetBank::open(const juce::File& file, const ParameterState& state)
+{
+    close();
+
+    if (!file.existsAsFile())
+        return false;
+
+    auto mapped = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+    auto* bytes = static_cast<const char*>(mapped->getData());
+    const size_t size = mapped->getSize();
+
+    if (bytes == nullptr || size < headerBytes || ParameterState::readUInt32(bytes) != bankMagic)
+        return false;
+
+    // Another version may lay the records out differently
+    if (ParameterState::readUInt32(bytes + 4) != currentVersion)
+        return false;
+
+    const juce::uint32 numValues = ParameterState::readUInt32(bytes + 8);
+    const juce::uint32 numPresets = ParameterState::readUInt32(bytes + 12);
+
+    const size_t recordBytes = nameBytes + sizeof(float) * (size_t)numValues;
+    const size_t recordsStart = headerBytes + sizeof(juce::uint32) * (size_t)numValues;
+
+    if (numValues > (size - headerBytes) / sizeof(juce::uint32))
+        return false;
+
+    // A truncated file keeps the presets that are complete
+    const size_t availablePresets = (size - recordsStart) / recordBytes;
+
+    m_parameterIndices.assign(numValues, -1);
+    m_stored.assign((size_t)state.getNumParameters(), false);
+
+    for (juce::uint32 i = 0; i < numValues; ++i)
+    {
+        const int index = state.indexOf(ParameterState::readUInt32(bytes + headerBytes + sizeof(juce::uint32) * i));
+        m_parameterIndices[i] = index;
+
+        if (index >= 0)
+            m_stored[(size_t)index] = true;
+    }
+
+    m_file = std::move(mapped);
+    m_state = &state;
+    m_records = bytes + recordsStart;
+    m_recordBytes = recordBytes;
+    m_numPresets = (int)juce::jmin((size_t)numPresets, availablePresets, (size_t)std::numeric_limits<int>::max());
+
+    return true;
+}
+
+void PresetBank::close()
+{
+    m_file = nullptr;
+    m_state = nullptr;
+    m_records = nullptr;
+    m_recordBytes = 0;
+    m_numPresets = 0;
+    m_parameterIndices.clear();
+    m_stored.clear();
+}
+
+//==============================================================================
+juce::String PresetBank::getName(int index) const
+{
+    if (index < 0 || index >= m_numPresets)
+        return {};
+
+    const char* name = getRecord(index);
+    return juce::String::fromUTF8(name, (int)strnlen(name, nameBytes));
+}
+
+PresetBank::Preset PresetBank::getPreset(int index) const
+{
+    Preset preset;
+
+    if (index < 0 || index >= m_numPresets)
+        return preset;
+
+    preset.name = getName(index);
+
+    for (int i = 0; i < m_state->getNumParameters(); ++i)
+        preset.values.push_back(m_state->getDefaultValue(i));
+
+    const char* values = getRecord(index) + nameBytes;
+
+    for (size_t i = 0; i < m_parameterIndices.size(); ++i)
+        if (m_parameterIndices[i] >= 0)
+            preset.values[(size_t)m_parameterIndices[i]] = ParameterState::readFloat(values + sizeof(float) * i);
+
+    return preset;
+}
+
+void PresetBank::apply(int index) const
+{
+    if (index < 0 || index >= m_numPresets)
+        return;
+
+    const char* values = getRecord(index) + nameBytes;
+
+    for (size_t i = 0; i < m_parameterIndices.size(); ++i)
+        if (m_parameterIndices[i] >= 0)
+            m_state->setValue(m_parameterIndices[i], ParameterState::readFloat(values + sizeof(float) * i));
+
+    for (int i = 0; i < m_state->getNumParameters(); ++i)
+        if (!m_stored[(size_t)i])
+            m_state->setToDefault(i);
+}
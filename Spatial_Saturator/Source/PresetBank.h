@@ -0,0 +1,90 @@
+/*
+  ==============================================================================
+
+    This file contains the memory-mapped preset bank
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ParameterState.h"
+
+//==============================================================================
+/**
+    A library of presets in one file of fixed size records, so thousands of
+    them can be browsed without parsing anything:
+
+        "SSPB", version, number of values, number of presets   (uint32)
+        ID hash of each value                                   (uint32)
+        per preset: UTF-8 name, zero padded to nameBytes        (char)
+                    raw value of each parameter                 (float)
+
+    open() maps the file and only reads the header and the hashes; a name or
+    a preset is read straight from the mapping when it is asked for. Values
+    are matched to the processor's parameters by ID hash once, at open(), so
+    banks written before parameters were added still apply (the new ones go
+    to their defaults). Banks of another version are not opened.
+
+    addPreset() makes and extends banks, e.g. from the render tool's
+    --save-preset.
+*/
+class PresetBank
+{
+public:
+    enum : juce::uint32
+    {
+        bankMagic = 0x42505353,     // "SSPB"
+        currentVersion = 1
+    };
+
+    enum { headerBytes = 16, nameBytes = 64 };
+
+    struct Preset
+    {
+        juce::String name;
+        std::vector<float> values;      // raw, in ParameterState order
+    };
+
+    // Writes a bank for the parameters of state; false if the file could not be written
+    static bool write(const juce::File& file, const ParameterState& state, const std::vector<Preset>& presets);
+
+    // Adds the current values of state to the bank in file as a preset, or
+    // replaces the preset of that name, creating the bank if there is none.
+    // False if the file is there but not a bank, or could not be written
+    static bool addPreset(const juce::File& file, const ParameterState& state, const juce::String& name);
+
+    // Where the plug-in looks for its bank when it is created
+    static juce::File getDefaultFile();
+
+    // False, and closed, if the file is missing or not a bank
+    bool open(const juce::File& file, const ParameterState& state);
+    void close();
+
+    bool isOpen() const                 { return m_file != nullptr; }
+    int getNumPresets() const           { return m_numPresets; }
+
+    juce::String getName(int index) const;
+
+    // Values in ParameterState order, with the defaults for those not stored
+    Preset getPreset(int index) const;
+
+    // Sets every parameter of the state from the preset, notifying the host
+    void apply(int index) const;
+
+private:
+    const char* getRecord(int index) const  { return m_records + m_recordBytes * (size_t)index; }
+
+    std::unique_ptr<juce::MemoryMappedFile> m_file;
+    const ParameterState* m_state = nullptr;
+
+    const char* m_records = nullptr;
+    size_t m_recordBytes = 0;
+    int m_numPresets = 0;
+
+    // State parameter of each stored value (-1 if it is gone), and whether
+    // each state parameter has a stored value
+    std::vector<int> m_parameterIndices;
+    std::vector<bool> m_stored;
+};
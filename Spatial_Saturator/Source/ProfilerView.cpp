@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+    This file contains the editor's stage timing table
+
+  ==============================================================================
+*/
+
+#include "ProfilerView.h"
+
+//==============================================================================
+ProfilerView::ProfilerView(StageProfiler& profiler)
+    : m_profiler(profiler)
+{
+    setOpaque(true);
+    startTimerHz(refreshRateHz);
+}
+
+ProfilerView::~ProfilerView()
+{
+    stopTimer();
+}
+
+//==============================================================================
+void ProfilerView::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colours::black);
+    g.setColour(juce::Colours::white);
+
+    auto area = getLocalBounds().reduced(4);
+    const int rowHeight = area.getHeight() / (StageProfiler::numStages + 2);
+
+    // Name, then four right aligned columns
+    auto drawRow = [&](const juce::String& name, const juce::String& min, const juce::String& mean, const juce::String& p99, const juce::String& max)
+    {
+        auto row = area.removeFromTop(rowHeight);
+        g.drawText(name, row.removeFromLeft(row.getWidth() / 3), juce::Justification::centredLeft);
+
+        const int columnWidth = row.getWidth() / 4;
+        for (auto* value : { &min, &mean, &p99, &max })
+            g.drawText(*value, row.removeFromLeft(columnWidth), juce::Justification::centredRight);
+    };
+
+    drawRow("us per block", "min", "mean", "p99", "max");
+
+    for (int stage = 0; stage < StageProfiler::numStages; ++stage)
+    {
+        const auto& statistics = m_statistics[stage];
+        drawRow(StageProfiler::getStageName(stage), juce::String(statistics.min, 1), juce::String(statistics.mean, 1),
+                juce::String(statistics.p99, 1), juce::String(statistics.max, 1));
+    }
+
+    g.drawText(juce::String(m_statistics[StageProfiler::wholeBlock].numBlocks) + " blocks, " + juce::String((juce::int64)m_numDropped) + " dropped",
+               area.removeFromTop(rowHeight), juce::Justification::centredLeft);
+}
+
+void ProfilerView::timerCallback()
+{
+    m_profiler.collect();
+
+    for (int stage = 0; stage < StageProfiler::numStages; ++stage)
+        m_statistics[stage] = m_profiler.getStatistics(stage);
+
+    m_numDropped = m_profiler.getNumDropped();
+    repaint();
+}
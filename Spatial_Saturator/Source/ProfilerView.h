@@ -0,0 +1,44 @@
+/*
+  ==============================================================================
+
+    This file contains the editor's stage timing table
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SpatialSaturatorProfiler.h"
+
+//==============================================================================
+/**
+    The engine's stage timings as a table: min, mean, 99th percentile and max
+    of each stage in microseconds per block, over the last
+    StageProfiler::historyLength blocks, with the number of blocks dropped
+    because the editor fell behind. The editor only has one in builds with
+    SPATIAL_SATURATOR_PROFILING.
+
+    The timer is the profiler's reader: it collects what the audio thread
+    pushed and repaints.
+*/
+class ProfilerView : public juce::Component, private juce::Timer
+{
+public:
+    explicit ProfilerView(StageProfiler& profiler);
+    ~ProfilerView() override;
+
+    void paint(juce::Graphics&) override;
+
+private:
+    enum { refreshRateHz = 5 };
+
+    void timerCallback() override;
+
+    StageProfiler& m_profiler;
+
+    StageProfiler::Statistics m_statistics[StageProfiler::numStages];
+    std::uint64_t m_numDropped = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ProfilerView)
+};
@@ -0,0 +1,317 @@
+/*
+  ==============================================================================
+
+    This file contains the C API of the Spatial Saturator DSP core
+
+  ==============================================================================
+*/
+
+#include "SpatialSaturatorCAPI.h"
+#include "SpatialSaturatorEngine.h"
+#include "SpatialSaturatorMultiStream.h"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <new>
+
+struct SpatialSaturator
+{
+    SpatialSaturatorEngine engine;
+    int maxBlockSize = 0;
+};
+
+struct SpatialSaturatorBatch
+{
+    MultiStreamEngine engine;
+    int maxBlockSize = 0;
+
+    // Channel pointers advanced into a long block
+    std::vector<float*> left, right;
+};
+
+//==============================================================================
+static SpatialSaturatorParameters toCParameters(const SpatialSaturatorEngine::Parameters& p)
+{
+    SpatialSaturatorParameters c;
+
+    c.midGain = p.midGain;
+    c.midFreq = p.midFreq;
+    c.sideGain = p.sideGain;
+    c.sideFreqLower = p.sideFreqLower;
+    c.sideFreqUpper = p.sideFreqUpper;
+    c.makeUpGain = p.makeUpGain;
+    c.filterMode = (int)p.filterMode;
+
+    c.tanhAmplitude = p.tanhAmplitude;
+    c.tanhSlope = p.tanhSlope;
+    c.saturatorMix = p.saturatorMix;
+    c.sinAmplitude = p.sinAmplitude;
+    c.sinFrequency = p.sinFrequency;
+
+    c.numBands = p.numBands;
+
+    for (int i = 0; i < Waveshaper::maxBands - 1; ++i)
+        c.crossoverFrequencies[i] = p.crossoverFrequencies[i];
+
+    for (int band = 0; band < Waveshaper::maxBands; ++band)
+    {
+        c.bandDrives[band] = p.bandDrives[band];
+        c.bandMixes[band] = p.bandMixes[band];
+    }
+
+    c.oversampling = p.oversamplingFactorLog2;
+    c.oversamplingPhase = (int)p.oversamplingPhase;
+    c.quality = (int)p.quality;
+    c.antiAliasing = (int)p.antiAliasing;
+
+    c.limiterEnabled = p.limiterEnabled ? 1 : 0;
+    c.limiterCeiling = p.limiterCeiling;
+    c.limiterLookahead = p.limiterLookahead;
+    c.limiterRelease = p.limiterRelease;
+
+    return c;
+}
+
+// Clamps value to [low, high], or gives fallback if it is NaN or infinite,
+// which std::clamp would pass through
+static float clampFinite(float value, float low, float high, float fallback)
+{
+    return std::isfinite(value) ? std::clamp(value, low, high) : fallback;
+}
+
+// Clamps to the plug-in's parameter ranges; non-finite values keep the defaults
+static SpatialSaturatorEngine::Parameters toEngineParameters(const SpatialSaturatorParameters& c)
+{
+    SpatialSaturatorEngine::Parameters p;
+
+    p.midGain = clampFinite(c.midGain, 0.0f, 12.0f, p.midGain);
+    p.midFreq = clampFinite(c.midFreq, 20.0f, 1000.0f, p.midFreq);
+    p.sideGain = clampFinite(c.sideGain, 0.0f, 12.0f, p.sideGain);
+    p.sideFreqLower = clampFinite(c.sideFreqLower, 20.0f, 20000.0f, p.sideFreqLower);
+    p.sideFreqUpper = clampFinite(c.sideFreqUpper, 1000.0f, 20000.0f, p.sideFreqUpper);
+    p.makeUpGain = clampFinite(c.makeUpGain, -12.0f, 12.0f, p.makeUpGain);
+    p.filterMode = (SpatialSaturatorEngine::FilterMode)std::clamp(c.filterMode, 0, 2);
+
+    p.tanhAmplitude = clampFinite(c.tanhAmplitude, 0.5f, 100.0f, p.tanhAmplitude);
+    p.tanhSlope = clampFinite(c.tanhSlope, 1.0f, 15.0f, p.tanhSlope);
+    p.saturatorMix = clampFinite(c.saturatorMix, 1.0f, 100.0f, p.saturatorMix);
+    p.sinAmplitude = clampFinite(c.sinAmplitude, 0.5f, 100.0f, p.sinAmplitude);
+    p.sinFrequency = clampFinite(c.sinFrequency, 0.5f, 100.0f, p.sinFrequency);
+
+    p.numBands = std::clamp(c.numBands, 1, (int)Waveshaper::maxBands);
+
+    for (int i = 0; i < Waveshaper::maxBands - 1; ++i)
+        p.crossoverFrequencies[i] = clampFinite(c.crossoverFrequencies[i], 20.0f, 20000.0f, p.crossoverFrequencies[i]);
+
+    for (int band = 0; band < Waveshaper::maxBands; ++band)
+    {
+        p.bandDrives[band] = clampFinite(c.bandDrives[band], 0.0f, 24.0f, p.bandDrives[band]);
+        p.bandMixes[band] = clampFinite(c.bandMixes[band], 0.0f, 100.0f, p.bandMixes[band]);
+    }
+
+    p.oversamplingFactorLog2 = std::clamp(c.oversampling, 0, 3);
+    p.oversamplingPhase = (Oversampler::Phase)std::clamp(c.oversamplingPhase, 0, 1);
+    p.quality = (FastMath::Precision)std::clamp(c.quality, 0, 2);
+    p.antiAliasing = (Waveshaper::AntiAliasing)std::clamp(c.antiAliasing, 0, 2);
+
+    p.limiterEnabled = c.limiterEnabled != 0;
+    p.limiterCeiling = clampFinite(c.limiterCeiling, -12.0f, 0.0f, p.limiterCeiling);
+    p.limiterLookahead = clampFinite(c.limiterLookahead, 0.5f, (float)Limiter::maxLookaheadMs, p.limiterLookahead);
+    p.limiterRelease = clampFinite(c.limiterRelease, 1.0f, 1000.0f, p.limiterRelease);
+
+    return p;
+}
+
+static SpatialSaturatorMeters toCMeters(const LoudnessMeter::Readings& readings)
+{
+    SpatialSaturatorMeters c;
+
+    for (int channel = 0; channel < LoudnessMeter::numChannels; ++channel)
+    {
+        c.momentaryLoudness[channel] = readings.momentary[channel];
+        c.shortTermLoudness[channel] = readings.shortTerm[channel];
+        c.rms[channel] = readings.rms[channel];
+        c.truePeak[channel] = readings.truePeak[channel];
+    }
+
+    c.momentaryLoudnessStereo = readings.momentaryStereo;
+    c.shortTermLoudnessStereo = readings.shortTermStereo;
+
+    return c;
+}
+
+//==============================================================================
+SpatialSaturator* spatial_saturator_create(double sampleRate, int maxBlockSize)
+{
+    if (!(sampleRate > 0.0) || maxBlockSize <= 0)
+        return nullptr;
+
+    try
+    {
+        std::unique_ptr<SpatialSaturator> saturator(new SpatialSaturator());
+        saturator->maxBlockSize = maxBlockSize;
+        saturator->engine.prepare(sampleRate, maxBlockSize);
+
+        // The same tables the plug-in builds for its parameter ranges
+        saturator->engine.setCoefficientTables(CoefficientTables::getShared((float)sampleRate, 20.0f, 20000.0f, 1.0f, 0.0f, 12.0f, 0.5f));
+        return saturator.release();
+    }
+    catch (const std::bad_alloc&)
+    {
+        return nullptr;
+    }
+}
+
+void spatial_saturator_destroy(SpatialSaturator* saturator)
+{
+    delete saturator;
+}
+
+void spatial_saturator_default_parameters(SpatialSaturatorParameters* parameters)
+{
+    *parameters = toCParameters(SpatialSaturatorEngine::Parameters());
+}
+
+void spatial_saturator_set_parameters(SpatialSaturator* saturator, const SpatialSaturatorParameters* parameters)
+{
+    saturator->engine.setParameters(toEngineParameters(*parameters));
+}
+
+void spatial_saturator_get_parameters(const SpatialSaturator* saturator, SpatialSaturatorParameters* parameters)
+{
+    *parameters = toCParameters(saturator->engine.getParameters());
+}
+
+void spatial_saturator_reset(SpatialSaturator* saturator)
+{
+    saturator->engine.reset();
+}
+
+int spatial_saturator_get_latency(const SpatialSaturator* saturator)
+{
+    return saturator->engine.getLatencyInSamples();
+}
+
+int spatial_saturator_get_tail_length(const SpatialSaturator* saturator)
+{
+    return saturator->engine.getTailLengthInSamples();
+}
+
+void spatial_saturator_process(SpatialSaturator* saturator, float* left, float* right, int numSamples)
+{
+    // Longer blocks are split rather than overrunning the prepared buffers
+    for (int start = 0; start < numSamples; start += saturator->maxBlockSize)
+    {
+        const int chunk = std::min(saturator->maxBlockSize, numSamples - start);
+        saturator->engine.process(left + start, right + start, chunk);
+    }
+}
+
+void spatial_saturator_process_mono(SpatialSaturator* saturator, float* samples, int numSamples)
+{
+    for (int start = 0; start < numSamples; start += saturator->maxBlockSize)
+    {
+        const int chunk = std::min(saturator->maxBlockSize, numSamples - start);
+        saturator->engine.processMono(samples + start, chunk);
+    }
+}
+
+void spatial_saturator_set_metering(SpatialSaturator* saturator, int enabled)
+{
+    saturator->engine.setMeteringEnabled(enabled != 0);
+}
+
+void spatial_saturator_get_meters(const SpatialSaturator* saturator, SpatialSaturatorMeters* input, SpatialSaturatorMeters* output)
+{
+    if (input != nullptr)
+        *input = toCMeters(saturator->engine.getInputMeter().getReadings());
+
+    if (output != nullptr)
+        *output = toCMeters(saturator->engine.getOutputMeter().getReadings());
+}
+
+//==============================================================================
+SpatialSaturatorBatch* spatial_saturator_batch_create(double sampleRate, int maxBlockSize, int numStreams)
+{
+    if (!(sampleRate > 0.0) || maxBlockSize <= 0 || numStreams <= 0)
+        return nullptr;
+
+    try
+    {
+        std::unique_ptr<SpatialSaturatorBatch> batch(new SpatialSaturatorBatch());
+        batch->maxBlockSize = maxBlockSize;
+        batch->left.resize((size_t)numStreams);
+        batch->right.resize((size_t)numStreams);
+        batch->engine.prepare(sampleRate, maxBlockSize, numStreams);
+        batch->engine.setCoefficientTables(CoefficientTables::getShared((float)sampleRate, 20.0f, 20000.0f, 1.0f, 0.0f, 12.0f, 0.5f));
+        return batch.release();
+    }
+    catch (const std::bad_alloc&)
+    {
+        return nullptr;
+    }
+}
+
+void spatial_saturator_batch_destroy(SpatialSaturatorBatch* batch)
+{
+    delete batch;
+}
+
+static bool isValidStream(const SpatialSaturatorBatch* batch, int stream)
+{
+    return stream >= 0 && stream < batch->engine.getNumStreams();
+}
+
+int spatial_saturator_batch_set_parameters(SpatialSaturatorBatch* batch, int stream, const SpatialSaturatorParameters* parameters)
+{
+    if (!isValidStream(batch, stream))
+        return -1;
+
+    batch->engine.setParameters(stream, toEngineParameters(*parameters));
+    return 0;
+}
+
+int spatial_saturator_batch_get_parameters(const SpatialSaturatorBatch* batch, int stream, SpatialSaturatorParameters* parameters)
+{
+    if (!isValidStream(batch, stream))
+        return -1;
+
+    *parameters = toCParameters(batch->engine.getParameters(stream));
+    return 0;
+}
+
+void spatial_saturator_batch_reset(SpatialSaturatorBatch* batch)
+{
+    batch->engine.reset();
+}
+
+int spatial_saturator_batch_get_latency(const SpatialSaturatorBatch* batch, int stream)
+{
+    if (!isValidStream(batch, stream))
+        return -1;
+
+    return batch->engine.getLatencyInSamples(stream);
+}
+
+void spatial_saturator_batch_process(SpatialSaturatorBatch* batch, float* const* left, float* const* right, int numSamples)
+{
+    if (numSamples <= batch->maxBlockSize)
+    {
+        batch->engine.process(left, right, numSamples);
+        return;
+    }
+
+    // Longer blocks are split rather than overrunning the prepared buffers
+    const int numStreams = batch->engine.getNumStreams();
+
+    for (int start = 0; start < numSamples; start += batch->maxBlockSize)
+    {
+        for (int stream = 0; stream < numStreams; ++stream)
+        {
+            batch->left[(size_t)stream] = left[stream] + start;
+            batch->right[(size_t)stream] = right[stream] != nullptr ? right[stream] + start : nullptr;
+        }
+
+        batch->engine.process(batch->left.data(), batch->right.data(), std::min(batch->maxBlockSize, numSamples - start));
+    }
+}
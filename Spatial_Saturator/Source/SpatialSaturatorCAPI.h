@@ -0,0 +1,153 @@
+/*
+  ==============================================================================
+
+    This file contains the C API of the Spatial Saturator DSP core, for
+    embedding the chain without JUCE or a plug-in host.
+
+        SpatialSaturator* s = spatial_saturator_create(48000.0, 512);
+
+        SpatialSaturatorParameters p;
+        spatial_saturator_default_parameters(&p);
+        p.midGain = 4.5f;
+        spatial_saturator_set_parameters(s, &p);
+
+        spatial_saturator_process(s, left, right, numSamples);
+        spatial_saturator_destroy(s);
+
+    The batch functions run many independent stereo streams in one call, with
+    the filters of several streams packed into each SIMD register:
+
+        SpatialSaturatorBatch* b = spatial_saturator_batch_create(48000.0, 512, 16);
+        spatial_saturator_batch_set_parameters(b, stream, &p);
+        spatial_saturator_batch_process(b, lefts, rights, numSamples);
+
+    Batch streams always run the biquad filters, whatever filterMode says.
+
+    All calls on one instance must come from one thread at a time, except
+    spatial_saturator_get_meters, which any thread can call at any time. Apart
+    from create and destroy, every call is realtime safe.
+
+  ==============================================================================
+*/
+#ifndef __SpatialSaturatorCAPI__SpatialSaturatorCAPI__
+#define __SpatialSaturatorCAPI__SpatialSaturatorCAPI__
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct SpatialSaturator SpatialSaturator;
+
+/* Raw parameter values, as shown by the plug-in */
+typedef struct SpatialSaturatorParameters
+{
+    float midGain;              /* dB, 0 .. 12 */
+    float midFreq;              /* Hz, 20 .. 1000 */
+    float sideGain;             /* dB, 0 .. 12 */
+    float sideFreqLower;        /* Hz, 20 .. 20000 */
+    float sideFreqUpper;        /* Hz, 1000 .. 20000 */
+    float makeUpGain;           /* dB, -12 .. 12 */
+    int filterMode;             /* 0 biquad, 1 linear phase, 2 SVF */
+
+    float tanhAmplitude;        /* %, 0.5 .. 100 */
+    float tanhSlope;            /* 1 .. 15 */
+    float saturatorMix;         /* %, 1 .. 100 */
+    float sinAmplitude;         /* %, 0.5 .. 100 */
+    float sinFrequency;         /* 0.5 .. 100 */
+
+    int numBands;               /* 1 .. 4, 1 saturates the full band */
+    float crossoverFrequencies[3];  /* Hz, 20 .. 20000, between bands 1-2, 2-3, 3-4 */
+    float bandDrives[4];        /* dB, 0 .. 24 */
+    float bandMixes[4];         /* %, 0 .. 100 of saturatorMix */
+
+    int oversampling;           /* 0, 1, 2, 3 for 1x, 2x, 4x, 8x */
+    int oversamplingPhase;      /* 0 minimum phase, 1 linear phase */
+    int quality;                /* 0 draft, 1 high, 2 full */
+    int antiAliasing;           /* 0 oversampling, 1 ADAA 1st order, 2 ADAA 2nd order */
+
+    int limiterEnabled;         /* 0 or 1 */
+    float limiterCeiling;       /* dBTP, -12 .. 0 */
+    float limiterLookahead;     /* ms, 0.5 .. 10 */
+    float limiterRelease;       /* ms, 1 .. 1000 */
+} SpatialSaturatorParameters;
+
+/* Returns null if the arguments are out of range or allocation fails.
+   maxBlockSize is the most samples processed at once; process calls given
+   more are split into blocks of maxBlockSize. */
+SpatialSaturator* spatial_saturator_create(double sampleRate, int maxBlockSize);
+void spatial_saturator_destroy(SpatialSaturator* saturator);
+
+/* Fills in the plug-in's default settings */
+void spatial_saturator_default_parameters(SpatialSaturatorParameters* parameters);
+
+/* Out of range values are clamped; NaN and infinite values give the defaults */
+void spatial_saturator_set_parameters(SpatialSaturator* saturator, const SpatialSaturatorParameters* parameters);
+void spatial_saturator_get_parameters(const SpatialSaturator* saturator, SpatialSaturatorParameters* parameters);
+
+/* Clears all filter, oversampling and look-ahead state */
+void spatial_saturator_reset(SpatialSaturator* saturator);
+
+/* Delay of the output against the input, in samples, for the current parameters */
+int spatial_saturator_get_latency(const SpatialSaturator* saturator);
+
+/* Samples the output keeps sounding after the input stops, for the current
+   parameters. Silent input sleeps once this has passed (see the engine) */
+int spatial_saturator_get_tail_length(const SpatialSaturator* saturator);
+
+/* Processes a stereo block of any length in place. Blocks with equal
+   channels run one channel once the side has rung out (see the engine) */
+void spatial_saturator_process(SpatialSaturator* saturator, float* left, float* right, int numSamples);
+
+/* Processes a mono block in place, as stereo with both sides equal */
+void spatial_saturator_process_mono(SpatialSaturator* saturator, float* samples, int numSamples);
+
+/* Metering ---------------------------------------------------------------- */
+
+/* BS.1770 readings, per channel in the order left, right, mid, side.
+   Silence reads -120. */
+typedef struct SpatialSaturatorMeters
+{
+    float momentaryLoudness[4];     /* LUFS, 400ms */
+    float shortTermLoudness[4];     /* LUFS, 3s */
+    float rms[4];                   /* dB, over 400ms */
+    float truePeak[4];              /* dBTP, highest over 3s */
+    float momentaryLoudnessStereo;  /* LUFS, left and right together */
+    float shortTermLoudnessStereo;  /* LUFS */
+} SpatialSaturatorMeters;
+
+/* Off by default; the input and output meters together cost more than the
+   biquad filters, less than the limiter */
+void spatial_saturator_set_metering(SpatialSaturator* saturator, int enabled);
+
+/* Latest input and output readings, either may be null */
+void spatial_saturator_get_meters(const SpatialSaturator* saturator, SpatialSaturatorMeters* input, SpatialSaturatorMeters* output);
+
+/* Many streams ------------------------------------------------------------ */
+
+typedef struct SpatialSaturatorBatch SpatialSaturatorBatch;
+
+/* Every stream starts with the default parameters */
+SpatialSaturatorBatch* spatial_saturator_batch_create(double sampleRate, int maxBlockSize, int numStreams);
+void spatial_saturator_batch_destroy(SpatialSaturatorBatch* batch);
+
+/* Return 0, or -1 (and do nothing) if stream is not in 0 .. numStreams - 1 */
+int spatial_saturator_batch_set_parameters(SpatialSaturatorBatch* batch, int stream, const SpatialSaturatorParameters* parameters);
+int spatial_saturator_batch_get_parameters(const SpatialSaturatorBatch* batch, int stream, SpatialSaturatorParameters* parameters);
+
+void spatial_saturator_batch_reset(SpatialSaturatorBatch* batch);
+
+/* -1 if stream is out of range */
+int spatial_saturator_batch_get_latency(const SpatialSaturatorBatch* batch, int stream);
+
+/* left[stream] and right[stream] for each of the numStreams streams, processed
+   in place; a null right[stream] makes that stream mid-only, one channel.
+   Blocks longer than maxBlockSize are split as for a single stream */
+void spatial_saturator_batch_process(SpatialSaturatorBatch* batch, float* const* left, float* const* right, int numSamples);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,176 @@
+/*
+  ==============================================================================
+
+    This file contains the band-parallel Linkwitz-Riley crossover
+
+  ==============================================================================
+*/
+
+#include "SpatialSaturatorCrossover.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+//==============================================================================
+void LinkwitzRileyCrossover::prepare(int numChannels)
+{
+    m_states.resize((size_t)numChannels);
+
+    // Forces the next setParameters() to compute the coefficients
+    m_sampleRate = 0.0f;
+
+    reset();
+}
+
+void LinkwitzRileyCrossover::reset()
+{
+    for (auto& state : m_states)
+        state = State();
+}
+
+void LinkwitzRileyCrossover::setBiquad(int biquad, int lane, const BiquadCoefficients& coefficients)
+{
+    m_coefficients.b0[biquad][lane] = coefficients.b0;
+    m_coefficients.b1[biquad][lane] = coefficients.b1;
+    m_coefficients.b2[biquad][lane] = coefficients.b2;
+    m_coefficients.a1[biquad][lane] = coefficients.a1;
+    m_coefficients.a2[biquad][lane] = coefficients.a2;
+
+    m_decayLength[biquad][lane] = getDecayLength(coefficients.a1, coefficients.a2);
+}
+
+int LinkwitzRileyCrossover::getTailLengthInSamples() const
+{
+    double longest = 0.0;
+
+    for (int lane = 0; lane < m_numBands; ++lane)
+    {
+        double length = 0.0;
+
+        for (int biquad = 0; biquad < numBiquads; ++biquad)
+            length += m_decayLength[biquad][lane];
+
+        longest = std::max(longest, length);
+    }
+
+    return (int)std::min(std::ceil(longest), (double)std::numeric_limits<int>::max());
+}
+
+void LinkwitzRileyCrossover::setParameters(float sampleRate, int numBands, const float* frequencies)
+{
+    numBands = std::clamp(numBands, 1, (int)maxBands);
+
+    // Ascending, and clear of Nyquist so the bilinear transform holds up
+    float sorted[maxBands - 1] = {};
+    float lowest = 10.0f;
+
+    for (int i = 0; i < numBands - 1; ++i)
+    {
+        sorted[i] = std::clamp(frequencies[i], lowest, 0.45f * sampleRate);
+        lowest = sorted[i];
+    }
+
+    if (sampleRate == m_sampleRate && numBands == m_numBands && std::equal(sorted, sorted + maxBands - 1, m_frequencies))
+        return;
+
+    // Fewer bands on the same state would leave stale lanes behind
+    if (numBands != m_numBands)
+        reset();
+
+    m_sampleRate = sampleRate;
+    m_numBands = numBands;
+    std::copy(sorted, sorted + maxBands - 1, m_frequencies);
+
+    const BiquadCoefficients passThrough;
+    BiquadCoefficients silence;
+    silence.b0 = 0.0;
+
+    for (int lane = 0; lane < maxBands; ++lane)
+    {
+        for (int stage = 0; stage < maxBands - 1; ++stage)
+        {
+            const int first = 2 * stage, second = 2 * stage + 1;
+
+            if (lane >= numBands)
+            {
+                setBiquad(first, lane, stage == 0 ? silence : passThrough);
+                setBiquad(second, lane, passThrough);
+            }
+            else if (stage >= numBands - 1)
+            {
+                setBiquad(first, lane, passThrough);
+                setBiquad(second, lane, passThrough);
+            }
+            else if (lane == stage)
+            {
+                const auto lowPass = makeLowPass(m_frequencies[stage], sampleRate);
+                setBiquad(first, lane, lowPass);
+                setBiquad(second, lane, lowPass);
+            }
+            else if (lane > stage)
+            {
+                const auto highPass = makeHighPass(m_frequencies[stage], sampleRate);
+                setBiquad(first, lane, highPass);
+                setBiquad(second, lane, highPass);
+            }
+            else
+            {
+                setBiquad(first, lane, makeAllPass(m_frequencies[stage], sampleRate));
+                setBiquad(second, lane, passThrough);
+            }
+        }
+    }
+}
+
+//==============================================================================
+template <typename SampleType>
+void LinkwitzRileyCrossover::process(int channel, const SampleType* input, SampleType* const* bands, int numSamples)
+{
+    using namespace SIMD;
+
+    auto& state = m_states[(size_t)channel];
+
+    // Coefficients and states live in registers for the whole block
+    double4 b0[numBiquads], b1[numBiquads], b2[numBiquads], a1[numBiquads], a2[numBiquads];
+    double4 z1[numBiquads], z2[numBiquads];
+
+    for (int biquad = 0; biquad < numBiquads; ++biquad)
+    {
+        b0[biquad] = load4(m_coefficients.b0[biquad]);
+        b1[biquad] = load4(m_coefficients.b1[biquad]);
+        b2[biquad] = load4(m_coefficients.b2[biquad]);
+        a1[biquad] = load4(m_coefficients.a1[biquad]);
+        a2[biquad] = load4(m_coefficients.a2[biquad]);
+        z1[biquad] = load4(state.z1[biquad]);
+        z2[biquad] = load4(state.z2[biquad]);
+    }
+
+    alignas(32) double output[maxBands];
+
+    for (int n = 0; n < numSamples; ++n)
+    {
+        double4 x = set4((double)input[n]);
+
+        for (int biquad = 0; biquad < numBiquads; ++biquad)
+        {
+            double4 y = add(mul(x, b0[biquad]), z1[biquad]);
+            z1[biquad] = sub(add(z2[biquad], mul(x, b1[biquad])), mul(y, a1[biquad]));
+            z2[biquad] = sub(mul(x, b2[biquad]), mul(y, a2[biquad]));
+            x = y;
+        }
+
+        store(output, x);
+
+        for (int band = 0; band < m_numBands; ++band)
+            bands[band][n] = (SampleType)output[band];
+    }
+
+    for (int biquad = 0; biquad < numBiquads; ++biquad)
+    {
+        store(state.z1[biquad], z1[biquad]);
+        store(state.z2[biquad], z2[biquad]);
+    }
+}
+
+template void LinkwitzRileyCrossover::process<float>(int, const float*, float* const*, int);
+template void LinkwitzRileyCrossover::process<double>(int, const double*, double* const*, int);
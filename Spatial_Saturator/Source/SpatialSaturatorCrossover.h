@@ -0,0 +1,93 @@
+/*
+  ==============================================================================
+
+    This file contains the Linkwitz-Riley crossover that splits the saturator
+    input into up to four bands, all bands side by side in SIMD lanes
+
+  ==============================================================================
+*/
+#ifndef __SpatialSaturatorCrossover__SpatialSaturatorCrossover__
+#define __SpatialSaturatorCrossover__SpatialSaturatorCrossover__
+
+#pragma once
+
+#include "SpatialSaturatorFilter.h"
+#include <vector>
+
+//==============================================================================
+/**
+    4th order Linkwitz-Riley crossover tree, computed band-parallel. Each band
+    is its own cascade from the input, one band per SIMD lane:
+
+        band 1: [ low pass f1  | all pass f2  | all pass f3 ]
+        band 2: [ high pass f1 | low pass f2  | all pass f3 ]
+        band 3: [ high pass f1 | high pass f2 | low pass f3 ]
+        band 4: [ high pass f1 | high pass f2 | high pass f3 ]
+
+    Every stage is two biquads (the all pass is one, plus a pass-through), so
+    the whole split is six four-lane biquads per sample whatever the number of
+    bands. The all passes line the lower bands up with the phase of the upper
+    ones, so the bands sum to a flat all pass. With fewer bands the unused
+    stages pass through and the unused lanes stay silent.
+
+    Biquads run in double, so crossovers far below the oversampled rate stay
+    clean.
+*/
+class LinkwitzRileyCrossover
+{
+public:
+    enum
+    {
+        maxBands = 4,
+        numBiquads = 2 * (maxBands - 1)
+    };
+
+    void prepare(int numChannels);
+    void reset();
+
+    // Gives channel to the filter states of channel from
+    void copyChannelState(int from, int to) { m_states[(size_t)to] = m_states[(size_t)from]; }
+
+    // numBands - 1 frequencies, kept ascending and under Nyquist. Only
+    // recomputes the coefficients when something changed
+    void setParameters(float sampleRate, int numBands, const float* frequencies);
+    int getNumBands() const { return m_numBands; }
+
+    // Samples the slowest band rings on after the input stops
+    int getTailLengthInSamples() const;
+
+    // Splits one channel into bands[band][n] for each of getNumBands() bands
+    template <typename SampleType>
+    void process(int channel, const SampleType* input, SampleType* const* bands, int numSamples);
+
+private:
+    // Biquad [biquad][lane]
+    struct Coefficients
+    {
+        alignas(32) double b0[numBiquads][maxBands];
+        alignas(32) double b1[numBiquads][maxBands];
+        alignas(32) double b2[numBiquads][maxBands];
+        alignas(32) double a1[numBiquads][maxBands];
+        alignas(32) double a2[numBiquads][maxBands];
+    };
+
+    struct State
+    {
+        alignas(32) double z1[numBiquads][maxBands];
+        alignas(32) double z2[numBiquads][maxBands];
+    };
+
+    void setBiquad(int biquad, int lane, const BiquadCoefficients& coefficients);
+
+    Coefficients m_coefficients {};
+
+    // getDecayLength() of each biquad, [biquad][lane]
+    double m_decayLength[numBiquads][maxBands] = {};
+    std::vector<State> m_states;
+
+    float m_sampleRate = 0.0f;
+    int m_numBands = 1;
+    float m_frequencies[maxBands - 1] = {};
+};
+
+#endif
@@ -0,0 +1,584 @@
+/*
+  ==============================================================================
+
+    This file contains the complete Spatial Saturator processing chain
+
+  ==============================================================================
+*/
+
+#include "SpatialSaturatorEngine.h"
+#include "SpatialSaturatorSIMD.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Input below this is treated as silence: the float denormal floor
+static const double silenceFloor = 1.17549435e-38;
+
+//==============================================================================
+// Peak of both channels, four floats or two doubles at a time
+static double getPeak(const float* left, const float* right, int numSamples)
+{
+    using namespace SIMD;
+
+    const float4 zero = set(0.0f);
+    float4 peak = zero;
+    int n = 0;
+
+    for (; n + 4 <= numSamples; n += 4)
+    {
+        const float4 l = load(left + n), r = load(right + n);
+        peak = max(peak, max(max(l, sub(zero, l)), max(r, sub(zero, r))));
+    }
+
+    alignas(16) float lanes[4];
+    store(lanes, peak);
+
+    float result = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+
+    for (; n < numSamples; ++n)
+        result = std::max(result, std::max(std::abs(left[n]), std::abs(right[n])));
+
+    return (double)result;
+}
+
+static double getPeak(const double* left, const double* right, int numSamples)
+{
+    using namespace SIMD;
+
+    const double2 zero = set(0.0, 0.0);
+    double2 peak = zero;
+    int n = 0;
+
+    for (; n + 2 <= numSamples; n += 2)
+    {
+        const double2 l = loadUnaligned(left + n), r = loadUnaligned(right + n);
+        peak = max(peak, max(max(l, sub(zero, l)), max(r, sub(zero, r))));
+    }
+
+    double result = std::max(getLane0(peak), getLane1(peak));
+
+    for (; n < numSamples; ++n)
+        result = std::max(result, std::max(std::abs(left[n]), std::abs(right[n])));
+
+    return result;
+}
+
+// Peak of the difference of the channels, twice the side
+static double getSidePeak(const float* left, const float* right, int numSamples)
+{
+    using namespace SIMD;
+
+    const float4 zero = set(0.0f);
+    float4 peak = zero;
+    int n = 0;
+
+    for (; n + 4 <= numSamples; n += 4)
+    {
+        const float4 difference = sub(load(left + n), load(right + n));
+        peak = max(peak, max(difference, sub(zero, difference)));
+    }
+
+    alignas(16) float lanes[4];
+    store(lanes, peak);
+
+    float result = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+
+    for (; n < numSamples; ++n)
+        result = std::max(result, std::abs(left[n] - right[n]));
+
+    return (double)result;
+}
+
+static double getSidePeak(const double* left, const double* right, int numSamples)
+{
+    using namespace SIMD;
+
+    const double2 zero = set(0.0, 0.0);
+    double2 peak = zero;
+    int n = 0;
+
+    for (; n + 2 <= numSamples; n += 2)
+    {
+        const double2 difference = sub(loadUnaligned(left + n), loadUnaligned(right + n));
+        peak = max(peak, max(difference, sub(zero, difference)));
+    }
+
+    double result = std::max(getLane0(peak), getLane1(peak));
+
+    for (; n < numSamples; ++n)
+        result = std::max(result, std::abs(left[n] - right[n]));
+
+    return result;
+}
+
+//==============================================================================
+bool SpatialSaturatorEngine::Parameters::operator== (const Parameters& other) const
+{
+    return midGain == other.midGain && midFreq == other.midFreq && sideGain == other.sideGain
+        && sideFreqLower == other.sideFreqLower && sideFreqUpper == other.sideFreqUpper
+        && makeUpGain == other.makeUpGain && filterMode == other.filterMode
+        && tanhAmplitude == other.tanhAmplitude && tanhSlope == other.tanhSlope && saturatorMix == other.saturatorMix
+        && sinAmplitude == other.sinAmplitude && sinFrequency == other.sinFrequency
+        && numBands == other.numBands
+        && std::equal(crossoverFrequencies, crossoverFrequencies + Waveshaper::maxBands - 1, other.crossoverFrequencies)
+        && std::equal(bandDrives, bandDrives + Waveshaper::maxBands, other.bandDrives)
+        && std::equal(bandMixes, bandMixes + Waveshaper::maxBands, other.bandMixes)
+        && oversamplingFactorLog2 == other.oversamplingFactorLog2 && oversamplingPhase == other.oversamplingPhase
+        && quality == other.quality && antiAliasing == other.antiAliasing
+        && limiterEnabled == other.limiterEnabled && limiterCeiling == other.limiterCeiling
+        && limiterLookahead == other.limiterLookahead && limiterRelease == other.limiterRelease;
+}
+
+void SpatialSaturatorEngine::prepare(double sampleRate, int maxBlockSize)
+{
+    m_filterChain.setSampleRate(static_cast<float>(sampleRate));
+    m_svfChain.setSampleRate(static_cast<float>(sampleRate));
+
+    // Only allocated and given its first kernel here if it is to run; later
+    // kernels, or the first one when the mode is chosen later, come from the design worker
+    m_linearPhaseFilter.prepare(static_cast<float>(sampleRate), m_parameters.midFreq, m_parameters.midGain,
+                                m_parameters.sideFreqLower, m_parameters.sideFreqUpper, m_parameters.sideGain,
+                                m_parameters.filterMode == linearPhaseFilters);
+
+    // Preallocate every oversampling stage, so the factor can change while playing
+    m_waveshaper.prepare(sampleRate, 2, maxBlockSize);
+
+    // Buffers for the longest look-ahead, so it can change while playing
+    m_limiter.prepare(sampleRate, 2, maxBlockSize);
+
+    m_inputMeter.prepare(sampleRate);
+    m_outputMeter.prepare(sampleRate);
+
+    for (auto& ramp : m_ramps)
+        ramp.setRampLength((int)std::lround(rampLengthMs * 0.001 * sampleRate));
+
+    setParameters(m_parameters);
+    reset();
+}
+
+void SpatialSaturatorEngine::reset()
+{
+    // Nothing is playing, so parameters can jump to where they are headed
+    jumpRampsToTargets();
+    m_snapParameters = true;
+
+    m_sleeping = false;
+    m_silentSamples = 0;
+
+    m_processingMono = false;
+    m_nullSideSamples = 0;
+
+    m_filterChain.reset();
+    m_svfChain.reset();
+    m_linearPhaseFilter.reset();
+    m_waveshaper.reset();
+    m_limiter.reset();
+
+    m_inputMeter.reset();
+    m_outputMeter.reset();
+}
+
+void SpatialSaturatorEngine::setCoefficientTables(std::shared_ptr<const CoefficientTables> tables)
+{
+    m_svfChain.setCoefficientTables(tables);
+    m_filterChain.setCoefficientTables(std::move(tables));
+}
+
+void SpatialSaturatorEngine::setParameters(const Parameters& parameters)
+{
+    const bool filterModeChanged = parameters.filterMode != m_parameters.filterMode;
+
+    m_parameters = parameters;
+
+    setRampTargets(m_ramps, parameters);
+
+    if (m_snapParameters)
+        for (auto& ramp : m_ramps)
+            ramp.setCurrentAndTarget(ramp.getTarget());
+
+    // Unchanged values cost nothing here: the filter chain only recomputes
+    // stages whose parameters moved
+    applyRampValues();
+
+    // Kernels are only designed while they are heard. The crossfade between
+    // kernels smooths the change, so they follow the targets, not the ramps.
+    // Chosen while playing, the filter is allocated by the design worker and
+    // the biquads carry on until it is ready
+    if (parameters.filterMode == linearPhaseFilters)
+    {
+        m_linearPhaseFilter.setParameters(parameters.midFreq, parameters.midGain, parameters.sideFreqLower,
+                                          parameters.sideFreqUpper, parameters.sideGain);
+        m_linearPhaseFilter.activate();
+    }
+
+    // The filter switched to still holds the state from when it last ran
+    if (filterModeChanged)
+    {
+        if (parameters.filterMode == linearPhaseFilters)
+            m_linearPhaseFilter.reset();
+        else if (parameters.filterMode == svfFilters)
+            m_svfChain.reset();
+        else
+            m_filterChain.reset();
+    }
+
+    m_waveshaper.setOversampling(parameters.oversamplingFactorLog2, parameters.oversamplingPhase);
+    m_waveshaper.setAntiAliasing(parameters.antiAliasing);
+    m_waveshaper.setPrecision(parameters.quality);
+
+    m_limiter.setParameters(parameters.limiterCeiling, parameters.limiterLookahead, parameters.limiterRelease);
+}
+
+void SpatialSaturatorEngine::setAutoSleepEnabled(bool enabled)
+{
+    m_autoSleepEnabled = enabled;
+
+    if (!enabled)
+    {
+        m_sleeping = false;
+        m_silentSamples = 0;
+    }
+}
+
+void SpatialSaturatorEngine::setMeteringEnabled(bool enabled)
+{
+    // Whatever the meters held predates the gap
+    if (enabled && !m_meteringEnabled)
+    {
+        m_inputMeter.reset();
+        m_outputMeter.reset();
+    }
+
+    m_meteringEnabled = enabled;
+}
+
+void SpatialSaturatorEngine::setMonoDetectionEnabled(bool enabled)
+{
+    m_monoDetectionEnabled = enabled;
+
+    if (!enabled)
+    {
+        if (m_processingMono)
+            stopProcessingMono();
+
+        m_nullSideSamples = 0;
+    }
+}
+
+int SpatialSaturatorEngine::getLatencyInSamples() const
+{
+    return (isLinearPhaseRunning() ? m_linearPhaseFilter.getLatencyInSamples() : 0)
+         + m_waveshaper.getLatencyInSamples() + (m_parameters.limiterEnabled ? m_limiter.getLatencyInSamples() : 0);
+}
+
+int SpatialSaturatorEngine::getTailLengthInSamples() const
+{
+    // Each stage rings on from where the one before it stopped
+    long long tail = isLinearPhaseRunning()                        ? m_linearPhaseFilter.getTailLengthInSamples()
+                   : m_parameters.filterMode == svfFilters         ? m_svfChain.getTailLengthInSamples()
+                                                                   : m_filterChain.getTailLengthInSamples();
+
+    tail += m_waveshaper.getTailLengthInSamples();
+
+    if (m_parameters.limiterEnabled)
+        tail += m_limiter.getLatencyInSamples();
+
+    return (int)std::min(tail, (long long)std::numeric_limits<int>::max());
+}
+
+//==============================================================================
+bool SpatialSaturatorEngine::isLinearPhaseRunning() const
+{
+    return m_parameters.filterMode == linearPhaseFilters && m_linearPhaseFilter.isReady();
+}
+
+bool SpatialSaturatorEngine::isRamping() const
+{
+    for (auto& ramp : m_ramps)
+        if (ramp.isRamping())
+            return true;
+
+    return false;
+}
+
+void SpatialSaturatorEngine::advanceRamps(int numSamples)
+{
+    for (auto& ramp : m_ramps)
+        ramp.skip(numSamples);
+
+    applyRampValues();
+}
+
+void SpatialSaturatorEngine::jumpRampsToTargets()
+{
+    for (auto& ramp : m_ramps)
+        ramp.setCurrentAndTarget(ramp.getTarget());
+
+    applyRampValues();
+}
+
+void SpatialSaturatorEngine::fallAsleep()
+{
+    m_sleeping = true;
+
+    // Whatever is left is below the floor; zeros make waking up exact
+    m_filterChain.reset();
+    m_svfChain.reset();
+    m_linearPhaseFilter.reset();
+    m_waveshaper.reset();
+    m_limiter.reset();
+}
+
+template <typename SampleType>
+void SpatialSaturatorEngine::updateMonoDetection(const SampleType* left, const SampleType* right, int numSamples)
+{
+    if (!m_monoDetectionEnabled)
+        return;
+
+    if (getSidePeak(left, right, numSamples) >= silenceFloor)
+    {
+        m_nullSideSamples = 0;
+
+        if (m_processingMono)
+            stopProcessingMono();
+
+        return;
+    }
+
+    // The blocks before this one had no side for longer than the tail, so
+    // both channels have the same history through every stage
+    if (!m_processingMono && m_nullSideSamples >= getTailLengthInSamples())
+        startProcessingMono();
+
+    m_nullSideSamples = (int)std::min((long long)m_nullSideSamples + numSamples, (long long)std::numeric_limits<int>::max());
+}
+
+void SpatialSaturatorEngine::startProcessingMono()
+{
+    m_processingMono = true;
+
+    // What is left of the side is below the floor; zeros let it restart exactly
+    m_filterChain.resetSide();
+    m_svfChain.resetSide();
+}
+
+void SpatialSaturatorEngine::stopProcessingMono()
+{
+    m_processingMono = false;
+
+    // The right channel's stages sat still; they carry on from the left's
+    m_waveshaper.copyChannelState(0, 1);
+    m_limiter.copyChannelState(0, 1);
+}
+
+void SpatialSaturatorEngine::applyRampValues()
+{
+    // Update the mid shelf, side high pass and side shelf coefficients (only if a parameter moved)
+    if (m_parameters.filterMode == svfFilters)
+        m_svfChain.updateCoefficients(m_ramps[midFreqRamp].getCurrent(), m_ramps[midGainRamp].getCurrent(),
+                                      m_ramps[sideFreqLowerRamp].getCurrent(), m_ramps[sideFreqUpperRamp].getCurrent(),
+                                      m_ramps[sideGainRamp].getCurrent());
+    else
+        m_filterChain.updateCoefficients(m_ramps[midFreqRamp].getCurrent(), m_ramps[midGainRamp].getCurrent(),
+                                         m_ramps[sideFreqLowerRamp].getCurrent(), m_ramps[sideFreqUpperRamp].getCurrent(),
+                                         m_ramps[sideGainRamp].getCurrent());
+
+    applyRampsToWaveshaper(m_ramps, m_parameters.numBands, m_waveshaper);
+}
+
+void SpatialSaturatorEngine::setRampTargets(LinearRamp* ramps, const Parameters& parameters)
+{
+    ramps[midGainRamp].setTarget(parameters.midGain);
+    ramps[midFreqRamp].setTarget(parameters.midFreq);
+    ramps[sideGainRamp].setTarget(parameters.sideGain);
+    ramps[sideFreqLowerRamp].setTarget(parameters.sideFreqLower);
+    ramps[sideFreqUpperRamp].setTarget(parameters.sideFreqUpper);
+    ramps[tanhAmplitudeRamp].setTarget(parameters.tanhAmplitude);
+    ramps[tanhSlopeRamp].setTarget(parameters.tanhSlope);
+    ramps[saturatorMixRamp].setTarget(parameters.saturatorMix);
+    ramps[sinAmplitudeRamp].setTarget(parameters.sinAmplitude);
+    ramps[sinFrequencyRamp].setTarget(parameters.sinFrequency);
+
+    for (int i = 0; i < Waveshaper::maxBands - 1; ++i)
+        ramps[crossoverFrequencyRamp + i].setTarget(parameters.crossoverFrequencies[i]);
+
+    for (int band = 0; band < Waveshaper::maxBands; ++band)
+    {
+        ramps[bandDriveRamp + band].setTarget(parameters.bandDrives[band]);
+        ramps[bandMixRamp + band].setTarget(parameters.bandMixes[band]);
+    }
+
+    ramps[makeUpGainRamp].setTarget(std::pow(10.0f, parameters.makeUpGain * 0.05f));
+}
+
+void SpatialSaturatorEngine::applyRampsToWaveshaper(const LinearRamp* ramps, int numBands, Waveshaper& waveshaper)
+{
+    waveshaper.setParameters(ramps[tanhAmplitudeRamp].getCurrent(), ramps[tanhSlopeRamp].getCurrent(),
+                             ramps[sinAmplitudeRamp].getCurrent(), ramps[sinFrequencyRamp].getCurrent(),
+                             ramps[saturatorMixRamp].getCurrent());
+
+    float crossoverFrequencies[Waveshaper::maxBands - 1], bandDrives[Waveshaper::maxBands], bandMixes[Waveshaper::maxBands];
+
+    for (int i = 0; i < Waveshaper::maxBands - 1; ++i)
+        crossoverFrequencies[i] = ramps[crossoverFrequencyRamp + i].getCurrent();
+
+    for (int band = 0; band < Waveshaper::maxBands; ++band)
+    {
+        bandDrives[band] = ramps[bandDriveRamp + band].getCurrent();
+        bandMixes[band] = ramps[bandMixRamp + band].getCurrent();
+    }
+
+    // The crossover only recomputes its biquads when a frequency moved
+    waveshaper.setBands(numBands, crossoverFrequencies, bandDrives, bandMixes);
+}
+
+template <typename SampleType>
+void SpatialSaturatorEngine::process(SampleType* left, SampleType* right, int numSamples)
+{
+    processChannels(left, right, numSamples, false);
+}
+
+template <typename SampleType>
+void SpatialSaturatorEngine::processMono(SampleType* samples, int numSamples)
+{
+    processChannels(samples, samples, numSamples, true);
+}
+
+template <typename SampleType>
+void SpatialSaturatorEngine::processChannels(SampleType* left, SampleType* right, int numSamples, bool monoInput)
+{
+    SPATIAL_SATURATOR_PROFILE_BLOCK(m_profiler);
+
+    // From here on, new parameters ramp
+    m_snapParameters = false;
+
+    if (m_meteringEnabled)
+    {
+        SPATIAL_SATURATOR_PROFILE_STAGE(m_profiler, metering);
+        m_inputMeter.process(left, right, numSamples);
+    }
+
+    if (m_autoSleepEnabled)
+    {
+        if (getPeak(left, right, numSamples) >= silenceFloor)
+        {
+            m_sleeping = false;
+            m_silentSamples = 0;
+        }
+        else
+        {
+            // The blocks before this one were silent for longer than the
+            // tail, so this one would come out silent too
+            if (!m_sleeping && m_silentSamples >= getTailLengthInSamples())
+                fallAsleep();
+
+            m_silentSamples = (int)std::min((long long)m_silentSamples + numSamples, (long long)std::numeric_limits<int>::max());
+
+            if (m_sleeping)
+            {
+                // Parameters that moved meanwhile are simply there on waking
+                if (isRamping())
+                    jumpRampsToTargets();
+
+                std::fill(left, left + numSamples, (SampleType)0);
+                std::fill(right, right + numSamples, (SampleType)0);
+
+                if (m_meteringEnabled)
+                {
+                    SPATIAL_SATURATOR_PROFILE_STAGE(m_profiler, metering);
+                    m_outputMeter.process(left, right, numSamples);
+                }
+
+                return;
+            }
+        }
+    }
+
+    // Mono input has no side to wait for
+    if (monoInput)
+    {
+        if (!m_processingMono)
+            startProcessingMono();
+    }
+    else
+    {
+        updateMonoDetection(left, right, numSamples);
+    }
+
+    // Nothing moving: one pass with the values set by setParameters()
+    if (!isRamping())
+    {
+        const SampleType makeUpGain = (SampleType)m_ramps[makeUpGainRamp].getCurrent();
+        processSubBlock(left, right, numSamples, makeUpGain, makeUpGain);
+    }
+    else
+    {
+        for (int start = 0; start < numSamples; start += subBlockSize)
+        {
+            const int subBlock = std::min((int)subBlockSize, numSamples - start);
+            const SampleType startGain = (SampleType)m_ramps[makeUpGainRamp].getCurrent();
+
+            {
+                SPATIAL_SATURATOR_PROFILE_STAGE(m_profiler, coefficients);
+                advanceRamps(subBlock);
+            }
+
+            processSubBlock(left + start, right + start, subBlock, startGain, (SampleType)m_ramps[makeUpGainRamp].getCurrent());
+        }
+    }
+
+    if (m_meteringEnabled)
+    {
+        SPATIAL_SATURATOR_PROFILE_STAGE(m_profiler, metering);
+        m_outputMeter.process(left, right, numSamples);
+    }
+}
+
+template <typename SampleType>
+void SpatialSaturatorEngine::processSubBlock(SampleType* left, SampleType* right, int numSamples, SampleType startGain, SampleType endGain)
+{
+    // Without a side the right channel is a copy of the left, which is all that runs
+    const bool mono = m_processingMono;
+    const int numChannels = mono ? 1 : 2;
+
+    // Encode to mids & sides, filter and decode back to L&R in a single pass.
+    // Mid and side share the linear phase transforms, so both always run
+    {
+        SPATIAL_SATURATOR_PROFILE_STAGE(m_profiler, filters);
+
+        if (isLinearPhaseRunning())
+            m_linearPhaseFilter.process(left, right, numSamples, startGain, endGain);
+        else if (m_parameters.filterMode == svfFilters && mono)
+            m_svfChain.processMid(left, numSamples, startGain, endGain);
+        else if (m_parameters.filterMode == svfFilters)
+            m_svfChain.process(left, right, numSamples, startGain, endGain);
+        else if (mono)
+            m_filterChain.processMid(left, numSamples, startGain, endGain);
+        else
+            m_filterChain.process(left, right, numSamples, startGain, endGain);
+    }
+
+    SampleType* channels[] = { left, right };
+
+    // Waveshaper Saturator (oversampled or ADAA)
+    {
+        SPATIAL_SATURATOR_PROFILE_STAGE(m_profiler, waveshaper);
+        m_waveshaper.process(channels, numChannels, numSamples);
+    }
+
+    // Look-ahead true-peak limiter, after the make up gain and the saturator
+    if (m_parameters.limiterEnabled)
+    {
+        SPATIAL_SATURATOR_PROFILE_STAGE(m_profiler, limiter);
+        m_limiter.process(channels, numChannels, numSamples);
+    }
+
+    if (mono && right != left)
+        std::copy(left, left + numSamples, right);
+}
+
+template void SpatialSaturatorEngine::process<float>(float*, float*, int);
+template void SpatialSaturatorEngine::process<double>(double*, double*, int);
+template void SpatialSaturatorEngine::processMono<float>(float*, int);
+template void SpatialSaturatorEngine::processMono<double>(double*, int);
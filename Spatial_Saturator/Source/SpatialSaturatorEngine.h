@@ -0,0 +1,246 @@
+/*
+  ==============================================================================
+
+    This file contains the complete Spatial Saturator processing chain without
+    any JUCE dependency, for the plug-in and for embedding through the C API
+
+  ==============================================================================
+*/
+#ifndef __SpatialSaturatorEngine__SpatialSaturatorEngine__
+#define __SpatialSaturatorEngine__SpatialSaturatorEngine__
+
+#pragma once
+
+#include "SpatialSaturatorFilter.h"
+#include "SpatialSaturatorLimiter.h"
+#include "SpatialSaturatorLinearPhase.h"
+#include "SpatialSaturatorMeter.h"
+#include "SpatialSaturatorProfiler.h"
+#include "SpatialSaturatorRamp.h"
+#include "SpatialSaturatorSVF.h"
+#include "SpatialSaturatorWaveshaper.h"
+
+//==============================================================================
+/**
+    Stereo chain on raw float or double pointers:
+
+        mid/side filters and make up gain (MidSideFilterChain, or
+        LinearPhaseMidSideFilter in the linear phase filter mode, or
+        MidSideSVFChain in the SVF filter mode)
+        waveshaper saturator, oversampled or with ADAA, full band or
+        multiband (Waveshaper)
+        look-ahead true-peak limiter (Limiter)
+
+    With metering on, a LoudnessMeter measures the input before the chain and
+    another the output after it.
+
+    With auto-sleep on (the default), a block whose input is all below the
+    float denormal floor counts as silent. Once the input has been silent for
+    getTailLengthInSamples() every stage has rung out, so the chain goes to
+    sleep: the stages are cleared, the output is zeroed and nothing else runs
+    until the first block with sound in it.
+
+    With mono detection on (the default), input without a side is found the
+    same way: both channels equal to within the denormal floor, like a mono
+    source on a stereo track. Once the side has been null for
+    getTailLengthInSamples(), whatever it left in the chain has rung out and
+    both channels would come out the same, so only the left one is processed:
+    the side filters are skipped and the waveshaper and limiter run one
+    channel, which is then copied to the right. The first block with a side
+    switches back, with the right channel's states copied from the left, so
+    the output does not step. processMono() runs mono buffers this way.
+    The linear phase filter always runs mid and side, which share its
+    transforms; the stages after it still run one channel.
+
+    prepare() allocates everything, after that setParameters() and process()
+    are realtime safe and can be called once per block. The linear phase
+    filter is the exception: it is only allocated once its mode is chosen, by
+    prepare() or, while playing, by its design worker, and the biquads run in
+    its place for the few milliseconds that takes.
+
+    Continuous parameters glide to new values over rampLengthMs instead of
+    jumping at the block boundary. The make up gain ramps per sample; while a
+    filter or saturator parameter moves, the block is split into sub-blocks of
+    subBlockSize samples and those are updated between sub-blocks. Blocks where
+    nothing moves run in one pass as before. In the SVF filter mode the filter
+    coefficients also glide sample by sample within each sub-block.
+
+    Both precisions are prepared, so a host can run either. Double input stays
+    double through the whole chain; float stays float except where a stage
+    computes in double (see each stage).
+*/
+class SpatialSaturatorEngine
+{
+public:
+    enum FilterMode
+    {
+        biquadFilters = 0,
+        linearPhaseFilters,     // same magnitudes without phase shift, adds latency
+        svfFilters              // same responses as state variable filters, for fast automation
+    };
+
+    // Raw parameter values, defaults as in the plug-in's parameter layout
+    struct Parameters
+    {
+        float midGain = 2.5f;               // dB
+        float midFreq = 250.0f;             // Hz
+        float sideGain = 6.0f;              // dB
+        float sideFreqLower = 140.0f;       // Hz
+        float sideFreqUpper = 4000.0f;      // Hz
+        float makeUpGain = 0.0f;            // dB
+        FilterMode filterMode = biquadFilters;
+
+        float tanhAmplitude = 50.0f;        // %
+        float tanhSlope = 7.0f;
+        float saturatorMix = 50.0f;         // %
+        float sinAmplitude = 50.0f;         // %
+        float sinFrequency = 60.0f;
+
+        int numBands = 1;                   // 1..4, 1 is the full band saturator
+        float crossoverFrequencies[Waveshaper::maxBands - 1] = { 150.0f, 1000.0f, 5000.0f };   // Hz
+        float bandDrives[Waveshaper::maxBands] = { 0.0f, 0.0f, 0.0f, 0.0f };                    // dB
+        float bandMixes[Waveshaper::maxBands] = { 100.0f, 100.0f, 100.0f, 100.0f };             // % of saturatorMix
+
+        int oversamplingFactorLog2 = 0;     // 0..3 for 1x..8x
+        Oversampler::Phase oversamplingPhase = Oversampler::minimumPhase;
+        FastMath::Precision quality = FastMath::full;
+        Waveshaper::AntiAliasing antiAliasing = Waveshaper::oversampled;
+
+        bool limiterEnabled = false;
+        float limiterCeiling = -1.0f;       // dBTP
+        float limiterLookahead = 2.0f;      // ms
+        float limiterRelease = 100.0f;      // ms
+
+        bool operator== (const Parameters& other) const;
+        bool operator!= (const Parameters& other) const { return !(*this == other); }
+    };
+
+    void prepare(double sampleRate, int maxBlockSize);
+    void reset();
+
+    // Tables for the filter coefficient updates, or null to compute them directly
+    void setCoefficientTables(std::shared_ptr<const CoefficientTables> tables);
+
+    enum { subBlockSize = 32 };
+    static constexpr double rampLengthMs = 20.0;
+
+    // Modes and the limiter settings apply at once, continuous parameters ramp
+    // to their new values. The first call after prepare() or reset() jumps
+    void setParameters(const Parameters& parameters);
+    const Parameters& getParameters() const { return m_parameters; }
+
+    enum RampIndex
+    {
+        midGainRamp = 0,
+        midFreqRamp,
+        sideGainRamp,
+        sideFreqLowerRamp,
+        sideFreqUpperRamp,
+        tanhAmplitudeRamp,
+        tanhSlopeRamp,
+        saturatorMixRamp,
+        sinAmplitudeRamp,
+        sinFrequencyRamp,
+        crossoverFrequencyRamp,                                 // one per crossover
+        bandDriveRamp = crossoverFrequencyRamp + Waveshaper::maxBands - 1,  // one per band
+        bandMixRamp = bandDriveRamp + Waveshaper::maxBands,     // one per band
+        makeUpGainRamp = bandMixRamp + Waveshaper::maxBands,    // linear gain, not dB
+        numRamps
+    };
+
+    // The ramps' targets for parameters, and the ramps' current values handed
+    // to a waveshaper; shared with MultiStreamEngine, which ramps every stream
+    static void setRampTargets(LinearRamp* ramps, const Parameters& parameters);
+    static void applyRampsToWaveshaper(const LinearRamp* ramps, int numBands, Waveshaper& waveshaper);
+
+    // Linear phase filter, waveshaper and limiter look-ahead, for the stages that are on
+    int getLatencyInSamples() const;
+
+    // How long the output keeps sounding after the input stops: filter and
+    // crossover decays to the denormal floor, FIR lengths and the limiter
+    // look-ahead, for the current settings
+    int getTailLengthInSamples() const;
+
+    // numSamples must not exceed the maxBlockSize given to prepare()
+    template <typename SampleType>
+    void process(SampleType* left, SampleType* right, int numSamples);
+
+    // One channel in place, as a stereo signal whose sides are both this
+    template <typename SampleType>
+    void processMono(SampleType* samples, int numSamples);
+
+    // Off by default; call while not processing. Turning it on starts the
+    // meters afresh. Readings can be taken from any thread
+    void setMeteringEnabled(bool enabled);
+    bool isMeteringEnabled() const                  { return m_meteringEnabled; }
+    const LoudnessMeter& getInputMeter() const      { return m_inputMeter; }
+    const LoudnessMeter& getOutputMeter() const     { return m_outputMeter; }
+
+    // Turning auto-sleep off wakes the chain up; it then always processes
+    void setAutoSleepEnabled(bool enabled);
+    bool isAutoSleepEnabled() const                 { return m_autoSleepEnabled; }
+    bool isSleeping() const                         { return m_sleeping; }
+
+    // Turning mono detection off returns to processing both channels
+    void setMonoDetectionEnabled(bool enabled);
+    bool isMonoDetectionEnabled() const             { return m_monoDetectionEnabled; }
+    bool isProcessingMono() const                   { return m_processingMono; }
+
+    // Where process() records its stage timings, null (the default) for
+    // nowhere. Only used in builds with SPATIAL_SATURATOR_PROFILING
+    void setProfiler(StageProfiler* profiler)       { m_profiler = profiler; }
+
+private:
+    // In the linear phase mode, once the filter has been allocated; the
+    // biquads run until then
+    bool isLinearPhaseRunning() const;
+
+    bool isRamping() const;
+
+    // Moves every ramp numSamples along and hands the values to the stages
+    void advanceRamps(int numSamples);
+    void applyRampValues();
+    void jumpRampsToTargets();
+
+    // Clears every stage, so waking up starts from exact silence
+    void fallAsleep();
+
+    // Follows the side of the input and switches the mono path on and off
+    template <typename SampleType>
+    void updateMonoDetection(const SampleType* left, const SampleType* right, int numSamples);
+    void startProcessingMono();
+    void stopProcessingMono();
+
+    // process() and processMono(), where right == left
+    template <typename SampleType>
+    void processChannels(SampleType* left, SampleType* right, int numSamples, bool monoInput);
+
+    template <typename SampleType>
+    void processSubBlock(SampleType* left, SampleType* right, int numSamples, SampleType startGain, SampleType endGain);
+
+    Parameters m_parameters;
+
+    LinearRamp m_ramps[numRamps];
+    bool m_snapParameters = true;
+
+    MidSideFilterChain m_filterChain;
+    MidSideSVFChain m_svfChain;
+    LinearPhaseMidSideFilter m_linearPhaseFilter;
+    Waveshaper m_waveshaper;
+    Limiter m_limiter;
+
+    bool m_meteringEnabled = false;
+    LoudnessMeter m_inputMeter, m_outputMeter;
+
+    bool m_autoSleepEnabled = true;
+    bool m_sleeping = false;
+    int m_silentSamples = 0;    // since the last block with sound, stops counting at INT_MAX
+
+    bool m_monoDetectionEnabled = true;
+    bool m_processingMono = false;
+    int m_nullSideSamples = 0;  // since the last block with a side, stops counting at INT_MAX
+
+    StageProfiler* m_profiler = nullptr;
+};
+
+#endif
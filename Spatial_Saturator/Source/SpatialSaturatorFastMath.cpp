@@ -0,0 +1,158 @@
+/*
+  ==============================================================================
+
+    This file contains the fast tanh and sin block kernels
+
+  ==============================================================================
+*/
+
+#include "SpatialSaturatorFastMath.h"
+#include "SpatialSaturatorSIMD.h"
+#include <cmath>
+
+namespace
+{
+    using namespace SIMD;
+
+    //==============================================================================
+    // tanh(x) ~= x * P(x^2) / Q(x^2), minimax fits on [0, clamp]. Past the clamp
+    // the fit stops being monotonic, and tanh is within the bound of +-1 anyway.
+    template <FastMath::Precision precision>
+    struct TanhApproximation;
+
+    template <>
+    struct TanhApproximation<FastMath::low>
+    {
+        static float4 process(float4 x)
+        {
+            x = max(min(x, set(5.0f)), set(-5.0f));
+            float4 x2 = mul(x, x);
+
+            float4 p = add(mul(add(mul(set(6.5841172761e-04f), x2), set(1.0182047891e-01f)), x2), set(9.9980640904e-01f));
+            float4 q = add(mul(add(mul(set(1.2670801698e-02f), x2), set(4.3460623523e-01f)), x2), set(1.0f));
+
+            return max(min(div(mul(x, p), q), set(1.0f)), set(-1.0f));
+        }
+    };
+
+    template <>
+    struct TanhApproximation<FastMath::medium>
+    {
+        static float4 process(float4 x)
+        {
+            x = max(min(x, set(7.0f)), set(-7.0f));
+            float4 x2 = mul(x, x);
+
+            float4 p = add(mul(add(mul(add(mul(set(3.9439991876e-06f), x2), set(2.2796680598e-03f)), x2), set(1.2305063083e-01f)), x2), set(9.9999571724e-01f));
+            float4 q = add(mul(add(mul(add(mul(set(1.4265502573e-04f), x2), set(2.1084319903e-02f)), x2), set(4.5636937483e-01f)), x2), set(1.0f));
+
+            return max(min(div(mul(x, p), q), set(1.0f)), set(-1.0f));
+        }
+    };
+
+    //==============================================================================
+    // sin(x) = (-1)^k * sin(r) with r = x - k * pi in [-pi/2, pi/2]. pi is split
+    // in three (Cody & Waite) so k * piA and k * piB are exact for |k| < 4096.
+    // sin(r) ~= r * S(r^2), odd minimax fits on [0, pi/2].
+    template <FastMath::Precision precision>
+    struct SinApproximation;
+
+    static inline float4 reduceToHalfPi(float4 x, float4& k)
+    {
+        k = round(mul(x, set(0.318309873f)));
+
+        x = sub(x, mul(k, set(3.140625f)));
+        x = sub(x, mul(k, set(9.67502593994140625e-4f)));
+        return sub(x, mul(k, set(1.509958025e-7f)));
+    }
+
+    template <>
+    struct SinApproximation<FastMath::low>
+    {
+        static float4 process(float4 x)
+        {
+            float4 k;
+            float4 r = reduceToHalfPi(x, k);
+            float4 r2 = mul(r, r);
+
+            float4 s = add(mul(add(mul(set(7.5143825393e-03f), r2), set(-1.6567309728e-01f)), r2), set(9.9969678623e-01f));
+
+            return negateIfOdd(mul(r, s), k);
+        }
+    };
+
+    template <>
+    struct SinApproximation<FastMath::medium>
+    {
+        static float4 process(float4 x)
+        {
+            float4 k;
+            float4 r = reduceToHalfPi(x, k);
+            float4 r2 = mul(r, r);
+
+            float4 s = add(mul(add(mul(add(mul(set(-1.8363662696e-04f), r2), set(8.3063256298e-03f)), r2), set(-1.6664828437e-01f)), r2), set(9.9999661612e-01f));
+
+            return negateIfOdd(mul(r, s), k);
+        }
+    };
+
+    //==============================================================================
+    template <typename Approximation>
+    void processBlock(float* dest, const float* src, float multiplier, int num)
+    {
+        const float4 scale = set(multiplier);
+        int i = 0;
+
+        for (; i + 4 <= num; i += 4)
+            store(dest + i, Approximation::process(mul(load(src + i), scale)));
+
+        // Tail through a padded register, so it gets the same rounding as the body
+        if (i < num)
+        {
+            float tail[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+            for (int j = i; j < num; ++j)
+                tail[j - i] = src[j];
+
+            store(tail, Approximation::process(mul(load(tail), scale)));
+
+            for (int j = i; j < num; ++j)
+                dest[j] = tail[j - i];
+        }
+    }
+}
+
+//==============================================================================
+void FastMath::tanh(float* dest, const float* src, float multiplier, int num, Precision precision)
+{
+    switch (precision)
+    {
+    case low:
+        processBlock<TanhApproximation<low>>(dest, src, multiplier, num);
+        break;
+    case medium:
+        processBlock<TanhApproximation<medium>>(dest, src, multiplier, num);
+        break;
+    default:
+        for (int i = 0; i < num; ++i)
+            dest[i] = (float)std::tanh((double)src[i] * (double)multiplier);
+        break;
+    }
+}
+
+void FastMath::sin(float* dest, const float* src, float multiplier, int num, Precision precision)
+{
+    switch (precision)
+    {
+    case low:
+        processBlock<SinApproximation<low>>(dest, src, multiplier, num);
+        break;
+    case medium:
+        processBlock<SinApproximation<medium>>(dest, src, multiplier, num);
+        break;
+    default:
+        for (int i = 0; i < num; ++i)
+            dest[i] = (float)std::sin((double)src[i] * (double)multiplier);
+        break;
+    }
+}
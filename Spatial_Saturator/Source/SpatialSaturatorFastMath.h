@@ -0,0 +1,41 @@
+/*
+  ==============================================================================
+
+    This file contains block versions of tanh and sin for the saturator, with
+    SIMD rational and polynomial approximations at selectable error bounds
+
+  ==============================================================================
+*/
+#ifndef __SpatialSaturatorFastMath__SpatialSaturatorFastMath__
+#define __SpatialSaturatorFastMath__SpatialSaturatorFastMath__
+
+#pragma once
+
+//==============================================================================
+/**
+    Works on whole blocks like juce::FloatVectorOperations:
+    dest[i] = f(src[i] * multiplier). dest and src may be the same buffer.
+
+    Maximum absolute errors over all inputs:
+
+        low     tanh 8e-5, sin 8e-5 (quality "Draft", bound 1e-3)
+        medium  tanh 2e-6, sin 5e-6 (quality "High", bound 1e-5)
+        full    std::tanh / std::sin in double precision
+
+    The sin figures hold for |src * multiplier| < 128 (the saturator's range);
+    past that the float rounding of the argument itself dominates.
+*/
+namespace FastMath
+{
+    enum Precision
+    {
+        low = 0,
+        medium,
+        full
+    };
+
+    void tanh(float* dest, const float* src, float multiplier, int num, Precision precision);
+    void sin(float* dest, const float* src, float multiplier, int num, Precision precision);
+}
+
+#endif
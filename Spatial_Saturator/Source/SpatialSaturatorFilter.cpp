@@ -6,117 +6,459 @@
   ==============================================================================
 */
 
-#include "PluginProcessor.h"
 #include "SpatialSaturatorFilter.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+
+// Q Parameter
+static const double Q = 1 / sqrt(2);
+
+// Single precision like pi, which the original filters used
+static const float pi = 3.141592653589793238f;
 
 //==============================================================================
-void Filter::setCutOffFrequency(float cutOffFrequency)
+BiquadCoefficients makeLowShelf(float cutOffFrequency, float gain, float sample_rate)
 {
-    m_cutOffFrequency = cutOffFrequency;
+    // shelf filter parameters
+    auto w0 = 2 * pi * ((double)cutOffFrequency / sample_rate);
+    double A = pow(10.0, (double)gain * 0.025);
+
+    return makeLowShelf(cos(w0), sin(w0), A, sqrt(A));
 }
 
-void Filter::setSampleRate(float sample_rate)
+BiquadCoefficients makeLowShelf(double cosW0, double sinW0, double A, double sqrtA)
 {
-    m_sample_rate = sample_rate;
+    auto alpha = sinW0 / (2 * Q);
+
+    auto b0 = A * ((A + 1) - (A - 1) * cosW0 + 2 * sqrtA * alpha);
+    auto b1 = 2 * A * ((A - 1) - (A + 1) * cosW0);
+    auto b2 = A * ((A + 1) - (A - 1) * cosW0 - 2 * sqrtA * alpha);
+    auto a0 = (A + 1) + (A - 1) * cosW0 + 2 * sqrtA * alpha;
+    auto a1 = -2 * ((A - 1) + (A + 1) * cosW0);
+    auto a2 = (A + 1) + (A - 1) * cosW0 - 2 * sqrtA * alpha;
+
+    BiquadCoefficients c;
+    c.b0 = b0 / a0; c.b1 = b1 / a0; c.b2 = b2 / a0; c.a1 = a1 / a0; c.a2 = a2 / a0;
+    return c;
 }
 
-//==============================================================================
+BiquadCoefficients makeHighPass(float cutOffFrequency, float sample_rate)
+{
+    // high_pass parameters
+    auto w0 = 2 * pi * ((double)cutOffFrequency / sample_rate);
 
-void MidShelfFilter::processFilter(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages, int numberSamples, std::atomic<float>* cutOffFrequency, std::atomic<float>* gain)
+    return makeHighPass(cos(w0), sin(w0));
+}
+
+BiquadCoefficients makeHighPass(double cosW0, double sinW0)
 {
-    // mid shelf filter parameters
-    auto w0b = 2 * juce::MathConstants<float>::pi * ((double)*cutOffFrequency / Filter::m_sample_rate);
-    auto alpha_b = sin(w0b) / (2 * Filter::Q);
-    double midGain = pow(10.0, (double)*gain * 0.025);
+    auto alpha = sinW0 / (2 * Q);
 
-    double mid_in{}, mid_out{};
+    auto b0 = (1 + cosW0) / 2;
+    auto b1 = -(1 + cosW0);
+    auto b2 = (1 + cosW0) / 2;
+    auto a0 = 1 + alpha;
+    auto a1 = -2 * cosW0;
+    auto a2 = 1 - alpha;
 
-    auto b0bs = midGain * ((midGain + 1) - (midGain - 1) * cos(w0b) + 2 * sqrt(midGain) * alpha_b);
-    auto b1bs = 2 * midGain * ((midGain - 1) - (midGain + 1) * cos(w0b));
-    auto b2bs = midGain * ((midGain + 1) - (midGain - 1) * cos(w0b) - 2 * sqrt(midGain) * alpha_b);
-    auto a0bs = (midGain + 1) + (midGain - 1) * cos(w0b) + 2 * sqrt(midGain) * alpha_b;
-    auto a1bs = -2 * ((midGain - 1) + (midGain + 1) * cos(w0b));
-    auto a2bs = (midGain + 1) + (midGain - 1) * cos(w0b) - 2 * sqrt(midGain) * alpha_b;
+    BiquadCoefficients c;
+    c.b0 = b0 / a0; c.b1 = b1 / a0; c.b2 = b2 / a0; c.a1 = a1 / a0; c.a2 = a2 / a0;
+    return c;
+}
 
-    b0bs = b0bs / a0bs; b1bs = b1bs / a0bs; b2bs = b2bs / a0bs; a1bs = a1bs / a0bs; a2bs = a2bs / a0bs; a0bs = a0bs / a0bs;
+BiquadCoefficients makeLowPass(float cutOffFrequency, float sample_rate)
+{
+    auto w0 = 2 * pi * ((double)cutOffFrequency / sample_rate);
+    auto cosW0 = cos(w0);
+    auto alpha = sin(w0) / (2 * Q);
 
-    for (int n = 0; n < numberSamples; ++n)
+    auto b0 = (1 - cosW0) / 2;
+    auto b1 = 1 - cosW0;
+    auto b2 = (1 - cosW0) / 2;
+    auto a0 = 1 + alpha;
+    auto a1 = -2 * cosW0;
+    auto a2 = 1 - alpha;
+
+    BiquadCoefficients c;
+    c.b0 = b0 / a0; c.b1 = b1 / a0; c.b2 = b2 / a0; c.a1 = a1 / a0; c.a2 = a2 / a0;
+    return c;
+}
+
+BiquadCoefficients makeAllPass(float cutOffFrequency, float sample_rate)
+{
+    auto w0 = 2 * pi * ((double)cutOffFrequency / sample_rate);
+    auto cosW0 = cos(w0);
+    auto alpha = sin(w0) / (2 * Q);
+
+    auto b0 = 1 - alpha;
+    auto b1 = -2 * cosW0;
+    auto b2 = 1 + alpha;
+    auto a0 = 1 + alpha;
+    auto a1 = -2 * cosW0;
+    auto a2 = 1 - alpha;
+
+    BiquadCoefficients c;
+    c.b0 = b0 / a0; c.b1 = b1 / a0; c.b2 = b2 / a0; c.a1 = a1 / a0; c.a2 = a2 / a0;
+    return c;
+}
+
+double getDecayLength(double a1, double a2, double floor)
+{
+    // Complex poles share the radius sqrt(a2), real ones are the roots
+    const double discriminant = a1 * a1 - 4 * a2;
+    const double radius = discriminant < 0 ? sqrt(a2)
+                                           : 0.5 * (std::abs(a1) + sqrt(discriminant));
+
+    // An FIR is done after its two delays; a pole on the unit circle never decays
+    if (radius <= 0)
+        return 2.0;
+
+    if (radius >= 1)
+        return (double)std::numeric_limits<int>::max();
+
+    return 2.0 + log(floor) / log(radius);
+}
+
+//==============================================================================
+CoefficientTables::CoefficientTables(float sample_rate, float freqStart, float freqEnd, float freqInterval,
+                                     float gainStart, float gainEnd, float gainInterval)
+    : m_sample_rate(sample_rate),
+      m_freqStart(freqStart), m_freqEnd(freqEnd), m_freqInterval(freqInterval),
+      m_gainStart(gainStart), m_gainEnd(gainEnd), m_gainInterval(gainInterval)
+{
+    // Steps are generated the same way NormalisableRange snaps values, so a
+    // snapped parameter value matches its table entry exactly
+    const int numFreqSteps = (int)floor((freqEnd - freqStart) / freqInterval) + 1;
+    m_cosW0.resize((size_t)numFreqSteps);
+    m_sinW0.resize((size_t)numFreqSteps);
+
+    for (int i = 0; i < numFreqSteps; ++i)
     {
-        // Read mid channel
-        mid_in = (double)buffer.getSample(0, n);
+        float cutOffFrequency = freqStart + freqInterval * (float)i;
+        auto w0 = 2 * pi * ((double)cutOffFrequency / sample_rate);
+        m_cosW0[(size_t)i] = cos(w0);
+        m_sinW0[(size_t)i] = sin(w0);
+    }
 
-        // Apply low shelf to mid
-        mid_out = (mid_in * b0bs) + m_m1;
-        m_m1 = m_m2 + (mid_in * b1bs) - (mid_out * a1bs);
-        m_m2 = (mid_in * b2bs) - (mid_out * a2bs);
+    const int numGainSteps = (int)floor((gainEnd - gainStart) / gainInterval) + 1;
+    m_A.resize((size_t)numGainSteps);
+    m_sqrtA.resize((size_t)numGainSteps);
 
-        // Set output (mid to left channel)
-        buffer.setSample(0, n, mid_out);
+    for (int i = 0; i < numGainSteps; ++i)
+    {
+        float gain = gainStart + gainInterval * (float)i;
+        double A = pow(10.0, (double)gain * 0.025);
+        m_A[(size_t)i] = A;
+        m_sqrtA[(size_t)i] = sqrt(A);
     }
 }
 
-void SideShelfFilter::processFilter(juce::AudioBuffer<float>& buffer, juce::MidiBuffer&, int numberSamples, std::atomic<float>* cutOffFrequency, std::atomic<float>* gain)
+std::shared_ptr<const CoefficientTables> CoefficientTables::getShared(float sample_rate, float freqStart, float freqEnd, float freqInterval,
+                                                                      float gainStart, float gainEnd, float gainInterval)
 {
-    // Space shelf parameters
-    auto w0ss = 2 * juce::MathConstants<float>::pi * ((double)*cutOffFrequency / Filter::m_sample_rate);
-    auto alpha_ss = sin(w0ss) / (2 * Q);
-    auto spaceGain = pow(10.0, (double)*gain * 0.025);
+    static std::mutex lock;
+    static std::vector<std::weak_ptr<const CoefficientTables>> cache;
 
-    double side_in{}, side_out{};
+    std::lock_guard<std::mutex> guard(lock);
 
-    auto b0ss = spaceGain * ((spaceGain + 1) - (spaceGain - 1) * cos(w0ss) + 2 * sqrt(spaceGain) * alpha_ss);
-    auto b1ss = 2 * spaceGain * ((spaceGain - 1) - (spaceGain + 1) * cos(w0ss));
-    auto b2ss = spaceGain * ((spaceGain + 1) - (spaceGain - 1) * cos(w0ss) - 2 * sqrt(spaceGain) * alpha_ss);
-    auto a0ss = (spaceGain + 1) + (spaceGain - 1) * cos(w0ss) + 2 * sqrt(spaceGain) * alpha_ss;
-    auto a1ss = -2 * ((spaceGain - 1) + (spaceGain + 1) * cos(w0ss));
-    auto a2ss = (spaceGain + 1) + (spaceGain - 1) * cos(w0ss) - 2 * sqrt(spaceGain) * alpha_ss;
+    for (auto& entry : cache)
+    {
+        if (auto tables = entry.lock())
+        {
+            if (tables->m_sample_rate == sample_rate
+                && tables->m_freqStart == freqStart && tables->m_freqEnd == freqEnd && tables->m_freqInterval == freqInterval
+                && tables->m_gainStart == gainStart && tables->m_gainEnd == gainEnd && tables->m_gainInterval == gainInterval)
+                return tables;
+        }
+    }
 
-    b0ss = b0ss / a0ss; b1ss = b1ss / a0ss; b2ss = b2ss / a0ss; a1ss = a1ss / a0ss; a2ss = a2ss / a0ss; a0ss = a0ss / a0ss;
+    // Drop tables no instance uses any more
+    cache.erase(std::remove_if(cache.begin(), cache.end(), [](const std::weak_ptr<const CoefficientTables>& entry) { return entry.expired(); }), cache.end());
 
-    for (int n = 0; n < numberSamples; ++n)
+    auto tables = std::make_shared<const CoefficientTables>(sample_rate, freqStart, freqEnd, freqInterval, gainStart, gainEnd, gainInterval);
+    cache.push_back(tables);
+    return tables;
+}
+
+int CoefficientTables::findStep(float value, float start, float interval, int numSteps)
+{
+    int step = (int)floor((value - start) / interval + 0.5f);
+
+    if (step < 0 || step >= numSteps || start + interval * (float)step != value)
+        return -1;
+
+    return step;
+}
+
+bool CoefficientTables::lookupFrequency(float cutOffFrequency, double& cosW0, double& sinW0) const
+{
+    int step = findStep(cutOffFrequency, m_freqStart, m_freqInterval, (int)m_cosW0.size());
+
+    if (step < 0)
+        return false;
+
+    cosW0 = m_cosW0[(size_t)step];
+    sinW0 = m_sinW0[(size_t)step];
+    return true;
+}
+
+bool CoefficientTables::lookupGain(float gain, double& A, double& sqrtA) const
+{
+    int step = findStep(gain, m_gainStart, m_gainInterval, (int)m_A.size());
+
+    if (step < 0)
+        return false;
+
+    A = m_A[(size_t)step];
+    sqrtA = m_sqrtA[(size_t)step];
+    return true;
+}
+
+BiquadCoefficients makeLowShelf(float cutOffFrequency, float gain, float sample_rate, const CoefficientTables* tables)
+{
+    double cosW0, sinW0, A, sqrtA;
+
+    if (tables != nullptr && tables->lookupFrequency(cutOffFrequency, cosW0, sinW0) && tables->lookupGain(gain, A, sqrtA))
+        return makeLowShelf(cosW0, sinW0, A, sqrtA);
+
+    return makeLowShelf(cutOffFrequency, gain, sample_rate);
+}
+
+BiquadCoefficients makeHighPass(float cutOffFrequency, float sample_rate, const CoefficientTables* tables)
+{
+    double cosW0, sinW0;
+
+    if (tables != nullptr && tables->lookupFrequency(cutOffFrequency, cosW0, sinW0))
+        return makeHighPass(cosW0, sinW0);
+
+    return makeHighPass(cutOffFrequency, sample_rate);
+}
+
+//==============================================================================
+MidSideFilterChain::MidSideFilterChain()
+{
+    // Everything starts as a pass-through; stage 1 of the mid lane stays that way
+    for (int stage = 0; stage < numStages; ++stage)
+        for (int lane = 0; lane < numLanes; ++lane)
+            setStage(stage, lane, BiquadCoefficients());
+
+    invalidateCoefficients();
+    reset();
+}
+
+void MidSideFilterChain::setSampleRate(float sample_rate)
+{
+    if (sample_rate != m_sample_rate)
+        invalidateCoefficients();
+
+    if (m_tables != nullptr && m_tables->m_sample_rate != sample_rate)
+        m_tables = nullptr;
+
+    m_sample_rate = sample_rate;
+}
+
+void MidSideFilterChain::setCoefficientTables(std::shared_ptr<const CoefficientTables> tables)
+{
+    // Tables built for another sample rate would give the wrong response
+    if (tables != nullptr && tables->m_sample_rate != m_sample_rate)
+        tables = nullptr;
+
+    m_tables = std::move(tables);
+}
+
+void MidSideFilterChain::invalidateCoefficients()
+{
+    // NaN never compares equal, so the next update recomputes every stage
+    m_midFreq = m_midGain = m_sideFreqLower = m_sideFreqUpper = m_sideGain = std::numeric_limits<float>::quiet_NaN();
+}
+
+void MidSideFilterChain::reset()
+{
+    for (int stage = 0; stage < numStages; ++stage)
+    {
+        for (int lane = 0; lane < numLanes; ++lane)
+        {
+            m_z1[stage][lane] = 0.0;
+            m_z2[stage][lane] = 0.0;
+        }
+    }
+}
+
+void MidSideFilterChain::resetSide()
+{
+    for (int stage = 0; stage < numStages; ++stage)
     {
-        // Read side channel 
-        side_in = (double)buffer.getSample(1, n);
+        m_z1[stage][sideLane] = 0.0;
+        m_z2[stage][sideLane] = 0.0;
+    }
+}
 
-        // Apply low-shelf to sides
-        side_out = (side_in * b0ss) + m_s1;
-        m_s1 = m_s2 + (side_in * b1ss) - (side_out * a1ss);
-        m_s2 = (side_in * b2ss) - (side_out * a2ss);
+void MidSideFilterChain::setStage(int stage, int lane, const BiquadCoefficients& coefficients)
+{
+    m_b0[stage][lane] = coefficients.b0;
+    m_b1[stage][lane] = coefficients.b1;
+    m_b2[stage][lane] = coefficients.b2;
+    m_a1[stage][lane] = coefficients.a1;
+    m_a2[stage][lane] = coefficients.a2;
+
+    m_decayLength[stage][lane] = getDecayLength(coefficients.a1, coefficients.a2);
+}
+
+int MidSideFilterChain::getTailLengthInSamples() const
+{
+    // The stages of a lane ring one after the other, so their tails add up
+    double longest = 0.0;
 
-        // Set output (side to right channel)
-        buffer.setSample(1, n, side_out);
+    for (int lane = 0; lane < numLanes; ++lane)
+    {
+        double length = 0.0;
+
+        for (int stage = 0; stage < numStages; ++stage)
+            length += m_decayLength[stage][lane];
+
+        longest = std::max(longest, length);
     }
+
+    return (int)std::min(std::ceil(longest), (double)std::numeric_limits<int>::max());
 }
 
-void SideHpFilter::processFilter(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages, int numberSamples, std::atomic<float>* cutOffFrequency)
+BiquadCoefficients MidSideFilterChain::lowShelf(float cutOffFrequency, float gain) const
 {
-    // Space high_pass parameters
-    auto w0shp = 2 * juce::MathConstants<float>::pi * ((double)*cutOffFrequency / Filter::m_sample_rate);
-    auto alpha_shp = sin(w0shp) / (2 * Q);
+    return makeLowShelf(cutOffFrequency, gain, m_sample_rate, m_tables.get());
+}
 
-    double side_in{}, side_out{};
+BiquadCoefficients MidSideFilterChain::highPass(float cutOffFrequency) const
+{
+    return makeHighPass(cutOffFrequency, m_sample_rate, m_tables.get());
+}
 
-    auto b0shp = (1 + cos(w0shp)) / 2;
-    auto b1shp = -(1 + cos(w0shp));
-    auto b2shp = (1 + cos(w0shp)) / 2;
-    auto a0shp = 1 + alpha_shp;
-    auto a1shp = -2 * cos(w0shp);
-    auto a2shp = 1 - alpha_shp;
+void MidSideFilterChain::updateCoefficients(float midFreq, float midGain, float sideFreqLower, float sideFreqUpper, float sideGain)
+{
+    if (midFreq != m_midFreq || midGain != m_midGain)
+    {
+        setStage(0, midLane, lowShelf(midFreq, midGain));
+        m_midFreq = midFreq;
+        m_midGain = midGain;
+    }
 
-    b0shp = b0shp / a0shp; b1shp = b1shp / a0shp; b2shp = b2shp / a0shp; a1shp = a1shp / a0shp; a2shp = a2shp / a0shp; a0shp = a0shp / a0shp;
+    if (sideFreqLower != m_sideFreqLower)
+    {
+        setStage(0, sideLane, highPass(sideFreqLower));
+        m_sideFreqLower = sideFreqLower;
+    }
 
+    if (sideFreqUpper != m_sideFreqUpper || sideGain != m_sideGain)
+    {
+        setStage(1, sideLane, lowShelf(sideFreqUpper, sideGain));
+        m_sideFreqUpper = sideFreqUpper;
+        m_sideGain = sideGain;
+    }
+}
 
+// Rounds a value computed in double to the precision the buffer holds it in
+template <typename SampleType> static SIMD::double2 roundToSampleType(SIMD::double2 x);
+template <> SIMD::double2 roundToSampleType<float>(SIMD::double2 x)  { return SIMD::roundToFloat(x); }
+template <> SIMD::double2 roundToSampleType<double>(SIMD::double2 x) { return x; }
+
+template <typename SampleType>
+void MidSideFilterChain::process(SampleType* left, SampleType* right, int numberSamples, SampleType startGain, SampleType endGain)
+{
+    using namespace SIMD;
+
+    const double2 half = set(0.5, 0.5);
+
+    // A constant gain has a zero step, which keeps it exact
+    const double gainStart = (double)startGain;
+    const double gainStep = numberSamples > 0 ? ((double)endGain - gainStart) / numberSamples : 0.0;
+
+    // Coefficients and states live in registers for the whole block
+    double2 b0[numStages], b1[numStages], b2[numStages], a1[numStages], a2[numStages];
+    double2 z1[numStages], z2[numStages];
+
+    for (int stage = 0; stage < numStages; ++stage)
+    {
+        b0[stage] = load(m_b0[stage]);
+        b1[stage] = load(m_b1[stage]);
+        b2[stage] = load(m_b2[stage]);
+        a1[stage] = load(m_a1[stage]);
+        a2[stage] = load(m_a2[stage]);
+        z1[stage] = load(m_z1[stage]);
+        z2[stage] = load(m_z2[stage]);
+    }
+
+    // For float, roundToSampleType() rounds exactly where the original
+    // multi-pass chain stored each stage back into the float buffer, so the
+    // output stays bit-identical to it. The pass-through stage on the mid lane
+    // is exact.
     for (int n = 0; n < numberSamples; ++n)
     {
-        // Read side channel 
-        side_in = (double)buffer.getSample(1, n);
+        // Read L/R once
+        double l = (double)left[n];
+        double r = (double)right[n];
+
+        // Process L+R into mids & sides: [ (l + r) / 2 | (l - r) / 2 ]
+        double2 x = roundToSampleType<SampleType>(mul(add(set(l, l), set(r, -r)), half));
 
-        // Apply high pass to sides
-        side_out = (side_in * b0shp) + m_shp1;
-        m_shp1 = m_shp2 + (side_in * b1shp) - (side_out * a1shp);
-        m_shp2 = (side_in * b2shp) - (side_out * a2shp);
+        // Mid shelf + side high pass, then pass-through + side shelf
+        for (int stage = 0; stage < numStages; ++stage)
+        {
+            double2 y = add(mul(x, b0[stage]), z1[stage]);
+            z1[stage] = sub(add(z2[stage], mul(x, b1[stage])), mul(y, a1[stage]));
+            z2[stage] = sub(mul(x, b2[stage]), mul(y, a2[stage]));
+            x = roundToSampleType<SampleType>(y);
+        }
 
-        // Set output (side to right channel)
-        buffer.setSample(1, n, side_out);
+        // Process mids+sides back to L&R: [ m + s | m - s ] * gain
+        double mids = getLane0(x);
+        double sides = getLane1(x);
+        double gain = gainStart + gainStep * (n + 1);
+        double2 lr = mul(add(set(mids, mids), set(sides, -sides)), set(gain, gain));
+
+        // Write L/R once
+        left[n] = (SampleType)getLane0(lr);
+        right[n] = (SampleType)getLane1(lr);
+    }
+
+    for (int stage = 0; stage < numStages; ++stage)
+    {
+        store(m_z1[stage], z1[stage]);
+        store(m_z2[stage], z2[stage]);
+    }
+}
+
+template <typename SampleType>
+void MidSideFilterChain::processMid(SampleType* samples, int numberSamples, SampleType startGain, SampleType endGain)
+{
+    const double gainStart = (double)startGain;
+    const double gainStep = numberSamples > 0 ? ((double)endGain - gainStart) / numberSamples : 0.0;
+
+    // Stage 1 of the mid lane is the pass-through, so the shelf is all there is
+    const double b0 = m_b0[0][midLane], b1 = m_b1[0][midLane], b2 = m_b2[0][midLane];
+    const double a1 = m_a1[0][midLane], a2 = m_a2[0][midLane];
+    double z1 = m_z1[0][midLane], z2 = m_z2[0][midLane];
+
+    // The same operations as the mid lane of process(), so the same samples
+    for (int n = 0; n < numberSamples; ++n)
+    {
+        // (l + r) / 2 of two equal sides is either side
+        double x = (double)samples[n];
+
+        double y = x * b0 + z1;
+        z1 = z2 + x * b1 - y * a1;
+        z2 = x * b2 - y * a2;
+
+        // With the side at zero, both m + s and m - s are the mid
+        double mids = (double)(SampleType)y;
+        samples[n] = (SampleType)(mids * (gainStart + gainStep * (n + 1)));
     }
+
+    m_z1[0][midLane] = z1;
+    m_z2[0][midLane] = z2;
 }
+
+template void MidSideFilterChain::process<float>(float*, float*, int, float, float);
+template void MidSideFilterChain::process<double>(double*, double*, int, double, double);
+template void MidSideFilterChain::processMid<float>(float*, int, float, float);
+template void MidSideFilterChain::processMid<double>(double*, int, double, double);
@@ -10,59 +10,169 @@
 
 #pragma once
 
-#include <JuceHeader.h>
 #include <math.h>
+#include <memory>
+#include <vector>
+#include "SpatialSaturatorSIMD.h"
 
 //==============================================================================
 /**
+    Coefficients of one biquad, normalised so that a0 == 1.
+    The default is a unity pass-through.
 */
-class Filter
+struct BiquadCoefficients
 {
-public:
+    double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+};
 
-    void setCutOffFrequency(float cutOffFrequency);
-    void setSampleRate(float sample_rate);
-    //==============================================================================
-    // Parameters
-    float m_cutOffFrequency;
-    float m_sample_rate;
-    // Filter states
-    double m_m1{}, m_m2{}, m_s1{}, m_s2{}, m_shp1{}, m_shp2{};
-    // Q Parameter
-    double Q = 1 / sqrt(2);
+// RBJ cookbook low shelf (used for the mid and side shelves)
+BiquadCoefficients makeLowShelf(float cutOffFrequency, float gain, float sample_rate);
+BiquadCoefficients makeLowShelf(double cosW0, double sinW0, double A, double sqrtA);
 
-private:
+// RBJ cookbook high pass (used for the side high pass)
+BiquadCoefficients makeHighPass(float cutOffFrequency, float sample_rate);
+BiquadCoefficients makeHighPass(double cosW0, double sinW0);
 
-};
+// RBJ cookbook low pass and all pass at the same Q (used with the high pass
+// for the saturator's Linkwitz-Riley crossovers)
+BiquadCoefficients makeLowPass(float cutOffFrequency, float sample_rate);
+BiquadCoefficients makeAllPass(float cutOffFrequency, float sample_rate);
+
+// Level a filter tail has to fall to before it counts as silence: the float
+// denormal floor, less 40 dB for shelf gain, drive and resonance above full scale
+const double tailFloor = 1.17549435e-38 * 0.01;
+
+// Samples until the impulse response of the poles of 1 + a1 z^-1 + a2 z^-2
+// has decayed from full scale to the floor, from the largest pole radius
+double getDecayLength(double a1, double a2, double floor = tailFloor);
 
-class MidShelfFilter : public Filter
+//==============================================================================
+/**
+    Precomputed cos/sin of w0 for every frequency step and A/sqrt(A) for every
+    gain step of the parameter ranges, so that a parameter change becomes a
+    table lookup instead of sin, cos, pow and sqrt.
+
+    Values off the step grid return false and are computed directly instead.
+    Tables only depend on the sample rate and ranges, so instances share them.
+*/
+class CoefficientTables
 {
 public:
-    void processFilter(juce::AudioBuffer<float>&, juce::MidiBuffer&, int numberSamples, std::atomic<float>* cutOffFrequency, std::atomic<float>* gain);
+    CoefficientTables(float sample_rate, float freqStart, float freqEnd, float freqInterval,
+                      float gainStart, float gainEnd, float gainInterval);
+
+    static std::shared_ptr<const CoefficientTables> getShared(float sample_rate, float freqStart, float freqEnd, float freqInterval,
+                                                              float gainStart, float gainEnd, float gainInterval);
 
+    bool lookupFrequency(float cutOffFrequency, double& cosW0, double& sinW0) const;
+    bool lookupGain(float gain, double& A, double& sqrtA) const;
+
+    float m_sample_rate;
+    float m_freqStart, m_freqEnd, m_freqInterval;
+    float m_gainStart, m_gainEnd, m_gainInterval;
 
 private:
+    static int findStep(float value, float start, float interval, int numSteps);
 
+    std::vector<double> m_cosW0, m_sinW0;
+    std::vector<double> m_A, m_sqrtA;
 };
 
-class SideShelfFilter : public Filter
-{
-public:
-    void processFilter(juce::AudioBuffer<float>&, juce::MidiBuffer&, int numberSamples, std::atomic<float>* cutOffFrequency, std::atomic<float>* gain);
+// From the tables when the values sit on their step grid, computed directly otherwise
+BiquadCoefficients makeLowShelf(float cutOffFrequency, float gain, float sample_rate, const CoefficientTables* tables);
+BiquadCoefficients makeHighPass(float cutOffFrequency, float sample_rate, const CoefficientTables* tables);
 
+//==============================================================================
+/**
+    Mid/side filter engine: encodes L/R to M/S, runs the mid shelf, side high
+    pass and side shelf, then decodes back to L/R with make up gain, all in a
+    single pass over the buffer.
 
-private:
+    The mid and side paths sit in the two lanes of one SIMD register and run in
+    lockstep as two transposed direct form II stages:
 
-};
+        stage 0: [ mid shelf    | side high pass ]
+        stage 1: [ pass-through | side shelf     ]
+
+    Coefficients and states are kept as structure-of-arrays so that each row
+    loads straight into a register.
 
-class SideHpFilter : public Filter
+    The filters always run in double. The float path rounds to float between
+    stages (where the original chain stored into its float buffer), the
+    double path never rounds.
+*/
+class MidSideFilterChain
 {
 public:
-    void processFilter(juce::AudioBuffer<float>&, juce::MidiBuffer&, int numberSamples, std::atomic<float>* cutOffFrequency);
+    enum
+    {
+        midLane = 0,
+        sideLane = 1,
+        numLanes = 2,
+        numStages = 2
+    };
+
+    MidSideFilterChain();
+
+    void setSampleRate(float sample_rate);
+    void reset();
+
+    // Clears the side lane only, before processMid() takes over
+    void resetSide();
+
+    // Uses the tables for coefficient updates, or computes directly if null
+    void setCoefficientTables(std::shared_ptr<const CoefficientTables> tables);
 
+    // Only recomputes the stages whose parameters changed since the last call
+    void updateCoefficients(float midFreq, float midGain, float sideFreqLower, float sideFreqUpper, float sideGain);
+
+    // Make up gain ramps linearly from startGain to reach endGain on the last
+    // sample, so automation never steps. Instantiated for float and double
+    template <typename SampleType>
+    void process(SampleType* left, SampleType* right, int numberSamples, SampleType startGain, SampleType endGain);
+
+    template <typename SampleType>
+    void process(SampleType* left, SampleType* right, int numberSamples, SampleType makeUpGain)
+    {
+        process(left, right, numberSamples, makeUpGain, makeUpGain);
+    }
+
+    // process() for input with no side, on the one channel both sides share:
+    // only the mid shelf runs, and its output goes out for left and right
+    // alike. The side lane has to be at rest (resetSide())
+    template <typename SampleType>
+    void processMid(SampleType* samples, int numberSamples, SampleType startGain, SampleType endGain);
+
+    // Samples the longer of the mid and side cascades rings on after the
+    // input stops, with the current coefficients
+    int getTailLengthInSamples() const;
 
 private:
+    void setStage(int stage, int lane, const BiquadCoefficients& coefficients);
+    void invalidateCoefficients();
+
+    BiquadCoefficients lowShelf(float cutOffFrequency, float gain) const;
+    BiquadCoefficients highPass(float cutOffFrequency) const;
+
+    float m_sample_rate = 44100.0f;
+    std::shared_ptr<const CoefficientTables> m_tables;
+
+    // Parameters the current coefficients were computed for
+    float m_midFreq, m_midGain, m_sideFreqLower, m_sideFreqUpper, m_sideGain;
+
+    // Coefficients, [stage][lane]
+    alignas(16) double m_b0[numStages][numLanes];
+    alignas(16) double m_b1[numStages][numLanes];
+    alignas(16) double m_b2[numStages][numLanes];
+    alignas(16) double m_a1[numStages][numLanes];
+    alignas(16) double m_a2[numStages][numLanes];
+
+    // getDecayLength() of each stage, kept with the coefficients
+    double m_decayLength[numStages][numLanes];
 
+    // Filter states, [stage][lane]
+    alignas(16) double m_z1[numStages][numLanes];
+    alignas(16) double m_z2[numStages][numLanes];
 };
 
-#endif 
\ No newline at end of file
+#endif
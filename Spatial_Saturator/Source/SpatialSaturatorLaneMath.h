@@ -0,0 +1,152 @@
+/*
+  ==============================================================================
+
+    This file contains tanh, sin, cos, expm1 and log1p on the four double
+    precision lanes of SIMD::double4, for the waveshaper's lane kernels
+
+  ==============================================================================
+*/
+#ifndef __SpatialSaturatorLaneMath__SpatialSaturatorLaneMath__
+#define __SpatialSaturatorLaneMath__SpatialSaturatorLaneMath__
+
+#pragma once
+
+#include "SpatialSaturatorSIMD.h"
+
+//==============================================================================
+/**
+    Four independent inputs per call, one per lane, so four bands or four
+    streams share one evaluation. Unlike FastMath these keep double precision:
+    every function is within a few ulp of the C library over its domain, so
+    the Full quality curve and ADAA can run in lanes without a new error bound.
+
+    The range reductions are Cody & Waite with the constant split in parts
+    whose products with the reduced multiple are exact, and the kernels are
+    Taylor series taken far enough to be exact to double precision on the
+    reduced range.
+*/
+namespace LaneMath
+{
+    using SIMD::double4;
+
+    // exp(x) - 1 for x <= 0 (below -700 it returns -1)
+    SPATIAL_SATURATOR_INLINE double4 expm1(double4 x)
+    {
+        using namespace SIMD;
+
+        x = max(x, set4(-700.0));
+
+        // x = k log(2) + r, |r| <= log(2) / 2
+        const double4 k = round(mul(x, set4(1.44269504088896340736)));
+        double4 r = sub(x, mul(k, set4(6.93147180369123816490e-01)));
+        r = sub(r, mul(k, set4(1.90821492927058770002e-10)));
+
+        // expm1(r) to r^13, exact to double precision for |r| <= log(2) / 2
+        double4 p = set4(1.6059043836821613e-10);
+        p = add(mul(p, r), set4(2.08767569878681e-09));
+        p = add(mul(p, r), set4(2.505210838544172e-08));
+        p = add(mul(p, r), set4(2.755731922398589e-07));
+        p = add(mul(p, r), set4(2.7557319223985893e-06));
+        p = add(mul(p, r), set4(2.48015873015873e-05));
+        p = add(mul(p, r), set4(1.984126984126984e-04));
+        p = add(mul(p, r), set4(1.388888888888889e-03));
+        p = add(mul(p, r), set4(8.333333333333333e-03));
+        p = add(mul(p, r), set4(4.1666666666666664e-02));
+        p = add(mul(p, r), set4(1.6666666666666666e-01));
+        p = add(mul(p, r), set4(0.5));
+        p = add(mul(mul(p, r), r), r);
+
+        // 2^k (expm1(r) + 1) - 1
+        const double4 scale = exp2Integer(k);
+        return add(mul(p, scale), sub(scale, set4(1.0)));
+    }
+
+    // log(1 + x) for 0 <= x <= 1
+    SPATIAL_SATURATOR_INLINE double4 log1p(double4 x)
+    {
+        using namespace SIMD;
+
+        // log(1 + x) = 2 atanh(s), s = x / (2 + x) <= 1/3, series to s^33
+        const double4 s = div(x, add(x, set4(2.0)));
+        const double4 s2 = mul(s, s);
+
+        double4 p = set4(1.0 / 33.0);
+        p = add(mul(p, s2), set4(1.0 / 31.0));
+        p = add(mul(p, s2), set4(1.0 / 29.0));
+        p = add(mul(p, s2), set4(1.0 / 27.0));
+        p = add(mul(p, s2), set4(1.0 / 25.0));
+        p = add(mul(p, s2), set4(1.0 / 23.0));
+        p = add(mul(p, s2), set4(1.0 / 21.0));
+        p = add(mul(p, s2), set4(1.0 / 19.0));
+        p = add(mul(p, s2), set4(1.0 / 17.0));
+        p = add(mul(p, s2), set4(1.0 / 15.0));
+        p = add(mul(p, s2), set4(1.0 / 13.0));
+        p = add(mul(p, s2), set4(1.0 / 11.0));
+        p = add(mul(p, s2), set4(1.0 / 9.0));
+        p = add(mul(p, s2), set4(1.0 / 7.0));
+        p = add(mul(p, s2), set4(1.0 / 5.0));
+        p = add(mul(p, s2), set4(1.0 / 3.0));
+
+        return mul(set4(2.0), add(s, mul(mul(s, s2), p)));
+    }
+
+    // sin(r) for |r| <= pi / 2, to r^21
+    SPATIAL_SATURATOR_INLINE double4 sinReduced(double4 r)
+    {
+        using namespace SIMD;
+
+        const double4 r2 = mul(r, r);
+
+        double4 p = set4(1.9572941063391263e-20);
+        p = add(mul(p, r2), set4(-8.22063524662433e-18));
+        p = add(mul(p, r2), set4(2.8114572543455206e-15));
+        p = add(mul(p, r2), set4(-7.647163731819816e-13));
+        p = add(mul(p, r2), set4(1.6059043836821613e-10));
+        p = add(mul(p, r2), set4(-2.505210838544172e-08));
+        p = add(mul(p, r2), set4(2.7557319223985893e-06));
+        p = add(mul(p, r2), set4(-1.984126984126984e-04));
+        p = add(mul(p, r2), set4(8.333333333333333e-03));
+        p = add(mul(p, r2), set4(-1.6666666666666666e-01));
+
+        return add(r, mul(mul(r, r2), p));
+    }
+
+    // x - m pi, with pi in three parts so m * part is exact for |m| < 2^26
+    SPATIAL_SATURATOR_INLINE double4 subtractMultipleOfPi(double4 x, double4 m)
+    {
+        using namespace SIMD;
+
+        x = sub(x, mul(m, set4(3.1415926218032837)));
+        x = sub(x, mul(m, set4(3.1786509424591713e-08)));
+        return sub(x, mul(m, set4(1.2246467991473532e-16)));
+    }
+
+    // sin(x) = (-1)^k sin(x - k pi), for |x| < 2^26
+    SPATIAL_SATURATOR_INLINE double4 sin(double4 x)
+    {
+        using namespace SIMD;
+
+        const double4 k = round(mul(x, set4(0.31830988618379067154)));
+        return negateIfOdd(sinReduced(subtractMultipleOfPi(x, k)), k);
+    }
+
+    // cos(x) = (-1)^k sin(x - (k - 1/2) pi), for |x| < 2^26
+    SPATIAL_SATURATOR_INLINE double4 cos(double4 x)
+    {
+        using namespace SIMD;
+
+        const double4 k = round(add(mul(x, set4(0.31830988618379067154)), set4(0.5)));
+        return negateIfOdd(sinReduced(subtractMultipleOfPi(x, sub(k, set4(0.5)))), k);
+    }
+
+    // tanh(|x|) = -expm1(-2|x|) / (2 + expm1(-2|x|)), with the sign of x
+    SPATIAL_SATURATOR_INLINE double4 tanh(double4 x)
+    {
+        using namespace SIMD;
+
+        const double4 e = expm1(mul(abs(x), set4(-2.0)));
+        return copySign(div(e, sub(set4(-2.0), e)), x);
+    }
+}
+
+#endif
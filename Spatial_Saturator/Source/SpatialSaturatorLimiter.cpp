@@ -0,0 +1,288 @@
+/*
+  ==============================================================================
+
+    This file contains the look-ahead true-peak limiter
+
+  ==============================================================================
+*/
+
+#include "SpatialSaturatorLimiter.h"
+#include "SpatialSaturatorSIMD.h"
+#include <algorithm>
+#include <cmath>
+
+static const double pi = 3.14159265358979323846;
+
+//==============================================================================
+static double besselI0(double x)
+{
+    double sum = 1.0, term = 1.0;
+
+    for (int k = 1; k < 50; ++k)
+    {
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
+
+        if (term < sum * 1e-17)
+            break;
+    }
+
+    return sum;
+}
+
+static int nextPowerOfTwo(int n)
+{
+    int power = 1;
+
+    while (power < n)
+        power <<= 1;
+
+    return power;
+}
+
+//==============================================================================
+void Limiter::makeInterpolationTaps(float taps[tapsPerPhase][interpolationFactor])
+{
+    // 48 tap Kaiser windowed sinc, cut off at the base rate Nyquist (as in BS.1770)
+    const int numTaps = tapsPerPhase * interpolationFactor;
+    const double centre = (numTaps - 1) / 2.0;
+    const double beta = 0.1102 * (60.0 - 8.7);
+
+    double kaiser[numTaps];
+    for (int i = 0; i < numTaps; ++i)
+    {
+        double t = i - centre;
+        double r = t / centre;
+        kaiser[i] = sin(pi * t / interpolationFactor) / (pi * t) * besselI0(beta * sqrt(std::max(0.0, 1 - r * r))) / besselI0(beta);
+    }
+
+    // Phase q uses taps q, q + 4, ...; each is normalised to unity gain at DC
+    for (int phase = 0; phase < interpolationFactor; ++phase)
+    {
+        double sum = 0.0;
+        for (int k = 0; k < tapsPerPhase; ++k)
+            sum += kaiser[k * interpolationFactor + phase];
+
+        for (int k = 0; k < tapsPerPhase; ++k)
+            taps[k][phase] = (float)(kaiser[k * interpolationFactor + phase] / sum);
+    }
+}
+
+void Limiter::prepare(double sampleRate, int numChannels, int maxBlockSize)
+{
+    m_sampleRate = sampleRate;
+    m_maxBlockSize = maxBlockSize;
+
+    makeInterpolationTaps(m_interpolationTaps);
+
+    m_histories.assign((size_t)numChannels, std::vector<float>(2 * tapsPerPhase, 0.0f));
+
+    const int maxLookahead = (int)std::ceil(maxLookaheadMs * 0.001 * sampleRate);
+
+    m_dequeMask = nextPowerOfTwo(maxLookahead + 2) - 1;
+    m_dequeGains.assign((size_t)m_dequeMask + 1, 1.0f);
+    m_dequeTimes.assign((size_t)m_dequeMask + 1, 0);
+
+    m_averageHistory.assign((size_t)maxLookahead, 1.0f);
+
+    m_delayMask = nextPowerOfTwo(maxLookahead + interpolationDelay + 1) - 1;
+    m_floatDelayLines.assign((size_t)numChannels, std::vector<float>((size_t)m_delayMask + 1, 0.0f));
+    m_doubleDelayLines.assign((size_t)numChannels, std::vector<double>((size_t)m_delayMask + 1, 0.0));
+
+    m_gains.assign((size_t)maxBlockSize, 1.0f);
+
+    m_lookahead = std::min(std::max(m_lookahead, 1), maxLookahead);
+    reset();
+}
+
+void Limiter::reset()
+{
+    for (auto& history : m_histories)
+        std::fill(history.begin(), history.end(), 0.0f);
+
+    m_historyPosition = 0;
+
+    m_dequeHead = m_dequeTail = m_time = 0;
+
+    m_releasedGain = 1.0f;
+    std::fill(m_averageHistory.begin(), m_averageHistory.end(), 1.0f);
+    m_averageSum = (double)m_lookahead;
+    m_averagePosition = 0;
+
+    for (auto& delayLine : m_floatDelayLines)
+        std::fill(delayLine.begin(), delayLine.end(), 0.0f);
+
+    for (auto& delayLine : m_doubleDelayLines)
+        std::fill(delayLine.begin(), delayLine.end(), 0.0);
+
+    m_delayPosition = 0;
+}
+
+void Limiter::copyChannelState(int from, int to)
+{
+    auto copy = [from, to](auto& lines)
+    {
+        std::copy(lines[(size_t)from].begin(), lines[(size_t)from].end(), lines[(size_t)to].begin());
+    };
+
+    copy(m_histories);
+    copy(m_floatDelayLines);
+    copy(m_doubleDelayLines);
+}
+
+void Limiter::setParameters(float ceilingDecibels, float lookaheadMs, float releaseMs)
+{
+    m_ceiling = std::pow(10.0f, ceilingDecibels * 0.05f);
+    m_releaseCoefficient = (float)std::exp(-1.0 / (releaseMs * 0.001 * m_sampleRate));
+
+    int lookahead = std::max(1, (int)std::lround(lookaheadMs * 0.001 * m_sampleRate));
+    lookahead = std::min(lookahead, std::max(1, (int)m_averageHistory.size()));
+
+    if (lookahead != m_lookahead)
+    {
+        m_lookahead = lookahead;
+        reset();
+    }
+}
+
+int Limiter::getLatencyInSamples() const
+{
+    return m_lookahead + interpolationDelay;
+}
+
+//==============================================================================
+float Limiter::detectTruePeak(int channel, float sample)
+{
+    using namespace SIMD;
+
+    // Newest sample first, so x[n - k] sits at position + k
+    float* history = m_histories[(size_t)channel].data() + m_historyPosition;
+    history[0] = sample;
+    history[tapsPerPhase] = sample;
+
+    // All four interpolated phases at once
+    float4 sum = set(0.0f);
+    for (int k = 0; k < tapsPerPhase; ++k)
+        sum = add(sum, mul(load(m_interpolationTaps[k]), set(history[k])));
+
+    float phases[interpolationFactor];
+    store(phases, max(sum, sub(set(0.0f), sum)));
+
+    // The sample peak at the newer end of the interpolated interval
+    float peak = std::abs(history[interpolationDelay]);
+
+    for (int phase = 0; phase < interpolationFactor; ++phase)
+        peak = std::max(peak, phases[phase]);
+
+    return peak;
+}
+
+float Limiter::holdMinimum(float gain)
+{
+    // Drop every older gain that is not smaller, they can never be the minimum again
+    while (m_dequeTail > m_dequeHead && m_dequeGains[(size_t)((m_dequeTail - 1) & m_dequeMask)] >= gain)
+        --m_dequeTail;
+
+    m_dequeGains[(size_t)(m_dequeTail & m_dequeMask)] = gain;
+    m_dequeTimes[(size_t)(m_dequeTail & m_dequeMask)] = m_time;
+    ++m_dequeTail;
+
+    // Expire the front once it leaves the window of m_lookahead + 1 samples
+    while (m_dequeTimes[(size_t)(m_dequeHead & m_dequeMask)] < m_time - m_lookahead)
+        ++m_dequeHead;
+
+    ++m_time;
+    return m_dequeGains[(size_t)(m_dequeHead & m_dequeMask)];
+}
+
+template <>
+std::vector<std::vector<float>>& Limiter::getDelayLines<float>()
+{
+    return m_floatDelayLines;
+}
+
+template <>
+std::vector<std::vector<double>>& Limiter::getDelayLines<double>()
+{
+    return m_doubleDelayLines;
+}
+
+template <>
+void Limiter::applyGains(float* samples, int numSamples) const
+{
+    using namespace SIMD;
+
+    int n = 0;
+    for (; n + 4 <= numSamples; n += 4)
+        store(samples + n, mul(load(samples + n), load(m_gains.data() + n)));
+
+    for (; n < numSamples; ++n)
+        samples[n] *= m_gains[(size_t)n];
+}
+
+template <>
+void Limiter::applyGains(double* samples, int numSamples) const
+{
+    for (int n = 0; n < numSamples; ++n)
+        samples[n] *= (double)m_gains[(size_t)n];
+}
+
+template <typename SampleType>
+void Limiter::process(SampleType* const* channels, int numChannels, int numSamples)
+{
+    numChannels = std::min(numChannels, (int)m_histories.size());
+
+    if (m_maxBlockSize <= 0 || numChannels == 0)
+        return;
+
+    const int delay = getLatencyInSamples();
+
+    for (int start = 0; start < numSamples; start += m_maxBlockSize)
+    {
+        const int chunkSize = std::min(numSamples - start, m_maxBlockSize);
+
+        // Gain envelope for the chunk
+        for (int n = 0; n < chunkSize; ++n)
+        {
+            m_historyPosition = (m_historyPosition + tapsPerPhase - 1) % tapsPerPhase;
+
+            float peak = 0.0f;
+            for (int ch = 0; ch < numChannels; ++ch)
+                peak = std::max(peak, detectTruePeak(ch, (float)channels[ch][start + n]));
+
+            float gain = peak > m_ceiling ? m_ceiling / peak : 1.0f;
+            float held = holdMinimum(gain);
+
+            // Instant attack (the averaging does the ramp), one pole release
+            m_releasedGain = held < m_releasedGain ? held : held + m_releaseCoefficient * (m_releasedGain - held);
+
+            m_averageSum += (double)m_releasedGain - (double)m_averageHistory[(size_t)m_averagePosition];
+            m_averageHistory[(size_t)m_averagePosition] = m_releasedGain;
+            m_averagePosition = m_averagePosition + 1 < m_lookahead ? m_averagePosition + 1 : 0;
+
+            m_gains[(size_t)n] = (float)(m_averageSum / m_lookahead);
+        }
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            SampleType* samples = channels[ch] + start;
+            SampleType* delayLine = getDelayLines<SampleType>()[(size_t)ch].data();
+            int position = m_delayPosition;
+
+            // Swap the chunk with the delayed audio
+            for (int n = 0; n < chunkSize; ++n)
+            {
+                delayLine[position] = samples[n];
+                samples[n] = delayLine[(position - delay) & m_delayMask];
+                position = (position + 1) & m_delayMask;
+            }
+
+            applyGains(samples, chunkSize);
+        }
+
+        m_delayPosition = (m_delayPosition + chunkSize) & m_delayMask;
+    }
+}
+
+template void Limiter::process<float>(float* const*, int, int);
+template void Limiter::process<double>(double* const*, int, int);
@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    This file contains the look-ahead true-peak brickwall limiter that ends
+    the processing chain
+
+  ==============================================================================
+*/
+#ifndef __SpatialSaturatorLimiter__SpatialSaturatorLimiter__
+#define __SpatialSaturatorLimiter__SpatialSaturatorLimiter__
+
+#pragma once
+
+#include <vector>
+
+//==============================================================================
+/**
+    Look-ahead brickwall limiter with inter-sample peak detection.
+
+    Peaks are taken from a 4x polyphase interpolation of every channel (the
+    four phases run in one SIMD register), so the limit holds for the true
+    peak and not just the sample peaks. Per sample, the gain needed to keep
+    the peak under the ceiling then goes through:
+
+        sliding window minimum (monotonic deque, O(1) amortised)
+        release (one pole, only ever slows the gain coming back up)
+        moving average over the look-ahead (the attack ramp)
+
+    The minimum is held one sample longer than the average, so the averaged
+    gain is fully down on both samples around every detected peak. The audio
+    is delayed to line up with it, and the gain is applied a block at a time.
+
+    process() takes float or double channels. Detection and the gain envelope
+    run in float either way, the audio itself stays in its own precision.
+*/
+class Limiter
+{
+public:
+    enum { maxLookaheadMs = 10 };
+
+    // Allocates for the longest look-ahead at this sample rate
+    void prepare(double sampleRate, int numChannels, int maxBlockSize);
+    void reset();
+
+    // Gives channel to the peak history and delayed audio of channel from;
+    // the gain is shared anyway
+    void copyChannelState(int from, int to);
+
+    // Takes the raw parameter values; a new look-ahead resets the limiter
+    void setParameters(float ceilingDecibels, float lookaheadMs, float releaseMs);
+
+    int getLatencyInSamples() const;
+
+    template <typename SampleType>
+    void process(SampleType* const* channels, int numChannels, int numSamples);
+
+    enum
+    {
+        interpolationFactor = 4,
+        tapsPerPhase = 12,
+        // Interpolated values of the newest history fall between x[n - 6] and x[n - 5]
+        interpolationDelay = tapsPerPhase / 2 - 1
+    };
+
+    // The 4x true-peak interpolator, [tap][phase]; shared with the meters
+    static void makeInterpolationTaps(float taps[tapsPerPhase][interpolationFactor]);
+
+private:
+
+    float detectTruePeak(int channel, float sample);
+    float holdMinimum(float gain);
+
+    double m_sampleRate = 44100.0;
+    int m_maxBlockSize = 0;
+
+    float m_ceiling = 1.0f;
+    float m_releaseCoefficient = 0.0f;
+    int m_lookahead = 1;
+
+    // 4x interpolator, taps interleaved by phase so a row loads into one register
+    alignas(16) float m_interpolationTaps[tapsPerPhase][interpolationFactor];
+    // Per channel input histories, stored twice so the newest taps are contiguous
+    std::vector<std::vector<float>> m_histories;
+    int m_historyPosition = 0;
+
+    // Sliding minimum of the needed gain over m_lookahead + 1 samples
+    std::vector<float> m_dequeGains;
+    std::vector<long long> m_dequeTimes;
+    long long m_dequeHead = 0, m_dequeTail = 0, m_time = 0;
+    int m_dequeMask = 0;
+
+    // Released gain and its moving average over m_lookahead samples
+    float m_releasedGain = 1.0f;
+    std::vector<float> m_averageHistory;
+    double m_averageSum = 0.0;
+    int m_averagePosition = 0;
+
+    // Audio delay lines, one ring per channel
+    std::vector<std::vector<float>> m_floatDelayLines;
+    std::vector<std::vector<double>> m_doubleDelayLines;
+    int m_delayMask = 0;
+    int m_delayPosition = 0;
+
+    // Smoothed gain for the current block
+    std::vector<float> m_gains;
+
+    template <typename SampleType>
+    std::vector<std::vector<SampleType>>& getDelayLines();
+    template <typename SampleType>
+    void applyGains(SampleType* samples, int numSamples) const;
+};
+
+#endif
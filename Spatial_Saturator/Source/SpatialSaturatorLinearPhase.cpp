@@ -0,0 +1,648 @@
+/*
+  ==============================================================================
+
+    This file contains the linear phase mid/side filter
+
+  ==============================================================================
+*/
+
+#include "SpatialSaturatorLinearPhase.h"
+#include "SpatialSaturatorFilter.h"
+#include "SpatialSaturatorSIMD.h"
+#include <algorithm>
+#include <chrono>
+#include <complex>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+static const double pi = 3.14159265358979323846;
+
+//==============================================================================
+void FFT::prepare(int order)
+{
+    m_size = 1 << order;
+
+    m_bitReverse.resize((size_t)m_size);
+    for (int i = 0; i < m_size; ++i)
+    {
+        int reversed = 0;
+        for (int bit = 0; bit < order; ++bit)
+            reversed |= ((i >> bit) & 1) << (order - 1 - bit);
+
+        m_bitReverse[(size_t)i] = reversed;
+    }
+
+    // Each stage gets its own contiguous table, so the butterflies read it in order
+    m_twiddleReal.resize((size_t)std::max(1, m_size - 1));
+    m_twiddleImag.resize((size_t)std::max(1, m_size - 1));
+
+    for (int half = 1; half < m_size; half <<= 1)
+        for (int k = 0; k < half; ++k)
+        {
+            const double angle = -pi * (double)k / (double)half;
+            m_twiddleReal[(size_t)(half - 1 + k)] = (float)std::cos(angle);
+            m_twiddleImag[(size_t)(half - 1 + k)] = (float)std::sin(angle);
+        }
+}
+
+void FFT::transform(float* real, float* imag) const
+{
+    using namespace SIMD;
+
+    for (int i = 0; i < m_size; ++i)
+    {
+        const int j = m_bitReverse[(size_t)i];
+        if (i < j)
+        {
+            std::swap(real[i], real[j]);
+            std::swap(imag[i], imag[j]);
+        }
+    }
+
+    for (int half = 1; half < m_size; half <<= 1)
+    {
+        const float* wr = m_twiddleReal.data() + half - 1;
+        const float* wi = m_twiddleImag.data() + half - 1;
+
+        for (int start = 0; start < m_size; start += 2 * half)
+        {
+            float* ar = real + start;
+            float* ai = imag + start;
+            float* br = ar + half;
+            float* bi = ai + half;
+
+            if (half >= 4)
+            {
+                for (int k = 0; k < half; k += 4)
+                {
+                    const float4 twr = load(wr + k), twi = load(wi + k);
+                    const float4 xr = load(br + k), xi = load(bi + k);
+                    const float4 tr = sub(mul(xr, twr), mul(xi, twi));
+                    const float4 ti = add(mul(xr, twi), mul(xi, twr));
+                    const float4 yr = load(ar + k), yi = load(ai + k);
+
+                    store(br + k, sub(yr, tr));
+                    store(bi + k, sub(yi, ti));
+                    store(ar + k, add(yr, tr));
+                    store(ai + k, add(yi, ti));
+                }
+            }
+            else
+            {
+                for (int k = 0; k < half; ++k)
+                {
+                    const float tr = br[k] * wr[k] - bi[k] * wi[k];
+                    const float ti = br[k] * wi[k] + bi[k] * wr[k];
+
+                    br[k] = ar[k] - tr;
+                    bi[k] = ai[k] - ti;
+                    ar[k] += tr;
+                    ai[k] += ti;
+                }
+            }
+        }
+    }
+}
+
+//==============================================================================
+bool LinearPhaseMidSideFilter::DesignParameters::operator==(const DesignParameters& other) const
+{
+    return midFreq == other.midFreq && midGain == other.midGain && sideFreqLower == other.sideFreqLower
+        && sideFreqUpper == other.sideFreqUpper && sideGain == other.sideGain;
+}
+
+//==============================================================================
+/**
+    The one thread that designs the kernels of every LinearPhaseMidSideFilter
+    in the process, so a session of many instances has one sleeping thread
+    rather than one per instance. It runs from the first filter prepared until
+    the last one is destroyed, and sleeps on a condition variable between
+    requests.
+
+    The worker holds the lock while it designs, so prepare() and the
+    destructor, which take it too, never overlap a design of their filter.
+    The audio thread only ever bumps a counter and notifies.
+*/
+class KernelDesigner
+{
+public:
+    // Never destroyed, so filters in static objects can still leave it at exit
+    static KernelDesigner& getInstance()
+    {
+        static KernelDesigner* const instance = new KernelDesigner();
+        return *instance;
+    }
+
+    // Starts the worker with the first filter
+    void add(LinearPhaseMidSideFilter* filter)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_filters.push_back(filter);
+
+        if (!m_thread.joinable())
+        {
+            const unsigned int generation = ++m_generation;
+            m_thread = std::thread([this, generation] { run(generation); });
+        }
+    }
+
+    // Waits for a design of filter in progress, and stops the worker after the last filter
+    void remove(LinearPhaseMidSideFilter* filter)
+    {
+        std::thread finished;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_filters.erase(std::remove(m_filters.begin(), m_filters.end(), filter), m_filters.end());
+
+            // A worker started by a later add() runs under the next generation
+            if (m_filters.empty() && m_thread.joinable())
+            {
+                ++m_generation;
+                finished = std::move(m_thread);
+            }
+        }
+
+        if (finished.joinable())
+        {
+            m_condition.notify_all();
+            finished.join();
+        }
+    }
+
+    std::mutex& getMutex() { return m_mutex; }
+
+    // Realtime safe
+    void wake()
+    {
+        m_requests.fetch_add(1, std::memory_order_release);
+        m_condition.notify_one();
+    }
+
+private:
+    KernelDesigner() = default;
+
+    void run(unsigned int generation)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        while (m_generation == generation)
+        {
+            const unsigned int requests = m_requests.load(std::memory_order_acquire);
+
+            bool designed = false;
+            for (auto* filter : m_filters)
+                designed = filter->serviceDesignRequests() || designed;
+
+            // A wake-up between the check and the wait would be lost, as
+            // wake() does not take the lock; the timeout catches that case
+            if (!designed)
+                m_condition.wait_for(lock, std::chrono::milliseconds(250), [this, generation, requests]
+                {
+                    return m_generation != generation || m_requests.load(std::memory_order_acquire) != requests;
+                });
+        }
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::vector<LinearPhaseMidSideFilter*> m_filters;
+    std::atomic<unsigned int> m_requests{ 0 };
+    unsigned int m_generation = 0;
+    std::thread m_thread;
+};
+
+//==============================================================================
+LinearPhaseMidSideFilter::~LinearPhaseMidSideFilter()
+{
+    if (m_registered)
+        KernelDesigner::getInstance().remove(this);
+}
+
+void LinearPhaseMidSideFilter::prepare(float sampleRate, float midFreq, float midGain, float sideFreqLower, float sideFreqUpper, float sideGain,
+                                       bool allocate)
+{
+    auto& designer = KernelDesigner::getInstance();
+
+    if (!m_registered)
+    {
+        designer.add(this);
+        m_registered = true;
+    }
+
+    std::lock_guard<std::mutex> lock(designer.getMutex());
+
+    m_sampleRate = sampleRate;
+
+    // Long enough for the response of the lowest corner the parameters allow
+    // (20Hz) to die out inside the kernel, so the same at every rate in time
+    m_kernelOrder = sampleRate > 100000.0f ? 15 : sampleRate > 50000.0f ? 14 : 13;
+    m_kernelLength = 1 << m_kernelOrder;
+    m_numPartitions = m_kernelLength / partitionSize;
+
+    m_postedParameters = { midFreq, midGain, sideFreqLower, sideFreqUpper, sideGain };
+
+    m_requestMidFreq.store(midFreq);
+    m_requestMidGain.store(midGain);
+    m_requestSideFreqLower.store(sideFreqLower);
+    m_requestSideFreqUpper.store(sideFreqUpper);
+    m_requestSideGain.store(sideGain);
+
+    m_designedVersion = m_requestVersion.load();
+    m_activationRequested.store(false);
+
+    // Once used, the filter stays allocated, so preparing it again at another
+    // rate resizes it. Otherwise activate() allocates it when it is needed
+    if (allocate || m_ready.load())
+        initialise(m_postedParameters);
+}
+
+void LinearPhaseMidSideFilter::initialise(const DesignParameters& parameters)
+{
+    m_fft.prepare(fftOrder);
+    m_designFFT.prepare(m_kernelOrder);
+    m_designSpectrum.assign((size_t)(2 * m_kernelLength), 0.0f);
+    m_designTaps.assign((size_t)(2 * m_kernelLength), 0.0f);
+    m_designFrame.assign((size_t)(2 * fftSize), 0.0f);
+
+    for (int slot = 0; slot < numKernelSlots; ++slot)
+    {
+        m_kernels[slot].sum.assign((size_t)(m_numPartitions * 2 * fftSize), 0.0f);
+        m_kernels[slot].difference.assign((size_t)(m_numPartitions * 2 * fftSize), 0.0f);
+        m_slotStates[slot].store(slotFree);
+    }
+
+    m_inputFrame.assign((size_t)(2 * fftSize), 0.0f);
+    m_spectra.assign((size_t)(m_numPartitions * 4 * fftSize), 0.0f);
+    m_result.assign((size_t)(2 * fftSize), 0.0f);
+    m_fadeResult.assign((size_t)(2 * fftSize), 0.0f);
+    m_output.assign((size_t)(2 * partitionSize), 0.0f);
+
+    // The first kernel is ready before anything plays
+    design(m_kernels[0], parameters);
+    m_slotStates[0].store(slotInUse);
+    m_currentSlot = 0;
+    m_nextSlot = -1;
+    m_readySlot.store(-1);
+
+    m_position = 0;
+    m_newestSpectrum = 0;
+    m_fadePosition = 0;
+
+    // Publishes everything above to the audio thread
+    m_ready.store(true, std::memory_order_release);
+}
+
+void LinearPhaseMidSideFilter::activate()
+{
+    if (!m_ready.load(std::memory_order_acquire) && !m_activationRequested.exchange(true))
+        KernelDesigner::getInstance().wake();
+}
+
+void LinearPhaseMidSideFilter::reset()
+{
+    // Not allocated yet, or being allocated by the design worker
+    if (!m_ready.load(std::memory_order_acquire))
+        return;
+
+    // A pending crossfade has nothing to fade from any more
+    if (m_nextSlot >= 0)
+    {
+        releaseSlot(m_currentSlot);
+        m_currentSlot = m_nextSlot;
+        m_nextSlot = -1;
+    }
+
+    std::fill(m_inputFrame.begin(), m_inputFrame.end(), 0.0f);
+    std::fill(m_spectra.begin(), m_spectra.end(), 0.0f);
+    std::fill(m_output.begin(), m_output.end(), 0.0f);
+
+    m_position = 0;
+    m_newestSpectrum = 0;
+    m_fadePosition = 0;
+}
+
+void LinearPhaseMidSideFilter::setParameters(float midFreq, float midGain, float sideFreqLower, float sideFreqUpper, float sideGain)
+{
+    const DesignParameters parameters = { midFreq, midGain, sideFreqLower, sideFreqUpper, sideGain };
+
+    if (parameters == m_postedParameters)
+        return;
+
+    m_postedParameters = parameters;
+
+    m_requestMidFreq.store(midFreq);
+    m_requestMidGain.store(midGain);
+    m_requestSideFreqLower.store(sideFreqLower);
+    m_requestSideFreqUpper.store(sideFreqUpper);
+    m_requestSideGain.store(sideGain);
+
+    // Published last, so the design worker sees every value once it sees the version
+    m_requestVersion.fetch_add(1, std::memory_order_release);
+
+    // Until activated the worker has nothing to do; activation reads the latest values
+    if (m_ready.load(std::memory_order_relaxed))
+        KernelDesigner::getInstance().wake();
+}
+
+void LinearPhaseMidSideFilter::releaseSlot(int slot)
+{
+    m_slotStates[slot].store(slotFree, std::memory_order_release);
+}
+
+//==============================================================================
+LinearPhaseMidSideFilter::DesignParameters LinearPhaseMidSideFilter::getRequest() const
+{
+    // A value that changes while being read also bumps the version again,
+    // so the latest request is always designed in the end
+    return { m_requestMidFreq.load(), m_requestMidGain.load(), m_requestSideFreqLower.load(),
+             m_requestSideFreqUpper.load(), m_requestSideGain.load() };
+}
+
+bool LinearPhaseMidSideFilter::serviceDesignRequests()
+{
+    if (!m_ready.load(std::memory_order_acquire))
+    {
+        if (!m_activationRequested.exchange(false))
+            return false;
+
+        m_designedVersion = m_requestVersion.load(std::memory_order_acquire);
+        initialise(getRequest());
+        return true;
+    }
+
+    const unsigned int version = m_requestVersion.load(std::memory_order_acquire);
+
+    if (version == m_designedVersion)
+        return false;
+
+    int slot = -1;
+    for (int i = 0; i < numKernelSlots && slot < 0; ++i)
+        if (m_slotStates[i].load(std::memory_order_acquire) == slotFree)
+            slot = i;
+
+    // Only while the audio thread holds all the slots; the next wake-up retries
+    if (slot < 0)
+        return false;
+
+    design(m_kernels[slot], getRequest());
+    m_designedVersion = version;
+
+    m_slotStates[slot].store(slotReady, std::memory_order_release);
+
+    // A ready kernel the audio thread never took is replaced by the newer one
+    const int replaced = m_readySlot.exchange(slot, std::memory_order_acq_rel);
+    if (replaced >= 0)
+        releaseSlot(replaced);
+
+    return true;
+}
+
+// Kaiser window shape, chosen against the 20Hz corners at the kernel length
+static const double kaiserBeta = 1.0;
+
+// Modified Bessel function of the first kind, order 0, by its power series
+static double besselI0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    const double quarterSquare = 0.25 * x * x;
+
+    for (int k = 1; term > 1.0e-12 * sum; ++k)
+    {
+        term *= quarterSquare / ((double)k * (double)k);
+        sum += term;
+    }
+
+    return sum;
+}
+
+static double getMagnitude(const BiquadCoefficients& c, double w)
+{
+    const std::complex<double> z1 = std::polar(1.0, -w);
+    const std::complex<double> z2 = z1 * z1;
+
+    return std::abs((c.b0 + c.b1 * z1 + c.b2 * z2) / (1.0 + c.a1 * z1 + c.a2 * z2));
+}
+
+void LinearPhaseMidSideFilter::design(Kernel& kernel, const DesignParameters& p)
+{
+    const int length = m_kernelLength;
+
+    const BiquadCoefficients midShelf = makeLowShelf(p.midFreq, p.midGain, m_sampleRate);
+    const BiquadCoefficients sideHighPass = makeHighPass(p.sideFreqLower, m_sampleRate);
+    const BiquadCoefficients sideShelf = makeLowShelf(p.sideFreqUpper, p.sideGain, m_sampleRate);
+
+    // Magnitudes of both paths, mid as the real and side as the imaginary part.
+    // Both are real and even, so one inverse FFT gives both zero phase responses
+    float* spectrumReal = m_designSpectrum.data();
+    float* spectrumImag = spectrumReal + length;
+
+    for (int k = 0; k < length; ++k)
+    {
+        const double w = 2.0 * pi * (double)k / (double)length;
+        spectrumReal[k] = (float)getMagnitude(midShelf, w);
+        spectrumImag[k] = (float)(getMagnitude(sideHighPass, w) * getMagnitude(sideShelf, w));
+    }
+
+    m_designFFT.inverse(spectrumReal, spectrumImag);
+
+    // Centred on length / 2 and Kaiser windowed, which makes the kernel
+    // symmetric. The small beta only tapers the ends: a wider main lobe would
+    // smear the response around the low corners. The inverse FFT scaling of
+    // both transforms goes in here too
+    float* tapsReal = m_designTaps.data();
+    float* tapsImag = tapsReal + length;
+    const double scale = 1.0 / ((double)length * (double)fftSize * besselI0(kaiserBeta));
+
+    for (int n = 0; n < length; ++n)
+    {
+        const double x = 2.0 * (double)n / (double)length - 1.0;
+        const double window = besselI0(kaiserBeta * std::sqrt(1.0 - x * x)) * scale;
+        const int centred = (n + length / 2) & (length - 1);
+
+        tapsReal[n] = (float)(spectrumReal[centred] * window);
+        tapsImag[n] = (float)(spectrumImag[centred] * window);
+    }
+
+    // Spectrum of every partition, split into the mid and side parts
+    float* frameReal = m_designFrame.data();
+    float* frameImag = frameReal + fftSize;
+
+    for (int partition = 0; partition < m_numPartitions; ++partition)
+    {
+        std::fill(m_designFrame.begin(), m_designFrame.end(), 0.0f);
+        std::copy_n(tapsReal + partition * partitionSize, (size_t)partitionSize, frameReal);
+        std::copy_n(tapsImag + partition * partitionSize, (size_t)partitionSize, frameImag);
+
+        m_fft.forward(frameReal, frameImag);
+
+        float* sum = kernel.sum.data() + partition * 2 * fftSize;
+        float* difference = kernel.difference.data() + partition * 2 * fftSize;
+
+        for (int k = 0; k < fftSize; ++k)
+        {
+            const int mirror = (fftSize - k) & (fftSize - 1);
+
+            // Hmid = (Z + Z*) / 2 and Hside = (Z - Z*) / 2i, Z* mirrored and conjugated
+            const float midReal = 0.5f * (frameReal[k] + frameReal[mirror]);
+            const float midImag = 0.5f * (frameImag[k] - frameImag[mirror]);
+            const float sideReal = 0.5f * (frameImag[k] + frameImag[mirror]);
+            const float sideImag = -0.5f * (frameReal[k] - frameReal[mirror]);
+
+            sum[k] = 0.5f * (midReal + sideReal);
+            sum[fftSize + k] = 0.5f * (midImag + sideImag);
+            difference[k] = 0.5f * (midReal - sideReal);
+            difference[fftSize + k] = 0.5f * (midImag - sideImag);
+        }
+    }
+}
+
+//==============================================================================
+void LinearPhaseMidSideFilter::convolve(const Kernel& kernel, float* result)
+{
+    using namespace SIMD;
+
+    float* yr = result;
+    float* yi = result + fftSize;
+    std::fill(result, result + 2 * fftSize, 0.0f);
+
+    // With x = M + iS, the real signals' spectra are M = (X + X*) / 2 and
+    // iS = (X - X*) / 2, X* being X mirrored and conjugated. So
+    // Hmid M + i Hside S = X sum + X* difference
+    for (int partition = 0; partition < m_numPartitions; ++partition)
+    {
+        const float* x = m_spectra.data() + ((m_newestSpectrum + partition) % m_numPartitions) * 4 * fftSize;
+        const float* s = kernel.sum.data() + partition * 2 * fftSize;
+        const float* d = kernel.difference.data() + partition * 2 * fftSize;
+
+        for (int k = 0; k < fftSize; k += 4)
+        {
+            const float4 xr = load(x + k), xi = load(x + fftSize + k);
+            const float4 mr = load(x + 2 * fftSize + k), mi = load(x + 3 * fftSize + k);
+            const float4 sr = load(s + k), si = load(s + fftSize + k);
+            const float4 dr = load(d + k), di = load(d + fftSize + k);
+
+            const float4 real = sub(add(mul(xr, sr), mul(mr, dr)), add(mul(xi, si), mul(mi, di)));
+            const float4 imag = add(add(mul(xr, si), mul(xi, sr)), add(mul(mr, di), mul(mi, dr)));
+
+            store(yr + k, add(load(yr + k), real));
+            store(yi + k, add(load(yi + k), imag));
+        }
+    }
+
+    m_fft.inverse(yr, yi);
+}
+
+void LinearPhaseMidSideFilter::processPartition()
+{
+    // The newest input spectrum goes in front of the frequency domain delay line,
+    // with its mirrored conjugate next to it so the convolution reads both in order
+    m_newestSpectrum = (m_newestSpectrum == 0 ? m_numPartitions : m_newestSpectrum) - 1;
+
+    float* xr = m_spectra.data() + m_newestSpectrum * 4 * fftSize;
+    float* xi = xr + fftSize;
+    float* mr = xi + fftSize;
+    float* mi = mr + fftSize;
+
+    std::copy(m_inputFrame.begin(), m_inputFrame.end(), xr);
+    m_fft.forward(xr, xi);
+
+    for (int k = 0; k < fftSize; ++k)
+    {
+        const int mirror = (fftSize - k) & (fftSize - 1);
+        mr[k] = xr[mirror];
+        mi[k] = -xi[mirror];
+    }
+
+    // Keep the current partition as the previous one
+    float* inputReal = m_inputFrame.data();
+    float* inputImag = inputReal + fftSize;
+    std::copy_n(inputReal + partitionSize, (size_t)partitionSize, inputReal);
+    std::copy_n(inputImag + partitionSize, (size_t)partitionSize, inputImag);
+
+    // Pick up a new kernel, unless the last one is still fading in
+    if (m_nextSlot < 0)
+    {
+        const int ready = m_readySlot.exchange(-1, std::memory_order_acq_rel);
+        if (ready >= 0)
+        {
+            m_slotStates[ready].store(slotInUse, std::memory_order_relaxed);
+            m_nextSlot = ready;
+            m_fadePosition = 0;
+        }
+    }
+
+    convolve(m_kernels[m_currentSlot], m_result.data());
+
+    // Overlap-save: the second half of the inverse transform is the output
+    const float* mid = m_result.data() + partitionSize;
+    const float* side = m_result.data() + fftSize + partitionSize;
+
+    if (m_nextSlot < 0)
+    {
+        std::copy_n(mid, (size_t)partitionSize, m_output.data());
+        std::copy_n(side, (size_t)partitionSize, m_output.data() + partitionSize);
+        return;
+    }
+
+    convolve(m_kernels[m_nextSlot], m_fadeResult.data());
+
+    const float* fadeMid = m_fadeResult.data() + partitionSize;
+    const float* fadeSide = m_fadeResult.data() + fftSize + partitionSize;
+
+    for (int n = 0; n < partitionSize; ++n)
+    {
+        const float fade = std::min(1.0f, (float)(m_fadePosition + n + 1) / (float)crossfadeLength);
+
+        m_output[(size_t)n] = mid[n] + (fadeMid[n] - mid[n]) * fade;
+        m_output[(size_t)(partitionSize + n)] = side[n] + (fadeSide[n] - side[n]) * fade;
+    }
+
+    m_fadePosition += partitionSize;
+
+    if (m_fadePosition >= crossfadeLength)
+    {
+        releaseSlot(m_currentSlot);
+        m_currentSlot = m_nextSlot;
+        m_nextSlot = -1;
+    }
+}
+
+template <typename SampleType>
+void LinearPhaseMidSideFilter::process(SampleType* left, SampleType* right, int numberSamples, SampleType startGain, SampleType endGain)
+{
+    const double gainStart = (double)startGain;
+    const double gainStep = numberSamples > 0 ? ((double)endGain - gainStart) / numberSamples : 0.0;
+
+    float* inputMid = m_inputFrame.data() + partitionSize;
+    float* inputSide = m_inputFrame.data() + fftSize + partitionSize;
+    const float* outputMid = m_output.data();
+    const float* outputSide = m_output.data() + partitionSize;
+
+    for (int n = 0; n < numberSamples; ++n)
+    {
+        // Encode to M/S, the output comes from the partition before
+        const double l = (double)left[n];
+        const double r = (double)right[n];
+        inputMid[m_position] = (float)((l + r) * 0.5);
+        inputSide[m_position] = (float)((l - r) * 0.5);
+
+        const double mids = (double)outputMid[m_position];
+        const double sides = (double)outputSide[m_position];
+        const double gain = gainStart + gainStep * (n + 1);
+
+        left[n] = (SampleType)((mids + sides) * gain);
+        right[n] = (SampleType)((mids - sides) * gain);
+
+        if (++m_position == partitionSize)
+        {
+            processPartition();
+            m_position = 0;
+        }
+    }
+}
+
+template void LinearPhaseMidSideFilter::process<float>(float*, float*, int, float, float);
+template void LinearPhaseMidSideFilter::process<double>(double*, double*, int, double, double);
@@ -0,0 +1,177 @@
+/*
+  ==============================================================================
+
+    This file contains the linear phase mid/side filter, a long FIR designed
+    from the biquad magnitudes and run as a partitioned FFT convolution
+
+  ==============================================================================
+*/
+#ifndef __SpatialSaturatorLinearPhase__SpatialSaturatorLinearPhase__
+#define __SpatialSaturatorLinearPhase__SpatialSaturatorLinearPhase__
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+//==============================================================================
+/**
+    In-place radix-2 complex FFT of a fixed power of two size, on separate
+    real and imaginary arrays so that every butterfly stage from the third on
+    runs four at a time. Neither direction is normalised. The transforms only
+    read the tables, so one instance can be shared between threads.
+*/
+class FFT
+{
+public:
+    // Allocates the bit reversal and twiddle tables
+    void prepare(int order);
+
+    int getSize() const { return m_size; }
+
+    void forward(float* real, float* imag) const    { transform(real, imag); }
+
+    // Swapping real and imaginary parts turns the forward transform into the inverse
+    void inverse(float* real, float* imag) const    { transform(imag, real); }
+
+private:
+    void transform(float* real, float* imag) const;
+
+    int m_size = 0;
+    std::vector<int> m_bitReverse;
+
+    // exp(-2 pi i k / (2 * half)) for k < half, the stage with half starting at half - 1
+    std::vector<float> m_twiddleReal, m_twiddleImag;
+};
+
+//==============================================================================
+/**
+    The mid shelf, side high pass and side shelf of MidSideFilterChain as one
+    linear phase FIR per path. The kernels have the magnitude responses of the
+    biquads and no phase shift, at the cost of kernelLength / 2 samples of
+    latency.
+
+    The convolution is uniformly partitioned overlap-save: the kernel is cut
+    into partitions of partitionSize samples, each is transformed once, and
+    every block of partitionSize input samples costs one forward FFT, one
+    complex multiply-add per partition and one inverse FFT of size
+    2 * partitionSize. Mid and side share the transforms as the real and
+    imaginary part of one complex signal.
+
+    Designing a kernel takes a few large FFTs, so it runs on a design worker
+    thread that all the filters in the process share. setParameters() only
+    posts the request and wakes the worker; once the kernel is ready process()
+    picks it up without locking and crossfades to it over crossfadeLength
+    samples.
+
+    Nothing is allocated until the filter is used: prepare() only allocates
+    and designs the first kernel when asked to, otherwise activate() has the
+    worker do it, and process() may only run once isReady().
+*/
+class LinearPhaseMidSideFilter
+{
+public:
+    enum
+    {
+        partitionSize = 256,
+        crossfadeLength = 1024,
+        numKernelSlots = 4      // playing, fading in, ready and one being designed
+    };
+
+    LinearPhaseMidSideFilter() = default;
+    ~LinearPhaseMidSideFilter();
+
+    // Sets the sample rate and the first kernel's parameters. With allocate,
+    // or if the filter was ready before, also allocates everything and
+    // designs the first kernel, so the filter is ready on return. The kernel
+    // is 8192 samples long up to 48kHz and grows with the sample rate
+    void prepare(float sampleRate, float midFreq, float midGain, float sideFreqLower, float sideFreqUpper, float sideGain,
+                 bool allocate = true);
+    void reset();
+
+    // Realtime safe: has the design worker allocate the filter and design
+    // its first kernel, for the latest parameters, if it is not ready yet
+    void activate();
+    bool isReady() const { return m_ready.load(std::memory_order_acquire); }
+
+    // Realtime safe, the new kernel fades in once the design worker has made it
+    void setParameters(float midFreq, float midGain, float sideFreqLower, float sideFreqUpper, float sideGain);
+
+    // One partition of buffering plus half the kernel, and the tail the whole kernel
+    int getLatencyInSamples() const     { return partitionSize + m_kernelLength / 2; }
+    int getTailLengthInSamples() const  { return partitionSize + m_kernelLength; }
+    int getKernelLength() const         { return m_kernelLength; }
+
+    // Encodes to M/S, filters, decodes to L/R and applies a make up gain that
+    // moves linearly from startGain to endGain, like MidSideFilterChain.
+    // The convolution itself runs in float for either sample type
+    template <typename SampleType>
+    void process(SampleType* left, SampleType* right, int numberSamples, SampleType startGain, SampleType endGain);
+
+private:
+    friend class KernelDesigner;
+
+    enum { fftOrder = 9, fftSize = 1 << fftOrder };
+    static_assert(fftSize == 2 * partitionSize, "overlap-save needs two partitions per transform");
+
+    struct DesignParameters
+    {
+        float midFreq, midGain, sideFreqLower, sideFreqUpper, sideGain;
+
+        bool operator==(const DesignParameters& other) const;
+    };
+
+    // Partition spectra for the combined M/S convolution, real parts then
+    // imaginary parts for each partition: sum = (Hmid + Hside) / 2 and difference = (Hmid - Hside) / 2, scaled for the inverse FFT
+    struct Kernel
+    {
+        std::vector<float> sum, difference;
+    };
+
+    enum SlotState { slotFree = 0, slotReady, slotInUse };
+
+    // Design worker (or prepare()), with the worker's lock held. Returns
+    // whether there was anything to do
+    bool serviceDesignRequests();
+    void initialise(const DesignParameters& parameters);
+    void design(Kernel& kernel, const DesignParameters& parameters);
+    DesignParameters getRequest() const;
+
+    // Audio thread, once per partition
+    void processPartition();
+    void convolve(const Kernel& kernel, float* result);
+    void releaseSlot(int slot);
+
+    float m_sampleRate = 44100.0f;
+    int m_kernelOrder = 0, m_kernelLength = 0, m_numPartitions = 0;
+
+    FFT m_fft;                          // fftSize, shared with the design worker
+    FFT m_designFFT;                    // kernelLength, design worker only
+    std::vector<float> m_designSpectrum, m_designTaps, m_designFrame;
+
+    Kernel m_kernels[numKernelSlots];
+    std::atomic<int> m_slotStates[numKernelSlots];
+    std::atomic<int> m_readySlot{ -1 };
+
+    // Parameters posted by setParameters(), read back by the design worker
+    std::atomic<float> m_requestMidFreq{ 0.0f }, m_requestMidGain{ 0.0f };
+    std::atomic<float> m_requestSideFreqLower{ 0.0f }, m_requestSideFreqUpper{ 0.0f }, m_requestSideGain{ 0.0f };
+    std::atomic<unsigned int> m_requestVersion{ 0 };
+    DesignParameters m_postedParameters{};
+
+    unsigned int m_designedVersion = 0;     // design worker
+
+    bool m_registered = false;
+    std::atomic<bool> m_ready{ false }, m_activationRequested{ false };
+
+    // Convolution state. Every signal is stored as its real parts (mid)
+    // followed by its imaginary parts (side)
+    int m_currentSlot = 0, m_nextSlot = -1, m_fadePosition = 0;
+    int m_position = 0, m_newestSpectrum = 0;
+    std::vector<float> m_inputFrame;        // previous and current partition
+    std::vector<float> m_spectra;           // the last numPartitions input spectra, each followed by its mirrored conjugate
+    std::vector<float> m_result, m_fadeResult;
+    std::vector<float> m_output;            // the partition being played out
+};
+
+#endif
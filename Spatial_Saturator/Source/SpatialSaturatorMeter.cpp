@@ -0,0 +1,293 @@
+/*
+  ==============================================================================
+
+    This file contains the BS.1770 loudness, RMS and true-peak meter
+
+  ==============================================================================
+*/
+
+#include "SpatialSaturatorMeter.h"
+#include "SpatialSaturatorSIMD.h"
+#include <algorithm>
+#include <cmath>
+
+static const double pi = 3.14159265358979323846;
+
+//==============================================================================
+static float toDecibels(double power, double offset)
+{
+    return power > 1.0e-12 ? std::max(LoudnessMeter::minimumDecibels, (float)(offset + 10.0 * std::log10(power)))
+                           : LoudnessMeter::minimumDecibels;
+}
+
+static float loudness(double meanSquare)
+{
+    return toDecibels(meanSquare, -0.691);
+}
+
+//==============================================================================
+LoudnessMeter::LoudnessMeter()
+{
+    float taps[Limiter::tapsPerPhase][Limiter::interpolationFactor];
+    Limiter::makeInterpolationTaps(taps);
+
+    for (int phase = 0; phase < Limiter::interpolationFactor; ++phase)
+        for (int k = 0; k < Limiter::tapsPerPhase; ++k)
+            for (int lane = 0; lane < numChannels; ++lane)
+                m_interpolationTaps[phase][k][lane] = taps[k][phase];
+
+    reset();
+}
+
+void LoudnessMeter::prepare(double sampleRate)
+{
+    // BS.1770 K-weighting, re-derived from its analogue prototypes so it fits any rate
+    {
+        const double f0 = 1681.974450955533, gain = 3.999843853973347, q = 0.7071752369554196;
+        const double k = std::tan(pi * f0 / sampleRate);
+        const double vh = std::pow(10.0, gain / 20.0);
+        const double vb = std::pow(vh, 0.4996667741545416);
+        const double a0 = 1.0 + k / q + k * k;
+
+        m_preFilter = { (vh + vb * k / q + k * k) / a0, 2.0 * (k * k - vh) / a0, (vh - vb * k / q + k * k) / a0,
+                        2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0 };
+    }
+
+    {
+        const double f0 = 38.13547087602444, q = 0.5003270373238773;
+        const double k = std::tan(pi * f0 / sampleRate);
+        const double a0 = 1.0 + k / q + k * k;
+
+        m_highPass = { 1.0, -2.0, 1.0, 2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0 };
+    }
+
+    m_blockLength = std::max(1, (int)std::lround(0.1 * sampleRate));
+    reset();
+}
+
+void LoudnessMeter::reset()
+{
+    for (int lane = 0; lane < numChannels; ++lane)
+    {
+        m_z1[0][lane] = m_z1[1][lane] = m_z2[0][lane] = m_z2[1][lane] = 0.0;
+        m_weightedSum[lane] = m_rawSum[lane] = 0.0;
+        m_peak[lane] = 0.0f;
+    }
+
+    for (auto& row : m_history)
+        std::fill(row, row + numChannels, 0.0f);
+
+    for (int block = 0; block < shortTermBlocks; ++block)
+    {
+        std::fill(m_weightedBlocks[block], m_weightedBlocks[block] + numChannels, 0.0);
+        std::fill(m_rawBlocks[block], m_rawBlocks[block] + numChannels, 0.0);
+        std::fill(m_peakBlocks[block], m_peakBlocks[block] + numChannels, 0.0f);
+    }
+
+    m_historyPosition = m_blockPosition = m_ringPosition = 0;
+
+    Readings silence;
+
+    for (int lane = 0; lane < numChannels; ++lane)
+        silence.momentary[lane] = silence.shortTerm[lane] = silence.rms[lane] = silence.truePeak[lane] = minimumDecibels;
+
+    silence.momentaryStereo = silence.shortTermStereo = minimumDecibels;
+    publish(silence);
+}
+
+//==============================================================================
+template <typename SampleType>
+void LoudnessMeter::process(const SampleType* leftSamples, const SampleType* rightSamples, int numSamples)
+{
+    using namespace SIMD;
+
+    const double4 preB0 = set4(m_preFilter.b0), preB1 = set4(m_preFilter.b1), preB2 = set4(m_preFilter.b2);
+    const double4 preA1 = set4(m_preFilter.a1), preA2 = set4(m_preFilter.a2);
+    const double4 highA1 = set4(m_highPass.a1), highA2 = set4(m_highPass.a2), two = set4(2.0);
+
+    double4 z1Pre = load4(m_z1[0]), z2Pre = load4(m_z2[0]);
+    double4 z1High = load4(m_z1[1]), z2High = load4(m_z2[1]);
+    double4 weightedSum = load4(m_weightedSum), rawSum = load4(m_rawSum);
+    float4 peak = load(m_peak);
+
+    const float4 zero = set(0.0f);
+    auto magnitude = [zero](float4 v) { return max(v, sub(zero, v)); };
+
+    for (int n = 0; n < numSamples; ++n)
+    {
+        const double l = (double)leftSamples[n], r = (double)rightSamples[n];
+        const double m = (l + r) * 0.5, s = (l - r) * 0.5;
+        const double4 x = set4(l, r, m, s);
+
+        rawSum = add(rawSum, mul(x, x));
+
+        // Shelf, then the high pass (b = 1, -2, 1)
+        double4 y = add(mul(x, preB0), z1Pre);
+        z1Pre = sub(add(z2Pre, mul(x, preB1)), mul(y, preA1));
+        z2Pre = sub(mul(x, preB2), mul(y, preA2));
+
+        double4 w = add(y, z1High);
+        z1High = sub(sub(z2High, mul(y, two)), mul(w, highA1));
+        z2High = sub(y, mul(w, highA2));
+
+        weightedSum = add(weightedSum, mul(w, w));
+
+        // True peak: the sample itself and the four interpolated phases
+        m_historyPosition = (m_historyPosition + Limiter::tapsPerPhase - 1) % Limiter::tapsPerPhase;
+        const float4 sample = set((float)l, (float)r, (float)m, (float)s);
+        store(m_history[m_historyPosition], sample);
+        store(m_history[m_historyPosition + Limiter::tapsPerPhase], sample);
+
+        peak = max(peak, magnitude(sample));
+
+        // The phases are independent sums, run side by side
+        const float* history = m_history[m_historyPosition];
+        float4 sum0 = zero, sum1 = zero, sum2 = zero, sum3 = zero;
+
+        for (int k = 0; k < Limiter::tapsPerPhase; ++k)
+        {
+            const float4 past = load(history + k * numChannels);
+            sum0 = add(sum0, mul(past, load(m_interpolationTaps[0][k])));
+            sum1 = add(sum1, mul(past, load(m_interpolationTaps[1][k])));
+            sum2 = add(sum2, mul(past, load(m_interpolationTaps[2][k])));
+            sum3 = add(sum3, mul(past, load(m_interpolationTaps[3][k])));
+        }
+
+        peak = max(peak, max(max(magnitude(sum0), magnitude(sum1)), max(magnitude(sum2), magnitude(sum3))));
+
+        if (++m_blockPosition == m_blockLength)
+        {
+            store(m_weightedSum, weightedSum);
+            store(m_rawSum, rawSum);
+            store(m_peak, peak);
+
+            finishBlock();
+
+            weightedSum = rawSum = set4(0.0);
+            peak = zero;
+        }
+    }
+
+    store(m_z1[0], z1Pre);
+    store(m_z2[0], z2Pre);
+    store(m_z1[1], z1High);
+    store(m_z2[1], z2High);
+    store(m_weightedSum, weightedSum);
+    store(m_rawSum, rawSum);
+    store(m_peak, peak);
+}
+
+void LoudnessMeter::finishBlock()
+{
+    for (int lane = 0; lane < numChannels; ++lane)
+    {
+        m_weightedBlocks[m_ringPosition][lane] = m_weightedSum[lane];
+        m_rawBlocks[m_ringPosition][lane] = m_rawSum[lane];
+        m_peakBlocks[m_ringPosition][lane] = m_peak[lane];
+    }
+
+    m_ringPosition = (m_ringPosition + 1) % shortTermBlocks;
+    m_blockPosition = 0;
+
+    // Windows are always full length, so the readings rise over the first 3s after a reset
+    const double momentaryLength = (double)momentaryBlocks * m_blockLength;
+    const double shortTermLength = (double)shortTermBlocks * m_blockLength;
+
+    Readings readings;
+
+    for (int lane = 0; lane < numChannels; ++lane)
+    {
+        double weightedMomentary = 0.0, weightedShortTerm = 0.0, rawMomentary = 0.0;
+        float peak = 0.0f;
+
+        for (int age = 0; age < shortTermBlocks; ++age)
+        {
+            const int block = (m_ringPosition + shortTermBlocks - 1 - age) % shortTermBlocks;
+
+            if (age < momentaryBlocks)
+            {
+                weightedMomentary += m_weightedBlocks[block][lane];
+                rawMomentary += m_rawBlocks[block][lane];
+            }
+
+            weightedShortTerm += m_weightedBlocks[block][lane];
+            peak = std::max(peak, m_peakBlocks[block][lane]);
+        }
+
+        readings.momentary[lane] = loudness(weightedMomentary / momentaryLength);
+        readings.shortTerm[lane] = loudness(weightedShortTerm / shortTermLength);
+        readings.rms[lane] = toDecibels(rawMomentary / momentaryLength, 0.0);
+        readings.truePeak[lane] = toDecibels((double)peak * (double)peak, 0.0);
+    }
+
+    // BS.1770 sums the channel powers; mid and side would only count the same power again
+    double stereoMomentary = 0.0, stereoShortTerm = 0.0;
+
+    for (int age = 0; age < shortTermBlocks; ++age)
+    {
+        const int block = (m_ringPosition + shortTermBlocks - 1 - age) % shortTermBlocks;
+        const double power = m_weightedBlocks[block][left] + m_weightedBlocks[block][right];
+
+        if (age < momentaryBlocks)
+            stereoMomentary += power;
+
+        stereoShortTerm += power;
+    }
+
+    readings.momentaryStereo = loudness(stereoMomentary / momentaryLength);
+    readings.shortTermStereo = loudness(stereoShortTerm / shortTermLength);
+
+    publish(readings);
+}
+
+//==============================================================================
+void LoudnessMeter::publish(const Readings& readings)
+{
+    const unsigned sequence = m_sequence.load(std::memory_order_relaxed);
+
+    m_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (int lane = 0; lane < numChannels; ++lane)
+    {
+        m_momentary[lane].store(readings.momentary[lane], std::memory_order_relaxed);
+        m_shortTerm[lane].store(readings.shortTerm[lane], std::memory_order_relaxed);
+        m_rms[lane].store(readings.rms[lane], std::memory_order_relaxed);
+        m_truePeak[lane].store(readings.truePeak[lane], std::memory_order_relaxed);
+    }
+
+    m_momentaryStereo.store(readings.momentaryStereo, std::memory_order_relaxed);
+    m_shortTermStereo.store(readings.shortTermStereo, std::memory_order_relaxed);
+
+    m_sequence.store(sequence + 2, std::memory_order_release);
+}
+
+LoudnessMeter::Readings LoudnessMeter::getReadings() const
+{
+    Readings readings;
+
+    for (;;)
+    {
+        const unsigned before = m_sequence.load(std::memory_order_acquire);
+
+        for (int lane = 0; lane < numChannels; ++lane)
+        {
+            readings.momentary[lane] = m_momentary[lane].load(std::memory_order_relaxed);
+            readings.shortTerm[lane] = m_shortTerm[lane].load(std::memory_order_relaxed);
+            readings.rms[lane] = m_rms[lane].load(std::memory_order_relaxed);
+            readings.truePeak[lane] = m_truePeak[lane].load(std::memory_order_relaxed);
+        }
+
+        readings.momentaryStereo = m_momentaryStereo.load(std::memory_order_relaxed);
+        readings.shortTermStereo = m_shortTermStereo.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        // Even and unchanged: no publish overlapped the reads
+        if ((before & 1) == 0 && m_sequence.load(std::memory_order_relaxed) == before)
+            return readings;
+    }
+}
+
+template void LoudnessMeter::process<float>(const float*, const float*, int);
+template void LoudnessMeter::process<double>(const double*, const double*, int);
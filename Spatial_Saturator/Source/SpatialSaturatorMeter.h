@@ -0,0 +1,105 @@
+/*
+  ==============================================================================
+
+    This file contains the BS.1770 loudness, RMS and true-peak meter used
+    for the engine's input and output
+
+  ==============================================================================
+*/
+#ifndef __SpatialSaturatorMeter__SpatialSaturatorMeter__
+#define __SpatialSaturatorMeter__SpatialSaturatorMeter__
+
+#pragma once
+
+#include "SpatialSaturatorLimiter.h"
+#include <atomic>
+
+//==============================================================================
+/**
+    Meters left, right, mid and side of a stereo signal, one channel per SIMD
+    lane, so all four cost about what one would:
+
+        K-weighting (BS.1770 shelf and RLB high pass, four lane biquads)
+        squares of the weighted and the raw samples, summed per 100ms block
+        4x true-peak interpolation (the limiter's interpolator, four lanes)
+
+    Every 100ms the block sums go into rings holding the last 3s, and the
+    momentary (400ms) and short-term (3s) loudness, the RMS over 400ms and
+    the highest true peak over 3s are published. The stereo loudness sums the
+    left and right channels as BS.1770 does; the per channel values are each
+    channel on its own (a mono signal reads the same on left, right and mid).
+
+    process() runs on the audio thread and never allocates, locks or waits.
+    getReadings() can be called from any thread: the values are published as a
+    lock-free snapshot, and a reader that overlaps a publish reads again.
+*/
+class LoudnessMeter
+{
+public:
+    enum Channel { left = 0, right, mid, side, numChannels };
+
+    // What silence reads, for every value
+    static constexpr float minimumDecibels = -120.0f;
+
+    struct Readings
+    {
+        float momentary[numChannels];   // LUFS, 400ms
+        float shortTerm[numChannels];   // LUFS, 3s
+        float rms[numChannels];         // dB, 20 log10 of the RMS over 400ms
+        float truePeak[numChannels];    // dBTP, highest over 3s
+
+        float momentaryStereo;          // LUFS, left and right together
+        float shortTermStereo;          // LUFS
+    };
+
+    LoudnessMeter();
+
+    // Designs the K-weighting for this sample rate and resets
+    void prepare(double sampleRate);
+    // Clears the history; readings go back to silence
+    void reset();
+
+    template <typename SampleType>
+    void process(const SampleType* leftSamples, const SampleType* rightSamples, int numSamples);
+
+    Readings getReadings() const;
+
+private:
+    enum
+    {
+        momentaryBlocks = 4,    // of 100ms
+        shortTermBlocks = 30
+    };
+
+    void finishBlock();
+    void publish(const Readings& readings);
+
+    // K-weighting biquads (direct form II transposed), the same in every lane
+    struct Biquad { double b0, b1, b2, a1, a2; };
+    Biquad m_preFilter {}, m_highPass {};
+    alignas(32) double m_z1[2][numChannels] = {}, m_z2[2][numChannels] = {};
+
+    // Interpolator taps [phase][tap][lane], each repeated across the lanes
+    alignas(16) float m_interpolationTaps[Limiter::interpolationFactor][Limiter::tapsPerPhase][numChannels];
+    // Raw samples [tap][lane], stored twice so the newest taps are contiguous
+    alignas(16) float m_history[2 * Limiter::tapsPerPhase][numChannels] = {};
+    int m_historyPosition = 0;
+
+    // Sums of the running 100ms block
+    int m_blockLength = 4800, m_blockPosition = 0;
+    alignas(32) double m_weightedSum[numChannels] = {}, m_rawSum[numChannels] = {};
+    alignas(16) float m_peak[numChannels] = {};
+
+    // The last shortTermBlocks blocks, per channel
+    double m_weightedBlocks[shortTermBlocks][numChannels] = {};
+    double m_rawBlocks[shortTermBlocks][numChannels] = {};
+    float m_peakBlocks[shortTermBlocks][numChannels] = {};
+    int m_ringPosition = 0;
+
+    // Published readings; odd while a publish is under way
+    std::atomic<unsigned> m_sequence { 0 };
+    std::atomic<float> m_momentary[numChannels], m_shortTerm[numChannels], m_rms[numChannels], m_truePeak[numChannels];
+    std::atomic<float> m_momentaryStereo, m_shortTermStereo;
+};
+
+#endif
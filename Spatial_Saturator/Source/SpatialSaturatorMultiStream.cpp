@@ -0,0 +1,537 @@
+/*
+  ==============================================================================
+
+    This file contains the batch processing of many independent stereo streams
+
+  ==============================================================================
+*/
+
+#include "SpatialSaturatorMultiStream.h"
+#include <cmath>
+#include <limits>
+
+//==============================================================================
+void MultiStreamFilterChain::prepare(float sample_rate, int numStreams)
+{
+    if (m_tables != nullptr && m_tables->m_sample_rate != sample_rate)
+        m_tables = nullptr;
+
+    m_sample_rate = sample_rate;
+    m_numStreams = numStreams;
+    m_numActiveStreams = numStreams;
+    m_packs.resize((size_t)((numStreams + streamsPerPack - 1) / streamsPerPack));
+
+    // NaN never compares equal, so the next update recomputes every biquad
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    m_parameters.assign((size_t)numStreams, { nan, nan, nan, nan, nan });
+
+    // Unused lanes of the last pack pass silence through unity biquads
+    for (int stream = 0; stream < (int)m_packs.size() * streamsPerPack; ++stream)
+        for (int biquad = 0; biquad < numBiquads; ++biquad)
+            setBiquad(stream, biquad, BiquadCoefficients());
+
+    reset();
+}
+
+void MultiStreamFilterChain::reset()
+{
+    for (auto& pack : m_packs)
+    {
+        for (int biquad = 0; biquad < numBiquads; ++biquad)
+        {
+            for (int lane = 0; lane < streamsPerPack; ++lane)
+            {
+                pack.z1[biquad][lane] = 0.0;
+                pack.z2[biquad][lane] = 0.0;
+            }
+        }
+    }
+}
+
+void MultiStreamFilterChain::setCoefficientTables(std::shared_ptr<const CoefficientTables> tables)
+{
+    // Tables built for another sample rate would give the wrong response
+    if (tables != nullptr && tables->m_sample_rate != m_sample_rate)
+        tables = nullptr;
+
+    m_tables = std::move(tables);
+}
+
+void MultiStreamFilterChain::setBiquad(int stream, int biquad, const BiquadCoefficients& coefficients)
+{
+    auto& pack = m_packs[(size_t)(stream / streamsPerPack)];
+    const int lane = stream % streamsPerPack;
+
+    pack.b0[biquad][lane] = coefficients.b0;
+    pack.b1[biquad][lane] = coefficients.b1;
+    pack.b2[biquad][lane] = coefficients.b2;
+    pack.a1[biquad][lane] = coefficients.a1;
+    pack.a2[biquad][lane] = coefficients.a2;
+    pack.decayLength[biquad][lane] = getDecayLength(coefficients.a1, coefficients.a2);
+}
+
+int MultiStreamFilterChain::getTailLengthInSamples(int stream) const
+{
+    const auto& pack = m_packs[(size_t)(stream / streamsPerPack)];
+    const int lane = stream % streamsPerPack;
+
+    // The side biquads ring one after the other, so their tails add up
+    const double longest = std::max(pack.decayLength[midShelf][lane],
+                                    pack.decayLength[sideHighPass][lane] + pack.decayLength[sideShelf][lane]);
+
+    return (int)std::min(std::ceil(longest), (double)std::numeric_limits<int>::max());
+}
+
+void MultiStreamFilterChain::updateCoefficients(int stream, float midFreq, float midGain, float sideFreqLower, float sideFreqUpper, float sideGain)
+{
+    auto& current = m_parameters[(size_t)stream];
+
+    if (midFreq != current.midFreq || midGain != current.midGain)
+    {
+        setBiquad(stream, midShelf, makeLowShelf(midFreq, midGain, m_sample_rate, m_tables.get()));
+        current.midFreq = midFreq;
+        current.midGain = midGain;
+    }
+
+    if (sideFreqLower != current.sideFreqLower)
+    {
+        setBiquad(stream, sideHighPass, makeHighPass(sideFreqLower, m_sample_rate, m_tables.get()));
+        current.sideFreqLower = sideFreqLower;
+    }
+
+    if (sideFreqUpper != current.sideFreqUpper || sideGain != current.sideGain)
+    {
+        setBiquad(stream, sideShelf, makeLowShelf(sideFreqUpper, sideGain, m_sample_rate, m_tables.get()));
+        current.sideFreqUpper = sideFreqUpper;
+        current.sideGain = sideGain;
+    }
+}
+
+void MultiStreamFilterChain::process(float* const* left, float* const* right, int numberSamples, const float* startGain, const float* endGain)
+{
+    for (int first = 0; first < m_numActiveStreams; first += streamsPerPack)
+    {
+        processPack(m_packs[(size_t)(first / streamsPerPack)], left + first, right + first,
+                    std::min((int)streamsPerPack, m_numActiveStreams - first), numberSamples, startGain + first, endGain + first);
+    }
+}
+
+void MultiStreamFilterChain::processPack(Pack& pack, float* const* left, float* const* right, int numStreamsInPack, int numberSamples, const float* startGain, const float* endGain)
+{
+    using namespace SIMD;
+
+    const double4 half = set4(0.5);
+
+    // A constant gain has a zero step, which keeps it exact
+    alignas(32) double gainStarts[streamsPerPack] = {}, gainSteps[streamsPerPack] = {};
+    for (int lane = 0; lane < numStreamsInPack; ++lane)
+    {
+        gainStarts[lane] = (double)startGain[lane];
+        gainSteps[lane] = numberSamples > 0 ? ((double)endGain[lane] - gainStarts[lane]) / numberSamples : 0.0;
+    }
+
+    const double4 gainStart = load4(gainStarts), gainStep = load4(gainSteps);
+
+    // Mid-only streams read their left channel for both sides
+    const float* rightInput[streamsPerPack];
+    for (int lane = 0; lane < numStreamsInPack; ++lane)
+        rightInput[lane] = right[lane] != nullptr ? right[lane] : left[lane];
+
+    // Coefficients and states live in registers for the whole block
+    double4 b0[numBiquads], b1[numBiquads], b2[numBiquads], a1[numBiquads], a2[numBiquads];
+    double4 z1[numBiquads], z2[numBiquads];
+
+    for (int biquad = 0; biquad < numBiquads; ++biquad)
+    {
+        b0[biquad] = load4(pack.b0[biquad]);
+        b1[biquad] = load4(pack.b1[biquad]);
+        b2[biquad] = load4(pack.b2[biquad]);
+        a1[biquad] = load4(pack.a1[biquad]);
+        a2[biquad] = load4(pack.a2[biquad]);
+        z1[biquad] = load4(pack.z1[biquad]);
+        z2[biquad] = load4(pack.z2[biquad]);
+    }
+
+    auto runBiquad = [&](int biquad, double4 x)
+    {
+        double4 y = add(mul(x, b0[biquad]), z1[biquad]);
+        z1[biquad] = sub(add(z2[biquad], mul(x, b1[biquad])), mul(y, a1[biquad]));
+        z2[biquad] = sub(mul(x, b2[biquad]), mul(y, a2[biquad]));
+        return roundToFloat(y);
+    };
+
+    // Same operations in the same order as MidSideFilterChain::process, one
+    // stream per lane, so every stream gives the same sample values as it
+    auto processSample = [&](int n, double4 l4, double4 r4, double* outLeft, double* outRight)
+    {
+        // Process L+R into mids & sides
+        double4 mids = roundToFloat(mul(add(l4, r4), half));
+        double4 sides = roundToFloat(mul(sub(l4, r4), half));
+
+        // Mid shelf (the single stream chain's pass-through stage is left out)
+        mids = runBiquad(midShelf, mids);
+
+        // Side high pass, then side shelf
+        sides = runBiquad(sideShelf, runBiquad(sideHighPass, sides));
+
+        // Process mids+sides back to L&R
+        const double4 gain = add(gainStart, mul(gainStep, set4((double)(n + 1))));
+        store(outLeft, mul(add(mids, sides), gain));
+        store(outRight, mul(sub(mids, sides), gain));
+    };
+
+    alignas(32) double outLeft[streamsPerPack], outRight[streamsPerPack];
+
+    // A mid-only stream's side is zero, so both outputs are its mid
+    auto storeSample = [&](int n, int lane)
+    {
+        left[lane][n] = (float)outLeft[lane];
+
+        if (right[lane] != nullptr)
+            right[lane][n] = (float)outRight[lane];
+    };
+
+    if (numStreamsInPack == streamsPerPack)
+    {
+        // Inputs go straight into registers; going through memory would stall
+        // every sample on a failed store-to-load forward
+        for (int n = 0; n < numberSamples; ++n)
+        {
+            processSample(n, set4(left[0][n], left[1][n], left[2][n], left[3][n]),
+                          set4(rightInput[0][n], rightInput[1][n], rightInput[2][n], rightInput[3][n]), outLeft, outRight);
+
+            for (int lane = 0; lane < streamsPerPack; ++lane)
+                storeSample(n, lane);
+        }
+    }
+    else
+    {
+        // Unused lanes keep reading and writing zeros
+        alignas(32) double l[streamsPerPack] = {}, r[streamsPerPack] = {};
+
+        for (int n = 0; n < numberSamples; ++n)
+        {
+            for (int lane = 0; lane < numStreamsInPack; ++lane)
+            {
+                l[lane] = (double)left[lane][n];
+                r[lane] = (double)rightInput[lane][n];
+            }
+
+            processSample(n, load4(l), load4(r), outLeft, outRight);
+
+            for (int lane = 0; lane < numStreamsInPack; ++lane)
+                storeSample(n, lane);
+        }
+    }
+
+    for (int biquad = 0; biquad < numBiquads; ++biquad)
+    {
+        store(pack.z1[biquad], z1[biquad]);
+        store(pack.z2[biquad], z2[biquad]);
+    }
+}
+
+//==============================================================================
+void MultiStreamEngine::prepare(double sampleRate, int maxBlockSize, int numStreams)
+{
+    m_filterChain.prepare(static_cast<float>(sampleRate), numStreams);
+
+    m_streams.resize((size_t)numStreams);
+    m_startGains.assign((size_t)numStreams, 1.0f);
+    m_endGains.assign((size_t)numStreams, 1.0f);
+    m_left.assign((size_t)numStreams, nullptr);
+    m_right.assign((size_t)numStreams, nullptr);
+
+    // One limiter for every channel of the bed, with the first stream's settings
+    m_linkedLimiter.prepare(sampleRate, 2 * numStreams, maxBlockSize);
+    m_linkedChannels.assign((size_t)(2 * numStreams), nullptr);
+
+    for (int stream = 0; stream < numStreams; ++stream)
+    {
+        auto& s = m_streams[(size_t)stream];
+
+        // Preallocate every oversampling stage and the longest look-ahead, so both can change while playing
+        s.waveshaper.prepare(sampleRate, 2, maxBlockSize);
+        s.limiter.prepare(sampleRate, 2, maxBlockSize);
+
+        for (auto& ramp : s.ramps)
+            ramp.setRampLength((int)std::lround(SpatialSaturatorEngine::rampLengthMs * 0.001 * sampleRate));
+
+        setParameters(stream, s.parameters);
+    }
+
+    reset();
+}
+
+void MultiStreamEngine::reset()
+{
+    // Nothing is playing, so parameters can jump to where they are headed
+    for (int stream = 0; stream < getNumStreams(); ++stream)
+    {
+        for (auto& ramp : m_streams[(size_t)stream].ramps)
+            ramp.setCurrentAndTarget(ramp.getTarget());
+
+        applyRampValues(stream);
+    }
+
+    m_snapParameters = true;
+
+    m_filterChain.reset();
+    m_linkedLimiter.reset();
+
+    for (auto& s : m_streams)
+    {
+        s.waveshaper.reset();
+        s.limiter.reset();
+    }
+}
+
+void MultiStreamEngine::setCoefficientTables(std::shared_ptr<const CoefficientTables> tables)
+{
+    m_filterChain.setCoefficientTables(std::move(tables));
+}
+
+void MultiStreamEngine::setParameters(int stream, const SpatialSaturatorEngine::Parameters& parameters)
+{
+    SPATIAL_SATURATOR_PROFILE_STAGE(m_profiler, coefficients);
+
+    auto& s = m_streams[(size_t)stream];
+    s.parameters = parameters;
+
+    // The packed filters are biquads only
+    s.parameters.filterMode = SpatialSaturatorEngine::biquadFilters;
+
+    SpatialSaturatorEngine::setRampTargets(s.ramps, parameters);
+
+    if (m_snapParameters)
+        for (auto& ramp : s.ramps)
+            ramp.setCurrentAndTarget(ramp.getTarget());
+
+    applyRampValues(stream);
+
+    s.waveshaper.setOversampling(parameters.oversamplingFactorLog2, parameters.oversamplingPhase);
+    s.waveshaper.setAntiAliasing(parameters.antiAliasing);
+    s.waveshaper.setPrecision(parameters.quality);
+
+    s.limiter.setParameters(parameters.limiterCeiling, parameters.limiterLookahead, parameters.limiterRelease);
+
+    if (stream == 0)
+        m_linkedLimiter.setParameters(parameters.limiterCeiling, parameters.limiterLookahead, parameters.limiterRelease);
+}
+
+void MultiStreamEngine::setLimiterLinked(bool linked)
+{
+    if (linked == m_limiterLinked)
+        return;
+
+    m_limiterLinked = linked;
+
+    // The limiters taking over last ran on other audio, or never
+    if (linked)
+    {
+        m_linkedLimiter.reset();
+    }
+    else
+    {
+        for (auto& s : m_streams)
+            s.limiter.reset();
+    }
+}
+
+int MultiStreamEngine::getLatencyInSamples(int stream) const
+{
+    auto& s = m_streams[(size_t)stream];
+
+    if (m_limiterLinked)
+        return s.waveshaper.getLatencyInSamples() + (m_streams[0].parameters.limiterEnabled ? m_linkedLimiter.getLatencyInSamples() : 0);
+
+    return s.waveshaper.getLatencyInSamples() + (s.parameters.limiterEnabled ? s.limiter.getLatencyInSamples() : 0);
+}
+
+int MultiStreamEngine::getTailLengthInSamples(int stream) const
+{
+    auto& s = m_streams[(size_t)stream];
+
+    // Each stage rings on from where the one before it stopped
+    long long tail = (long long)m_filterChain.getTailLengthInSamples(stream) + s.waveshaper.getTailLengthInSamples();
+
+    if (m_limiterLinked ? m_streams[0].parameters.limiterEnabled : s.parameters.limiterEnabled)
+        tail += m_limiterLinked ? m_linkedLimiter.getLatencyInSamples() : s.limiter.getLatencyInSamples();
+
+    return (int)std::min(tail, (long long)std::numeric_limits<int>::max());
+}
+
+bool MultiStreamEngine::isRamping() const
+{
+    for (int stream = 0; stream < getNumActiveStreams(); ++stream)
+        for (auto& ramp : m_streams[(size_t)stream].ramps)
+            if (ramp.isRamping())
+                return true;
+
+    return false;
+}
+
+void MultiStreamEngine::advanceRamps(int numSamples)
+{
+    for (int stream = 0; stream < getNumActiveStreams(); ++stream)
+    {
+        auto& ramps = m_streams[(size_t)stream].ramps;
+
+        // Streams holding still keep their coefficients
+        if (std::none_of(std::begin(ramps), std::end(ramps), [](const LinearRamp& ramp) { return ramp.isRamping(); }))
+            continue;
+
+        for (auto& ramp : ramps)
+            ramp.skip(numSamples);
+
+        applyRampValues(stream);
+    }
+}
+
+void MultiStreamEngine::applyRampValues(int stream)
+{
+    using Engine = SpatialSaturatorEngine;
+
+    auto& s = m_streams[(size_t)stream];
+    const LinearRamp* ramps = s.ramps;
+
+    // Only the biquads whose parameters moved are recomputed
+    m_filterChain.updateCoefficients(stream, ramps[Engine::midFreqRamp].getCurrent(), ramps[Engine::midGainRamp].getCurrent(),
+                                     ramps[Engine::sideFreqLowerRamp].getCurrent(), ramps[Engine::sideFreqUpperRamp].getCurrent(),
+                                     ramps[Engine::sideGainRamp].getCurrent());
+
+    Engine::applyRampsToWaveshaper(ramps, s.parameters.numBands, s.waveshaper);
+}
+
+void MultiStreamEngine::process(float* const* left, float* const* right, int numSamples)
+{
+    SPATIAL_SATURATOR_PROFILE_BLOCK(m_profiler);
+
+    // From here on, new parameters ramp
+    m_snapParameters = false;
+
+    // Nothing moving: one pass with the values set by setParameters()
+    if (!isRamping())
+    {
+        for (int stream = 0; stream < getNumActiveStreams(); ++stream)
+            m_startGains[(size_t)stream] = m_endGains[(size_t)stream] = m_streams[(size_t)stream].ramps[SpatialSaturatorEngine::makeUpGainRamp].getCurrent();
+
+        processSubBlock(left, right, 0, numSamples);
+        return;
+    }
+
+    for (int start = 0; start < numSamples; start += SpatialSaturatorEngine::subBlockSize)
+    {
+        const int subBlock = std::min((int)SpatialSaturatorEngine::subBlockSize, numSamples - start);
+
+        for (int stream = 0; stream < getNumActiveStreams(); ++stream)
+            m_startGains[(size_t)stream] = m_streams[(size_t)stream].ramps[SpatialSaturatorEngine::makeUpGainRamp].getCurrent();
+
+        {
+            SPATIAL_SATURATOR_PROFILE_STAGE(m_profiler, coefficients);
+            advanceRamps(subBlock);
+        }
+
+        for (int stream = 0; stream < getNumActiveStreams(); ++stream)
+            m_endGains[(size_t)stream] = m_streams[(size_t)stream].ramps[SpatialSaturatorEngine::makeUpGainRamp].getCurrent();
+
+        processSubBlock(left, right, start, subBlock);
+    }
+}
+
+void MultiStreamEngine::processSubBlock(float* const* left, float* const* right, int start, int numSamples)
+{
+    const int numStreams = getNumActiveStreams();
+
+    for (int stream = 0; stream < numStreams; ++stream)
+    {
+        m_left[(size_t)stream] = left[stream] + start;
+        m_right[(size_t)stream] = right[stream] != nullptr ? right[stream] + start : nullptr;
+    }
+
+    // All streams through the packed filters first
+    {
+        SPATIAL_SATURATOR_PROFILE_STAGE(m_profiler, filters);
+        m_filterChain.process(m_left.data(), m_right.data(), numSamples, m_startGains.data(), m_endGains.data());
+    }
+
+    static_assert((int)MultiStreamFilterChain::streamsPerPack == (int)Waveshaper::maxLanes, "one filter pack per waveshaper lane call");
+
+    for (int first = 0; first < numStreams; first += MultiStreamFilterChain::streamsPerPack)
+    {
+        const int numStreamsInPack = std::min((int)MultiStreamFilterChain::streamsPerPack, numStreams - first);
+
+        {
+            SPATIAL_SATURATOR_PROFILE_STAGE(m_profiler, waveshaper);
+            processWaveshapers(m_left.data() + first, m_right.data() + first, first, numStreamsInPack, numSamples);
+        }
+
+        if (m_limiterLinked)
+            continue;
+
+        for (int stream = first; stream < first + numStreamsInPack; ++stream)
+        {
+            auto& s = m_streams[(size_t)stream];
+
+            if (s.parameters.limiterEnabled)
+            {
+                SPATIAL_SATURATOR_PROFILE_STAGE(m_profiler, limiter);
+                float* channels[] = { m_left[(size_t)stream], m_right[(size_t)stream] };
+                s.limiter.process(channels, channels[1] != nullptr ? 2 : 1, numSamples);
+            }
+        }
+    }
+
+    // One gain for the whole bed, after every stream has been shaped
+    if (m_limiterLinked && numStreams > 0 && m_streams[0].parameters.limiterEnabled)
+    {
+        SPATIAL_SATURATOR_PROFILE_STAGE(m_profiler, limiter);
+
+        int numChannels = 0;
+
+        for (int stream = 0; stream < numStreams; ++stream)
+        {
+            m_linkedChannels[(size_t)numChannels++] = m_left[(size_t)stream];
+
+            if (m_right[(size_t)stream] != nullptr)
+                m_linkedChannels[(size_t)numChannels++] = m_right[(size_t)stream];
+        }
+
+        m_linkedLimiter.process(m_linkedChannels.data(), numChannels, numSamples);
+    }
+}
+
+void MultiStreamEngine::processWaveshapers(float* const* left, float* const* right, int first, int numStreamsInPack, int numSamples)
+{
+    Waveshaper* waveshapers[Waveshaper::maxLanes];
+    float* channelPointers[Waveshaper::maxLanes][2];
+    float* const* channels[Waveshaper::maxLanes];
+    int numChannels[Waveshaper::maxLanes];
+
+    // A pack shares lanes when every stream has the mode of the first and
+    // there are more than two channels to fill them; otherwise it runs
+    // stream by stream
+    bool shareLanes = true;
+    int numLanes = 0;
+
+    for (int i = 0; i < numStreamsInPack; ++i)
+    {
+        waveshapers[i] = &m_streams[(size_t)(first + i)].waveshaper;
+        channelPointers[i][0] = left[i];
+        channelPointers[i][1] = right[i];
+        channels[i] = channelPointers[i];
+        numChannels[i] = right[i] != nullptr ? 2 : 1;
+        numLanes += numChannels[i];
+
+        shareLanes = shareLanes && waveshapers[0]->canShareLanesWith(*waveshapers[i]);
+    }
+
+    if (shareLanes && numLanes > 2)
+    {
+        Waveshaper::processLanes(waveshapers, numStreamsInPack, channels, numChannels, numSamples);
+        return;
+    }
+
+    for (int i = 0; i < numStreamsInPack; ++i)
+        waveshapers[i]->process(channels[i], numChannels[i], numSamples);
+}
@@ -0,0 +1,213 @@
+/*
+  ==============================================================================
+
+    This file contains the batch processing of many independent stereo
+    streams, with the filter state of several streams packed side by side
+
+  ==============================================================================
+*/
+#ifndef __SpatialSaturatorMultiStream__SpatialSaturatorMultiStream__
+#define __SpatialSaturatorMultiStream__SpatialSaturatorMultiStream__
+
+#pragma once
+
+#include "SpatialSaturatorEngine.h"
+#include <algorithm>
+
+//==============================================================================
+/**
+    MidSideFilterChain for many streams at once. Each SIMD lane is a different
+    stream, so a pack of streamsPerPack streams runs its mid shelf, side high
+    pass and side shelf as three four-lane biquads:
+
+        mid:  [ mid shelf      s0 | s1 | s2 | s3 ]
+        side: [ side high pass s0 | s1 | s2 | s3 ]  ->  [ side shelf s0 | ... ]
+
+    One stream no longer waits on its own recursion, so the throughput per
+    core grows with the vector width (one AVX register per biquad when built
+    for AVX, two SSE2/NEON registers otherwise). Every stream has its own
+    parameters, and its output has the same sample values as a MidSideFilterChain
+    (only the sign of an exact zero can differ, as the mid pass-through stage
+    is left out).
+
+    A stream without a right channel is mid-only, as MidSideFilterChain::processMid():
+    its left channel feeds both sides, so its side lanes filter exact zeros,
+    and only its left channel is written.
+*/
+class MultiStreamFilterChain
+{
+public:
+    enum
+    {
+        streamsPerPack = 4,
+        numBiquads = 3      // mid shelf, side high pass, side shelf
+    };
+
+    void prepare(float sample_rate, int numStreams);
+    void reset();
+
+    void setCoefficientTables(std::shared_ptr<const CoefficientTables> tables);
+
+    // Only recomputes the biquads whose parameters changed since the last call
+    void updateCoefficients(int stream, float midFreq, float midGain, float sideFreqLower, float sideFreqUpper, float sideGain);
+
+    // left[stream] and right[stream] for every active stream, right[stream]
+    // null for a mid-only stream. Each stream's make up gain ramps linearly
+    // from startGain[stream] to reach endGain[stream] on the last sample, as
+    // linear gains
+    void process(float* const* left, float* const* right, int numberSamples, const float* startGain, const float* endGain);
+
+    int getNumStreams() const { return m_numStreams; }
+
+    // Samples the longer of a stream's mid and side cascades rings on after
+    // its input stops, with the current coefficients
+    int getTailLengthInSamples(int stream) const;
+
+    // process() only runs the first numStreams of those prepared (all of them
+    // after prepare()), so the count can change without reallocating
+    void setNumActiveStreams(int numStreams) { m_numActiveStreams = std::clamp(numStreams, 0, m_numStreams); }
+    int getNumActiveStreams() const { return m_numActiveStreams; }
+
+private:
+    enum { midShelf = 0, sideHighPass, sideShelf };
+
+    // Coefficients and states of streamsPerPack streams, [biquad][lane]
+    struct Pack
+    {
+        alignas(32) double b0[numBiquads][streamsPerPack];
+        alignas(32) double b1[numBiquads][streamsPerPack];
+        alignas(32) double b2[numBiquads][streamsPerPack];
+        alignas(32) double a1[numBiquads][streamsPerPack];
+        alignas(32) double a2[numBiquads][streamsPerPack];
+
+        alignas(32) double z1[numBiquads][streamsPerPack];
+        alignas(32) double z2[numBiquads][streamsPerPack];
+
+        // getDecayLength() of each biquad, kept with the coefficients
+        double decayLength[numBiquads][streamsPerPack];
+    };
+
+    // Parameters the current coefficients of one stream were computed for
+    struct StreamParameters
+    {
+        float midFreq, midGain, sideFreqLower, sideFreqUpper, sideGain;
+    };
+
+    void setBiquad(int stream, int biquad, const BiquadCoefficients& coefficients);
+    void processPack(Pack& pack, float* const* left, float* const* right, int numStreamsInPack, int numberSamples, const float* startGain, const float* endGain);
+
+    float m_sample_rate = 44100.0f;
+    std::shared_ptr<const CoefficientTables> m_tables;
+
+    int m_numStreams = 0;
+    int m_numActiveStreams = 0;
+    std::vector<Pack> m_packs;
+    std::vector<StreamParameters> m_parameters;
+};
+
+//==============================================================================
+/**
+    The full chain for many stereo streams in one call: packed filters, then
+    the waveshapers and each stream's limiter. Every stream has its own
+    parameters.
+
+    A stream given no right channel is mid-only and runs like
+    SpatialSaturatorEngine::processMono(): the mid shelf in its filter lane,
+    then one channel through its waveshaper and limiter.
+
+    The channels of a filter pack also share the waveshaper's lanes
+    (Waveshaper::processLanes) when their streams run the same full band
+    mode: ADAA, or oversampling by the same factor at Full quality. Each
+    stream still runs its own oversampling filters. Multiband streams already
+    fill the lanes with their bands, and the Draft/High approximations and the
+    limiter are vectorised over the samples of a stream, so those run stream
+    by stream.
+
+    With the limiter linked, one limiter takes every channel of every stream,
+    so a peak in one speaker of a bed turns all of them down together and the
+    image holds. It uses the first stream's limiter settings.
+
+    Continuous parameters ramp as in SpatialSaturatorEngine: while any stream
+    ramps, the block runs in sub-blocks of SpatialSaturatorEngine::subBlockSize
+    with the coefficients updated in between, and the make up gain ramps per
+    sample, so automation matches a stream's own engine too. The filters always
+    run as biquads, the linear phase filter mode is ignored.
+*/
+class MultiStreamEngine
+{
+public:
+    void prepare(double sampleRate, int maxBlockSize, int numStreams);
+    void reset();
+
+    void setCoefficientTables(std::shared_ptr<const CoefficientTables> tables);
+
+    // As SpatialSaturatorEngine::setParameters(), the first call after
+    // prepare() or reset() jumps
+    void setParameters(int stream, const SpatialSaturatorEngine::Parameters& parameters);
+    const SpatialSaturatorEngine::Parameters& getParameters(int stream) const { return m_streams[(size_t)stream].parameters; }
+
+    int getLatencyInSamples(int stream) const;
+
+    // As SpatialSaturatorEngine::getTailLengthInSamples(), for one stream
+    int getTailLengthInSamples(int stream) const;
+
+    int getNumStreams() const { return (int)m_streams.size(); }
+
+    // See MultiStreamFilterChain::setNumActiveStreams(); streams that were
+    // idle should be reset() before they run again
+    void setNumActiveStreams(int numStreams)    { m_filterChain.setNumActiveStreams(numStreams); }
+    int getNumActiveStreams() const             { return m_filterChain.getNumActiveStreams(); }
+
+    // Off by default. Switching resets the limiters that take over, so it
+    // drops their look-ahead's worth of audio; realtime safe
+    void setLimiterLinked(bool linked);
+    bool isLimiterLinked() const                { return m_limiterLinked; }
+
+    // left[stream] and right[stream] for every active stream, right[stream]
+    // null for a mid-only stream; numSamples <= maxBlockSize
+    void process(float* const* left, float* const* right, int numSamples);
+
+    // As SpatialSaturatorEngine::setProfiler(), with every stream's
+    // waveshaper and limiter summed into one stage each. setParameters()
+    // counts as the coefficients of the next block, outside its whole block
+    void setProfiler(StageProfiler* profiler) { m_profiler = profiler; }
+
+private:
+    bool isRamping() const;
+
+    // Moves every ramping stream numSamples along and hands the values to its stages
+    void advanceRamps(int numSamples);
+    void applyRampValues(int stream);
+
+    // All active streams from sample start on, with the current coefficients
+    void processSubBlock(float* const* left, float* const* right, int start, int numSamples);
+
+    // The waveshapers of one filter pack, in lanes when they can share them
+    void processWaveshapers(float* const* left, float* const* right, int first, int numStreamsInPack, int numSamples);
+
+    struct Stream
+    {
+        SpatialSaturatorEngine::Parameters parameters;
+        LinearRamp ramps[SpatialSaturatorEngine::numRamps];
+        Waveshaper waveshaper;
+        Limiter limiter;
+    };
+
+    MultiStreamFilterChain m_filterChain;
+    std::vector<Stream> m_streams;
+    bool m_snapParameters = true;
+
+    // Make up gains of the current sub-block, per stream
+    std::vector<float> m_startGains, m_endGains;
+
+    // Channel pointers from the start of the current sub-block
+    std::vector<float*> m_left, m_right;
+
+    bool m_limiterLinked = false;
+    Limiter m_linkedLimiter;
+    std::vector<float*> m_linkedChannels;
+
+    StageProfiler* m_profiler = nullptr;
+};
+
+#endif
@@ -0,0 +1,556 @@
+/*
+  ==============================================================================
+
+    This file contains the oversampling stage used around the waveshaper
+
+  ==============================================================================
+*/
+
+#include "SpatialSaturatorOversampler.h"
+#include "SpatialSaturatorFilter.h"
+#include <algorithm>
+#include <cmath>
+
+static const double pi = 3.14159265358979323846;
+
+//==============================================================================
+// Integer power, used by the elliptic series below
+static double ipowp(double x, long n)
+{
+    double z = 1.0;
+
+    while (n != 0)
+    {
+        if ((n & 1) != 0)
+            z *= x;
+
+        n >>= 1;
+        x *= x;
+    }
+
+    return z;
+}
+
+std::vector<double> HalfBandIIR::design(double attenuation, double transition)
+{
+    // Transition parameters
+    double k = tan((1 - transition * 2) * pi / 4);
+    k *= k;
+    double kksqrt = pow(1 - k * k, 0.25);
+    double e = 0.5 * (1 - kksqrt) / (1 + kksqrt);
+    double e2 = e * e;
+    double e4 = e2 * e2;
+    double q = e * (1 + e4 * (2 + e4 * (15 + 150 * e4)));
+
+    // Filter order for the requested attenuation
+    double attn_p2 = pow(10.0, -attenuation / 10);
+    double a = attn_p2 / (1 - attn_p2);
+    int order = (int)ceil(log(a * a / 16) / log(q));
+
+    if ((order & 1) == 0)
+        ++order;
+
+    if (order == 1)
+        order = 3;
+
+    int numCoefficients = std::min((order - 1) / 2, (int)maxCoefficients);
+    std::vector<double> coefficients((size_t)numCoefficients);
+
+    for (int index = 0; index < numCoefficients; ++index)
+    {
+        const int c = index + 1;
+
+        // Numerator series
+        double num = 0.0;
+        {
+            long i = 0;
+            int j = 1;
+            double term;
+
+            do
+            {
+                term = ipowp(q, i * (i + 1)) * sin(static_cast<double>((i * 2 + 1) * c) * pi / order) * j;
+                num += term;
+                j = -j;
+                ++i;
+            }
+            while (fabs(term) > 1e-100);
+        }
+
+        // Denominator series
+        double den = 0.0;
+        {
+            long i = 1;
+            int j = -1;
+            double term;
+
+            do
+            {
+                term = ipowp(q, i * i) * cos(static_cast<double>(i * 2 * c) * pi / order) * j;
+                den += term;
+                j = -j;
+                ++i;
+            }
+            while (fabs(term) > 1e-100);
+        }
+
+        num *= pow(q, 0.25);
+        den += 0.5;
+
+        double ww = num / den;
+        double wwsq = ww * ww;
+        double x = sqrt((1 - wwsq * k) * (1 - wwsq / k)) / (1 + wwsq);
+
+        coefficients[(size_t)index] = (1 - x) / (1 + x);
+    }
+
+    return coefficients;
+}
+
+void HalfBandIIR::setCoefficients(const std::vector<double>& coefficients)
+{
+    m_numCoefficients = std::min((int)coefficients.size(), (int)maxCoefficients);
+
+    for (int i = 0; i < m_numCoefficients; ++i)
+        m_coefficients[i] = coefficients[(size_t)i];
+
+    reset();
+}
+
+void HalfBandIIR::reset()
+{
+    std::fill(std::begin(m_x1), std::end(m_x1), 0.0);
+    std::fill(std::begin(m_y1), std::end(m_y1), 0.0);
+}
+
+template <typename SampleType>
+void HalfBandIIR::upsample(const SampleType* in, SampleType* out, int numIn)
+{
+    for (int n = 0; n < numIn; ++n)
+    {
+        double x = (double)in[n];
+
+        out[2 * n] = (SampleType)processPath(x, 0);
+        out[2 * n + 1] = (SampleType)processPath(x, 1);
+    }
+}
+
+template <typename SampleType>
+void HalfBandIIR::downsample(const SampleType* in, SampleType* out, int numOut)
+{
+    for (int n = 0; n < numOut; ++n)
+    {
+        double path0 = processPath((double)in[2 * n + 1], 0);
+        double path1 = processPath((double)in[2 * n], 1);
+
+        out[n] = (SampleType)(0.5 * (path0 + path1));
+    }
+}
+
+double HalfBandIIR::getGroupDelay() const
+{
+    // A first order allpass (c + z^-1) / (1 + c z^-1) delays DC by (1 - c) / (1 + c)
+    // samples; each section runs at half the rate and path 1 sits one sample later
+    double delay0 = 0.0, delay1 = 1.0;
+
+    for (int i = 0; i < m_numCoefficients; ++i)
+    {
+        double sectionDelay = 2 * (1 - m_coefficients[i]) / (1 + m_coefficients[i]);
+
+        if ((i & 1) == 0)
+            delay0 += sectionDelay;
+        else
+            delay1 += sectionDelay;
+    }
+
+    return 0.5 * (delay0 + delay1);
+}
+
+double HalfBandIIR::getDecayLength() const
+{
+    // A section's pole sits at -c, and the sections run at half the rate
+    double length0 = 0.0, length1 = 1.0;
+
+    for (int i = 0; i < m_numCoefficients; ++i)
+    {
+        double sectionLength = 2 * ::getDecayLength(m_coefficients[i], 0.0);
+
+        if ((i & 1) == 0)
+            length0 += sectionLength;
+        else
+            length1 += sectionLength;
+    }
+
+    return std::max(length0, length1);
+}
+
+//==============================================================================
+static double besselI0(double x)
+{
+    double sum = 1.0, term = 1.0;
+
+    for (int k = 1; k < 50; ++k)
+    {
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
+
+        if (term < sum * 1e-17)
+            break;
+    }
+
+    return sum;
+}
+
+template <typename SampleType>
+std::vector<double> HalfBandFIR<SampleType>::design(int numEvenTaps, double attenuation)
+{
+    const int numTaps = 2 * numEvenTaps - 1;
+    const double centre = (numTaps - 1) / 2.0;
+
+    // Kaiser window beta for the requested stopband attenuation
+    double beta = attenuation > 50 ? 0.1102 * (attenuation - 8.7)
+                                   : 0.5842 * pow(attenuation - 21, 0.4) + 0.07886 * (attenuation - 21);
+
+    std::vector<double> kernel((size_t)numTaps, 0.0);
+    double evenSum = 0.0;
+
+    for (int i = 0; i < numTaps; ++i)
+    {
+        double t = i - centre;
+        double sinc = t == 0 ? 0.5 : sin(pi * t / 2) / (pi * t);
+        double r = t / centre;
+        double window = besselI0(beta * sqrt(std::max(0.0, 1 - r * r))) / besselI0(beta);
+
+        kernel[(size_t)i] = sinc * window;
+
+        if ((i & 1) == 0)
+            evenSum += kernel[(size_t)i];
+    }
+
+    // Normalise each polyphase branch to a DC gain of one half
+    for (int i = 0; i < numTaps; i += 2)
+        kernel[(size_t)i] *= 0.5 / evenSum;
+
+    // Exact zeros and centre tap
+    for (int i = 1; i < numTaps; i += 2)
+        kernel[(size_t)i] = 0.0;
+
+    kernel[(size_t)centre] = 0.5;
+
+    return kernel;
+}
+
+template <typename SampleType>
+void HalfBandFIR<SampleType>::setCoefficients(const std::vector<double>& kernel)
+{
+    m_numEvenTaps = ((int)kernel.size() + 1) / 2;
+
+    m_evenTaps.resize((size_t)m_numEvenTaps);
+    for (int j = 0; j < m_numEvenTaps; ++j)
+        m_evenTaps[(size_t)j] = (SampleType)kernel[(size_t)(2 * j)];
+
+    m_history.assign((size_t)(2 * m_numEvenTaps), (SampleType)0);
+    m_oddHistory.assign((size_t)(2 * (m_numEvenTaps / 2 + 1)), (SampleType)0);
+
+    reset();
+}
+
+template <typename SampleType>
+void HalfBandFIR<SampleType>::reset()
+{
+    std::fill(m_history.begin(), m_history.end(), (SampleType)0);
+    std::fill(m_oddHistory.begin(), m_oddHistory.end(), (SampleType)0);
+    m_position = 0;
+    m_oddPosition = 0;
+}
+
+template <typename SampleType>
+void HalfBandFIR<SampleType>::upsample(const SampleType* in, SampleType* out, int numIn)
+{
+    const int length = m_numEvenTaps;
+    const int centreDelay = m_numEvenTaps / 2 - 1;
+    const SampleType* taps = m_evenTaps.data();
+
+    for (int n = 0; n < numIn; ++n)
+    {
+        // Newest sample at m_position, older ones follow it
+        m_position = (m_position == 0 ? length : m_position) - 1;
+        m_history[(size_t)m_position] = in[n];
+        m_history[(size_t)(m_position + length)] = in[n];
+
+        const SampleType* x = m_history.data() + m_position;
+        SampleType sum = 0;
+
+        for (int j = 0; j < length; ++j)
+            sum += taps[j] * x[j];
+
+        // Zero stuffing halves the level, so the branches carry a gain of two
+        out[2 * n] = (SampleType)2 * sum;
+        out[2 * n + 1] = x[centreDelay];
+    }
+}
+
+template <typename SampleType>
+void HalfBandFIR<SampleType>::downsample(const SampleType* in, SampleType* out, int numOut)
+{
+    const int length = m_numEvenTaps;
+    const int oddLength = m_numEvenTaps / 2 + 1;
+    const SampleType* taps = m_evenTaps.data();
+
+    for (int n = 0; n < numOut; ++n)
+    {
+        m_position = (m_position == 0 ? length : m_position) - 1;
+        m_history[(size_t)m_position] = in[2 * n];
+        m_history[(size_t)(m_position + length)] = in[2 * n];
+
+        m_oddPosition = (m_oddPosition == 0 ? oddLength : m_oddPosition) - 1;
+        m_oddHistory[(size_t)m_oddPosition] = in[2 * n + 1];
+        m_oddHistory[(size_t)(m_oddPosition + oddLength)] = in[2 * n + 1];
+
+        const SampleType* x = m_history.data() + m_position;
+        SampleType sum = 0;
+
+        for (int j = 0; j < length; ++j)
+            sum += taps[j] * x[j];
+
+        // Centre tap, half a kernel behind
+        out[n] = sum + (SampleType)0.5 * m_oddHistory[(size_t)(m_oddPosition + oddLength - 1)];
+    }
+}
+
+//==============================================================================
+// Per stage designs: the first stage needs the steepest transition, the later
+// ones only have to keep the images of the first stage's passband out
+static const double iirAttenuation = 96.0;
+static const double iirTransition[Oversampler::maxFactorLog2] = { 0.02, 0.12, 0.18 };
+
+static const double firAttenuation = 96.0;
+static const int firEvenTaps[Oversampler::maxFactorLog2] = { 64, 20, 12 };
+
+Oversampler::Oversampler()
+{
+    // Designs only depend on the stage, so latencies are known up front
+    for (int stage = 0; stage < maxFactorLog2; ++stage)
+    {
+        HalfBandIIR iir;
+        iir.setCoefficients(HalfBandIIR::design(iirAttenuation, iirTransition[stage]));
+
+        HalfBandFIR<float> fir;
+        fir.setCoefficients(HalfBandFIR<float>::design(firEvenTaps[stage], firAttenuation));
+
+        // Up and down pass at 2^(stage + 1) times the base rate; the IIR down
+        // pass reads the odd sample first, which saves one sample there
+        const double rateRatio = (double)(2 << stage);
+        m_stageLatency[minimumPhase][stage] = (2 * iir.getGroupDelay() - 1) / rateRatio;
+        m_stageLatency[linearPhase][stage] = (2 * fir.getDelay()) / rateRatio;
+
+        // The FIR kernel is twice its delay long
+        m_stageTail[minimumPhase][stage] = (2 * iir.getDecayLength()) / rateRatio;
+        m_stageTail[linearPhase][stage] = (2 * (2 * fir.getDelay() + 1)) / rateRatio;
+    }
+}
+
+void Oversampler::prepare(int numChannels, int maxBlockSize)
+{
+    m_numChannels = numChannels;
+    m_maxBlockSize = maxBlockSize;
+
+    m_stages.assign((size_t)numChannels, std::vector<Stage>((size_t)maxFactorLog2));
+
+    for (auto& channelStages : m_stages)
+    {
+        for (int stage = 0; stage < maxFactorLog2; ++stage)
+        {
+            auto iirCoefficients = HalfBandIIR::design(iirAttenuation, iirTransition[stage]);
+
+            channelStages[(size_t)stage].upIIR.setCoefficients(iirCoefficients);
+            channelStages[(size_t)stage].downIIR.setCoefficients(iirCoefficients);
+        }
+    }
+
+    prepareBuffers(m_floatBuffers);
+    prepareBuffers(m_doubleBuffers);
+
+    reset();
+}
+
+template <typename SampleType>
+void Oversampler::prepareBuffers(Buffers<SampleType>& buffers)
+{
+    buffers.upFIR.assign((size_t)m_numChannels, std::vector<HalfBandFIR<SampleType>>((size_t)maxFactorLog2));
+    buffers.downFIR.assign((size_t)m_numChannels, std::vector<HalfBandFIR<SampleType>>((size_t)maxFactorLog2));
+
+    for (int stage = 0; stage < maxFactorLog2; ++stage)
+    {
+        auto firKernel = HalfBandFIR<SampleType>::design(firEvenTaps[stage], firAttenuation);
+
+        for (int ch = 0; ch < m_numChannels; ++ch)
+        {
+            buffers.upFIR[(size_t)ch][(size_t)stage].setCoefficients(firKernel);
+            buffers.downFIR[(size_t)ch][(size_t)stage].setCoefficients(firKernel);
+        }
+    }
+
+    buffers.data.assign((size_t)maxFactorLog2, {});
+    buffers.pointers.assign((size_t)maxFactorLog2, {});
+
+    for (int stage = 0; stage < maxFactorLog2; ++stage)
+    {
+        buffers.data[(size_t)stage].assign((size_t)m_numChannels, std::vector<SampleType>((size_t)m_maxBlockSize << (stage + 1), (SampleType)0));
+
+        for (auto& buffer : buffers.data[(size_t)stage])
+            buffers.pointers[(size_t)stage].push_back(buffer.data());
+    }
+}
+
+template <>
+Oversampler::Buffers<float>& Oversampler::getBuffers<float>()
+{
+    return m_floatBuffers;
+}
+
+template <>
+Oversampler::Buffers<double>& Oversampler::getBuffers<double>()
+{
+    return m_doubleBuffers;
+}
+
+void Oversampler::reset()
+{
+    for (auto& channelStages : m_stages)
+    {
+        for (auto& stage : channelStages)
+        {
+            stage.upIIR.reset();
+            stage.downIIR.reset();
+        }
+    }
+
+    auto resetFIRs = [](auto& buffers)
+    {
+        for (int ch = 0; ch < (int)buffers.upFIR.size(); ++ch)
+        {
+            for (auto& fir : buffers.upFIR[(size_t)ch])
+                fir.reset();
+
+            for (auto& fir : buffers.downFIR[(size_t)ch])
+                fir.reset();
+        }
+    };
+
+    resetFIRs(m_floatBuffers);
+    resetFIRs(m_doubleBuffers);
+}
+
+void Oversampler::copyChannelState(int from, int to)
+{
+    // Same sized vectors, so the copies reuse the storage of channel to
+    m_stages[(size_t)to] = m_stages[(size_t)from];
+
+    auto copyFIRs = [from, to](auto& buffers)
+    {
+        buffers.upFIR[(size_t)to] = buffers.upFIR[(size_t)from];
+        buffers.downFIR[(size_t)to] = buffers.downFIR[(size_t)from];
+    };
+
+    copyFIRs(m_floatBuffers);
+    copyFIRs(m_doubleBuffers);
+}
+
+void Oversampler::setFactorLog2(int factorLog2)
+{
+    factorLog2 = std::max(0, std::min(factorLog2, (int)maxFactorLog2));
+
+    // Stages that were idle hold stale state
+    if (factorLog2 != m_factorLog2)
+        reset();
+
+    m_factorLog2 = factorLog2;
+}
+
+void Oversampler::setPhase(Phase phase)
+{
+    if (phase != m_phase)
+        reset();
+
+    m_phase = phase;
+}
+
+int Oversampler::getLatencyInSamples() const
+{
+    double latency = 0.0;
+
+    for (int stage = 0; stage < m_factorLog2; ++stage)
+        latency += m_stageLatency[m_phase][stage];
+
+    return (int)std::lround(latency);
+}
+
+int Oversampler::getTailLengthInSamples() const
+{
+    double tail = 0.0;
+
+    for (int stage = 0; stage < m_factorLog2; ++stage)
+        tail += m_stageTail[m_phase][stage];
+
+    return (int)std::ceil(tail);
+}
+
+template <typename SampleType>
+SampleType* const* Oversampler::upsample(const SampleType* const* channels, int numChannels, int numSamples)
+{
+    numChannels = std::min(numChannels, m_numChannels);
+
+    auto& buffers = getBuffers<SampleType>();
+    const SampleType* const* source = channels;
+
+    for (int stage = 0; stage < m_factorLog2; ++stage)
+    {
+        const int numIn = numSamples << stage;
+        SampleType* const* destination = buffers.pointers[(size_t)stage].data();
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            if (m_phase == minimumPhase)
+                m_stages[(size_t)ch][(size_t)stage].upIIR.upsample(source[ch], destination[ch], numIn);
+            else
+                buffers.upFIR[(size_t)ch][(size_t)stage].upsample(source[ch], destination[ch], numIn);
+        }
+
+        source = destination;
+    }
+
+    return const_cast<SampleType* const*>(source);
+}
+
+template <typename SampleType>
+void Oversampler::downsample(SampleType* const* channels, int numChannels, int numSamples)
+{
+    numChannels = std::min(numChannels, m_numChannels);
+
+    auto& buffers = getBuffers<SampleType>();
+
+    for (int stage = m_factorLog2 - 1; stage >= 0; --stage)
+    {
+        const int numOut = numSamples << stage;
+        const SampleType* const* source = buffers.pointers[(size_t)stage].data();
+        SampleType* const* destination = stage == 0 ? channels : buffers.pointers[(size_t)(stage - 1)].data();
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            if (m_phase == minimumPhase)
+                m_stages[(size_t)ch][(size_t)stage].downIIR.downsample(source[ch], destination[ch], numOut);
+            else
+                buffers.downFIR[(size_t)ch][(size_t)stage].downsample(source[ch], destination[ch], numOut);
+        }
+    }
+}
+
+//==============================================================================
+template class HalfBandFIR<float>;
+template class HalfBandFIR<double>;
+
+template float* const* Oversampler::upsample<float>(const float* const*, int, int);
+template double* const* Oversampler::upsample<double>(const double* const*, int, int);
+template void Oversampler::downsample<float>(float* const*, int, int);
+template void Oversampler::downsample<double>(double* const*, int, int);
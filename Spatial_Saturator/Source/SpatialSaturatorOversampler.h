@@ -0,0 +1,197 @@
+/*
+  ==============================================================================
+
+    This file contains the oversampling stage used around the waveshaper:
+    cascaded 2x polyphase half-band filters, either minimum phase (allpass
+    IIR) or linear phase (FIR)
+
+  ==============================================================================
+*/
+#ifndef __SpatialSaturatorOversampler__SpatialSaturatorOversampler__
+#define __SpatialSaturatorOversampler__SpatialSaturatorOversampler__
+
+#pragma once
+
+#include <vector>
+
+//==============================================================================
+/**
+    Polyphase IIR half-band filter made of two parallel chains of first order
+    allpass sections (one 2x up or down stage). Coefficients come from the
+    elliptic design of Valenzuela & Constantinides as used by de Soras' HIIR.
+*/
+class HalfBandIIR
+{
+public:
+    enum { maxCoefficients = 16 };
+
+    // Designs the allpass coefficients for a stopband attenuation (dB) and a
+    // transition half width (fraction of the high sample rate)
+    static std::vector<double> design(double attenuation, double transition);
+
+    void setCoefficients(const std::vector<double>& coefficients);
+    void reset();
+
+    // numIn samples in, 2 * numIn samples out (float or double)
+    template <typename SampleType>
+    void upsample(const SampleType* in, SampleType* out, int numIn);
+    // 2 * numOut samples in, numOut samples out (float or double)
+    template <typename SampleType>
+    void downsample(const SampleType* in, SampleType* out, int numOut);
+
+    // Group delay at DC in samples at the high rate, for one up or down pass
+    double getGroupDelay() const;
+
+    // Samples at the high rate until the slower path has rung out, for one
+    // up or down pass
+    double getDecayLength() const;
+
+private:
+    inline double processPath(double x, int firstSection)
+    {
+        // Sections alternate between the two paths
+        for (int i = firstSection; i < m_numCoefficients; i += 2)
+        {
+            double y = m_coefficients[i] * (x - m_y1[i]) + m_x1[i];
+            m_x1[i] = x;
+            m_y1[i] = y;
+            x = y;
+        }
+
+        return x;
+    }
+
+    double m_coefficients[maxCoefficients]{};
+    int m_numCoefficients = 0;
+
+    // Allpass states
+    double m_x1[maxCoefficients]{}, m_y1[maxCoefficients]{};
+};
+
+//==============================================================================
+/**
+    Linear phase half-band FIR (one 2x up or down stage), Kaiser windowed sinc.
+    Half of the taps of a half-band filter are zero, so the polyphase form only
+    runs the even taps plus a pure delay for the centre tap.
+    Instantiated for float and double.
+*/
+template <typename SampleType>
+class HalfBandFIR
+{
+public:
+    // Designs a half-band kernel of 4 * numEvenTaps / 2 - 1 taps
+    static std::vector<double> design(int numEvenTaps, double attenuation);
+
+    void setCoefficients(const std::vector<double>& kernel);
+    void reset();
+
+    void upsample(const SampleType* in, SampleType* out, int numIn);
+    void downsample(const SampleType* in, SampleType* out, int numOut);
+
+    // Delay in samples at the high rate, for one up or down pass
+    int getDelay() const { return m_numEvenTaps - 1; }
+
+private:
+    int m_numEvenTaps = 0;
+
+    // Even taps h[0], h[2], ... of the kernel
+    std::vector<SampleType> m_evenTaps;
+
+    // Histories, stored twice so the newest numEvenTaps samples are contiguous
+    std::vector<SampleType> m_history, m_oddHistory;
+    int m_position = 0, m_oddPosition = 0;
+};
+
+//==============================================================================
+/**
+    1x/2x/4x/8x oversampling built from cascaded half-band stages. All state and
+    buffers are allocated in prepare(); changing factor or phase is realtime safe.
+
+    upsample() and downsample() take float or double channels. Both have their
+    own buffers and FIR histories; the IIR states are shared, as a host only
+    ever runs one precision between two prepare() calls.
+*/
+class Oversampler
+{
+public:
+    enum Phase
+    {
+        minimumPhase = 0,
+        linearPhase
+    };
+
+    enum { maxFactorLog2 = 3 };
+
+    Oversampler();
+
+    void prepare(int numChannels, int maxBlockSize);
+    void reset();
+
+    // Gives channel to the filter states of channel from, for both sample types
+    void copyChannelState(int from, int to);
+
+    void setFactorLog2(int factorLog2);
+    void setPhase(Phase phase);
+
+    int getFactorLog2() const { return m_factorLog2; }
+    int getFactor() const { return 1 << m_factorLog2; }
+
+    // Round trip latency (up and down) in samples at the base rate
+    int getLatencyInSamples() const;
+
+    // Round trip tail in samples at the base rate: how long the filters ring on
+    // after the input stops
+    int getTailLengthInSamples() const;
+
+    // Upsamples numSamples per channel and returns the oversampled channels,
+    // which hold numSamples * getFactor() samples each
+    template <typename SampleType>
+    SampleType* const* upsample(const SampleType* const* channels, int numChannels, int numSamples);
+
+    // Downsamples the buffers returned by upsample() back into channels
+    template <typename SampleType>
+    void downsample(SampleType* const* channels, int numChannels, int numSamples);
+
+private:
+    struct Stage
+    {
+        HalfBandIIR upIIR, downIIR;
+    };
+
+    // Linear phase filters and oversampled data for one sample type
+    template <typename SampleType>
+    struct Buffers
+    {
+        // [channel][stage]
+        std::vector<std::vector<HalfBandFIR<SampleType>>> upFIR, downFIR;
+
+        // [stage][channel], stage k holds maxBlockSize << (k + 1) samples
+        std::vector<std::vector<std::vector<SampleType>>> data;
+        std::vector<std::vector<SampleType*>> pointers;
+    };
+
+    template <typename SampleType>
+    void prepareBuffers(Buffers<SampleType>& buffers);
+
+    template <typename SampleType>
+    Buffers<SampleType>& getBuffers();
+
+    int m_factorLog2 = 0;
+    Phase m_phase = minimumPhase;
+    int m_numChannels = 0;
+    int m_maxBlockSize = 0;
+
+    // Per stage latency at the base rate, [phase][stage]
+    double m_stageLatency[2][maxFactorLog2]{};
+
+    // Per stage round trip tail at the base rate, [phase][stage]
+    double m_stageTail[2][maxFactorLog2]{};
+
+    // [channel][stage]
+    std::vector<std::vector<Stage>> m_stages;
+
+    Buffers<float> m_floatBuffers;
+    Buffers<double> m_doubleBuffers;
+};
+
+#endif
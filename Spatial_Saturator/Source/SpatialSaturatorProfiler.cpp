@@ -0,0 +1,124 @@
+/*
+  ==============================================================================
+
+    This file contains the optional per-stage timing of the engines
+
+  ==============================================================================
+*/
+
+#include "SpatialSaturatorProfiler.h"
+#include <algorithm>
+#include <iterator>
+
+static_assert((StageProfiler::ringSize & (StageProfiler::ringSize - 1)) == 0, "the ring indices wrap at a power of two");
+
+//==============================================================================
+const char* StageProfiler::getStageName(int stage)
+{
+    static const char* const names[numStages] = { "coefficients", "filters", "waveshaper", "limiter", "metering", "block" };
+    return stage >= 0 && stage < numStages ? names[stage] : "";
+}
+
+StageProfiler::StageProfiler()
+    : m_ring((size_t)ringSize)
+{
+    for (auto& history : m_history)
+        history.assign((size_t)historyLength, 0);
+}
+
+double StageProfiler::getTicksPerMicrosecond()
+{
+   #if SPATIAL_SATURATOR_HAS_TSC
+    // Assumes an invariant counter, as every x86 of the last decade has
+    static const double ticksPerMicrosecond = []
+    {
+        const auto startTime = std::chrono::steady_clock::now();
+        const auto startTicks = readTicks();
+
+        while (std::chrono::steady_clock::now() - startTime < std::chrono::milliseconds(20))
+            ;
+
+        const auto endTicks = readTicks();
+        const auto endTime = std::chrono::steady_clock::now();
+
+        return (double)(endTicks - startTicks) / std::chrono::duration<double, std::micro>(endTime - startTime).count();
+    }();
+
+    return ticksPerMicrosecond;
+   #else
+    return 1000.0;
+   #endif
+}
+
+//==============================================================================
+void StageProfiler::endBlock()
+{
+    const auto write = m_writeIndex.load(std::memory_order_relaxed);
+
+    if (write - m_readIndex.load(std::memory_order_acquire) < (std::uint32_t)ringSize)
+    {
+        std::copy(std::begin(m_blockTicks), std::end(m_blockTicks), m_ring[write & (ringSize - 1)].ticks);
+        m_writeIndex.store(write + 1, std::memory_order_release);
+    }
+    else
+    {
+        m_numDropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::fill(std::begin(m_blockTicks), std::end(m_blockTicks), (std::uint64_t)0);
+}
+
+void StageProfiler::collect()
+{
+    const auto write = m_writeIndex.load(std::memory_order_acquire);
+    auto read = m_readIndex.load(std::memory_order_relaxed);
+
+    for (; read != write; ++read)
+    {
+        const auto& record = m_ring[read & (ringSize - 1)];
+
+        for (int stage = 0; stage < numStages; ++stage)
+            m_history[stage][(size_t)m_historyPosition] = record.ticks[stage];
+
+        m_historyPosition = (m_historyPosition + 1) % historyLength;
+        m_historySize = std::min(m_historySize + 1, (int)historyLength);
+    }
+
+    // Hands the slots back to the audio thread
+    m_readIndex.store(read, std::memory_order_release);
+}
+
+void StageProfiler::clearHistory()
+{
+    m_historyPosition = 0;
+    m_historySize = 0;
+}
+
+StageProfiler::Statistics StageProfiler::getStatistics(int stage) const
+{
+    Statistics statistics;
+
+    if (m_historySize == 0 || stage < 0 || stage >= numStages)
+        return statistics;
+
+    // Until the circle is full the history is its start
+    std::vector<std::uint64_t> ticks(m_history[stage].begin(), m_history[stage].begin() + m_historySize);
+
+    const double microsecondsPerTick = 1.0 / getTicksPerMicrosecond();
+    const auto minMax = std::minmax_element(ticks.begin(), ticks.end());
+
+    double sum = 0.0;
+    for (auto t : ticks)
+        sum += (double)t;
+
+    statistics.min = (double)*minMax.first * microsecondsPerTick;
+    statistics.max = (double)*minMax.second * microsecondsPerTick;
+    statistics.mean = sum / (double)ticks.size() * microsecondsPerTick;
+
+    const auto p99 = ticks.begin() + (std::ptrdiff_t)((ticks.size() - 1) * 99 / 100);
+    std::nth_element(ticks.begin(), p99, ticks.end());
+    statistics.p99 = (double)*p99 * microsecondsPerTick;
+
+    statistics.numBlocks = m_historySize;
+    return statistics;
+}
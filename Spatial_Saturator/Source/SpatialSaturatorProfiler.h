@@ -0,0 +1,209 @@
+/*
+  ==============================================================================
+
+    This file contains the optional per-stage timing of the engines
+
+  ==============================================================================
+*/
+#ifndef __SpatialSaturatorProfiler__SpatialSaturatorProfiler__
+#define __SpatialSaturatorProfiler__SpatialSaturatorProfiler__
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#if defined (_M_X64) || defined (__x86_64__) || defined (_M_IX86) || defined (__i386__)
+ #if defined (_MSC_VER)
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+ #define SPATIAL_SATURATOR_HAS_TSC 1
+#else
+ #define SPATIAL_SATURATOR_HAS_TSC 0
+#endif
+
+// Off unless the build turns it on (CMake: -DSPATIAL_SATURATOR_PROFILING=ON)
+#ifndef SPATIAL_SATURATOR_PROFILING
+ #define SPATIAL_SATURATOR_PROFILING 0
+#endif
+
+// Time stamp counter, 0 where there is none
+inline unsigned long long readCycleCounter()
+{
+   #if SPATIAL_SATURATOR_HAS_TSC
+    return __rdtsc();
+   #else
+    return 0;
+   #endif
+}
+
+//==============================================================================
+/**
+    Where the time of an engine's process() calls goes, stage by stage, to
+    find out what a CPU spike was.
+
+    With SPATIAL_SATURATOR_PROFILING set, an engine given a profiler times
+    each stage with the time stamp counter (steady_clock where there is none)
+    and pushes one record per block, the ticks of every stage, into a ring
+    allocated up front. It is a single producer, single consumer ring: pushing
+    never allocates, locks or waits, and when the reader falls behind the
+    block is dropped and counted instead.
+
+    The reader (the editor's timer, a tool's main thread) calls collect() to
+    move the records into a history of the last historyLength blocks, and
+    getStatistics() for the min, mean, 99th percentile and max of each stage
+    over it, in microseconds per block.
+
+    Without SPATIAL_SATURATOR_PROFILING the macros at the end of this file are
+    empty, so the engines have no timing code at all.
+*/
+class StageProfiler
+{
+public:
+    enum Stage
+    {
+        coefficients = 0,   // filter and saturator coefficient updates
+        filters,            // M/S encode, filters, make up gain and decode
+        waveshaper,
+        limiter,
+        metering,           // input and output loudness meters
+        wholeBlock,         // all of process(), the stages above included
+        numStages
+    };
+
+    enum
+    {
+        ringSize = 1024,        // blocks, a power of two
+        historyLength = 4096    // blocks
+    };
+
+    static constexpr bool isEnabled = SPATIAL_SATURATOR_PROFILING != 0;
+
+    static const char* getStageName(int stage);
+
+    // Microseconds per block
+    struct Statistics
+    {
+        double min = 0.0, mean = 0.0, p99 = 0.0, max = 0.0;
+        int numBlocks = 0;
+    };
+
+    // Allocates the ring and the history
+    StageProfiler();
+
+    // The clock the stages are timed with
+    static std::uint64_t readTicks()
+    {
+       #if SPATIAL_SATURATOR_HAS_TSC
+        return __rdtsc();
+       #else
+        return (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+       #endif
+    }
+
+    //==============================================================================
+    // Audio thread: adds to stage in the current block
+    void addTicks(int stage, std::uint64_t ticks)   { m_blockTicks[stage] += ticks; }
+
+    // Audio thread: pushes the current block and starts the next
+    void endBlock();
+
+    //==============================================================================
+    // Reader thread: moves everything pushed since the last call into the history
+    void collect();
+
+    // Reader thread: forgets the history
+    void clearHistory();
+
+    // Reader thread: over the history. The first call calibrates the time
+    // stamp counter, which takes about 20ms
+    Statistics getStatistics(int stage) const;
+
+    // Blocks dropped as the ring was full
+    std::uint64_t getNumDropped() const { return m_numDropped.load(std::memory_order_relaxed); }
+
+    //==============================================================================
+    // Times its scope as stage of profiler, if not null
+    class ScopedStage
+    {
+    public:
+        ScopedStage(StageProfiler* profiler, Stage stage)
+            : m_profiler(profiler), m_stage(stage), m_start(profiler != nullptr ? readTicks() : 0) {}
+
+        ~ScopedStage()
+        {
+            if (m_profiler != nullptr)
+                m_profiler->addTicks(m_stage, readTicks() - m_start);
+        }
+
+    private:
+        StageProfiler* m_profiler;
+        Stage m_stage;
+        std::uint64_t m_start;
+    };
+
+    // Times its scope as the whole block of profiler, if not null, and pushes
+    // the block at the end
+    class ScopedBlock
+    {
+    public:
+        explicit ScopedBlock(StageProfiler* profiler)
+            : m_profiler(profiler), m_start(profiler != nullptr ? readTicks() : 0) {}
+
+        ~ScopedBlock()
+        {
+            if (m_profiler != nullptr)
+            {
+                m_profiler->addTicks(wholeBlock, readTicks() - m_start);
+                m_profiler->endBlock();
+            }
+        }
+
+    private:
+        StageProfiler* m_profiler;
+        std::uint64_t m_start;
+    };
+
+private:
+    static double getTicksPerMicrosecond();
+
+    struct BlockRecord
+    {
+        std::uint64_t ticks[numStages];
+    };
+
+    // Audio thread
+    std::uint64_t m_blockTicks[numStages] = {};
+
+    std::vector<BlockRecord> m_ring;
+    std::atomic<std::uint32_t> m_writeIndex { 0 }, m_readIndex { 0 };
+    std::atomic<std::uint64_t> m_numDropped { 0 };
+
+    // Reader thread: ticks of the last m_historySize blocks per stage, in a
+    // circle that m_historyPosition goes round
+    std::vector<std::uint64_t> m_history[numStages];
+    int m_historyPosition = 0, m_historySize = 0;
+};
+
+//==============================================================================
+// In an engine's process(): times the rest of the scope as stage (a
+// StageProfiler::Stage) or as the whole block, profiler being a possibly
+// null StageProfiler*. Nothing without SPATIAL_SATURATOR_PROFILING
+#if SPATIAL_SATURATOR_PROFILING
+ #define SPATIAL_SATURATOR_PROFILE_JOIN_(a, b) a##b
+ #define SPATIAL_SATURATOR_PROFILE_JOIN(a, b) SPATIAL_SATURATOR_PROFILE_JOIN_(a, b)
+
+ #define SPATIAL_SATURATOR_PROFILE_STAGE(profiler, stage) \
+    StageProfiler::ScopedStage SPATIAL_SATURATOR_PROFILE_JOIN(scopedStage, __LINE__) (profiler, StageProfiler::stage)
+ #define SPATIAL_SATURATOR_PROFILE_BLOCK(profiler) \
+    StageProfiler::ScopedBlock SPATIAL_SATURATOR_PROFILE_JOIN(scopedBlock, __LINE__) (profiler)
+#else
+ #define SPATIAL_SATURATOR_PROFILE_STAGE(profiler, stage)
+ #define SPATIAL_SATURATOR_PROFILE_BLOCK(profiler)
+#endif
+
+#endif
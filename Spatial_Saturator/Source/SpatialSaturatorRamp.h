@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+    This file contains the linear parameter ramp used to smooth automation
+
+  ==============================================================================
+*/
+#ifndef __SpatialSaturatorRamp__SpatialSaturatorRamp__
+#define __SpatialSaturatorRamp__SpatialSaturatorRamp__
+
+#pragma once
+
+//==============================================================================
+/**
+    Linear ramp from the current value to a target over a fixed number of
+    samples, like juce::SmoothedValue but without the JUCE dependency.
+
+    A new target restarts the ramp from wherever the value is, so a parameter
+    that keeps moving never jumps.
+*/
+class LinearRamp
+{
+public:
+    void setRampLength(int numSamples)      { m_rampLength = numSamples > 0 ? numSamples : 1; }
+
+    // Jumps straight to the value
+    void setCurrentAndTarget(float value)
+    {
+        m_current = m_target = value;
+        m_step = 0.0f;
+        m_countdown = 0;
+    }
+
+    void setTarget(float target)
+    {
+        if (target == m_target)
+            return;
+
+        m_target = target;
+        m_step = (m_target - m_current) / (float)m_rampLength;
+        m_countdown = m_rampLength;
+    }
+
+    bool isRamping() const                  { return m_countdown > 0; }
+    float getCurrent() const                { return m_current; }
+    float getTarget() const                 { return m_target; }
+
+    // Moves numSamples along the ramp and returns the value there
+    float skip(int numSamples)
+    {
+        if (numSamples >= m_countdown)
+        {
+            m_current = m_target;
+            m_countdown = 0;
+        }
+        else
+        {
+            m_current += m_step * (float)numSamples;
+            m_countdown -= numSamples;
+        }
+
+        return m_current;
+    }
+
+private:
+    float m_current = 0.0f, m_target = 0.0f, m_step = 0.0f;
+    int m_rampLength = 1, m_countdown = 0;
+};
+
+#endif
@@ -0,0 +1,226 @@
+/*
+  ==============================================================================
+
+    This file contains a small SIMD wrapper (SSE2 on x86, NEON on AArch64,
+    scalar otherwise): two lane double precision for the filter engine, four
+    lane double precision for the multi-stream filters and the waveshaper's
+    lane kernels (one AVX register when built for AVX, two two-lane registers
+    otherwise) and four lane single precision for the saturator kernels
+
+  ==============================================================================
+*/
+#ifndef __SpatialSaturatorSIMD__SpatialSaturatorSIMD__
+#define __SpatialSaturatorSIMD__SpatialSaturatorSIMD__
+
+#pragma once
+
+#if defined (_M_X64) || defined (__x86_64__) || defined (__SSE2__) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+ #define SPATIAL_SATURATOR_SIMD_SSE2 1
+ #if defined (__AVX__)
+  #include <immintrin.h>
+  #define SPATIAL_SATURATOR_SIMD_AVX 1
+ #endif
+#elif defined (__aarch64__) || defined (_M_ARM64)
+ #include <arm_neon.h>
+ #define SPATIAL_SATURATOR_SIMD_NEON 1
+#else
+ #include <math.h>
+ #define SPATIAL_SATURATOR_SIMD_SCALAR 1
+#endif
+
+// For the double4 kernels: without AVX a double4 is two registers, which a
+// call passes through memory, so the math on it must always inline
+#if defined (_MSC_VER)
+ #define SPATIAL_SATURATOR_INLINE __forceinline
+#else
+ #define SPATIAL_SATURATOR_INLINE inline __attribute__((always_inline))
+#endif
+
+namespace SIMD
+{
+#if SPATIAL_SATURATOR_SIMD_SSE2
+    typedef __m128d double2;
+
+    inline double2 load(const double* p)                { return _mm_load_pd(p); }
+    inline double2 loadUnaligned(const double* p)       { return _mm_loadu_pd(p); }
+    inline void store(double* p, double2 v)             { _mm_store_pd(p, v); }
+    inline double2 set(double lane0, double lane1)      { return _mm_set_pd(lane1, lane0); }
+    inline double2 add(double2 a, double2 b)            { return _mm_add_pd(a, b); }
+    inline double2 sub(double2 a, double2 b)            { return _mm_sub_pd(a, b); }
+    inline double2 mul(double2 a, double2 b)            { return _mm_mul_pd(a, b); }
+    inline double2 div(double2 a, double2 b)            { return _mm_div_pd(a, b); }
+    inline double2 max(double2 a, double2 b)            { return _mm_max_pd(a, b); }
+    // Round both lanes to float precision and back, like storing to a float buffer
+    inline double2 roundToFloat(double2 v)              { return _mm_cvtps_pd(_mm_cvtpd_ps(v)); }
+    inline double getLane0(double2 v)                   { return _mm_cvtsd_f64(v); }
+    inline double getLane1(double2 v)                   { return _mm_cvtsd_f64(_mm_unpackhi_pd(v, v)); }
+
+    // For the double precision curve kernels. A mask has every bit of a lane
+    // set where the comparison holds
+    inline double2 min(double2 a, double2 b)            { return _mm_min_pd(a, b); }
+    inline double2 abs(double2 v)                       { return _mm_andnot_pd(_mm_set1_pd(-0.0), v); }
+    inline double2 lessThan(double2 a, double2 b)       { return _mm_cmplt_pd(a, b); }
+    inline double2 select(double2 mask, double2 a, double2 b) { return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b)); }
+    inline bool anyLane(double2 mask)                   { return _mm_movemask_pd(mask) != 0; }
+    // |v| with the sign of sign
+    inline double2 copySign(double2 v, double2 sign)    { const __m128d s = _mm_set1_pd(-0.0); return _mm_or_pd(_mm_andnot_pd(s, v), _mm_and_pd(s, sign)); }
+    // Round to the nearest integer for |v| < 2^51: adding 1.5 * 2^52 leaves it in the low mantissa bits
+    inline double2 round(double2 v)                     { const __m128d m = _mm_set1_pd(6755399441055744.0); return _mm_sub_pd(_mm_add_pd(v, m), m); }
+    inline double2 negateIfOdd(double2 v, double2 k)    { return _mm_xor_pd(v, _mm_castsi128_pd(_mm_slli_epi64(_mm_castpd_si128(_mm_add_pd(k, _mm_set1_pd(6755399441055744.0))), 63))); }
+    // 2^k for integers k in [-1022, 1023], built in the exponent bits
+    inline double2 exp2Integer(double2 k)               { return _mm_castsi128_pd(_mm_slli_epi64(_mm_castpd_si128(_mm_add_pd(k, _mm_set1_pd(6755399441056767.0))), 52)); }
+
+    typedef __m128 float4;
+
+    // Unaligned, so they work on any buffer position
+    inline float4 load(const float* p)                  { return _mm_loadu_ps(p); }
+    inline void store(float* p, float4 v)               { _mm_storeu_ps(p, v); }
+    inline float4 set(float value)                      { return _mm_set1_ps(value); }
+    inline float4 set(float lane0, float lane1, float lane2, float lane3) { return _mm_setr_ps(lane0, lane1, lane2, lane3); }
+    inline float4 add(float4 a, float4 b)               { return _mm_add_ps(a, b); }
+    inline float4 sub(float4 a, float4 b)               { return _mm_sub_ps(a, b); }
+    inline float4 mul(float4 a, float4 b)               { return _mm_mul_ps(a, b); }
+    inline float4 div(float4 a, float4 b)               { return _mm_div_ps(a, b); }
+    inline float4 min(float4 a, float4 b)               { return _mm_min_ps(a, b); }
+    inline float4 max(float4 a, float4 b)               { return _mm_max_ps(a, b); }
+    // Round to the nearest integer (default rounding mode)
+    inline float4 round(float4 v)                       { return _mm_cvtepi32_ps(_mm_cvtps_epi32(v)); }
+    // Flips the sign of the lanes of v where the integer in k is odd
+    inline float4 negateIfOdd(float4 v, float4 k)       { return _mm_xor_ps(v, _mm_castsi128_ps(_mm_slli_epi32(_mm_cvtps_epi32(k), 31))); }
+#elif SPATIAL_SATURATOR_SIMD_NEON
+    typedef float64x2_t double2;
+
+    inline double2 load(const double* p)                { return vld1q_f64(p); }
+    inline double2 loadUnaligned(const double* p)       { return vld1q_f64(p); }
+    inline void store(double* p, double2 v)             { vst1q_f64(p, v); }
+    inline double2 set(double lane0, double lane1)      { return vsetq_lane_f64(lane1, vdupq_n_f64(lane0), 1); }
+    inline double2 add(double2 a, double2 b)            { return vaddq_f64(a, b); }
+    inline double2 sub(double2 a, double2 b)            { return vsubq_f64(a, b); }
+    inline double2 mul(double2 a, double2 b)            { return vmulq_f64(a, b); }
+    inline double2 div(double2 a, double2 b)            { return vdivq_f64(a, b); }
+    inline double2 max(double2 a, double2 b)            { return vmaxq_f64(a, b); }
+    inline double2 roundToFloat(double2 v)              { return vcvt_f64_f32(vcvt_f32_f64(v)); }
+    inline double getLane0(double2 v)                   { return vgetq_lane_f64(v, 0); }
+    inline double getLane1(double2 v)                   { return vgetq_lane_f64(v, 1); }
+
+    inline double2 min(double2 a, double2 b)            { return vminq_f64(a, b); }
+    inline double2 abs(double2 v)                       { return vabsq_f64(v); }
+    inline double2 lessThan(double2 a, double2 b)       { return vreinterpretq_f64_u64(vcltq_f64(a, b)); }
+    inline double2 select(double2 mask, double2 a, double2 b) { return vbslq_f64(vreinterpretq_u64_f64(mask), a, b); }
+    inline bool anyLane(double2 mask)                   { const uint64x2_t m = vreinterpretq_u64_f64(mask); return (vgetq_lane_u64(m, 0) | vgetq_lane_u64(m, 1)) != 0; }
+    inline double2 copySign(double2 v, double2 sign)    { return vbslq_f64(vdupq_n_u64(0x8000000000000000ull), sign, v); }
+    inline double2 round(double2 v)                     { return vrndnq_f64(v); }
+    inline double2 negateIfOdd(double2 v, double2 k)    { return vreinterpretq_f64_u64(veorq_u64(vreinterpretq_u64_f64(v), vshlq_n_u64(vreinterpretq_u64_s64(vcvtnq_s64_f64(k)), 63))); }
+    inline double2 exp2Integer(double2 k)               { return vreinterpretq_f64_s64(vshlq_n_s64(vaddq_s64(vcvtnq_s64_f64(k), vdupq_n_s64(1023)), 52)); }
+
+    typedef float32x4_t float4;
+
+    inline float4 load(const float* p)                  { return vld1q_f32(p); }
+    inline void store(float* p, float4 v)               { vst1q_f32(p, v); }
+    inline float4 set(float value)                      { return vdupq_n_f32(value); }
+    inline float4 set(float lane0, float lane1, float lane2, float lane3) { const float lanes[4] = { lane0, lane1, lane2, lane3 }; return vld1q_f32(lanes); }
+    inline float4 add(float4 a, float4 b)               { return vaddq_f32(a, b); }
+    inline float4 sub(float4 a, float4 b)               { return vsubq_f32(a, b); }
+    inline float4 mul(float4 a, float4 b)               { return vmulq_f32(a, b); }
+    inline float4 div(float4 a, float4 b)               { return vdivq_f32(a, b); }
+    inline float4 min(float4 a, float4 b)               { return vminq_f32(a, b); }
+    inline float4 max(float4 a, float4 b)               { return vmaxq_f32(a, b); }
+    inline float4 round(float4 v)                       { return vrndnq_f32(v); }
+    inline float4 negateIfOdd(float4 v, float4 k)       { return vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(v), vshlq_n_u32(vreinterpretq_u32_s32(vcvtnq_s32_f32(k)), 31))); }
+#else
+    struct double2 { double v[2]; };
+
+    inline double2 load(const double* p)                { return { { p[0], p[1] } }; }
+    inline double2 loadUnaligned(const double* p)       { return { { p[0], p[1] } }; }
+    inline void store(double* p, double2 v)             { p[0] = v.v[0]; p[1] = v.v[1]; }
+    inline double2 set(double lane0, double lane1)      { return { { lane0, lane1 } }; }
+    inline double2 add(double2 a, double2 b)            { return { { a.v[0] + b.v[0], a.v[1] + b.v[1] } }; }
+    inline double2 sub(double2 a, double2 b)            { return { { a.v[0] - b.v[0], a.v[1] - b.v[1] } }; }
+    inline double2 mul(double2 a, double2 b)            { return { { a.v[0] * b.v[0], a.v[1] * b.v[1] } }; }
+    inline double2 div(double2 a, double2 b)            { return { { a.v[0] / b.v[0], a.v[1] / b.v[1] } }; }
+    inline double2 max(double2 a, double2 b)            { return { { a.v[0] > b.v[0] ? a.v[0] : b.v[0], a.v[1] > b.v[1] ? a.v[1] : b.v[1] } }; }
+    // The volatile stops the SLP vectoriser folding the round trip away (seen with GCC 12 at -O2)
+    inline double2 roundToFloat(double2 v)              { volatile float f0 = (float)v.v[0], f1 = (float)v.v[1]; return { { (double)f0, (double)f1 } }; }
+    inline double getLane0(double2 v)                   { return v.v[0]; }
+    inline double getLane1(double2 v)                   { return v.v[1]; }
+
+    inline double2 min(double2 a, double2 b)            { return { { a.v[0] < b.v[0] ? a.v[0] : b.v[0], a.v[1] < b.v[1] ? a.v[1] : b.v[1] } }; }
+    inline double2 abs(double2 v)                       { return { { fabs(v.v[0]), fabs(v.v[1]) } }; }
+    inline double2 lessThan(double2 a, double2 b)       { return { { a.v[0] < b.v[0] ? 1.0 : 0.0, a.v[1] < b.v[1] ? 1.0 : 0.0 } }; }
+    inline double2 select(double2 mask, double2 a, double2 b) { return { { mask.v[0] != 0.0 ? a.v[0] : b.v[0], mask.v[1] != 0.0 ? a.v[1] : b.v[1] } }; }
+    inline bool anyLane(double2 mask)                   { return mask.v[0] != 0.0 || mask.v[1] != 0.0; }
+    inline double2 copySign(double2 v, double2 sign)    { return { { copysign(v.v[0], sign.v[0]), copysign(v.v[1], sign.v[1]) } }; }
+    inline double2 round(double2 v)                     { return { { nearbyint(v.v[0]), nearbyint(v.v[1]) } }; }
+    inline double2 negateIfOdd(double2 v, double2 k)    { return { { ((long long)k.v[0] & 1) ? -v.v[0] : v.v[0], ((long long)k.v[1] & 1) ? -v.v[1] : v.v[1] } }; }
+    inline double2 exp2Integer(double2 k)               { return { { ldexp(1.0, (int)k.v[0]), ldexp(1.0, (int)k.v[1]) } }; }
+
+    struct float4 { float v[4]; };
+
+    inline float4 load(const float* p)                  { return { { p[0], p[1], p[2], p[3] } }; }
+    inline void store(float* p, float4 v)               { p[0] = v.v[0]; p[1] = v.v[1]; p[2] = v.v[2]; p[3] = v.v[3]; }
+    inline float4 set(float value)                      { return { { value, value, value, value } }; }
+    inline float4 set(float lane0, float lane1, float lane2, float lane3) { return { { lane0, lane1, lane2, lane3 } }; }
+    inline float4 add(float4 a, float4 b)               { return { { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } }; }
+    inline float4 sub(float4 a, float4 b)               { return { { a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] } }; }
+    inline float4 mul(float4 a, float4 b)               { return { { a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3] } }; }
+    inline float4 div(float4 a, float4 b)               { return { { a.v[0] / b.v[0], a.v[1] / b.v[1], a.v[2] / b.v[2], a.v[3] / b.v[3] } }; }
+    inline float4 min(float4 a, float4 b)               { float4 r; for (int i = 0; i < 4; ++i) r.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i]; return r; }
+    inline float4 max(float4 a, float4 b)               { float4 r; for (int i = 0; i < 4; ++i) r.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i]; return r; }
+    inline float4 round(float4 v)                       { float4 r; for (int i = 0; i < 4; ++i) r.v[i] = nearbyintf(v.v[i]); return r; }
+    inline float4 negateIfOdd(float4 v, float4 k)       { float4 r; for (int i = 0; i < 4; ++i) r.v[i] = ((long)k.v[i] & 1) ? -v.v[i] : v.v[i]; return r; }
+#endif
+
+#if SPATIAL_SATURATOR_SIMD_AVX
+    typedef __m256d double4;
+
+    inline double4 load4(const double* p)               { return _mm256_load_pd(p); }
+    inline void store(double* p, double4 v)             { _mm256_store_pd(p, v); }
+    inline double4 set4(double value)                   { return _mm256_set1_pd(value); }
+    inline double4 set4(double lane0, double lane1, double lane2, double lane3) { return _mm256_set_pd(lane3, lane2, lane1, lane0); }
+    inline double4 add(double4 a, double4 b)            { return _mm256_add_pd(a, b); }
+    inline double4 sub(double4 a, double4 b)            { return _mm256_sub_pd(a, b); }
+    inline double4 mul(double4 a, double4 b)            { return _mm256_mul_pd(a, b); }
+    inline double4 roundToFloat(double4 v)              { return _mm256_cvtps_pd(_mm256_cvtpd_ps(v)); }
+
+    inline double4 div(double4 a, double4 b)            { return _mm256_div_pd(a, b); }
+    inline double4 min(double4 a, double4 b)            { return _mm256_min_pd(a, b); }
+    inline double4 max(double4 a, double4 b)            { return _mm256_max_pd(a, b); }
+    inline double4 abs(double4 v)                       { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), v); }
+    inline double4 lessThan(double4 a, double4 b)       { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+    inline double4 select(double4 mask, double4 a, double4 b) { return _mm256_blendv_pd(b, a, mask); }
+    inline bool anyLane(double4 mask)                   { return _mm256_movemask_pd(mask) != 0; }
+    inline double4 copySign(double4 v, double4 sign)    { const __m256d s = _mm256_set1_pd(-0.0); return _mm256_or_pd(_mm256_andnot_pd(s, v), _mm256_and_pd(s, sign)); }
+    inline double4 round(double4 v)                     { return _mm256_round_pd(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    // AVX has no 256 bit integer shifts, so these go through the two halves
+    inline double4 negateIfOdd(double4 v, double4 k)    { return _mm256_insertf128_pd(_mm256_castpd128_pd256(negateIfOdd(_mm256_castpd256_pd128(v), _mm256_castpd256_pd128(k))),
+                                                                                      negateIfOdd(_mm256_extractf128_pd(v, 1), _mm256_extractf128_pd(k, 1)), 1); }
+    inline double4 exp2Integer(double4 k)               { return _mm256_insertf128_pd(_mm256_castpd128_pd256(exp2Integer(_mm256_castpd256_pd128(k))),
+                                                                                      exp2Integer(_mm256_extractf128_pd(k, 1)), 1); }
+#else
+    struct double4 { double2 low, high; };
+
+    inline double4 load4(const double* p)               { return { load(p), load(p + 2) }; }
+    inline void store(double* p, double4 v)             { store(p, v.low); store(p + 2, v.high); }
+    inline double4 set4(double value)                   { return { set(value, value), set(value, value) }; }
+    inline double4 set4(double lane0, double lane1, double lane2, double lane3) { return { set(lane0, lane1), set(lane2, lane3) }; }
+    inline double4 add(double4 a, double4 b)            { return { add(a.low, b.low), add(a.high, b.high) }; }
+    inline double4 sub(double4 a, double4 b)            { return { sub(a.low, b.low), sub(a.high, b.high) }; }
+    inline double4 mul(double4 a, double4 b)            { return { mul(a.low, b.low), mul(a.high, b.high) }; }
+    inline double4 roundToFloat(double4 v)              { return { roundToFloat(v.low), roundToFloat(v.high) }; }
+
+    inline double4 div(double4 a, double4 b)            { return { div(a.low, b.low), div(a.high, b.high) }; }
+    inline double4 min(double4 a, double4 b)            { return { min(a.low, b.low), min(a.high, b.high) }; }
+    inline double4 max(double4 a, double4 b)            { return { max(a.low, b.low), max(a.high, b.high) }; }
+    inline double4 abs(double4 v)                       { return { abs(v.low), abs(v.high) }; }
+    inline double4 lessThan(double4 a, double4 b)       { return { lessThan(a.low, b.low), lessThan(a.high, b.high) }; }
+    inline double4 select(double4 mask, double4 a, double4 b) { return { select(mask.low, a.low, b.low), select(mask.high, a.high, b.high) }; }
+    inline bool anyLane(double4 mask)                   { return anyLane(mask.low) || anyLane(mask.high); }
+    inline double4 copySign(double4 v, double4 sign)    { return { copySign(v.low, sign.low), copySign(v.high, sign.high) }; }
+    inline double4 round(double4 v)                     { return { round(v.low), round(v.high) }; }
+    inline double4 negateIfOdd(double4 v, double4 k)    { return { negateIfOdd(v.low, k.low), negateIfOdd(v.high, k.high) }; }
+    inline double4 exp2Integer(double4 k)               { return { exp2Integer(k.low), exp2Integer(k.high) }; }
+#endif
+}
+
+#endif
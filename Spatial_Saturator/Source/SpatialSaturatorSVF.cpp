@@ -0,0 +1,361 @@
+/*
+  ==============================================================================
+
+    This file contains the topology-preserving state variable filters
+
+  ==============================================================================
+*/
+
+#include "SpatialSaturatorSVF.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+// Damping, 1 / Q for the Q of the biquads
+static const double k = sqrt(2.0);
+
+// Single precision like pi, as the biquads use it, so the cutoffs agree
+static const float pi = 3.141592653589793238f;
+
+//==============================================================================
+// tan(w0 / 2), from the tables' cos and sin of w0 when they hold the frequency
+static double getCutOffGain(float cutOffFrequency, float sample_rate, const CoefficientTables* tables)
+{
+    double cosW0, sinW0;
+
+    if (tables != nullptr && tables->lookupFrequency(cutOffFrequency, cosW0, sinW0))
+        return sinW0 / (1 + cosW0);
+
+    auto w0 = 2 * pi * ((double)cutOffFrequency / sample_rate);
+    return tan(0.5 * w0);
+}
+
+SVFCoefficients makeSVFLowShelf(float cutOffFrequency, float gain, float sample_rate, const CoefficientTables* tables)
+{
+    double A, sqrtA;
+
+    if (tables == nullptr || !tables->lookupGain(gain, A, sqrtA))
+    {
+        A = pow(10.0, (double)gain * 0.025);
+        sqrtA = sqrt(A);
+    }
+
+    SVFCoefficients c;
+    c.g = getCutOffGain(cutOffFrequency, sample_rate, tables) / sqrtA;
+    c.m1 = k * (A - 1);
+    c.m2 = A * A - 1;
+    return c;
+}
+
+SVFCoefficients makeSVFHighPass(float cutOffFrequency, float sample_rate, const CoefficientTables* tables)
+{
+    SVFCoefficients c;
+    c.g = getCutOffGain(cutOffFrequency, sample_rate, tables);
+    c.m1 = -k;
+    c.m2 = -1.0;
+    return c;
+}
+
+//==============================================================================
+MidSideSVFChain::MidSideSVFChain()
+{
+    // Everything starts as a pass-through; stage 1 of the mid lane stays that way
+    for (int stage = 0; stage < numStages; ++stage)
+        for (int lane = 0; lane < numLanes; ++lane)
+            setStage(stage, lane, SVFCoefficients());
+
+    invalidateCoefficients();
+    reset();
+}
+
+void MidSideSVFChain::setSampleRate(float sample_rate)
+{
+    if (sample_rate != m_sample_rate)
+        invalidateCoefficients();
+
+    if (m_tables != nullptr && m_tables->m_sample_rate != sample_rate)
+        m_tables = nullptr;
+
+    m_sample_rate = sample_rate;
+}
+
+void MidSideSVFChain::setCoefficientTables(std::shared_ptr<const CoefficientTables> tables)
+{
+    // Tables built for another sample rate would give the wrong response
+    if (tables != nullptr && tables->m_sample_rate != m_sample_rate)
+        tables = nullptr;
+
+    m_tables = std::move(tables);
+}
+
+void MidSideSVFChain::invalidateCoefficients()
+{
+    // NaN never compares equal, so the next update recomputes every stage
+    m_midFreq = m_midGain = m_sideFreqLower = m_sideFreqUpper = m_sideGain = std::numeric_limits<float>::quiet_NaN();
+    m_jumpToNext = true;
+}
+
+void MidSideSVFChain::reset()
+{
+    for (int stage = 0; stage < numStages; ++stage)
+    {
+        for (int lane = 0; lane < numLanes; ++lane)
+        {
+            m_ic1[stage][lane] = 0.0;
+            m_ic2[stage][lane] = 0.0;
+        }
+    }
+
+    std::memcpy(m_g, m_targetG, sizeof(m_g));
+    std::memcpy(m_m1, m_targetM1, sizeof(m_m1));
+    std::memcpy(m_m2, m_targetM2, sizeof(m_m2));
+}
+
+void MidSideSVFChain::resetSide()
+{
+    for (int stage = 0; stage < numStages; ++stage)
+    {
+        m_ic1[stage][sideLane] = 0.0;
+        m_ic2[stage][sideLane] = 0.0;
+    }
+}
+
+void MidSideSVFChain::setStage(int stage, int lane, const SVFCoefficients& coefficients)
+{
+    m_targetG[stage][lane] = coefficients.g;
+    m_targetM1[stage][lane] = coefficients.m1;
+    m_targetM2[stage][lane] = coefficients.m2;
+
+    // The SVF has the poles of the biquad 1 + a1 z^-1 + a2 z^-2 below. A
+    // pass-through never hears its integrators, which hold still at g == 0
+    const double g = coefficients.g;
+    const double a0 = 1 + g * (g + k);
+
+    if (coefficients.m1 == 0 && coefficients.m2 == 0)
+        m_decayLength[stage][lane] = 0.0;
+    else
+        m_decayLength[stage][lane] = getDecayLength(2 * (g * g - 1) / a0, (1 - g * k + g * g) / a0);
+}
+
+bool MidSideSVFChain::isGliding() const
+{
+    return std::memcmp(m_g, m_targetG, sizeof(m_g)) != 0
+        || std::memcmp(m_m1, m_targetM1, sizeof(m_m1)) != 0
+        || std::memcmp(m_m2, m_targetM2, sizeof(m_m2)) != 0;
+}
+
+int MidSideSVFChain::getTailLengthInSamples() const
+{
+    // The stages of a lane ring one after the other, so their tails add up
+    double longest = 0.0;
+
+    for (int lane = 0; lane < numLanes; ++lane)
+    {
+        double length = 0.0;
+
+        for (int stage = 0; stage < numStages; ++stage)
+            length += m_decayLength[stage][lane];
+
+        longest = std::max(longest, length);
+    }
+
+    return (int)std::min(std::ceil(longest), (double)std::numeric_limits<int>::max());
+}
+
+void MidSideSVFChain::updateCoefficients(float midFreq, float midGain, float sideFreqLower, float sideFreqUpper, float sideGain)
+{
+    if (midFreq != m_midFreq || midGain != m_midGain)
+    {
+        setStage(0, midLane, makeSVFLowShelf(midFreq, midGain, m_sample_rate, m_tables.get()));
+        m_midFreq = midFreq;
+        m_midGain = midGain;
+    }
+
+    if (sideFreqLower != m_sideFreqLower)
+    {
+        setStage(0, sideLane, makeSVFHighPass(sideFreqLower, m_sample_rate, m_tables.get()));
+        m_sideFreqLower = sideFreqLower;
+    }
+
+    if (sideFreqUpper != m_sideFreqUpper || sideGain != m_sideGain)
+    {
+        setStage(1, sideLane, makeSVFLowShelf(sideFreqUpper, sideGain, m_sample_rate, m_tables.get()));
+        m_sideFreqUpper = sideFreqUpper;
+        m_sideGain = sideGain;
+    }
+
+    // Nothing to glide from at a new sample rate
+    if (m_jumpToNext)
+    {
+        std::memcpy(m_g, m_targetG, sizeof(m_g));
+        std::memcpy(m_m1, m_targetM1, sizeof(m_m1));
+        std::memcpy(m_m2, m_targetM2, sizeof(m_m2));
+        m_jumpToNext = false;
+    }
+}
+
+//==============================================================================
+template <typename SampleType>
+void MidSideSVFChain::process(SampleType* left, SampleType* right, int numberSamples, SampleType startGain, SampleType endGain)
+{
+    if (isGliding())
+        processStages<SampleType, true>(left, right, numberSamples, startGain, endGain);
+    else
+        processStages<SampleType, false>(left, right, numberSamples, startGain, endGain);
+
+    std::memcpy(m_g, m_targetG, sizeof(m_g));
+    std::memcpy(m_m1, m_targetM1, sizeof(m_m1));
+    std::memcpy(m_m2, m_targetM2, sizeof(m_m2));
+}
+
+template <typename SampleType, bool gliding>
+void MidSideSVFChain::processStages(SampleType* left, SampleType* right, int numberSamples, SampleType startGain, SampleType endGain)
+{
+    using namespace SIMD;
+
+    const double2 half = set(0.5, 0.5);
+    const double2 one = set(1.0, 1.0);
+    const double2 damping = set(k, k);
+
+    // A constant gain has a zero step, which keeps it exact
+    const double gainStart = (double)startGain;
+    const double gainStep = numberSamples > 0 ? ((double)endGain - gainStart) / numberSamples : 0.0;
+
+    // Coefficients and states live in registers for the whole block; while
+    // gliding, g, m1 and m2 step towards the targets on every sample
+    double2 g[numStages], m1[numStages], m2[numStages];
+    double2 gStep[numStages], m1Step[numStages], m2Step[numStages];
+    double2 a1[numStages], a2[numStages], a3[numStages];
+    double2 ic1[numStages], ic2[numStages];
+
+    const double inverseLength = 1.0 / std::max(numberSamples, 1);
+    const double2 perSample = set(inverseLength, inverseLength);
+
+    for (int stage = 0; stage < numStages; ++stage)
+    {
+        g[stage] = load(m_g[stage]);
+        m1[stage] = load(m_m1[stage]);
+        m2[stage] = load(m_m2[stage]);
+        gStep[stage] = mul(sub(load(m_targetG[stage]), g[stage]), perSample);
+        m1Step[stage] = mul(sub(load(m_targetM1[stage]), m1[stage]), perSample);
+        m2Step[stage] = mul(sub(load(m_targetM2[stage]), m2[stage]), perSample);
+
+        a1[stage] = div(one, add(one, mul(g[stage], add(g[stage], damping))));
+        a2[stage] = mul(g[stage], a1[stage]);
+        a3[stage] = mul(g[stage], a2[stage]);
+
+        ic1[stage] = load(m_ic1[stage]);
+        ic2[stage] = load(m_ic2[stage]);
+    }
+
+    for (int n = 0; n < numberSamples; ++n)
+    {
+        double l = (double)left[n];
+        double r = (double)right[n];
+
+        // [ (l + r) / 2 | (l - r) / 2 ]
+        double2 x = mul(add(set(l, l), set(r, -r)), half);
+
+        for (int stage = 0; stage < numStages; ++stage)
+        {
+            // One division per sample and stage instead of a tan
+            if (gliding)
+            {
+                g[stage] = add(g[stage], gStep[stage]);
+                m1[stage] = add(m1[stage], m1Step[stage]);
+                m2[stage] = add(m2[stage], m2Step[stage]);
+
+                a1[stage] = div(one, add(one, mul(g[stage], add(g[stage], damping))));
+                a2[stage] = mul(g[stage], a1[stage]);
+                a3[stage] = mul(g[stage], a2[stage]);
+            }
+
+            // Band pass v1 and low pass v2 from the two trapezoidal integrators
+            double2 v3 = sub(x, ic2[stage]);
+            double2 v1 = add(mul(a1[stage], ic1[stage]), mul(a2[stage], v3));
+            double2 v2 = add(ic2[stage], add(mul(a2[stage], ic1[stage]), mul(a3[stage], v3)));
+            ic1[stage] = sub(add(v1, v1), ic1[stage]);
+            ic2[stage] = sub(add(v2, v2), ic2[stage]);
+
+            x = add(x, add(mul(m1[stage], v1), mul(m2[stage], v2)));
+        }
+
+        // [ m + s | m - s ] * gain
+        double mids = getLane0(x);
+        double sides = getLane1(x);
+        double gain = gainStart + gainStep * (n + 1);
+        double2 lr = mul(add(set(mids, mids), set(sides, -sides)), set(gain, gain));
+
+        left[n] = (SampleType)getLane0(lr);
+        right[n] = (SampleType)getLane1(lr);
+    }
+
+    for (int stage = 0; stage < numStages; ++stage)
+    {
+        store(m_ic1[stage], ic1[stage]);
+        store(m_ic2[stage], ic2[stage]);
+    }
+}
+
+template <typename SampleType>
+void MidSideSVFChain::processMid(SampleType* samples, int numberSamples, SampleType startGain, SampleType endGain)
+{
+    const double gainStart = (double)startGain;
+    const double gainStep = numberSamples > 0 ? ((double)endGain - gainStart) / numberSamples : 0.0;
+    const double inverseLength = 1.0 / std::max(numberSamples, 1);
+
+    // Stage 1 of the mid lane is the pass-through, so the shelf is all there is
+    double g = m_g[0][midLane], m1 = m_m1[0][midLane], m2 = m_m2[0][midLane];
+    const double gStep = (m_targetG[0][midLane] - g) * inverseLength;
+    const double m1Step = (m_targetM1[0][midLane] - m1) * inverseLength;
+    const double m2Step = (m_targetM2[0][midLane] - m2) * inverseLength;
+    const bool gliding = gStep != 0.0 || m1Step != 0.0 || m2Step != 0.0;
+
+    double a1 = 1.0 / (1.0 + g * (g + k));
+    double a2 = g * a1;
+    double a3 = g * a2;
+
+    double ic1 = m_ic1[0][midLane], ic2 = m_ic2[0][midLane];
+
+    // The same operations as the mid lane of processStages()
+    for (int n = 0; n < numberSamples; ++n)
+    {
+        if (gliding)
+        {
+            g += gStep;
+            m1 += m1Step;
+            m2 += m2Step;
+
+            a1 = 1.0 / (1.0 + g * (g + k));
+            a2 = g * a1;
+            a3 = g * a2;
+        }
+
+        // (l + r) / 2 of two equal sides is either side
+        double x = (double)samples[n];
+
+        double v3 = x - ic2;
+        double v1 = a1 * ic1 + a2 * v3;
+        double v2 = ic2 + (a2 * ic1 + a3 * v3);
+        ic1 = (v1 + v1) - ic1;
+        ic2 = (v2 + v2) - ic2;
+
+        x = x + (m1 * v1 + m2 * v2);
+
+        // With the side at zero, both m + s and m - s are the mid
+        samples[n] = (SampleType)(x * (gainStart + gainStep * (n + 1)));
+    }
+
+    m_ic1[0][midLane] = ic1;
+    m_ic2[0][midLane] = ic2;
+
+    std::memcpy(m_g, m_targetG, sizeof(m_g));
+    std::memcpy(m_m1, m_targetM1, sizeof(m_m1));
+    std::memcpy(m_m2, m_targetM2, sizeof(m_m2));
+}
+
+template void MidSideSVFChain::process<float>(float*, float*, int, float, float);
+template void MidSideSVFChain::process<double>(double*, double*, int, double, double);
+template void MidSideSVFChain::processMid<float>(float*, int, float, float);
+template void MidSideSVFChain::processMid<double>(double*, int, double, double);
@@ -0,0 +1,129 @@
+/*
+  ==============================================================================
+
+    This file contains the topology-preserving state variable filters, the
+    mid/side filters for cutoffs that move on every sample
+
+  ==============================================================================
+*/
+#ifndef __SpatialSaturatorSVF__SpatialSaturatorSVF__
+#define __SpatialSaturatorSVF__SpatialSaturatorSVF__
+
+#pragma once
+
+#include "SpatialSaturatorFilter.h"
+
+//==============================================================================
+/**
+    One trapezoidal (TPT) state variable filter, as the cutoff gain g and the
+    mixing gains of the band pass and low pass outputs:
+
+        y = x + m1 * band pass + m2 * low pass
+
+    The damping is the same 1/Q as the biquads. The default is a pass-through.
+*/
+struct SVFCoefficients
+{
+    double g = 0.0, m1 = 0.0, m2 = 0.0;
+};
+
+// Same responses as the RBJ cookbook biquads of SpatialSaturatorFilter.h,
+// with one tan per update (none when the tables hold the frequency)
+SVFCoefficients makeSVFLowShelf(float cutOffFrequency, float gain, float sample_rate, const CoefficientTables* tables);
+SVFCoefficients makeSVFHighPass(float cutOffFrequency, float sample_rate, const CoefficientTables* tables);
+
+//==============================================================================
+/**
+    MidSideFilterChain with TPT state variable filters in place of the biquads:
+    the same mid shelf, side high pass and side shelf in the same lanes,
+
+        stage 0: [ mid shelf    | side high pass ]
+        stage 1: [ pass-through | side shelf     ]
+
+    A direct form biquad needs trig for every new cutoff and misbehaves when
+    its coefficients move quickly. The SVF only needs g = tan(w0 / 2), and its
+    states stay valid whatever the coefficients do, so updateCoefficients()
+    can be called as often as the parameters move: process() then moves g and
+    the mixing gains linearly from the previous update to the new one, sample
+    by sample, and recomputes the rest of the filter per sample.
+
+    Runs in double for both precisions.
+*/
+class MidSideSVFChain
+{
+public:
+    enum
+    {
+        midLane = 0,
+        sideLane = 1,
+        numLanes = 2,
+        numStages = 2
+    };
+
+    MidSideSVFChain();
+
+    void setSampleRate(float sample_rate);
+
+    // Clears the states; the coefficients jump to the last update
+    void reset();
+
+    // Clears the side lane only, before processMid() takes over
+    void resetSide();
+
+    // Uses the tables for coefficient updates, or computes directly if null
+    void setCoefficientTables(std::shared_ptr<const CoefficientTables> tables);
+
+    // The next process() glides from the previous values to these. The first
+    // update after setSampleRate() is applied at once
+    void updateCoefficients(float midFreq, float midGain, float sideFreqLower, float sideFreqUpper, float sideGain);
+
+    // Make up gain ramps as in MidSideFilterChain. Instantiated for float and double
+    template <typename SampleType>
+    void process(SampleType* left, SampleType* right, int numberSamples, SampleType startGain, SampleType endGain);
+
+    template <typename SampleType>
+    void process(SampleType* left, SampleType* right, int numberSamples, SampleType makeUpGain)
+    {
+        process(left, right, numberSamples, makeUpGain, makeUpGain);
+    }
+
+    // As MidSideFilterChain::processMid(): input with no side, one channel
+    // for both, through the mid shelf only
+    template <typename SampleType>
+    void processMid(SampleType* samples, int numberSamples, SampleType startGain, SampleType endGain);
+
+    // Samples the longer of the mid and side cascades rings on after the
+    // input stops, with the latest coefficients
+    int getTailLengthInSamples() const;
+
+private:
+    void setStage(int stage, int lane, const SVFCoefficients& coefficients);
+    void invalidateCoefficients();
+    bool isGliding() const;
+
+    template <typename SampleType, bool gliding>
+    void processStages(SampleType* left, SampleType* right, int numberSamples, SampleType startGain, SampleType endGain);
+
+    float m_sample_rate = 44100.0f;
+    std::shared_ptr<const CoefficientTables> m_tables;
+
+    // Parameters the latest coefficients were computed for
+    float m_midFreq, m_midGain, m_sideFreqLower, m_sideFreqUpper, m_sideGain;
+
+    // Set until the first update after the coefficients were invalidated
+    bool m_jumpToNext = true;
+
+    // Coefficients process() starts from and the latest update, [stage][lane]
+    alignas(16) double m_g[numStages][numLanes], m_targetG[numStages][numLanes];
+    alignas(16) double m_m1[numStages][numLanes], m_targetM1[numStages][numLanes];
+    alignas(16) double m_m2[numStages][numLanes], m_targetM2[numStages][numLanes];
+
+    // getDecayLength() of each stage with the latest coefficients
+    double m_decayLength[numStages][numLanes];
+
+    // Integrator states, [stage][lane]
+    alignas(16) double m_ic1[numStages][numLanes];
+    alignas(16) double m_ic2[numStages][numLanes];
+};
+
+#endif
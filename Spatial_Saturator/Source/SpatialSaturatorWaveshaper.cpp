@@ -0,0 +1,924 @@
+/*
+  ==============================================================================
+
+    This file contains the waveshaper saturator
+
+  ==============================================================================
+*/
+
+#include "SpatialSaturatorWaveshaper.h"
+#include "SpatialSaturatorLaneMath.h"
+#include <algorithm>
+#include <cmath>
+
+// Below this input step the ADAA divided differences lose precision, so the
+// curve is evaluated at the midpoint instead
+static const double antiderivativeTolerance = 1e-5;
+
+//==============================================================================
+void Waveshaper::prepare(double sampleRate, int numChannels, int maxBlockSize)
+{
+    m_oversampler.prepare(numChannels, maxBlockSize);
+    m_sampleRate = sampleRate;
+    m_maxBlockSize = maxBlockSize;
+    m_floatChunk.assign((size_t)numChannels, nullptr);
+    m_doubleChunk.assign((size_t)numChannels, nullptr);
+
+    m_tanhBuffer.assign((size_t)maxBlockSize << Oversampler::maxFactorLog2, 0.0f);
+    m_sinBuffer.assign((size_t)maxBlockSize << Oversampler::maxFactorLog2, 0.0f);
+
+    m_antiderivativeStates.assign((size_t)numChannels, AntiderivativeState());
+    m_bandAntiderivativeStates.assign((size_t)(numChannels * maxBands), AntiderivativeState());
+    m_antiderivativesValid = false;
+
+    m_crossover.prepare(numChannels);
+    m_floatBands.assign((size_t)(numChannels * maxBands * bandChunkSize), 0.0f);
+    m_doubleBands.assign((size_t)(numChannels * maxBands * bandChunkSize), 0.0);
+    updateCrossover();
+}
+
+void Waveshaper::reset()
+{
+    m_oversampler.reset();
+    m_crossover.reset();
+
+    std::fill(m_antiderivativeStates.begin(), m_antiderivativeStates.end(), AntiderivativeState());
+    std::fill(m_bandAntiderivativeStates.begin(), m_bandAntiderivativeStates.end(), AntiderivativeState());
+    m_antiderivativesValid = false;
+}
+
+void Waveshaper::copyChannelState(int from, int to)
+{
+    m_oversampler.copyChannelState(from, to);
+    m_crossover.copyChannelState(from, to);
+
+    m_antiderivativeStates[(size_t)to] = m_antiderivativeStates[(size_t)from];
+
+    for (int band = 0; band < maxBands; ++band)
+        m_bandAntiderivativeStates[(size_t)(to * maxBands + band)] = m_bandAntiderivativeStates[(size_t)(from * maxBands + band)];
+}
+
+void Waveshaper::setOversampling(int factorLog2, Oversampler::Phase phase)
+{
+    m_oversampler.setFactorLog2(factorLog2);
+    m_oversampler.setPhase(phase);
+    updateCrossover();
+}
+
+void Waveshaper::setAntiAliasing(AntiAliasing antiAliasing)
+{
+    if (antiAliasing != m_antiAliasing)
+    {
+        m_antiAliasing = antiAliasing;
+        reset();
+        updateCrossover();
+    }
+}
+
+void Waveshaper::setBands(int numBands, const float* crossoverFrequencies, const float* drives, const float* mixes)
+{
+    m_numBands = std::clamp(numBands, 1, (int)maxBands);
+
+    for (int i = 0; i < maxBands - 1; ++i)
+        m_crossoverFrequencies[i] = crossoverFrequencies[i];
+
+    for (int band = 0; band < maxBands; ++band)
+    {
+        m_bandDrives[band] = std::pow(10.0, (double)drives[band] * 0.05);
+        m_bandMixes[band] = (double)mixes[band] * 0.01;
+    }
+
+    updateCrossover();
+}
+
+void Waveshaper::updateCrossover()
+{
+    // The bands are split at the rate the curve runs at
+    const double rate = m_antiAliasing == oversampled ? m_sampleRate * m_oversampler.getFactor() : m_sampleRate;
+    m_crossover.setParameters((float)rate, m_numBands, m_crossoverFrequencies);
+}
+
+int Waveshaper::getLatencyInSamples() const
+{
+    // Second order ADAA delays by one sample, first order by half a sample
+    // which cannot be reported (nor compensated on the dry signal)
+    switch (m_antiAliasing)
+    {
+    case firstOrderADAA:  return 0;
+    case secondOrderADAA: return 1;
+    default:              return m_oversampler.getLatencyInSamples();
+    }
+}
+
+int Waveshaper::getTailLengthInSamples() const
+{
+    const int crossoverTail = m_numBands > 1 ? m_crossover.getTailLengthInSamples() : 0;
+
+    // The crossover runs at the oversampled rate there
+    if (m_antiAliasing == oversampled)
+        return m_oversampler.getTailLengthInSamples() + crossoverTail / m_oversampler.getFactor() + 1;
+
+    return crossoverTail + 2;
+}
+
+void Waveshaper::setParameters(float tanhAmplitude, float tanhSlope, float sinAmplitude, float sinFreq, float saturatorMix)
+{
+    const double tanhAmplitudeBefore = m_tanhAmplitude, tanhSlopeBefore = m_tanhSlope;
+    const double sinAmplitudeBefore = m_sinAmplitude, sinFreqBefore = m_sinFreq;
+
+    m_tanhAmplitude = (double)tanhAmplitude * 0.01;
+    m_tanhSlope = (double)tanhSlope;
+    m_sinAmplitude = (double)sinAmplitude * 0.01;
+    m_sinFreq = (double)sinFreq;
+    m_mix = (double)saturatorMix * 0.01;
+
+    if (m_tanhAmplitude != tanhAmplitudeBefore || m_tanhSlope != tanhSlopeBefore
+        || m_sinAmplitude != sinAmplitudeBefore || m_sinFreq != sinFreqBefore)
+        m_antiderivativesValid = false;
+}
+
+template <>
+std::vector<float*>& Waveshaper::getChunk<float>()
+{
+    return m_floatChunk;
+}
+
+template <>
+std::vector<double*>& Waveshaper::getChunk<double>()
+{
+    return m_doubleChunk;
+}
+
+template <>
+std::vector<float>& Waveshaper::getBands<float>()
+{
+    return m_floatBands;
+}
+
+template <>
+std::vector<double>& Waveshaper::getBands<double>()
+{
+    return m_doubleBands;
+}
+
+template <typename SampleType>
+void Waveshaper::process(SampleType* const* channels, int numChannels, int numSamples)
+{
+    auto& chunk = getChunk<SampleType>();
+    numChannels = std::min(numChannels, (int)chunk.size());
+
+    if (m_maxBlockSize <= 0)
+        return;
+
+    // ADAA runs at the base rate, straight on the buffers
+    if (m_antiAliasing != oversampled)
+    {
+        updateAntiderivativeStates();
+
+        if (m_numBands > 1)
+        {
+            processBands(channels, numChannels, numSamples);
+            return;
+        }
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            if (m_antiAliasing == firstOrderADAA)
+                processAntiderivative1(channels[ch], numSamples, m_antiderivativeStates[(size_t)ch], m_mix);
+            else
+                processAntiderivative2(channels[ch], numSamples, m_antiderivativeStates[(size_t)ch], m_mix);
+        }
+
+        return;
+    }
+
+    // Hosts may send more than the block size given to prepare()
+    for (int start = 0; start < numSamples; start += m_maxBlockSize)
+    {
+        const int chunkSize = std::min(numSamples - start, m_maxBlockSize);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            chunk[(size_t)ch] = channels[ch] + start;
+
+        // Up, shape at the oversampled rate, then back down
+        SampleType* const* upsampled = m_oversampler.upsample<SampleType>(chunk.data(), numChannels, chunkSize);
+
+        if (m_numBands > 1)
+        {
+            processBands(upsampled, numChannels, chunkSize * m_oversampler.getFactor());
+        }
+        else
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                if (m_precision == FastMath::full)
+                    processCurve(upsampled[ch], chunkSize * m_oversampler.getFactor(), m_mix);
+                else
+                    processCurveApproximated(upsampled[ch], chunkSize * m_oversampler.getFactor(), m_mix);
+            }
+        }
+
+        m_oversampler.downsample(chunk.data(), numChannels, chunkSize);
+    }
+}
+
+bool Waveshaper::canShareLanesWith(const Waveshaper& other) const
+{
+    if (m_numBands > 1 || other.m_numBands > 1 || m_maxBlockSize != other.m_maxBlockSize || m_antiAliasing != other.m_antiAliasing)
+        return false;
+
+    if (m_antiAliasing != oversampled)
+        return true;
+
+    return m_precision == FastMath::full && other.m_precision == FastMath::full
+        && m_oversampler.getFactor() == other.m_oversampler.getFactor();
+}
+
+template <typename SampleType>
+void Waveshaper::processLanes(Waveshaper* const* waveshapers, int numWaveshapers, SampleType* const* const* channels, const int* numChannels, int numSamples)
+{
+    Waveshaper& first = *waveshapers[0];
+    numWaveshapers = std::min(numWaveshapers, (int)maxLanes);
+
+    if (first.m_maxBlockSize <= 0)
+        return;
+
+    int channelCounts[maxLanes];
+    for (int i = 0; i < numWaveshapers; ++i)
+        channelCounts[i] = std::min(numChannels[i], (int)waveshapers[i]->getChunk<SampleType>().size());
+
+    // Every channel of every waveshaper is one lane, maxLanes to a kernel call
+    const Waveshaper* owners[maxLanes];
+    SampleType* lanes[maxLanes];
+    AntiderivativeState* states[maxLanes];
+    int numLanes = 0;
+
+    auto getMix = [&owners, &numLanes]()
+    {
+        alignas(32) double mixes[maxLanes] = {};
+        for (int lane = 0; lane < numLanes; ++lane)
+            mixes[lane] = owners[lane]->m_mix;
+
+        return SIMD::load4(mixes);
+    };
+
+    // ADAA runs at the base rate, straight on the buffers. The history stays
+    // with each waveshaper, so it can leave the lanes at any block
+    if (first.m_antiAliasing != oversampled)
+    {
+        auto runLanes = [&]()
+        {
+            const CurveLanes curve(owners, numLanes);
+
+            AntiderivativeLanes state;
+            state.gather(states, numLanes);
+
+            if (first.m_antiAliasing == firstOrderADAA)
+                processAntiderivative1Lanes(lanes, numLanes, numSamples, curve, state, getMix());
+            else
+                processAntiderivative2Lanes(lanes, numLanes, numSamples, curve, state, getMix());
+
+            state.scatter(states, numLanes);
+            numLanes = 0;
+        };
+
+        for (int i = 0; i < numWaveshapers; ++i)
+        {
+            waveshapers[i]->updateAntiderivativeStates();
+
+            for (int ch = 0; ch < channelCounts[i]; ++ch)
+            {
+                owners[numLanes] = waveshapers[i];
+                lanes[numLanes] = channels[i][ch];
+                states[numLanes] = &waveshapers[i]->m_antiderivativeStates[(size_t)ch];
+
+                if (++numLanes == maxLanes)
+                    runLanes();
+            }
+        }
+
+        if (numLanes > 0)
+            runLanes();
+
+        return;
+    }
+
+    const int factor = first.m_oversampler.getFactor();
+
+    for (int start = 0; start < numSamples; start += first.m_maxBlockSize)
+    {
+        const int chunkSize = std::min(numSamples - start, first.m_maxBlockSize);
+
+        auto runLanes = [&]()
+        {
+            processCurveLanes(lanes, numLanes, chunkSize * factor, CurveLanes(owners, numLanes), getMix());
+            numLanes = 0;
+        };
+
+        // Every waveshaper up through its own filters, all shaped at once, then each back down
+        for (int i = 0; i < numWaveshapers; ++i)
+        {
+            auto& chunk = waveshapers[i]->getChunk<SampleType>();
+
+            for (int ch = 0; ch < channelCounts[i]; ++ch)
+                chunk[(size_t)ch] = channels[i][ch] + start;
+
+            SampleType* const* upsampled = waveshapers[i]->m_oversampler.template upsample<SampleType>(chunk.data(), channelCounts[i], chunkSize);
+
+            for (int ch = 0; ch < channelCounts[i]; ++ch)
+            {
+                owners[numLanes] = waveshapers[i];
+                lanes[numLanes] = upsampled[ch];
+
+                if (++numLanes == maxLanes)
+                    runLanes();
+            }
+        }
+
+        if (numLanes > 0)
+            runLanes();
+
+        for (int i = 0; i < numWaveshapers; ++i)
+            waveshapers[i]->m_oversampler.downsample(waveshapers[i]->getChunk<SampleType>().data(), channelCounts[i], chunkSize);
+    }
+}
+
+template <typename SampleType>
+void Waveshaper::processBands(SampleType* const* channels, int numChannels, int numSamples)
+{
+    auto& buffer = getBands<SampleType>();
+    const int numBands = m_crossover.getNumBands();
+
+    auto getBand = [&buffer](int channel, int band)
+    {
+        return buffer.data() + (channel * maxBands + band) * bandChunkSize;
+    };
+
+    // Every band has the same curve, with its own mix
+    const Waveshaper* self[] = { this };
+    const CurveLanes curve(self, 1);
+    const bool inLanes = m_antiAliasing != oversampled || m_precision == FastMath::full;
+
+    for (int start = 0; start < numSamples; start += bandChunkSize)
+    {
+        const int chunkSize = std::min(numSamples - start, (int)bandChunkSize);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            SampleType* bands[maxBands];
+            for (int band = 0; band < maxBands; ++band)
+                bands[band] = getBand(ch, band);
+
+            m_crossover.process(ch, channels[ch] + start, bands, chunkSize);
+
+            // Driven into the curve, then brought back to the band's level
+            for (int band = 0; band < numBands; ++band)
+            {
+                const double drive = m_bandDrives[band];
+
+                for (int n = 0; n < chunkSize; ++n)
+                    bands[band][n] = (SampleType)(bands[band][n] * drive);
+            }
+        }
+
+        if (inLanes)
+        {
+            // Four (channel, band) pairs per kernel call, so the lanes stay full
+            // whenever there are four bands in total
+            for (int first = 0; first < numChannels * numBands; first += maxLanes)
+            {
+                const int numLanes = std::min((int)maxLanes, numChannels * numBands - first);
+
+                SampleType* lanes[maxLanes];
+                AntiderivativeState* states[maxLanes];
+                alignas(32) double mixes[maxLanes] = {};
+
+                for (int lane = 0; lane < numLanes; ++lane)
+                {
+                    const int ch = (first + lane) / numBands;
+                    const int band = (first + lane) % numBands;
+
+                    lanes[lane] = getBand(ch, band);
+                    states[lane] = &m_bandAntiderivativeStates[(size_t)(ch * maxBands + band)];
+                    mixes[lane] = m_mix * m_bandMixes[band];
+                }
+
+                const SIMD::double4 mix = SIMD::load4(mixes);
+
+                if (m_antiAliasing == oversampled)
+                {
+                    processCurveLanes(lanes, numLanes, chunkSize, curve, mix);
+                    continue;
+                }
+
+                AntiderivativeLanes state;
+                state.gather(states, numLanes);
+
+                if (m_antiAliasing == firstOrderADAA)
+                    processAntiderivative1Lanes(lanes, numLanes, chunkSize, curve, state, mix);
+                else
+                    processAntiderivative2Lanes(lanes, numLanes, chunkSize, curve, state, mix);
+
+                state.scatter(states, numLanes);
+            }
+        }
+        else
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+                for (int band = 0; band < numBands; ++band)
+                    processCurveApproximated(getBand(ch, band), chunkSize, m_mix * m_bandMixes[band]);
+        }
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            SampleType* output = channels[ch] + start;
+            std::fill(output, output + chunkSize, (SampleType)0);
+
+            for (int band = 0; band < numBands; ++band)
+            {
+                const SampleType* bandSamples = getBand(ch, band);
+                const double level = 1.0 / m_bandDrives[band];
+
+                for (int n = 0; n < chunkSize; ++n)
+                    output[n] += (SampleType)(bandSamples[n] * level);
+            }
+        }
+    }
+}
+
+template <typename SampleType>
+void Waveshaper::processCurve(SampleType* samples, int numSamples, double mix)
+{
+    for (int n = 0; n < numSamples; ++n)
+    {
+        double input = (double)samples[n];
+
+        // waveshaper saturator
+        double shaped = m_tanhAmplitude * tanh(input * m_tanhSlope) + m_sinAmplitude * sin(input * m_sinFreq);
+
+        // Mixer Processing (dry/wet)
+        samples[n] = (SampleType)(input + mix * (shaped - input));
+    }
+}
+
+template <>
+void Waveshaper::processCurveApproximated(float* samples, int numSamples, double mix)
+{
+    float* tanhTerm = m_tanhBuffer.data();
+    float* sinTerm = m_sinBuffer.data();
+
+    FastMath::tanh(tanhTerm, samples, (float)m_tanhSlope, numSamples, m_precision);
+    FastMath::sin(sinTerm, samples, (float)m_sinFreq, numSamples, m_precision);
+
+    const float tanhAmplitude = (float)m_tanhAmplitude;
+    const float sinAmplitude = (float)m_sinAmplitude;
+    const float wet = (float)mix;
+
+    for (int n = 0; n < numSamples; ++n)
+    {
+        float shaped = tanhAmplitude * tanhTerm[n] + sinAmplitude * sinTerm[n];
+        samples[n] += wet * (shaped - samples[n]);
+    }
+}
+
+template <>
+void Waveshaper::processCurveApproximated(double* samples, int numSamples, double mix)
+{
+    float* tanhTerm = m_tanhBuffer.data();
+    float* sinTerm = m_sinBuffer.data();
+
+    // The kernels are only float accurate anyway, so they run on a float copy
+    for (int n = 0; n < numSamples; ++n)
+        tanhTerm[n] = (float)samples[n];
+
+    FastMath::sin(sinTerm, tanhTerm, (float)m_sinFreq, numSamples, m_precision);
+    FastMath::tanh(tanhTerm, tanhTerm, (float)m_tanhSlope, numSamples, m_precision);
+
+    for (int n = 0; n < numSamples; ++n)
+    {
+        double shaped = m_tanhAmplitude * (double)tanhTerm[n] + m_sinAmplitude * (double)sinTerm[n];
+        samples[n] += mix * (shaped - samples[n]);
+    }
+}
+
+//==============================================================================
+// log(cosh(u)) without overflow
+static double logCosh(double u)
+{
+    u = std::abs(u);
+    return u + std::log1p(std::exp(-2.0 * u)) - std::log(2.0);
+}
+
+// Integral of log(cosh(t)) from 0 to u, for u >= 0:
+//   u^2 / 2 - u log(2) + Li2(-exp(-2u)) / 2 + pi^2 / 24
+// Li2(z) uses the Bernoulli series in w = -log(1 - z), with |w| <= log(2)
+// here, so the terms up to w^17 are exact to double precision.
+static double integralLogCosh(double u)
+{
+    const double sign = u < 0.0 ? -1.0 : 1.0;
+    u = std::abs(u);
+
+    const double w = -std::log1p(std::exp(-2.0 * u));
+    const double w2 = w * w;
+
+    double series = -1.99392958607210744e-14;
+    series = series * w2 + 8.92169102045645230e-13;
+    series = series * w2 - 4.06476164514422560e-11;
+    series = series * w2 + 1.89788699889710005e-09;
+    series = series * w2 - 9.18577307466196408e-08;
+    series = series * w2 + 4.72411186696900978e-06;
+    series = series * w2 - 2.77777777777777778e-04;
+    series = series * w2 + 2.77777777777777778e-02;
+
+    const double dilogarithm = w - 0.25 * w2 + w * w2 * series;
+    const double pi = 3.14159265358979323846;
+
+    return sign * (0.5 * u * u - u * std::log(2.0) + 0.5 * dilogarithm + pi * pi / 24.0);
+}
+
+double Waveshaper::curve(double x) const
+{
+    return m_tanhAmplitude * tanh(x * m_tanhSlope) + m_sinAmplitude * sin(x * m_sinFreq);
+}
+
+// a / g * log(cosh(g x)) - b / f * cos(f x)
+double Waveshaper::antiderivative1(double x) const
+{
+    return m_tanhAmplitude / m_tanhSlope * logCosh(x * m_tanhSlope)
+         - m_sinAmplitude / m_sinFreq * cos(x * m_sinFreq);
+}
+
+// a / g^2 * integral of log(cosh) at g x - b / f^2 * sin(f x)
+double Waveshaper::antiderivative2(double x) const
+{
+    return m_tanhAmplitude / (m_tanhSlope * m_tanhSlope) * integralLogCosh(x * m_tanhSlope)
+         - m_sinAmplitude / (m_sinFreq * m_sinFreq) * sin(x * m_sinFreq);
+}
+
+// (F2(x0) - F2(x1)) / (x0 - x1), or F1 at the midpoint when x0 ~= x1
+double Waveshaper::dividedDifference(double x0, double x1, double F2x0, double F2x1) const
+{
+    const double delta = x0 - x1;
+
+    if (std::abs(delta) < antiderivativeTolerance)
+        return antiderivative1(0.5 * (x0 + x1));
+
+    return (F2x0 - F2x1) / delta;
+}
+
+void Waveshaper::updateAntiderivativeStates()
+{
+    if (m_antiderivativesValid)
+        return;
+
+    // The curve changed: recompute the cached antiderivatives of the previous
+    // inputs, or the next differences would mix two curves and click
+    for (auto* states : { &m_antiderivativeStates, &m_bandAntiderivativeStates })
+    {
+        for (auto& state : *states)
+        {
+            state.F1x1 = antiderivative1(state.x1);
+            state.F2x1 = antiderivative2(state.x1);
+            state.D1 = dividedDifference(state.x1, state.x2, state.F2x1, antiderivative2(state.x2));
+        }
+    }
+
+    m_antiderivativesValid = true;
+}
+
+template <typename SampleType>
+void Waveshaper::processAntiderivative1(SampleType* samples, int numSamples, AntiderivativeState& state, double mix)
+{
+    for (int n = 0; n < numSamples; ++n)
+    {
+        double input = (double)samples[n];
+        double F1x = antiderivative1(input);
+        double delta = input - state.x1;
+
+        // y = (F1(x[n]) - F1(x[n-1])) / (x[n] - x[n-1])
+        double shaped = std::abs(delta) < antiderivativeTolerance ? curve(0.5 * (input + state.x1))
+                                                                  : (F1x - state.F1x1) / delta;
+
+        state.x1 = input;
+        state.F1x1 = F1x;
+
+        // Mixer Processing (dry/wet)
+        samples[n] = (SampleType)(input + mix * (shaped - input));
+    }
+}
+
+template <typename SampleType>
+void Waveshaper::processAntiderivative2(SampleType* samples, int numSamples, AntiderivativeState& state, double mix)
+{
+    for (int n = 0; n < numSamples; ++n)
+    {
+        double input = (double)samples[n];
+        double F2x = antiderivative2(input);
+        double D0 = dividedDifference(input, state.x1, F2x, state.F2x1);
+        double delta = input - state.x2;
+        double shaped;
+
+        if (std::abs(delta) >= antiderivativeTolerance)
+        {
+            // y = 2 / (x[n] - x[n-2]) * (D(x[n], x[n-1]) - D(x[n-1], x[n-2]))
+            shaped = 2.0 * (D0 - state.D1) / delta;
+        }
+        else
+        {
+            // x[n] ~= x[n-2]: expand around their mean instead (Parker et al. 2016)
+            double mean = 0.5 * (input + state.x2);
+            double offset = mean - state.x1;
+
+            if (std::abs(offset) < antiderivativeTolerance)
+                shaped = curve(0.5 * (mean + state.x1));
+            else
+                shaped = 2.0 / offset * (antiderivative1(mean) + (state.F2x1 - antiderivative2(mean)) / offset);
+        }
+
+        // The ADAA output is centred on x[n-1], so the dry signal is too
+        double dry = state.x1;
+
+        state.x2 = state.x1;
+        state.x1 = input;
+        state.F2x1 = F2x;
+        state.D1 = D0;
+
+        // Mixer Processing (dry/wet)
+        samples[n] = (SampleType)(dry + mix * (shaped - dry));
+    }
+}
+
+//==============================================================================
+// The same curve and antiderivatives on four lanes, in the same order of
+// operations as the scalar versions above
+static SPATIAL_SATURATOR_INLINE SIMD::double4 logCosh(SIMD::double4 u)
+{
+    using namespace SIMD;
+
+    u = abs(u);
+    const double4 w = add(LaneMath::expm1(mul(u, set4(-2.0))), set4(1.0));
+    return sub(add(u, LaneMath::log1p(w)), set4(0.69314718055994530942));
+}
+
+static SPATIAL_SATURATOR_INLINE SIMD::double4 integralLogCosh(SIMD::double4 u)
+{
+    using namespace SIMD;
+
+    const double4 sign = copySign(set4(1.0), u);
+    u = abs(u);
+
+    const double4 w = mul(LaneMath::log1p(add(LaneMath::expm1(mul(u, set4(-2.0))), set4(1.0))), set4(-1.0));
+    const double4 w2 = mul(w, w);
+
+    double4 series = set4(-1.99392958607210744e-14);
+    series = add(mul(series, w2), set4(8.92169102045645230e-13));
+    series = add(mul(series, w2), set4(-4.06476164514422560e-11));
+    series = add(mul(series, w2), set4(1.89788699889710005e-09));
+    series = add(mul(series, w2), set4(-9.18577307466196408e-08));
+    series = add(mul(series, w2), set4(4.72411186696900978e-06));
+    series = add(mul(series, w2), set4(-2.77777777777777778e-04));
+    series = add(mul(series, w2), set4(2.77777777777777778e-02));
+
+    const double4 dilogarithm = add(sub(w, mul(set4(0.25), w2)), mul(mul(w, w2), series));
+    const double pi = 3.14159265358979323846;
+
+    double4 result = sub(mul(mul(set4(0.5), u), u), mul(u, set4(0.69314718055994530942)));
+    result = add(add(result, mul(set4(0.5), dilogarithm)), set4(pi * pi / 24.0));
+    return mul(sign, result);
+}
+
+Waveshaper::CurveLanes::CurveLanes(const Waveshaper* const* waveshapers, int numWaveshapers)
+{
+    using namespace SIMD;
+
+    alignas(32) double a[maxLanes], g[maxLanes], b[maxLanes], f[maxLanes];
+    alignas(32) double a1[maxLanes], b1[maxLanes], a2[maxLanes], b2[maxLanes];
+
+    for (int lane = 0; lane < maxLanes; ++lane)
+    {
+        const Waveshaper& w = *waveshapers[lane < numWaveshapers ? lane : 0];
+
+        a[lane] = w.m_tanhAmplitude;
+        g[lane] = w.m_tanhSlope;
+        b[lane] = w.m_sinAmplitude;
+        f[lane] = w.m_sinFreq;
+        a1[lane] = w.m_tanhAmplitude / w.m_tanhSlope;
+        b1[lane] = w.m_sinAmplitude / w.m_sinFreq;
+        a2[lane] = w.m_tanhAmplitude / (w.m_tanhSlope * w.m_tanhSlope);
+        b2[lane] = w.m_sinAmplitude / (w.m_sinFreq * w.m_sinFreq);
+    }
+
+    tanhAmplitude = load4(a);
+    tanhSlope = load4(g);
+    sinAmplitude = load4(b);
+    sinFreq = load4(f);
+    tanhScale1 = load4(a1);
+    sinScale1 = load4(b1);
+    tanhScale2 = load4(a2);
+    sinScale2 = load4(b2);
+}
+
+SPATIAL_SATURATOR_INLINE SIMD::double4 Waveshaper::CurveLanes::curve(SIMD::double4 x) const
+{
+    using namespace SIMD;
+    return add(mul(tanhAmplitude, LaneMath::tanh(mul(x, tanhSlope))), mul(sinAmplitude, LaneMath::sin(mul(x, sinFreq))));
+}
+
+SPATIAL_SATURATOR_INLINE SIMD::double4 Waveshaper::CurveLanes::antiderivative1(SIMD::double4 x) const
+{
+    using namespace SIMD;
+    return sub(mul(tanhScale1, logCosh(mul(x, tanhSlope))), mul(sinScale1, LaneMath::cos(mul(x, sinFreq))));
+}
+
+SPATIAL_SATURATOR_INLINE SIMD::double4 Waveshaper::CurveLanes::antiderivative2(SIMD::double4 x) const
+{
+    using namespace SIMD;
+    return sub(mul(tanhScale2, integralLogCosh(mul(x, tanhSlope))), mul(sinScale2, LaneMath::sin(mul(x, sinFreq))));
+}
+
+SPATIAL_SATURATOR_INLINE SIMD::double4 Waveshaper::CurveLanes::dividedDifference(SIMD::double4 x0, SIMD::double4 x1, SIMD::double4 F2x0, SIMD::double4 F2x1, SIMD::double4 active) const
+{
+    using namespace SIMD;
+
+    const double4 delta = sub(x0, x1);
+    const double4 close = select(active, lessThan(abs(delta), set4(antiderivativeTolerance)), set4(0.0));
+    const double4 difference = div(sub(F2x0, F2x1), delta);
+
+    if (! anyLane(close))
+        return difference;
+
+    return select(close, antiderivative1(mul(set4(0.5), add(x0, x1))), difference);
+}
+
+void Waveshaper::AntiderivativeLanes::gather(AntiderivativeState* const* states, int numStates)
+{
+    using namespace SIMD;
+
+    alignas(32) double values[5][maxLanes] = {};
+
+    for (int lane = 0; lane < numStates; ++lane)
+    {
+        values[0][lane] = states[lane]->x1;
+        values[1][lane] = states[lane]->x2;
+        values[2][lane] = states[lane]->F1x1;
+        values[3][lane] = states[lane]->F2x1;
+        values[4][lane] = states[lane]->D1;
+    }
+
+    x1 = load4(values[0]);
+    x2 = load4(values[1]);
+    F1x1 = load4(values[2]);
+    F2x1 = load4(values[3]);
+    D1 = load4(values[4]);
+}
+
+void Waveshaper::AntiderivativeLanes::scatter(AntiderivativeState* const* states, int numStates) const
+{
+    using namespace SIMD;
+
+    alignas(32) double values[5][maxLanes];
+    store(values[0], x1);
+    store(values[1], x2);
+    store(values[2], F1x1);
+    store(values[3], F2x1);
+    store(values[4], D1);
+
+    for (int lane = 0; lane < numStates; ++lane)
+    {
+        states[lane]->x1 = values[0][lane];
+        states[lane]->x2 = values[1][lane];
+        states[lane]->F1x1 = values[2][lane];
+        states[lane]->F2x1 = values[3][lane];
+        states[lane]->D1 = values[4][lane];
+    }
+}
+
+// One sample of every lane; the lanes past numLanes read silence and are not written
+template <typename SampleType>
+static SPATIAL_SATURATOR_INLINE SIMD::double4 loadLanes(SampleType* const* lanes, int numLanes, int n)
+{
+    using namespace SIMD;
+
+    // Straight into a register; going through memory would stall every
+    // sample on a failed store-to-load forward
+    return set4((double)lanes[0][n],
+                numLanes > 1 ? (double)lanes[1][n] : 0.0,
+                numLanes > 2 ? (double)lanes[2][n] : 0.0,
+                numLanes > 3 ? (double)lanes[3][n] : 0.0);
+}
+
+template <typename SampleType>
+static SPATIAL_SATURATOR_INLINE void storeLanes(SampleType* const* lanes, int numLanes, int n, SIMD::double4 v)
+{
+    alignas(32) double values[Waveshaper::maxLanes];
+    SIMD::store(values, v);
+
+    for (int lane = 0; lane < numLanes; ++lane)
+        lanes[lane][n] = (SampleType)values[lane];
+}
+
+// Set in the lanes below numLanes, so silent lanes never take the fallbacks
+static SIMD::double4 getActiveLanes(int numLanes)
+{
+    return SIMD::lessThan(SIMD::set4(0.0, 1.0, 2.0, 3.0), SIMD::set4((double)numLanes));
+}
+
+template <typename SampleType>
+void Waveshaper::processCurveLanes(SampleType* const* lanes, int numLanes, int numSamples, const CurveLanes& curve, SIMD::double4 mix)
+{
+    using namespace SIMD;
+
+    for (int n = 0; n < numSamples; ++n)
+    {
+        const double4 input = loadLanes(lanes, numLanes, n);
+
+        // waveshaper saturator, then Mixer Processing (dry/wet)
+        const double4 shaped = curve.curve(input);
+        storeLanes(lanes, numLanes, n, add(input, mul(mix, sub(shaped, input))));
+    }
+}
+
+template <typename SampleType>
+void Waveshaper::processAntiderivative1Lanes(SampleType* const* lanes, int numLanes, int numSamples, const CurveLanes& curve, AntiderivativeLanes& state, SIMD::double4 mix)
+{
+    using namespace SIMD;
+
+    const double4 active = getActiveLanes(numLanes);
+    const double4 tolerance = set4(antiderivativeTolerance);
+    const double4 half = set4(0.5);
+
+    for (int n = 0; n < numSamples; ++n)
+    {
+        const double4 input = loadLanes(lanes, numLanes, n);
+        const double4 F1x = curve.antiderivative1(input);
+        const double4 delta = sub(input, state.x1);
+
+        // y = (F1(x[n]) - F1(x[n-1])) / (x[n] - x[n-1])
+        double4 shaped = div(sub(F1x, state.F1x1), delta);
+        const double4 close = select(active, lessThan(abs(delta), tolerance), set4(0.0));
+
+        if (anyLane(close))
+            shaped = select(close, curve.curve(mul(half, add(input, state.x1))), shaped);
+
+        state.x1 = input;
+        state.F1x1 = F1x;
+
+        // Mixer Processing (dry/wet)
+        storeLanes(lanes, numLanes, n, add(input, mul(mix, sub(shaped, input))));
+    }
+}
+
+template <typename SampleType>
+void Waveshaper::processAntiderivative2Lanes(SampleType* const* lanes, int numLanes, int numSamples, const CurveLanes& curve, AntiderivativeLanes& state, SIMD::double4 mix)
+{
+    using namespace SIMD;
+
+    const double4 active = getActiveLanes(numLanes);
+    const double4 tolerance = set4(antiderivativeTolerance);
+    const double4 half = set4(0.5);
+    const double4 two = set4(2.0);
+
+    for (int n = 0; n < numSamples; ++n)
+    {
+        const double4 input = loadLanes(lanes, numLanes, n);
+        const double4 F2x = curve.antiderivative2(input);
+        const double4 D0 = curve.dividedDifference(input, state.x1, F2x, state.F2x1, active);
+        const double4 delta = sub(input, state.x2);
+
+        // y = 2 / (x[n] - x[n-2]) * (D(x[n], x[n-1]) - D(x[n-1], x[n-2]))
+        double4 shaped = div(mul(two, sub(D0, state.D1)), delta);
+        const double4 close = select(active, lessThan(abs(delta), tolerance), set4(0.0));
+
+        if (anyLane(close))
+        {
+            // x[n] ~= x[n-2]: expand around their mean instead (Parker et al. 2016)
+            const double4 mean = mul(half, add(input, state.x2));
+            const double4 offset = sub(mean, state.x1);
+
+            double4 expanded = mul(div(two, offset), add(curve.antiderivative1(mean), div(sub(state.F2x1, curve.antiderivative2(mean)), offset)));
+            const double4 centred = select(close, lessThan(abs(offset), tolerance), set4(0.0));
+
+            if (anyLane(centred))
+                expanded = select(centred, curve.curve(mul(half, add(mean, state.x1))), expanded);
+
+            shaped = select(close, expanded, shaped);
+        }
+
+        // The ADAA output is centred on x[n-1], so the dry signal is too
+        const double4 dry = state.x1;
+
+        state.x2 = state.x1;
+        state.x1 = input;
+        state.F2x1 = F2x;
+        state.D1 = D0;
+
+        // Mixer Processing (dry/wet)
+        storeLanes(lanes, numLanes, n, add(dry, mul(mix, sub(shaped, dry))));
+    }
+}
+
+//==============================================================================
+template void Waveshaper::process<float>(float* const*, int, int);
+template void Waveshaper::process<double>(double* const*, int, int);
+template void Waveshaper::processLanes<float>(Waveshaper* const*, int, float* const* const*, const int*, int);
+template void Waveshaper::processLanes<double>(Waveshaper* const*, int, double* const* const*, const int*, int);
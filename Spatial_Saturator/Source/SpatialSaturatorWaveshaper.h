@@ -0,0 +1,214 @@
+/*
+  ==============================================================================
+
+    This file contains the waveshaper saturator:
+    a * tanh(g * x) + b * sin(f * x), mixed with the dry signal and run
+    either inside the oversampling stage or with antiderivative anti-aliasing,
+    full band or on up to four Linkwitz-Riley bands
+
+  ==============================================================================
+*/
+#ifndef __SpatialSaturatorWaveshaper__SpatialSaturatorWaveshaper__
+#define __SpatialSaturatorWaveshaper__SpatialSaturatorWaveshaper__
+
+#pragma once
+
+#include "SpatialSaturatorCrossover.h"
+#include "SpatialSaturatorFastMath.h"
+#include "SpatialSaturatorOversampler.h"
+#include "SpatialSaturatorSIMD.h"
+#include <vector>
+
+//==============================================================================
+/**
+    process() takes float or double channels. The exact curve and ADAA always
+    compute in double, so the double path never rounds; the approximations are
+    float kernels and run on a float copy of double input.
+
+    With more than one band, a LinkwitzRileyCrossover splits each channel at
+    the rate the curve runs at (oversampled, or the base rate for ADAA) and
+    every band goes through the curve on its own, driven by its own gain and
+    mixed by its own amount, before the bands are summed again. The split runs
+    all bands in the lanes of one SIMD register, so it costs the same for two
+    bands as for four. At Full quality and with ADAA the (channel, band) pairs
+    then go through the curve four to a double4 kernel (LaneMath), so a stereo
+    pair fills the lanes from two bands up; the Draft and High approximations
+    run band by band, vectorised over samples.
+
+    processLanes() runs the channels of up to maxLanes full band waveshapers
+    in the lanes of double4 kernels (LaneMath), so several streams share each
+    evaluation of the Full quality curve or of ADAA. Each keeps its own
+    parameters, oversampling filters and ADAA history.
+*/
+class Waveshaper
+{
+public:
+    enum AntiAliasing
+    {
+        oversampled = 0,
+        firstOrderADAA,     // first order ADAA at the base rate
+        secondOrderADAA     // second order ADAA at the base rate
+    };
+
+    enum
+    {
+        maxBands = LinkwitzRileyCrossover::maxBands,
+        maxLanes = 4        // lanes of the double4 curve kernels
+    };
+
+    void prepare(double sampleRate, int numChannels, int maxBlockSize);
+    void reset();
+
+    // Gives channel to every state of channel from: oversampling filters,
+    // crossover and ADAA history. Realtime safe
+    void copyChannelState(int from, int to);
+
+    void setOversampling(int factorLog2, Oversampler::Phase phase);
+    // The ADAA modes replace the oversampling stage
+    void setAntiAliasing(AntiAliasing antiAliasing);
+    int getLatencyInSamples() const;
+
+    // Samples the oversampling filters, the crossover and the ADAA history ring
+    // on after the input stops, at the base rate
+    int getTailLengthInSamples() const;
+
+    // Takes the raw parameter values (amplitudes and mix in percent)
+    void setParameters(float tanhAmplitude, float tanhSlope, float sinAmplitude, float sinFreq, float saturatorMix);
+
+    // 1 band is the full band saturator. numBands - 1 crossover frequencies in
+    // Hz, and per band the drive in dB and the mix in percent of saturatorMix
+    void setBands(int numBands, const float* crossoverFrequencies, const float* drives, const float* mixes);
+
+    // full keeps the exact double precision curve, low and medium use the
+    // SIMD approximations
+    void setPrecision(FastMath::Precision precision) { m_precision = precision; }
+
+    template <typename SampleType>
+    void process(SampleType* const* channels, int numChannels, int numSamples);
+
+    // Whether this and other can run in one processLanes() call: full band,
+    // prepared for the same block size, with the same ADAA mode, or both
+    // oversampled by the same factor at Full quality (the approximations are
+    // vectorised over samples instead)
+    bool canShareLanesWith(const Waveshaper& other) const;
+
+    // Runs waveshapers[i] on numChannels[i] channels[i] for up to maxLanes
+    // waveshapers, one channel per lane, so two stereo streams or a stereo and
+    // two mono ones fill a call. The curve is within a few ulp of their own
+    // process(); ADAA's divided differences amplify that to 1e-8 or so, below
+    // float precision. Every waveshaper must be able to share lanes with the first
+    template <typename SampleType>
+    static void processLanes(Waveshaper* const* waveshapers, int numWaveshapers, SampleType* const* const* channels, const int* numChannels, int numSamples);
+
+private:
+    enum { bandChunkSize = 256 };
+
+    template <typename SampleType>
+    void processCurve(SampleType* samples, int numSamples, double mix);
+    template <typename SampleType>
+    void processCurveApproximated(SampleType* samples, int numSamples, double mix);
+
+    // Splits, shapes and sums every channel, at the rate the curve runs at
+    template <typename SampleType>
+    void processBands(SampleType* const* channels, int numChannels, int numSamples);
+    void updateCrossover();
+
+    // Antiderivative anti-aliasing, per channel
+    struct AntiderivativeState
+    {
+        double x1 = 0.0, x2 = 0.0;      // previous inputs
+        double F1x1 = 0.0;              // first antiderivative at x1
+        double F2x1 = 0.0;              // second antiderivative at x1
+        double D1 = 0.0;                // divided difference of F2 over [x2, x1]
+    };
+
+    void updateAntiderivativeStates();
+    template <typename SampleType>
+    void processAntiderivative1(SampleType* samples, int numSamples, AntiderivativeState& state, double mix);
+    template <typename SampleType>
+    void processAntiderivative2(SampleType* samples, int numSamples, AntiderivativeState& state, double mix);
+
+    // The curve and its first and second antiderivatives
+    double curve(double x) const;
+    double antiderivative1(double x) const;
+    double antiderivative2(double x) const;
+    double dividedDifference(double x0, double x1, double F2x0, double F2x1) const;
+
+    // The curves of up to maxLanes waveshapers, or bands, one per lane
+    struct CurveLanes
+    {
+        // Lane i takes the curve of waveshapers[i], the lanes past
+        // numWaveshapers that of the first
+        CurveLanes(const Waveshaper* const* waveshapers, int numWaveshapers);
+
+        SIMD::double4 curve(SIMD::double4 x) const;
+        SIMD::double4 antiderivative1(SIMD::double4 x) const;
+        SIMD::double4 antiderivative2(SIMD::double4 x) const;
+        // Only the lanes set in active take the midpoint fallback
+        SIMD::double4 dividedDifference(SIMD::double4 x0, SIMD::double4 x1, SIMD::double4 F2x0, SIMD::double4 F2x1, SIMD::double4 active) const;
+
+        SIMD::double4 tanhAmplitude, tanhSlope, sinAmplitude, sinFreq;
+        SIMD::double4 tanhScale1, sinScale1;    // a / g and b / f
+        SIMD::double4 tanhScale2, sinScale2;    // a / g^2 and b / f^2
+    };
+
+    // AntiderivativeState of up to maxLanes channels, one per lane
+    struct AntiderivativeLanes
+    {
+        SIMD::double4 x1 = SIMD::set4(0.0), x2 = SIMD::set4(0.0);
+        SIMD::double4 F1x1 = SIMD::set4(0.0), F2x1 = SIMD::set4(0.0), D1 = SIMD::set4(0.0);
+
+        void gather(AntiderivativeState* const* states, int numStates);
+        void scatter(AntiderivativeState* const* states, int numStates) const;
+    };
+
+    // In place on lanes[0 .. numLanes - 1], the other lanes run on silence
+    template <typename SampleType>
+    static void processCurveLanes(SampleType* const* lanes, int numLanes, int numSamples, const CurveLanes& curve, SIMD::double4 mix);
+    template <typename SampleType>
+    static void processAntiderivative1Lanes(SampleType* const* lanes, int numLanes, int numSamples, const CurveLanes& curve, AntiderivativeLanes& state, SIMD::double4 mix);
+    template <typename SampleType>
+    static void processAntiderivative2Lanes(SampleType* const* lanes, int numLanes, int numSamples, const CurveLanes& curve, AntiderivativeLanes& state, SIMD::double4 mix);
+
+    Oversampler m_oversampler;
+    double m_sampleRate = 44100.0;
+    int m_maxBlockSize = 0;
+
+    // Channel pointers advanced into a long block
+    std::vector<float*> m_floatChunk;
+    std::vector<double*> m_doubleChunk;
+
+    template <typename SampleType>
+    std::vector<SampleType*>& getChunk();
+
+    // Oversampled tanh and sin terms for the approximated curve
+    std::vector<float> m_tanhBuffer, m_sinBuffer;
+    FastMath::Precision m_precision = FastMath::full;
+
+    AntiAliasing m_antiAliasing = oversampled;
+    std::vector<AntiderivativeState> m_antiderivativeStates;
+    // [channel * maxBands + band], in the driven domain of each band
+    std::vector<AntiderivativeState> m_bandAntiderivativeStates;
+
+    // Cleared when the curve changes, so the cached antiderivatives get recomputed
+    bool m_antiderivativesValid = false;
+
+    double m_tanhAmplitude = 0.0, m_tanhSlope = 1.0;
+    double m_sinAmplitude = 0.0, m_sinFreq = 1.0;
+    double m_mix = 0.0;
+
+    LinkwitzRileyCrossover m_crossover;
+    int m_numBands = 1;
+    float m_crossoverFrequencies[maxBands - 1] = {};
+    double m_bandDrives[maxBands] = { 1.0, 1.0, 1.0, 1.0 };     // linear
+    double m_bandMixes[maxBands] = { 1.0, 1.0, 1.0, 1.0 };      // of m_mix
+
+    // One chunk of every band of every channel, [(channel * maxBands + band) * bandChunkSize + n]
+    std::vector<float> m_floatBands;
+    std::vector<double> m_doubleBands;
+
+    template <typename SampleType>
+    std::vector<SampleType>& getBands();
+};
+
+#endif
@@ -0,0 +1,182 @@
+/*
+  ==============================================================================
+
+    This file contains the routing of surround and immersive speaker beds
+    through the multi-stream engine
+
+  ==============================================================================
+*/
+
+#include "SurroundRouter.h"
+#include <algorithm>
+#include <utility>
+
+using ChannelType = juce::AudioChannelSet::ChannelType;
+
+// Left/right partners, front to back and then the height layer; the first
+// is the pair frontPairOnly keeps
+static const std::pair<ChannelType, ChannelType> speakerPairs[] =
+{
+    { juce::AudioChannelSet::left,              juce::AudioChannelSet::right },
+    { juce::AudioChannelSet::leftCentre,        juce::AudioChannelSet::rightCentre },
+    { juce::AudioChannelSet::wideLeft,          juce::AudioChannelSet::wideRight },
+    { juce::AudioChannelSet::leftSurroundSide,  juce::AudioChannelSet::rightSurroundSide },
+    { juce::AudioChannelSet::leftSurround,      juce::AudioChannelSet::rightSurround },
+    { juce::AudioChannelSet::leftSurroundRear,  juce::AudioChannelSet::rightSurroundRear },
+    { juce::AudioChannelSet::topFrontLeft,      juce::AudioChannelSet::topFrontRight },
+    { juce::AudioChannelSet::topSideLeft,       juce::AudioChannelSet::topSideRight },
+    { juce::AudioChannelSet::topRearLeft,       juce::AudioChannelSet::topRearRight }
+};
+
+//==============================================================================
+bool SurroundRouter::isSupported(const juce::AudioChannelSet& layout)
+{
+    // Ambisonic and discrete channels have no speaker positions to pair
+    return layout.size() >= 2 && layout.size() <= maxChannels
+        && layout.getAmbisonicOrder() < 0 && !layout.isDiscreteLayout();
+}
+
+void SurroundRouter::prepare(const juce::AudioChannelSet& layout, int maxBlockSize)
+{
+    const int numChannels = layout.size();
+
+    m_channelTypes.resize((size_t)numChannels);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        m_channelTypes[(size_t)channel] = layout.getTypeOfChannel(channel);
+
+    // setPairing() regroups within what is reserved here, without allocating
+    m_streams.clear();
+    m_streams.reserve((size_t)numChannels);
+    m_grouped = false;
+
+    m_maxBlockSize = std::max(maxBlockSize, 0);
+    m_scratch.assign((size_t)numChannels * (size_t)m_maxBlockSize, 0.0f);
+    m_left.assign((size_t)numChannels, nullptr);
+    m_right.assign((size_t)numChannels, nullptr);
+
+    setPairing(m_pairing);
+}
+
+bool SurroundRouter::setPairing(Pairing pairing)
+{
+    if (m_grouped && pairing == m_pairing)
+        return false;
+
+    m_pairing = pairing;
+    m_grouped = true;
+    m_streams.clear();
+
+    const int numChannels = (int)m_channelTypes.size();
+    bool paired[maxChannels] = {};
+
+    auto findChannel = [this, numChannels, &paired](ChannelType type)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            if (!paired[channel] && m_channelTypes[(size_t)channel] == type)
+                return channel;
+
+        return -1;
+    };
+
+    if (pairing != allMidOnly)
+    {
+        for (const auto& pair : speakerPairs)
+        {
+            const int left = findChannel(pair.first);
+            const int right = findChannel(pair.second);
+
+            if (left >= 0 && right >= 0)
+            {
+                paired[left] = paired[right] = true;
+                m_streams.push_back({ left, right });
+            }
+
+            if (pairing == frontPairOnly)
+                break;
+        }
+    }
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        if (!paired[channel])
+            m_streams.push_back({ channel, -1 });
+
+    return true;
+}
+
+int SurroundRouter::getFrontLeftChannel() const
+{
+    return !m_streams.empty() && m_streams.front().right >= 0 ? m_streams.front().left : -1;
+}
+
+int SurroundRouter::getFrontRightChannel() const
+{
+    return !m_streams.empty() ? m_streams.front().right : -1;
+}
+
+//==============================================================================
+float* SurroundRouter::getChannel(juce::AudioBuffer<float>& buffer, int channel, int start, int)
+{
+    return buffer.getWritePointer(channel, start);
+}
+
+float* SurroundRouter::getChannel(juce::AudioBuffer<double>& buffer, int channel, int start, int numSamples)
+{
+    const double* source = buffer.getReadPointer(channel, start);
+    float* destination = getScratch(channel);
+
+    for (int n = 0; n < numSamples; ++n)
+        destination[n] = (float)source[n];
+
+    return destination;
+}
+
+void SurroundRouter::finishChannel(juce::AudioBuffer<double>& buffer, int channel, int start, int numSamples)
+{
+    const float* source = getScratch(channel);
+    double* destination = buffer.getWritePointer(channel, start);
+
+    for (int n = 0; n < numSamples; ++n)
+        destination[n] = (double)source[n];
+}
+
+template <typename SampleType>
+void SurroundRouter::process(MultiStreamEngine& engine, juce::AudioBuffer<SampleType>& buffer)
+{
+    const int numChannels = getMaxStreams();
+    const int numSamples = buffer.getNumSamples();
+    const int numStreams = std::min(getNumStreams(), engine.getNumActiveStreams());
+
+    jassert(engine.getNumActiveStreams() == getNumStreams());
+
+    // A bus other than the prepared one is passed through
+    if (buffer.getNumChannels() != numChannels || m_maxBlockSize <= 0)
+        return;
+
+    // Blocks longer than the prepared size run in chunks of it
+    for (int start = 0; start < numSamples; start += m_maxBlockSize)
+    {
+        const int chunkSize = std::min(m_maxBlockSize, numSamples - start);
+        float* channels[maxChannels];
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            channels[channel] = getChannel(buffer, channel, start, chunkSize);
+
+        for (int stream = 0; stream < numStreams; ++stream)
+        {
+            const auto& group = m_streams[(size_t)stream];
+            m_left[(size_t)stream] = channels[group.left];
+
+            // Mid-only streams run one channel
+            m_right[(size_t)stream] = group.right >= 0 ? channels[group.right] : nullptr;
+        }
+
+        engine.process(m_left.data(), m_right.data(), chunkSize);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            finishChannel(buffer, channel, start, chunkSize);
+    }
+}
+
+template void SurroundRouter::process<float>(MultiStreamEngine&, juce::AudioBuffer<float>&);
+template void SurroundRouter::process<double>(MultiStreamEngine&, juce::AudioBuffer<double>&);
@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    This file contains the routing of surround and immersive speaker beds
+    through the multi-stream engine
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SpatialSaturatorMultiStream.h"
+
+//==============================================================================
+/**
+    Splits a multichannel bus into the stereo streams of one MultiStreamEngine,
+    so a 7.1.4 bed runs as a handful of packed streams in a single instance
+    instead of one plug-in per pair.
+
+    Left/right speaker pairs (L/R, Ls/Rs, Lrs/Rrs, Ltf/Rtf, ...) become M/S
+    streams. Every other channel (centre, LFE, anything without a partner)
+    is a mid-only stream: the engine runs it as one channel whose side is
+    exactly zero, so only the mid shelf, the saturator and the limiter act
+    on it. The pairing decides which pairs are formed:
+
+        leftRightPairs  every pair the layout has
+        frontPairOnly   only L/R, the rest mid-only
+        allMidOnly      no widening at all
+
+    Pairs come first, front to back, then the mid-only channels in bus order.
+    The packed engine runs in float; double buffers are converted on the way
+    in and out.
+*/
+class SurroundRouter
+{
+public:
+    enum Pairing
+    {
+        leftRightPairs = 0,
+        frontPairOnly,
+        allMidOnly
+    };
+
+    enum { maxChannels = 16 };
+
+    // Speaker layouts (not ambisonic or discrete) of 2 to maxChannels channels
+    static bool isSupported(const juce::AudioChannelSet& layout);
+
+    // Allocates for the layout; the engine needs getMaxStreams() streams
+    void prepare(const juce::AudioChannelSet& layout, int maxBlockSize);
+    int getMaxStreams() const { return (int)m_channelTypes.size(); }
+
+    // True if the streams changed, in which case the engine should be reset
+    // and given the new getNumStreams()
+    bool setPairing(Pairing pairing);
+    int getNumStreams() const { return (int)m_streams.size(); }
+
+    // Bus channels of the first stream if it is a pair (for the analysis display), else -1
+    int getFrontLeftChannel() const;
+    int getFrontRightChannel() const;
+
+    // Every channel of buffer through its stream of engine, in chunks of at
+    // most maxBlockSize
+    template <typename SampleType>
+    void process(MultiStreamEngine& engine, juce::AudioBuffer<SampleType>& buffer);
+
+private:
+    struct Stream
+    {
+        int left = 0, right = -1;       // bus channels, right -1 for mid-only
+    };
+
+    // Where the engine reads and writes a channel: in place for float, a
+    // converted copy for double
+    float* getChannel(juce::AudioBuffer<float>& buffer, int channel, int start, int numSamples);
+    float* getChannel(juce::AudioBuffer<double>& buffer, int channel, int start, int numSamples);
+    void finishChannel(juce::AudioBuffer<float>&, int, int, int) {}
+    void finishChannel(juce::AudioBuffer<double>& buffer, int channel, int start, int numSamples);
+
+    float* getScratch(int slot) { return m_scratch.data() + (size_t)slot * (size_t)m_maxBlockSize; }
+
+    std::vector<juce::AudioChannelSet::ChannelType> m_channelTypes;
+    std::vector<Stream> m_streams;
+    Pairing m_pairing = leftRightPairs;
+    bool m_grouped = false;
+
+    // One slot of maxBlockSize per channel, for converted doubles
+    int m_maxBlockSize = 0;
+    std::vector<float> m_scratch;
+    std::vector<float*> m_left, m_right;
+};
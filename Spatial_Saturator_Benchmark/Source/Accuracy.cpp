@@ -0,0 +1,629 @@
+/*
+  ==============================================================================
+
+    This file contains the accuracy checks of the benchmark.
+
+  ==============================================================================
+*/
+
+#include "Accuracy.h"
+#include "LegacyMidSideChain.h"
+#include "../../Spatial_Saturator/Source/SpatialSaturatorLinearPhase.h"
+#include "../../Spatial_Saturator/Source/SpatialSaturatorMultiStream.h"
+#include "../../Spatial_Saturator/Source/SpatialSaturatorSVF.h"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+
+namespace
+{
+    const double sampleRate = 48000.0;
+    const double twoPi = 6.283185307179586476925;
+    const int blockSize = 512;
+
+    // Signals run warmUp samples before the analysed part. The sine sits
+    // exactly on sineBin of the analysed part (~1 kHz), so no window is needed
+    const int warmUp = 1 << 14;
+    const int analysisLength = 1 << 16;
+    const int signalLength = warmUp + analysisLength;
+    const int sineBin = 1365;
+    const int numHarmonics = 10;
+
+    // THD below this (dB) is rounding noise, and counts as this
+    const double thdFloor = -120.0;
+
+    // Points of the magnitude response, log spaced from 20 Hz to 20 kHz. Only
+    // points where the reference is above responseFloor (dB) are compared: in
+    // the stop band of the side high pass the linear phase kernel's length,
+    // not its accuracy, decides the level
+    const int numResponsePoints = 128;
+    const double responseFloor = -20.0;
+
+    // Default parameter values from createParameterLayout
+    const float midFreq = 250.0f, midGain = 2.5f, sideFreqLower = 140.0f, sideFreqUpper = 4000.0f, sideGain = 6.0f;
+
+    //==============================================================================
+    struct Signal
+    {
+        std::string name;
+        std::vector<double> left, right;
+    };
+
+    std::vector<Signal> makeSignals()
+    {
+        std::vector<Signal> signals(4);
+
+        for (auto& signal : signals)
+        {
+            signal.left.assign((size_t)signalLength, 0.0);
+            signal.right.assign((size_t)signalLength, 0.0);
+        }
+
+        // Exponential sweep from 20 Hz to 20 kHz, the right side in quadrature
+        // so there is as much side as mid
+        signals[0].name = "sweep";
+        const double duration = signalLength / sampleRate, logRatio = std::log(1000.0);
+        for (int n = 0; n < signalLength; ++n)
+        {
+            const double phase = twoPi * 20.0 * duration / logRatio * (std::exp(logRatio * n / signalLength) - 1.0);
+            signals[0].left[(size_t)n] = 0.5 * std::sin(phase);
+            signals[0].right[(size_t)n] = 0.5 * std::cos(phase);
+        }
+
+        // Uniform white noise, independent on each side. A fixed generator so
+        // every platform checks the same samples
+        signals[1].name = "noise";
+        uint32_t seed = 1;
+        auto nextNoise = [&seed]
+        {
+            seed = seed * 1664525u + 1013904223u;
+            return (double)(seed >> 8) / (double)(1 << 23) - 1.0;
+        };
+
+        for (int n = 0; n < signalLength; ++n)
+        {
+            signals[1].left[(size_t)n] = 0.5 * nextNoise();
+            signals[1].right[(size_t)n] = 0.5 * nextNoise();
+        }
+
+        // Unit impulse on the left, for the magnitude responses
+        signals[2].name = "impulse";
+        signals[2].left[0] = 1.0;
+
+        // Full scale sine on the left and half scale on the right, for THD
+        signals[3].name = "sine";
+        for (int n = 0; n < signalLength; ++n)
+        {
+            signals[3].left[(size_t)n] = std::sin(twoPi * sineBin * n / analysisLength);
+            signals[3].right[(size_t)n] = 0.5 * signals[3].left[(size_t)n];
+        }
+
+        return signals;
+    }
+
+    //==============================================================================
+    // Processes both sides of a signal in place, starting from silence
+    using Processor = std::function<void(std::vector<double>& left, std::vector<double>& right)>;
+
+    // Runs process over a SampleType copy of the signal, blockSize at a time
+    template <typename SampleType>
+    void runInBlocks(std::vector<double>& left, std::vector<double>& right,
+                     const std::function<void(SampleType* left, SampleType* right, int numSamples)>& process)
+    {
+        std::vector<SampleType> l(left.begin(), left.end()), r(right.begin(), right.end());
+
+        for (int start = 0; start < signalLength; start += blockSize)
+            process(l.data() + start, r.data() + start, std::min(blockSize, signalLength - start));
+
+        std::copy(l.begin(), l.end(), left.begin());
+        std::copy(r.begin(), r.end(), right.begin());
+    }
+
+    // The getSample/setSample view of two channels LegacyMidSideChain takes
+    struct StereoView
+    {
+        float getSample(int channel, int n) const { return channels[channel][n]; }
+        void setSample(int channel, int n, float value) { channels[channel][n] = value; }
+
+        float* channels[2];
+    };
+
+    // The original five pass chain through a float buffer, the reference of
+    // every filter mode
+    Processor legacyFilters()
+    {
+        return [](std::vector<double>& left, std::vector<double>& right)
+        {
+            LegacyMidSideChain chain;
+            chain.setSampleRate(sampleRate);
+
+            runInBlocks<float>(left, right, [&](float* l, float* r, int numSamples)
+            {
+                StereoView buffer{ { l, r } };
+                chain.process(buffer, numSamples, midFreq, midGain, sideFreqLower, sideFreqUpper, sideGain, 0.0f);
+            });
+        };
+    }
+
+    template <typename SampleType>
+    Processor biquadFilters(bool useTables)
+    {
+        return [useTables](std::vector<double>& left, std::vector<double>& right)
+        {
+            MidSideFilterChain chain;
+            chain.setSampleRate((float)sampleRate);
+
+            if (useTables)
+                chain.setCoefficientTables(CoefficientTables::getShared((float)sampleRate, 20.0f, 20000.0f, 1.0f, 0.0f, 12.0f, 0.5f));
+
+            chain.updateCoefficients(midFreq, midGain, sideFreqLower, sideFreqUpper, sideGain);
+
+            runInBlocks<SampleType>(left, right, [&](SampleType* l, SampleType* r, int numSamples)
+            {
+                chain.process(l, r, numSamples, (SampleType)1);
+            });
+        };
+    }
+
+    template <typename SampleType>
+    Processor svfFilters()
+    {
+        return [](std::vector<double>& left, std::vector<double>& right)
+        {
+            MidSideSVFChain chain;
+            chain.setSampleRate((float)sampleRate);
+            chain.updateCoefficients(midFreq, midGain, sideFreqLower, sideFreqUpper, sideGain);
+
+            runInBlocks<SampleType>(left, right, [&](SampleType* l, SampleType* r, int numSamples)
+            {
+                chain.process(l, r, numSamples, (SampleType)1);
+            });
+        };
+    }
+
+    // The mono path: the left side through the mid shelf only, for both sides
+    Processor midOnlyFilters()
+    {
+        return [](std::vector<double>& left, std::vector<double>& right)
+        {
+            MidSideFilterChain chain;
+            chain.setSampleRate((float)sampleRate);
+            chain.updateCoefficients(midFreq, midGain, sideFreqLower, sideFreqUpper, sideGain);
+            chain.resetSide();
+
+            runInBlocks<float>(left, right, [&](float* l, float* r, int numSamples)
+            {
+                chain.processMid(l, numSamples, 1.0f, 1.0f);
+                std::copy(l, l + numSamples, r);
+            });
+        };
+    }
+
+    Processor linearPhaseFilters()
+    {
+        return [](std::vector<double>& left, std::vector<double>& right)
+        {
+            LinearPhaseMidSideFilter filter;
+            filter.prepare((float)sampleRate, midFreq, midGain, sideFreqLower, sideFreqUpper, sideGain);
+
+            runInBlocks<float>(left, right, [&](float* l, float* r, int numSamples)
+            {
+                filter.process(l, r, numSamples, 1.0f, 1.0f);
+            });
+        };
+    }
+
+    // Stream 0 of a packed chain, the other lanes idle
+    Processor multiStreamFilters()
+    {
+        return [](std::vector<double>& left, std::vector<double>& right)
+        {
+            MultiStreamFilterChain chain;
+            chain.prepare((float)sampleRate, 1);
+            chain.updateCoefficients(0, midFreq, midGain, sideFreqLower, sideFreqUpper, sideGain);
+            const float makeUpGain = 1.0f;
+
+            runInBlocks<float>(left, right, [&](float* l, float* r, int numSamples)
+            {
+                chain.process(&l, &r, numSamples, &makeUpGain, &makeUpGain);
+            });
+        };
+    }
+
+    // The curve of the original processBlock, per sample in double at the
+    // base rate, with the default parameters. The original multiplied by the
+    // mix percentage; here the mix is the dry/wet its parameter is named for,
+    // as in the waveshaper
+    Processor originalCurve()
+    {
+        return [](std::vector<double>& left, std::vector<double>& right)
+        {
+            const SpatialSaturatorEngine::Parameters defaults;
+            const double mix = (double)defaults.saturatorMix * 0.01;
+
+            for (auto* channel : { &left, &right })
+            {
+                for (auto& sample : *channel)
+                {
+                    double input = sample;
+                    double shaped = ((double)defaults.tanhAmplitude * 0.01) * tanh(input * (double)defaults.tanhSlope)
+                                  + ((double)defaults.sinAmplitude * 0.01) * sin(input * (double)defaults.sinFrequency);
+                    sample = input + mix * (shaped - input);
+                }
+            }
+        };
+    }
+
+    // The default curve at 2^oversamplingFactorLog2 times the rate, with
+    // numBands bands at the default crossovers
+    template <typename SampleType>
+    Processor saturator(Waveshaper::AntiAliasing antiAliasing, FastMath::Precision precision, int numBands, int oversamplingFactorLog2)
+    {
+        return [=](std::vector<double>& left, std::vector<double>& right)
+        {
+            const SpatialSaturatorEngine::Parameters defaults;
+
+            Waveshaper waveshaper;
+            waveshaper.prepare(sampleRate, 2, blockSize);
+            waveshaper.setParameters(defaults.tanhAmplitude, defaults.tanhSlope, defaults.sinAmplitude, defaults.sinFrequency, defaults.saturatorMix);
+            waveshaper.setBands(numBands, defaults.crossoverFrequencies, defaults.bandDrives, defaults.bandMixes);
+            waveshaper.setOversampling(oversamplingFactorLog2, defaults.oversamplingPhase);
+            waveshaper.setAntiAliasing(antiAliasing);
+            waveshaper.setPrecision(precision);
+
+            runInBlocks<SampleType>(left, right, [&](SampleType* l, SampleType* r, int numSamples)
+            {
+                SampleType* channels[] = { l, r };
+                waveshaper.process(channels, 2, numSamples);
+            });
+        };
+    }
+
+    template <typename SampleType>
+    Processor limiter()
+    {
+        return [](std::vector<double>& left, std::vector<double>& right)
+        {
+            const SpatialSaturatorEngine::Parameters defaults;
+
+            Limiter limiter;
+            limiter.prepare(sampleRate, 2, blockSize);
+            limiter.setParameters(defaults.limiterCeiling, defaults.limiterLookahead, defaults.limiterRelease);
+
+            runInBlocks<SampleType>(left, right, [&](SampleType* l, SampleType* r, int numSamples)
+            {
+                SampleType* channels[] = { l, r };
+                limiter.process(channels, 2, numSamples);
+            });
+        };
+    }
+
+    // The whole chain: the default parameters with 2x oversampling and the limiter on
+    SpatialSaturatorEngine::Parameters chainParameters()
+    {
+        SpatialSaturatorEngine::Parameters parameters;
+        parameters.oversamplingFactorLog2 = 1;
+        parameters.limiterEnabled = true;
+        return parameters;
+    }
+
+    // The whole chain, always on the stereo path
+    template <typename SampleType>
+    Processor stereoEngine()
+    {
+        return [](std::vector<double>& left, std::vector<double>& right)
+        {
+            auto engine = std::make_unique<SpatialSaturatorEngine>();
+            engine->prepare(sampleRate, blockSize);
+            engine->setParameters(chainParameters());
+            engine->setMonoDetectionEnabled(false);
+
+            runInBlocks<SampleType>(left, right, [&](SampleType* l, SampleType* r, int numSamples)
+            {
+                engine->process(l, r, numSamples);
+            });
+        };
+    }
+
+    Processor monoEngine()
+    {
+        return [](std::vector<double>& left, std::vector<double>& right)
+        {
+            auto engine = std::make_unique<SpatialSaturatorEngine>();
+            engine->prepare(sampleRate, blockSize);
+            engine->setParameters(chainParameters());
+
+            runInBlocks<float>(left, right, [&](float* l, float* r, int numSamples)
+            {
+                engine->processMono(l, numSamples);
+                std::copy(l, l + numSamples, r);
+            });
+        };
+    }
+
+    Processor multiStreamEngine()
+    {
+        return [](std::vector<double>& left, std::vector<double>& right)
+        {
+            auto engine = std::make_unique<MultiStreamEngine>();
+            engine->prepare(sampleRate, blockSize, 1);
+            engine->setParameters(0, chainParameters());
+
+            runInBlocks<float>(left, right, [&](float* l, float* r, int numSamples)
+            {
+                engine->process(&l, &r, numSamples);
+            });
+        };
+    }
+
+    //==============================================================================
+    // Energy of the reference over the energy of the difference, both sides
+    double getSnr(const Signal& reference, const Signal& output)
+    {
+        double signal = 0.0, error = 0.0;
+
+        for (size_t n = 0; n < reference.left.size(); ++n)
+        {
+            const double leftError = output.left[n] - reference.left[n], rightError = output.right[n] - reference.right[n];
+            signal += reference.left[n] * reference.left[n] + reference.right[n] * reference.right[n];
+            error += leftError * leftError + rightError * rightError;
+        }
+
+        return error > 0.0 ? 10.0 * std::log10(signal / error) : std::numeric_limits<double>::infinity();
+    }
+
+    // Largest difference on either side, in dBFS
+    double getMaxError(const Signal& reference, const Signal& output)
+    {
+        double error = 0.0;
+
+        for (size_t n = 0; n < reference.left.size(); ++n)
+            error = std::max({ error, std::abs(output.left[n] - reference.left[n]), std::abs(output.right[n] - reference.right[n]) });
+
+        return error > 0.0 ? 20.0 * std::log10(error) : -std::numeric_limits<double>::infinity();
+    }
+
+    // Power of bin over the analysed part, with the phase taken from a table
+    // so the bins are exact
+    double getPower(const std::vector<double>& samples, int bin)
+    {
+        static const auto twiddles = []
+        {
+            std::vector<std::complex<double>> table((size_t)analysisLength);
+            for (int n = 0; n < analysisLength; ++n)
+                table[(size_t)n] = std::polar(1.0, -twoPi * n / analysisLength);
+            return table;
+        }();
+
+        std::complex<double> sum = 0.0;
+        for (int n = 0; n < analysisLength; ++n)
+            sum += samples[(size_t)(warmUp + n)] * twiddles[(size_t)(((long long)bin * n) % analysisLength)];
+
+        return std::norm(sum);
+    }
+
+    // Harmonics 2 to numHarmonics of the sine relative to the fundamental, in
+    // dB. None of them reaches Nyquist at sampleRate
+    double getThd(const std::vector<double>& samples)
+    {
+        double harmonics = 0.0;
+        for (int harmonic = 2; harmonic <= numHarmonics; ++harmonic)
+            harmonics += getPower(samples, harmonic * sineBin);
+
+        return std::max(thdFloor, 10.0 * std::log10(harmonics / getPower(samples, sineBin)));
+    }
+
+    // Magnitude responses of mid and side in dB at the log spaced points, from
+    // the output for the impulse (half mid, half side). Mid and side are taken
+    // apart as the linear phase filter only keeps their magnitudes, and
+    // latency does not matter
+    std::vector<double> getMagnitudeResponses(const Signal& impulseResponse)
+    {
+        std::vector<double> responses;
+
+        for (int point = 0; point < numResponsePoints; ++point)
+        {
+            const double frequency = 20.0 * std::pow(1000.0, point / (double)(numResponsePoints - 1));
+            const auto step = std::polar(1.0, -twoPi * frequency / sampleRate);
+
+            std::complex<double> rotation = 1.0, mid = 0.0, side = 0.0;
+            for (size_t n = 0; n < impulseResponse.left.size(); ++n)
+            {
+                mid += (impulseResponse.left[n] + impulseResponse.right[n]) * rotation;
+                side += (impulseResponse.left[n] - impulseResponse.right[n]) * rotation;
+                rotation *= step;
+            }
+
+            responses.push_back(20.0 * std::log10(std::abs(mid)));
+            responses.push_back(20.0 * std::log10(std::abs(side)));
+        }
+
+        return responses;
+    }
+
+    //==============================================================================
+    struct Check
+    {
+        enum Kind
+        {
+            linear,         // waveform and magnitude response
+            nonlinear,      // waveform and THD
+            magnitudeOnly,  // magnitude response only, the phase differs by design
+            harmonicsOnly   // THD only, the aliasing and the phase differ by design
+        };
+
+        const char* name;
+        Processor reference, tested;
+        Kind kind;
+        bool mono;          // every signal with its left side on both sides
+        AccuracyResult::Bounds bounds;
+    };
+
+    AccuracyResult runCheck(const Check& check, const std::vector<Signal>& signals)
+    {
+        AccuracyResult result;
+        result.check = check.name;
+        result.hasWaveform = check.kind == Check::linear || check.kind == Check::nonlinear;
+        result.hasThd = check.kind == Check::nonlinear || check.kind == Check::harmonicsOnly;
+        result.hasResponse = check.kind == Check::linear || check.kind == Check::magnitudeOnly;
+        result.bounds = check.bounds;
+        result.snr = std::numeric_limits<double>::infinity();
+        result.maxError = -std::numeric_limits<double>::infinity();
+
+        for (auto& signal : signals)
+        {
+            const bool isImpulse = signal.name == "impulse";
+            const bool isSine = signal.name == "sine";
+
+            if (!result.hasWaveform && !(result.hasResponse && isImpulse) && !(result.hasThd && isSine))
+                continue;
+
+            Signal reference = signal;
+            if (check.mono)
+                reference.right = reference.left;
+
+            Signal tested = reference;
+            check.reference(reference.left, reference.right);
+            check.tested(tested.left, tested.right);
+
+            if (result.hasWaveform)
+            {
+                result.snr = std::min(result.snr, getSnr(reference, tested));
+                result.maxError = std::max(result.maxError, getMaxError(reference, tested));
+            }
+
+            if (result.hasThd && isSine)
+                result.thdDelta = getThd(tested.left) - getThd(reference.left);
+
+            if (result.hasResponse && isImpulse)
+            {
+                const auto referenceResponses = getMagnitudeResponses(reference);
+                const auto testedResponses = getMagnitudeResponses(tested);
+
+                for (size_t point = 0; point < referenceResponses.size(); ++point)
+                    if (referenceResponses[point] > responseFloor)
+                        result.responseDeviation = std::max(result.responseDeviation, std::abs(testedResponses[point] - referenceResponses[point]));
+            }
+        }
+
+        result.passed = (!result.hasWaveform || (result.snr >= check.bounds.minSnr && result.maxError <= check.bounds.maxError))
+                     && (!result.hasThd || std::abs(result.thdDelta) <= check.bounds.maxThdDelta)
+                     && (!result.hasResponse || result.responseDeviation <= check.bounds.maxResponseDeviation);
+
+        return result;
+    }
+}
+
+//==============================================================================
+std::vector<AccuracyResult> runAccuracyChecks(const std::vector<std::string>& stages)
+{
+    const auto filterReference = legacyFilters();
+    const auto biquadReference = biquadFilters<double>(false);
+    const auto curveReference = originalCurve();
+    const auto engineReference = stereoEngine<double>();
+
+    // Bounds: min SNR dB, max error dBFS, max THD change dB, max response
+    // deviation dB. SNR and error bounds sit 10 dB (rounded out to 5 dB) past
+    // the measured figures, and exact matches get the float or double rounding
+    // level. THD and response bounds sit a decade above the measured change,
+    // or up to 0.15 dB above it where the change is by design (the ADAA high
+    // frequency droop)
+    const Check checks[] =
+    {
+        // Against the original chain
+        { "filter.biquad.double",     filterReference, biquadReference,             Check::linear, false, { 130.0, -125.0, 0.0, 1e-4 } },
+        { "filter.biquad.float",      filterReference, biquadFilters<float>(false), Check::linear, false, { 130.0, -125.0, 0.0, 1e-4 } },
+        { "filter.svf.float",         filterReference, svfFilters<float>(),         Check::linear, false, { 125.0, -125.0, 0.0, 1e-4 } },
+        { "filter.midOnly.float",     filterReference, midOnlyFilters(),            Check::linear, true,  { 130.0, -125.0, 0.0, 1e-4 } },
+        { "filter.multiStream.float", filterReference, multiStreamFilters(),        Check::linear, false, { 130.0, -125.0, 0.0, 1e-4 } },
+        { "filter.linearPhase.float", filterReference, linearPhaseFilters(),        Check::magnitudeOnly, false, { 0.0, 0.0, 0.0, 0.1 } },
+
+        // Against the biquads in double, below the original chain's float rounding
+        { "filter.tables",            biquadReference, biquadFilters<double>(true), Check::linear, false, { 240.0, -235.0, 0.0, 1e-9 } },
+        { "filter.svf.double",        biquadReference, svfFilters<double>(),        Check::linear, false, { 240.0, -235.0, 0.0, 1e-9 } },
+
+        // Against the original curve: sample for sample at the base rate, and
+        // by the harmonics of the sine with oversampling or ADAA
+        { "waveshaper.curve.double",  curveReference, saturator<double>(Waveshaper::oversampled, FastMath::full, 1, 0), Check::nonlinear, false, { 240.0, -235.0, 1e-9, 0.0 } },
+        { "waveshaper.curve.float",   curveReference, saturator<float>(Waveshaper::oversampled, FastMath::full, 1, 0), Check::nonlinear, false, { 120.0, -115.0, 1e-6, 0.0 } },
+        { "waveshaper.high.float",    curveReference, saturator<float>(Waveshaper::oversampled, FastMath::medium, 1, 0), Check::nonlinear, false, { 110.0, -105.0, 1e-5, 0.0 } },
+        { "waveshaper.draft.float",   curveReference, saturator<float>(Waveshaper::oversampled, FastMath::low, 1, 0), Check::nonlinear, false, { 75.0, -75.0, 1e-5, 0.0 } },
+        { "waveshaper.2x.float",      curveReference, saturator<float>(Waveshaper::oversampled, FastMath::full, 1, 1), Check::harmonicsOnly, false, { 0.0, 0.0, 1e-6, 0.0 } },
+        { "waveshaper.adaa1.float",   curveReference, saturator<float>(Waveshaper::firstOrderADAA, FastMath::full, 1, 1), Check::harmonicsOnly, false, { 0.0, 0.0, 0.25, 0.0 } },
+        { "waveshaper.adaa2.float",   curveReference, saturator<float>(Waveshaper::secondOrderADAA, FastMath::full, 1, 1), Check::harmonicsOnly, false, { 0.0, 0.0, 0.45, 0.0 } },
+
+        // Against their own double precision path, the original had none of these
+        { "waveshaper.2x.double",     saturator<double>(Waveshaper::oversampled, FastMath::full, 1, 1),
+                                      saturator<float>(Waveshaper::oversampled, FastMath::full, 1, 1), Check::nonlinear, false, { 120.0, -110.0, 1e-6, 0.0 } },
+        { "waveshaper.adaa1.double",  saturator<double>(Waveshaper::firstOrderADAA, FastMath::full, 1, 1),
+                                      saturator<float>(Waveshaper::firstOrderADAA, FastMath::full, 1, 1), Check::nonlinear, false, { 125.0, -115.0, 1e-6, 0.0 } },
+        { "waveshaper.adaa2.double",  saturator<double>(Waveshaper::secondOrderADAA, FastMath::full, 1, 1),
+                                      saturator<float>(Waveshaper::secondOrderADAA, FastMath::full, 1, 1), Check::nonlinear, false, { 130.0, -95.0, 1e-6, 0.0 } },
+        { "waveshaper.bands.float",   saturator<double>(Waveshaper::oversampled, FastMath::full, 4, 1),
+                                      saturator<float>(Waveshaper::oversampled, FastMath::full, 4, 1), Check::nonlinear, false, { 120.0, -105.0, 1e-6, 0.0 } },
+
+        { "limiter.float",            limiter<double>(), limiter<float>(), Check::nonlinear, false, { 140.0, -135.0, 1e-6, 0.0 } },
+
+        { "engine.float",             engineReference, stereoEngine<float>(), Check::nonlinear, false, { 110.0, -105.0, 1e-6, 0.0 } },
+        { "engine.mono.float",        engineReference, monoEngine(),          Check::nonlinear, true,  { 115.0, -105.0, 1e-6, 0.0 } },
+        { "engine.multiStream.float", engineReference, multiStreamEngine(),   Check::nonlinear, false, { 110.0, -105.0, 1e-6, 0.0 } },
+    };
+
+    const auto signals = makeSignals();
+    std::vector<AccuracyResult> results;
+
+    for (auto& check : checks)
+    {
+        const std::string name(check.name);
+
+        if (!stages.empty() && std::none_of(stages.begin(), stages.end(), [&](const std::string& stage) { return name.compare(0, stage.size(), stage) == 0; }))
+            continue;
+
+        results.push_back(runCheck(check, signals));
+    }
+
+    return results;
+}
+
+bool printAccuracyResults(const std::vector<AccuracyResult>& results)
+{
+    bool allPassed = true;
+
+    std::cout << std::endl << "accuracy                   SNR dB  max err dBFS  THD delta dB  response dB" << std::endl;
+
+    for (auto& result : results)
+    {
+        // Figures out of bounds are marked with a *
+        auto mark = [](bool outOfBounds) { return outOfBounds ? '*' : ' '; };
+        const auto& bounds = result.bounds;
+
+        std::printf("%-24s", result.check.c_str());
+
+        if (result.hasWaveform)
+            std::printf("  %7.1f%c  %11.1f%c", result.snr, mark(result.snr < bounds.minSnr),
+                        result.maxError, mark(result.maxError > bounds.maxError));
+        else
+            std::printf("  %7s   %11s ", "-", "-");
+
+        if (result.hasThd)
+            std::printf("  %11.2e%c", result.thdDelta, mark(std::abs(result.thdDelta) > bounds.maxThdDelta));
+        else
+            std::printf("  %11s ", "-");
+
+        if (result.hasResponse)
+            std::printf("  %10.2e%c", result.responseDeviation, mark(result.responseDeviation > bounds.maxResponseDeviation));
+        else
+            std::printf("  %10s ", "-");
+
+        std::printf("  %s\n", result.passed ? "ok" : "FAIL");
+        allPassed = allPassed && result.passed;
+    }
+
+    return allPassed;
+}
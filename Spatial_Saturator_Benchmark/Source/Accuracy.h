@@ -0,0 +1,61 @@
+/*
+  ==============================================================================
+
+    This file contains the accuracy checks of the benchmark, also built by
+    CMake (without JUCE) as the spatial_saturator_accuracy test.
+
+    Every optimised processing mode (the float paths, the SVF and linear phase
+    filters, the coefficient tables, the mid-only path, the packed
+    multi-stream chains, the saturator approximations) runs next to a
+    reference over the same signals: a logarithmic sweep, white noise, an
+    impulse and a full scale sine. The filters are checked against the
+    original five pass chain (LegacyMidSideChain) and the waveshaper against
+    the original curve of processBlock; stages the original plug-in did not
+    have (ADAA, bands, the limiter, the engine) against their own double
+    precision path. Each check reports the worst SNR and peak error against
+    the reference, the THD change on the sine for the nonlinear stages, and
+    the magnitude response deviation (from the impulse) for the linear ones.
+    A check fails when any figure is outside its bounds.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+//==============================================================================
+struct AccuracyResult
+{
+    std::string check;
+
+    // Worst over the signals; SNR in dB, peak error in dBFS
+    double snr = 0.0;
+    double maxError = 0.0;
+
+    // THD of the output minus THD of the reference on the sine, in dB
+    double thdDelta = 0.0;
+
+    // Largest magnitude response difference from 20 Hz to 20 kHz, in dB
+    double responseDeviation = 0.0;
+
+    // Which of the figures apply to the check
+    bool hasWaveform = true, hasThd = false, hasResponse = false;
+
+    // Lowest SNR and highest error, THD change and deviation that still pass
+    struct Bounds
+    {
+        double minSnr, maxError, maxThdDelta, maxResponseDeviation;
+    };
+
+    Bounds bounds{};
+    bool passed = true;
+};
+
+// Runs the checks whose names start with one of stages, all when empty
+std::vector<AccuracyResult> runAccuracyChecks(const std::vector<std::string>& stages);
+
+// One line per check with the figures out of bounds marked; returns false if
+// any check failed
+bool printAccuracyResults(const std::vector<AccuracyResult>& results);
@@ -0,0 +1,43 @@
+/*
+  ==============================================================================
+
+    This file contains the entry point of the accuracy test CMake builds
+    without JUCE. The Projucer benchmark runs the same checks with --accuracy.
+
+        spatial_saturator_accuracy [--stages a,b]
+
+    It exits with code 1 if any check is out of its bounds.
+
+  ==============================================================================
+*/
+
+#include "Accuracy.h"
+#include <iostream>
+#include <sstream>
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> stages;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg(argv[i]);
+
+        if (arg == "--stages" && i + 1 < argc)
+        {
+            std::istringstream list(argv[++i]);
+            for (std::string stage; std::getline(list, stage, ',');)
+                if (!stage.empty())
+                    stages.push_back(stage);
+        }
+        else
+        {
+            std::cerr << "Unknown option " << arg << std::endl;
+            std::cout << "Usage: spatial_saturator_accuracy [--stages a,b]" << std::endl;
+            return 1;
+        }
+    }
+
+    return printAccuracyResults(runAccuracyChecks(stages)) ? 0 : 1;
+}
@@ -0,0 +1,139 @@
+/*
+  ==============================================================================
+
+    This file contains a reference copy of the original five pass mid/side
+    chain (M/S encode, three filter passes and L/R decode through
+    getSample/setSample), split into its stages so each can be timed alone.
+
+    Buffer is juce::AudioBuffer<float> or any type with its getSample and
+    setSample, so the accuracy test can run it without JUCE
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cmath>
+
+//==============================================================================
+class LegacyMidSideChain
+{
+public:
+    void setSampleRate(double sample_rate) { m_sample_rate = (float)sample_rate; }
+
+    template <typename Buffer>
+    void process(Buffer& buffer, int numberSamples, float midFreq, float midGain,
+                 float sideFreqLower, float sideFreqUpper, float sideGain, float makeUpGain)
+    {
+        encode(buffer, numberSamples);
+        midShelf(buffer, numberSamples, midFreq, midGain);
+        sideHighPass(buffer, numberSamples, sideFreqLower);
+        sideShelf(buffer, numberSamples, sideFreqUpper, sideGain);
+        decode(buffer, numberSamples, makeUpGain);
+    }
+
+    // Process L+R into mids & sides
+    template <typename Buffer>
+    void encode(Buffer& buffer, int numberSamples)
+    {
+        for (int n = 0; n < numberSamples; ++n)
+        {
+            double mids = ((double)buffer.getSample(0, n) + (double)buffer.getSample(1, n)) / 2;
+            double sides = ((double)buffer.getSample(0, n) - (double)buffer.getSample(1, n)) / 2;
+            buffer.setSample(0, n, (float)mids);
+            buffer.setSample(1, n, (float)sides);
+        }
+    }
+
+    // Apply mid low shelf to mids
+    template <typename Buffer>
+    void midShelf(Buffer& buffer, int numberSamples, float midFreq, float midGain)
+    {
+        processShelf(buffer, 0, numberSamples, midFreq, midGain, m_m1, m_m2);
+    }
+
+    // Apply side high pass to sides
+    template <typename Buffer>
+    void sideHighPass(Buffer& buffer, int numberSamples, float sideFreqLower)
+    {
+        auto w0shp = 2 * pi * ((double)sideFreqLower / m_sample_rate);
+        auto alpha_shp = sin(w0shp) / (2 * Q);
+
+        auto b0shp = (1 + cos(w0shp)) / 2;
+        auto b1shp = -(1 + cos(w0shp));
+        auto b2shp = (1 + cos(w0shp)) / 2;
+        auto a0shp = 1 + alpha_shp;
+        auto a1shp = -2 * cos(w0shp);
+        auto a2shp = 1 - alpha_shp;
+
+        b0shp = b0shp / a0shp; b1shp = b1shp / a0shp; b2shp = b2shp / a0shp; a1shp = a1shp / a0shp; a2shp = a2shp / a0shp;
+
+        for (int n = 0; n < numberSamples; ++n)
+        {
+            double side_in = (double)buffer.getSample(1, n);
+            double side_out = (side_in * b0shp) + m_shp1;
+            m_shp1 = m_shp2 + (side_in * b1shp) - (side_out * a1shp);
+            m_shp2 = (side_in * b2shp) - (side_out * a2shp);
+            buffer.setSample(1, n, (float)side_out);
+        }
+    }
+
+    // Apply side low-shelf to sides
+    template <typename Buffer>
+    void sideShelf(Buffer& buffer, int numberSamples, float sideFreqUpper, float sideGain)
+    {
+        processShelf(buffer, 1, numberSamples, sideFreqUpper, sideGain, m_s1, m_s2);
+    }
+
+    // Process mids+sides back to L&R
+    template <typename Buffer>
+    void decode(Buffer& buffer, int numberSamples, float makeUpGain)
+    {
+        for (int n = 0; n < numberSamples; ++n)
+        {
+            double left = ((double)buffer.getSample(0, n) + (double)buffer.getSample(1, n)) * decibelsToGain(makeUpGain);
+            double right = ((double)buffer.getSample(0, n) - (double)buffer.getSample(1, n)) * decibelsToGain(makeUpGain);
+            buffer.setSample(0, n, (float)left);
+            buffer.setSample(1, n, (float)right);
+        }
+    }
+
+private:
+    // As juce::Decibels::decibelsToGain, silent at -100 dB and below
+    static float decibelsToGain(float decibels)
+    {
+        return decibels > -100.0f ? std::pow(10.0f, decibels * 0.05f) : 0.0f;
+    }
+
+    template <typename Buffer>
+    void processShelf(Buffer& buffer, int channel, int numberSamples, float cutOffFrequency, float gain, double& z1, double& z2)
+    {
+        auto w0 = 2 * pi * ((double)cutOffFrequency / m_sample_rate);
+        auto alpha = sin(w0) / (2 * Q);
+        double A = pow(10.0, (double)gain * 0.025);
+
+        auto b0 = A * ((A + 1) - (A - 1) * cos(w0) + 2 * sqrt(A) * alpha);
+        auto b1 = 2 * A * ((A - 1) - (A + 1) * cos(w0));
+        auto b2 = A * ((A + 1) - (A - 1) * cos(w0) - 2 * sqrt(A) * alpha);
+        auto a0 = (A + 1) + (A - 1) * cos(w0) + 2 * sqrt(A) * alpha;
+        auto a1 = -2 * ((A - 1) + (A + 1) * cos(w0));
+        auto a2 = (A + 1) + (A - 1) * cos(w0) - 2 * sqrt(A) * alpha;
+
+        b0 = b0 / a0; b1 = b1 / a0; b2 = b2 / a0; a1 = a1 / a0; a2 = a2 / a0;
+
+        for (int n = 0; n < numberSamples; ++n)
+        {
+            double in = (double)buffer.getSample(channel, n);
+            double out = (in * b0) + z1;
+            z1 = z2 + (in * b1) - (out * a1);
+            z2 = (in * b2) - (out * a2);
+            buffer.setSample(channel, n, (float)out);
+        }
+    }
+
+    static constexpr float pi = 3.14159265358979323846f;
+
+    float m_sample_rate{};
+    double Q = 1 / sqrt(2);
+    double m_m1{}, m_m2{}, m_s1{}, m_s2{}, m_shp1{}, m_shp2{};
+};
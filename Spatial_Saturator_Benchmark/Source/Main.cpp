@@ -0,0 +1,390 @@
+/*
+  ==============================================================================
+
+    This file contains the benchmark for the Spatial Saturator DSP.
+
+    It times the fused mid/side chain against the original multi-pass chain
+    (M/S encode, three filter passes and L/R decode through getSample/setSample)
+    and checks that both produce bit-identical output. It also times coefficient
+    updates under constant automation, computed directly and from the tables,
+    and the saturator's tanh/sin kernels at each precision against the exact
+    double precision curve. Finally it compares the cost and the aliasing of
+    the waveshaper under oversampling and antiderivative anti-aliasing.
+
+        Spatial_Saturator_Benchmark [options]
+
+            --suite             also time every stage and processBlock over
+                                block sizes, sample rates and automation
+            --quick             shorter suite runs (less stable numbers)
+            --stages a,b        only the suite stages starting with a or b
+            --json file         write the suite results as JSON
+            --compare file      compare the suite with an earlier JSON run
+                                and fail on any regression
+            --tolerance pct     allowed slowdown for --compare (default 10)
+            --accuracy          only check every fast and vectorised mode
+                                against the original chain and curve (or a
+                                double precision reference), and fail if any
+                                is out of its bounds (--stages picks the
+                                checks)
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Spatial_Saturator/Source/SpatialSaturatorFastMath.h"
+#include "../../Spatial_Saturator/Source/SpatialSaturatorFilter.h"
+#include "../../Spatial_Saturator/Source/SpatialSaturatorWaveshaper.h"
+#include "Accuracy.h"
+#include "LegacyMidSideChain.h"
+#include "Suite.h"
+#include "Timing.h"
+
+//==============================================================================
+// Level of everything but the harmonics of a sine, relative to the sine, in dB.
+// The sine sits exactly on bin fundamentalBin so no window is needed, and any
+// non-harmonic bin below Nyquist holds aliased (folded) harmonics.
+static double measureAliasing(Waveshaper& waveshaper, int fundamentalBin)
+{
+    const int fftSize = 4096;
+    const int warmUp = 8192;
+
+    std::vector<float> signal((size_t)(warmUp + fftSize));
+    for (int n = 0; n < warmUp + fftSize; ++n)
+        signal[(size_t)n] = (float)(0.8 * std::sin(juce::MathConstants<double>::twoPi * fundamentalBin * n / fftSize));
+
+    waveshaper.reset();
+    for (int start = 0; start < warmUp + fftSize; start += 512)
+    {
+        float* block = signal.data() + start;
+        waveshaper.process(&block, 1, 512);
+    }
+
+    std::vector<double> cosTable((size_t)fftSize), sinTable((size_t)fftSize);
+    for (int n = 0; n < fftSize; ++n)
+    {
+        cosTable[(size_t)n] = std::cos(juce::MathConstants<double>::twoPi * n / fftSize);
+        sinTable[(size_t)n] = std::sin(juce::MathConstants<double>::twoPi * n / fftSize);
+    }
+
+    double fundamental = 0.0, aliases = 0.0;
+    const float* analysed = signal.data() + warmUp;
+
+    for (int bin = 1; bin < fftSize / 2; ++bin)
+    {
+        double re = 0.0, im = 0.0;
+        for (int n = 0; n < fftSize; ++n)
+        {
+            const size_t phase = (size_t)(((long long)bin * n) % fftSize);
+            re += analysed[n] * cosTable[phase];
+            im -= analysed[n] * sinTable[phase];
+        }
+
+        const double power = re * re + im * im;
+
+        if (bin == fundamentalBin)
+            fundamental = power;
+        else if (bin % fundamentalBin != 0)
+            aliases += power;
+    }
+
+    return 10.0 * std::log10(aliases / fundamental);
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    // The processor's parameter tree needs a message manager, but no display
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add(juce::CharPointer_UTF8(argv[i]));
+
+    SuiteOptions suiteOptions;
+    bool runSuite = false, runAccuracy = false;
+    juce::File jsonFile, baselineFile;
+    double tolerance = 0.1;
+
+    for (int i = 0; i < args.size(); ++i)
+    {
+        const auto& arg = args[i];
+        const bool hasValue = i + 1 < args.size();
+
+        if (arg == "--suite")
+        {
+            runSuite = true;
+        }
+        else if (arg == "--quick")
+        {
+            suiteOptions.samplesPerCase = 1 << 14;
+            suiteOptions.repeats = 1;
+        }
+        else if (arg == "--stages" && hasValue)
+        {
+            suiteOptions.stages.addTokens(args[++i], ",", "");
+        }
+        else if (arg == "--json" && hasValue)
+        {
+            jsonFile = juce::File::getCurrentWorkingDirectory().getChildFile(args[++i]);
+            runSuite = true;
+        }
+        else if (arg == "--compare" && hasValue)
+        {
+            baselineFile = juce::File::getCurrentWorkingDirectory().getChildFile(args[++i]);
+            runSuite = true;
+        }
+        else if (arg == "--tolerance" && hasValue)
+        {
+            tolerance = args[++i].getDoubleValue() / 100.0;
+        }
+        else if (arg == "--accuracy")
+        {
+            runAccuracy = true;
+        }
+        else
+        {
+            std::cerr << "Unknown option " << arg << std::endl;
+            std::cout << "Usage: Spatial_Saturator_Benchmark [--suite] [--quick] [--stages a,b] [--json file]" << std::endl
+                      << "                                   [--compare file] [--tolerance pct] [--accuracy]" << std::endl;
+            return 1;
+        }
+    }
+
+    // No timing at all, so it is quick enough to run on every build
+    if (runAccuracy)
+    {
+        std::vector<std::string> stages;
+        for (auto& stage : suiteOptions.stages)
+            stages.push_back(stage.toStdString());
+
+        return printAccuracyResults(runAccuracyChecks(stages)) ? 0 : 1;
+    }
+
+    juce::var baseline;
+    if (baselineFile != juce::File())
+    {
+        baseline = juce::JSON::parse(baselineFile);
+
+        if (!baseline.isObject())
+        {
+            std::cerr << "Cannot read a benchmark baseline from " << baselineFile.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+
+    const double sampleRate = 48000.0;
+    const int blockSizes[] = { 32, 64, 128, 256, 512, 1024 };
+    const int totalSamples = 1 << 21;
+
+    // Default parameter values from createParameterLayout
+    const float midFreq = 250.0f, midGain = 2.5f, sideFreqLower = 140.0f, sideFreqUpper = 4000.0f, sideGain = 6.0f, makeUpGain = 0.0f;
+
+    // Noise source shared by both chains
+    juce::Random random;
+    juce::AudioBuffer<float> source(2, totalSamples);
+    for (int ch = 0; ch < 2; ++ch)
+        for (int n = 0; n < totalSamples; ++n)
+            source.setSample(ch, n, random.nextFloat() * 2.0f - 1.0f);
+
+    bool allBitExact = true;
+
+    std::cout << "block  legacy ns/smp  fused ns/smp  legacy cyc/smp  fused cyc/smp  speedup  bit-exact" << std::endl;
+
+    for (auto blockSize : blockSizes)
+    {
+        const int numBlocks = totalSamples / blockSize;
+
+        juce::AudioBuffer<float> legacyOut(source), fusedOut(source);
+        juce::AudioBuffer<float> legacyBlock(2, blockSize);
+
+        LegacyMidSideChain legacy;
+        legacy.setSampleRate(sampleRate);
+
+        MidSideFilterChain fused;
+        fused.setSampleRate((float)sampleRate);
+        fused.reset();
+
+        auto legacyTiming = timeBlocks([&](int i)
+        {
+            // The legacy chain only understands whole AudioBuffers
+            for (int ch = 0; ch < 2; ++ch)
+                std::memcpy(legacyBlock.getWritePointer(ch), legacyOut.getReadPointer(ch) + i * blockSize, sizeof(float) * (size_t)blockSize);
+
+            legacy.process(legacyBlock, blockSize, midFreq, midGain, sideFreqLower, sideFreqUpper, sideGain, makeUpGain);
+
+            for (int ch = 0; ch < 2; ++ch)
+                std::memcpy(legacyOut.getWritePointer(ch) + i * blockSize, legacyBlock.getReadPointer(ch), sizeof(float) * (size_t)blockSize);
+        }, numBlocks, blockSize);
+
+        auto fusedTiming = timeBlocks([&](int i)
+        {
+            fused.updateCoefficients(midFreq, midGain, sideFreqLower, sideFreqUpper, sideGain);
+            fused.process(fusedOut.getWritePointer(0) + i * blockSize, fusedOut.getWritePointer(1) + i * blockSize,
+                          blockSize, juce::Decibels::decibelsToGain(makeUpGain));
+        }, numBlocks, blockSize);
+
+        bool bitExact = true;
+        for (int ch = 0; ch < 2; ++ch)
+            bitExact = bitExact && std::memcmp(legacyOut.getReadPointer(ch), fusedOut.getReadPointer(ch), sizeof(float) * (size_t)totalSamples) == 0;
+
+        allBitExact = allBitExact && bitExact;
+
+        std::printf("%5d  %13.3f  %12.3f  %14.2f  %13.2f  %6.2fx  %s\n", blockSize,
+                    legacyTiming.nsPerSample, fusedTiming.nsPerSample,
+                    legacyTiming.cyclesPerSample, fusedTiming.cyclesPerSample,
+                    legacyTiming.nsPerSample / fusedTiming.nsPerSample, bitExact ? "yes" : "NO");
+    }
+
+    // Coefficient updates with every parameter moving on every block, computed
+    // directly versus looked up in the shared tables
+    {
+        const int blockSize = 32;
+        const int numBlocks = totalSamples / blockSize;
+
+        juce::AudioBuffer<float> directOut(source), tableOut(source);
+
+        MidSideFilterChain direct, tabled;
+        direct.setSampleRate((float)sampleRate);
+        tabled.setSampleRate((float)sampleRate);
+        tabled.setCoefficientTables(CoefficientTables::getShared((float)sampleRate, 20.0f, 20000.0f, 1.0f, 0.0f, 12.0f, 0.5f));
+
+        auto automatedBlock = [&](MidSideFilterChain& chain, juce::AudioBuffer<float>& out, int i)
+        {
+            // Sweep every filter parameter through its steps
+            chain.updateCoefficients((float)(20 + i % 981), (float)(i % 25) * 0.5f,
+                                     (float)(20 + i % 19981), (float)(1000 + i % 19001), (float)((i + 7) % 25) * 0.5f);
+            chain.process(out.getWritePointer(0) + i * blockSize, out.getWritePointer(1) + i * blockSize, blockSize, 1.0f);
+        };
+
+        auto directTiming = timeBlocks([&](int i) { automatedBlock(direct, directOut, i); }, numBlocks, blockSize);
+        auto tableTiming = timeBlocks([&](int i) { automatedBlock(tabled, tableOut, i); }, numBlocks, blockSize);
+
+        bool bitExact = true;
+        for (int ch = 0; ch < 2; ++ch)
+            bitExact = bitExact && std::memcmp(directOut.getReadPointer(ch), tableOut.getReadPointer(ch), sizeof(float) * (size_t)totalSamples) == 0;
+
+        allBitExact = allBitExact && bitExact;
+
+        std::cout << std::endl << "automated, block 32  direct ns/smp  tables ns/smp  direct cyc/smp  tables cyc/smp  speedup  bit-exact" << std::endl;
+        std::printf("                     %13.3f  %13.3f  %14.2f  %14.2f  %6.2fx  %s\n",
+                    directTiming.nsPerSample, tableTiming.nsPerSample,
+                    directTiming.cyclesPerSample, tableTiming.cyclesPerSample,
+                    directTiming.nsPerSample / tableTiming.nsPerSample, bitExact ? "yes" : "NO");
+    }
+
+    // Saturator kernels over the oversampled range of the curve (default slope
+    // and sin frequency), timed per sample of tanh + sin
+    bool allWithinBounds = true;
+    {
+        const int blockSize = 256;
+        const int numBlocks = totalSamples / blockSize;
+        const float tanhSlope = 7.0f, sinFreq = 60.0f;
+
+        const char* names[] = { "Draft", "High", "Full" };
+        const double bounds[] = { 1e-3, 1e-5, 0.0 };
+
+        std::vector<float> tanhExact((size_t)totalSamples), sinExact((size_t)totalSamples);
+        FastMath::tanh(tanhExact.data(), source.getReadPointer(0), tanhSlope, totalSamples, FastMath::full);
+        FastMath::sin(sinExact.data(), source.getReadPointer(0), sinFreq, totalSamples, FastMath::full);
+
+        std::cout << std::endl << "saturator  ns/smp  cyc/smp  speedup  tanh max err  sin max err" << std::endl;
+
+        Timing fullTiming;
+        for (int precision = FastMath::full; precision >= FastMath::low; --precision)
+        {
+            std::vector<float> tanhOut((size_t)totalSamples), sinOut((size_t)totalSamples);
+
+            auto timing = timeBlocks([&](int i)
+            {
+                FastMath::tanh(tanhOut.data() + i * blockSize, source.getReadPointer(0) + i * blockSize, tanhSlope, blockSize, (FastMath::Precision)precision);
+                FastMath::sin(sinOut.data() + i * blockSize, source.getReadPointer(0) + i * blockSize, sinFreq, blockSize, (FastMath::Precision)precision);
+            }, numBlocks, blockSize);
+
+            if (precision == FastMath::full)
+                fullTiming = timing;
+
+            double tanhError = 0.0, sinError = 0.0;
+            for (int n = 0; n < totalSamples; ++n)
+            {
+                tanhError = std::max(tanhError, (double)std::abs(tanhOut[(size_t)n] - tanhExact[(size_t)n]));
+                sinError = std::max(sinError, (double)std::abs(sinOut[(size_t)n] - sinExact[(size_t)n]));
+            }
+
+            const bool withinBounds = tanhError <= bounds[precision] && sinError <= bounds[precision];
+            allWithinBounds = allWithinBounds && withinBounds;
+
+            std::printf("%-9s  %6.3f  %7.2f  %6.2fx  %12.3g  %11.3g%s\n", names[precision],
+                        timing.nsPerSample, timing.cyclesPerSample, fullTiming.nsPerSample / timing.nsPerSample,
+                        tanhError, sinError, withinBounds ? "" : "  OUT OF BOUNDS");
+        }
+    }
+
+    // Waveshaper at the default curve with full wet mix: cost of each
+    // anti-aliasing option and the aliasing left for sines at ~1.1, 3.9 and 8.2 kHz
+    {
+        const int blockSize = 512;
+        const int numBlocks = totalSamples / blockSize;
+        const int fundamentalBins[] = { 97, 331, 701 };
+
+        struct Mode { const char* name; Waveshaper::AntiAliasing antiAliasing; int factorLog2; Oversampler::Phase phase; };
+        const Mode modes[] =
+        {
+            { "none (1x)",       Waveshaper::oversampled,     0, Oversampler::minimumPhase },
+            { "2x min phase",    Waveshaper::oversampled,     1, Oversampler::minimumPhase },
+            { "4x min phase",    Waveshaper::oversampled,     2, Oversampler::minimumPhase },
+            { "8x min phase",    Waveshaper::oversampled,     3, Oversampler::minimumPhase },
+            { "2x linear phase", Waveshaper::oversampled,     1, Oversampler::linearPhase },
+            { "ADAA 1st order",  Waveshaper::firstOrderADAA,  0, Oversampler::minimumPhase },
+            { "ADAA 2nd order",  Waveshaper::secondOrderADAA, 0, Oversampler::minimumPhase },
+        };
+
+        std::cout << std::endl << "waveshaper       ns/smp  cyc/smp  latency  alias @1.1k  alias @3.9k  alias @8.2k" << std::endl;
+
+        for (auto& mode : modes)
+        {
+            Waveshaper waveshaper;
+            waveshaper.prepare(sampleRate, 2, blockSize);
+            waveshaper.setParameters(50.0f, 7.0f, 50.0f, 60.0f, 100.0f);
+            waveshaper.setOversampling(mode.factorLog2, mode.phase);
+            waveshaper.setAntiAliasing(mode.antiAliasing);
+
+            juce::AudioBuffer<float> out(source);
+
+            auto timing = timeBlocks([&](int i)
+            {
+                float* channels[] = { out.getWritePointer(0) + i * blockSize, out.getWritePointer(1) + i * blockSize };
+                waveshaper.process(channels, 2, blockSize);
+            }, numBlocks, blockSize);
+
+            std::printf("%-15s  %6.2f  %7.2f  %7d", mode.name, timing.nsPerSample, timing.cyclesPerSample, waveshaper.getLatencyInSamples());
+
+            for (auto bin : fundamentalBins)
+                std::printf("  %8.1f dB", measureAliasing(waveshaper, bin));
+
+            std::printf("\n");
+        }
+    }
+
+    // Every stage on its own and the full processBlock
+    bool noRegressions = true;
+    if (runSuite)
+    {
+        std::cout << std::endl << "stage suite" << std::flush;
+        auto results = runStageSuite(suiteOptions);
+        printStageResults(results);
+
+        if (jsonFile != juce::File())
+        {
+            if (!jsonFile.replaceWithText(juce::JSON::toString(resultsToJson(results))))
+            {
+                std::cerr << "Cannot write " << jsonFile.getFullPathName() << std::endl;
+                return 1;
+            }
+        }
+
+        if (baseline.isObject())
+            noRegressions = compareWithBaseline(results, baseline, tolerance);
+    }
+
+    return allBitExact && allWithinBounds && noRegressions ? 0 : 1;
+}
@@ -0,0 +1,679 @@
+/*
+  ==============================================================================
+
+    This file contains the stage suite of the benchmark.
+
+  ==============================================================================
+*/
+
+#include "Suite.h"
+#include "LegacyMidSideChain.h"
+#include "../../Spatial_Saturator/Source/PluginProcessor.h"
+#include "../../Spatial_Saturator/Source/SpatialSaturatorMultiStream.h"
+#include <functional>
+#include <map>
+#include <type_traits>
+
+namespace
+{
+    //==============================================================================
+    // Everything a stage needs to know about the case it is timed for
+    struct Case
+    {
+        double sampleRate = 0.0;
+        int blockSize = 0;
+        int numBlocks = 0;
+        int repeats = 0;
+        bool automated = false;
+        const juce::AudioBuffer<float>* source = nullptr;
+        const juce::AudioBuffer<double>* doubleSource = nullptr;
+        std::shared_ptr<const CoefficientTables> tables;
+        SpatialSaturatorAudioProcessor* processor = nullptr;
+    };
+
+    // Triangle sweep between start and end with the given period in blocks, so
+    // automated parameters move on every block
+    float sweep(int block, int period, float start, float end)
+    {
+        const int phase = block % (2 * period);
+        const float position = (float)(phase < period ? phase : 2 * period - phase) / (float)period;
+        return start + (end - start) * position;
+    }
+
+    // Filter parameters for a block, on the parameter steps so the tables are hit
+    struct FilterParameters { float midFreq, midGain, sideFreqLower, sideFreqUpper, sideGain; };
+
+    FilterParameters getFilterParameters(const Case& c, int block)
+    {
+        if (!c.automated)
+            return { 250.0f, 2.5f, 140.0f, 4000.0f, 6.0f };
+
+        return { std::round(sweep(block, 97, 20.0f, 1000.0f)), std::round(sweep(block, 23, 0.0f, 24.0f)) * 0.5f,
+                 std::round(sweep(block, 131, 20.0f, 2000.0f)), std::round(sweep(block, 89, 1000.0f, 20000.0f)),
+                 std::round(sweep(block, 29, 0.0f, 24.0f)) * 0.5f };
+    }
+
+    template <typename SampleType> const juce::AudioBuffer<SampleType>& getSource(const Case& c);
+    template <> const juce::AudioBuffer<float>& getSource<float>(const Case& c)   { return *c.source; }
+    template <> const juce::AudioBuffer<double>& getSource<double>(const Case& c) { return *c.doubleSource; }
+
+    // Times process(block, channels) over the source, keeping the fastest of the
+    // repeats. reset() runs before each repeat so every run starts from silence
+    template <typename SampleType = float, typename Reset, typename Process>
+    Timing timeCase(const Case& c, Reset&& reset, Process&& process)
+    {
+        juce::AudioBuffer<SampleType> work(2, c.numBlocks * c.blockSize);
+        Timing best;
+        best.nsPerSample = std::numeric_limits<double>::max();
+
+        for (int repeat = 0; repeat < c.repeats; ++repeat)
+        {
+            work.makeCopyOf(getSource<SampleType>(c), true);
+            reset();
+
+            auto timing = timeBlocks([&](int i)
+            {
+                SampleType* channels[] = { work.getWritePointer(0) + i * c.blockSize, work.getWritePointer(1) + i * c.blockSize };
+                process(i, channels);
+            }, c.numBlocks, c.blockSize);
+
+            if (timing.nsPerSample < best.nsPerSample)
+                best = timing;
+        }
+
+        return best;
+    }
+
+    //==============================================================================
+    struct Stage
+    {
+        juce::String name;
+        std::function<Timing(const Case&)> run;
+        juce::String precision = "float";
+    };
+
+    template <typename SampleType> const char* getPrecisionName();
+    template <> const char* getPrecisionName<float>()  { return "float"; }
+    template <> const char* getPrecisionName<double>() { return "double"; }
+
+    // One pass of the original chain, timed through its getSample/setSample interface
+    Stage makeLegacyStage(const juce::String& name, std::function<void(LegacyMidSideChain&, juce::AudioBuffer<float>&, int, const FilterParameters&)> pass)
+    {
+        return { "legacy." + name, [pass](const Case& c)
+        {
+            LegacyMidSideChain legacy;
+
+            return timeCase(c, [&] { legacy = LegacyMidSideChain(); legacy.setSampleRate(c.sampleRate); },
+                            [&](int i, float** channels)
+            {
+                // Refers to the block in place, so no copy is timed
+                juce::AudioBuffer<float> block(channels, 2, c.blockSize);
+                pass(legacy, block, c.blockSize, getFilterParameters(c, i));
+            });
+        } };
+    }
+
+    template <typename SampleType = float>
+    Stage makeWaveshaperStage(const juce::String& name, Waveshaper::AntiAliasing antiAliasing, int factorLog2, FastMath::Precision precision, int numBands = 1)
+    {
+        return { "waveshaper." + name, [=](const Case& c)
+        {
+            const float crossoverFrequencies[] = { 150.0f, 1000.0f, 5000.0f };
+            const float drives[] = { 6.0f, 3.0f, 0.0f, 0.0f };
+            const float mixes[] = { 100.0f, 100.0f, 100.0f, 100.0f };
+
+            Waveshaper waveshaper;
+            waveshaper.prepare(c.sampleRate, 2, c.blockSize);
+            waveshaper.setOversampling(factorLog2, Oversampler::minimumPhase);
+            waveshaper.setAntiAliasing(antiAliasing);
+            waveshaper.setPrecision(precision);
+            waveshaper.setBands(numBands, crossoverFrequencies, drives, mixes);
+
+            return timeCase<SampleType>(c, [&] { waveshaper.reset(); }, [&](int i, SampleType** channels)
+            {
+                if (c.automated)
+                    waveshaper.setParameters(sweep(i, 37, 1.0f, 100.0f), sweep(i, 41, 1.0f, 15.0f), sweep(i, 43, 1.0f, 100.0f),
+                                             sweep(i, 47, 1.0f, 100.0f), 100.0f);
+                else
+                    waveshaper.setParameters(50.0f, 7.0f, 50.0f, 60.0f, 100.0f);
+
+                waveshaper.process(channels, 2, c.blockSize);
+            });
+        }, getPrecisionName<SampleType>() };
+    }
+
+    // The fused chain as the processor runs it, with coefficient tables
+    template <typename SampleType>
+    Stage makeFilterChainStage()
+    {
+        return { "filterChain", [](const Case& c)
+        {
+            MidSideFilterChain chain;
+            chain.setSampleRate((float)c.sampleRate);
+            chain.setCoefficientTables(c.tables);
+
+            return timeCase<SampleType>(c, [&] { chain.reset(); }, [&](int i, SampleType** channels)
+            {
+                auto p = getFilterParameters(c, i);
+                chain.updateCoefficients(p.midFreq, p.midGain, p.sideFreqLower, p.sideFreqUpper, p.sideGain);
+                chain.process(channels[0], channels[1], c.blockSize, (SampleType)1);
+            });
+        }, getPrecisionName<SampleType>() };
+    }
+
+    // The state variable filters with the same tables. Automated, every block
+    // glides to its new coefficients sample by sample
+    template <typename SampleType>
+    Stage makeSVFChainStage()
+    {
+        return { "svfChain", [](const Case& c)
+        {
+            MidSideSVFChain chain;
+            chain.setSampleRate((float)c.sampleRate);
+            chain.setCoefficientTables(c.tables);
+
+            return timeCase<SampleType>(c, [&] { chain.reset(); }, [&](int i, SampleType** channels)
+            {
+                auto p = getFilterParameters(c, i);
+                chain.updateCoefficients(p.midFreq, p.midGain, p.sideFreqLower, p.sideFreqUpper, p.sideGain);
+                chain.process(channels[0], channels[1], c.blockSize, (SampleType)1);
+            });
+        }, getPrecisionName<SampleType>() };
+    }
+
+    // Ceiling and release only, a new look-ahead would reset the limiter
+    template <typename SampleType>
+    Stage makeLimiterStage()
+    {
+        return { "limiter", [](const Case& c)
+        {
+            Limiter limiter;
+            limiter.prepare(c.sampleRate, 2, c.blockSize);
+            limiter.setParameters(-1.0f, 2.0f, 100.0f);
+
+            return timeCase<SampleType>(c, [&] { limiter.reset(); }, [&](int i, SampleType** channels)
+            {
+                if (c.automated)
+                    limiter.setParameters(-std::round(sweep(i, 59, 0.0f, 120.0f)) * 0.1f, 2.0f, std::round(sweep(i, 61, 1.0f, 1000.0f)));
+
+                limiter.process(channels, 2, c.blockSize);
+            });
+        }, getPrecisionName<SampleType>() };
+    }
+
+    // Everything, at the default settings, with the host moving the
+    // filter and saturator parameters on every block when automated
+    template <typename SampleType>
+    Stage makeProcessBlockStage()
+    {
+        return { "processBlock", [](const Case& c)
+        {
+            auto& processor = *c.processor;
+            processor.setPlayConfigDetails(2, 2, c.sampleRate, c.blockSize);
+            processor.setProcessingPrecision(std::is_same<SampleType, double>::value ? juce::AudioProcessor::doublePrecision
+                                                                                      : juce::AudioProcessor::singlePrecision);
+
+            const char* automatedIDs[] = { "midFreqID", "midGainID", "sideFreqLowerID", "sideFreqUpperID", "sideGainID",
+                                           "tanhAmplitudeID", "tanhSlopeID", "sinAmplitudeID", "sinFrequencyID" };
+            juce::Array<juce::RangedAudioParameter*> automatedParameters;
+
+            for (auto* parameter : processor.getParameters())
+                if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+                    for (auto id : automatedIDs)
+                        if (ranged->getParameterID() == id)
+                            automatedParameters.add(ranged);
+
+            auto setDefaults = [&]
+            {
+                for (auto* parameter : automatedParameters)
+                    parameter->setValueNotifyingHost(parameter->getDefaultValue());
+            };
+
+            juce::MidiBuffer midi;
+
+            auto timing = timeCase<SampleType>(c, [&] { setDefaults(); processor.prepareToPlay(c.sampleRate, c.blockSize); },
+                                               [&](int i, SampleType** channels)
+            {
+                if (c.automated)
+                    for (int p = 0; p < automatedParameters.size(); ++p)
+                        automatedParameters.getUnchecked(p)->setValueNotifyingHost(sweep(i, 31 + 6 * p, 0.0f, 1.0f));
+
+                juce::AudioBuffer<SampleType> block(channels, 2, c.blockSize);
+                processor.processBlock(block, midi);
+            });
+
+            setDefaults();
+            processor.releaseResources();
+            processor.setProcessingPrecision(juce::AudioProcessor::singlePrecision);
+            return timing;
+        }, getPrecisionName<SampleType>() };
+    }
+
+    std::vector<Stage> createStages()
+    {
+        std::vector<Stage> stages;
+
+        // The original chain pass by pass, then all of it
+        stages.push_back(makeLegacyStage("processMidsSides", [](LegacyMidSideChain& legacy, juce::AudioBuffer<float>& block, int numSamples, const FilterParameters&)
+        {
+            legacy.encode(block, numSamples);
+        }));
+
+        stages.push_back(makeLegacyStage("midLowShelf", [](LegacyMidSideChain& legacy, juce::AudioBuffer<float>& block, int numSamples, const FilterParameters& p)
+        {
+            legacy.midShelf(block, numSamples, p.midFreq, p.midGain);
+        }));
+
+        stages.push_back(makeLegacyStage("sideHighPass", [](LegacyMidSideChain& legacy, juce::AudioBuffer<float>& block, int numSamples, const FilterParameters& p)
+        {
+            legacy.sideHighPass(block, numSamples, p.sideFreqLower);
+        }));
+
+        stages.push_back(makeLegacyStage("sideLowShelf", [](LegacyMidSideChain& legacy, juce::AudioBuffer<float>& block, int numSamples, const FilterParameters& p)
+        {
+            legacy.sideShelf(block, numSamples, p.sideFreqUpper, p.sideGain);
+        }));
+
+        stages.push_back(makeLegacyStage("processLeftRight", [](LegacyMidSideChain& legacy, juce::AudioBuffer<float>& block, int numSamples, const FilterParameters&)
+        {
+            legacy.decode(block, numSamples, 0.0f);
+        }));
+
+        stages.push_back(makeLegacyStage("total", [](LegacyMidSideChain& legacy, juce::AudioBuffer<float>& block, int numSamples, const FilterParameters& p)
+        {
+            legacy.process(block, numSamples, p.midFreq, p.midGain, p.sideFreqLower, p.sideFreqUpper, p.sideGain, 0.0f);
+        }));
+
+        stages.push_back(makeFilterChainStage<float>());
+        stages.push_back(makeFilterChainStage<double>());
+        stages.push_back(makeSVFChainStage<float>());
+        stages.push_back(makeSVFChainStage<double>());
+
+        // The partitioned convolution. Kernels are designed on the filter's own
+        // thread, so automation here only times the crossfades between them
+        stages.push_back({ "linearPhase", [](const Case& c)
+        {
+            auto p = getFilterParameters(c, 0);
+
+            LinearPhaseMidSideFilter filter;
+            filter.prepare((float)c.sampleRate, p.midFreq, p.midGain, p.sideFreqLower, p.sideFreqUpper, p.sideGain);
+
+            return timeCase(c, [&] { filter.reset(); }, [&](int i, float** channels)
+            {
+                p = getFilterParameters(c, i);
+                filter.setParameters(p.midFreq, p.midGain, p.sideFreqLower, p.sideFreqUpper, p.sideGain);
+                filter.process(channels[0], channels[1], c.blockSize, 1.0f, 1.0f);
+            });
+        } });
+
+        // Sixteen streams packed into SIMD lanes, reported per sample of one
+        // stream. Each stream gets its own copy of the block, which is timed too
+        stages.push_back({ "multiStream.filterChain", [](const Case& c)
+        {
+            const int numStreams = 16;
+
+            MultiStreamFilterChain chain;
+            chain.prepare((float)c.sampleRate, numStreams);
+            chain.setCoefficientTables(c.tables);
+
+            juce::AudioBuffer<float> streams(2 * numStreams, c.blockSize);
+            std::vector<float*> left, right;
+            std::vector<float> makeUpGains((size_t)numStreams, 1.0f);
+
+            for (int stream = 0; stream < numStreams; ++stream)
+            {
+                left.push_back(streams.getWritePointer(2 * stream));
+                right.push_back(streams.getWritePointer(2 * stream + 1));
+            }
+
+            auto timing = timeCase(c, [&] { chain.reset(); }, [&](int i, float** channels)
+            {
+                auto p = getFilterParameters(c, i);
+
+                for (int stream = 0; stream < numStreams; ++stream)
+                {
+                    chain.updateCoefficients(stream, p.midFreq, p.midGain, p.sideFreqLower, p.sideFreqUpper, p.sideGain);
+                    std::copy(channels[0], channels[0] + c.blockSize, left[(size_t)stream]);
+                    std::copy(channels[1], channels[1] + c.blockSize, right[(size_t)stream]);
+                }
+
+                chain.process(left.data(), right.data(), c.blockSize, makeUpGains.data(), makeUpGains.data());
+            });
+
+            timing.nsPerSample /= numStreams;
+            timing.cyclesPerSample /= numStreams;
+            return timing;
+        } });
+
+        // The whole chain for the same sixteen streams: packed filters,
+        // waveshapers sharing lanes, one limiter per stream
+        stages.push_back({ "multiStream.engine", [](const Case& c)
+        {
+            const int numStreams = 16;
+
+            MultiStreamEngine engine;
+            engine.prepare(c.sampleRate, c.blockSize, numStreams);
+            engine.setCoefficientTables(c.tables);
+
+            juce::AudioBuffer<float> streams(2 * numStreams, c.blockSize);
+            std::vector<float*> left, right;
+
+            for (int stream = 0; stream < numStreams; ++stream)
+            {
+                left.push_back(streams.getWritePointer(2 * stream));
+                right.push_back(streams.getWritePointer(2 * stream + 1));
+            }
+
+            // The whole chain, so 2x oversampling and the limiter too
+            SpatialSaturatorEngine::Parameters parameters;
+            parameters.oversamplingFactorLog2 = 1;
+            parameters.limiterEnabled = true;
+
+            auto timing = timeCase(c, [&] { engine.reset(); }, [&](int i, float** channels)
+            {
+                auto p = getFilterParameters(c, i);
+                parameters.midFreq = p.midFreq;
+                parameters.midGain = p.midGain;
+                parameters.sideFreqLower = p.sideFreqLower;
+                parameters.sideFreqUpper = p.sideFreqUpper;
+                parameters.sideGain = p.sideGain;
+
+                for (int stream = 0; stream < numStreams; ++stream)
+                {
+                    engine.setParameters(stream, parameters);
+                    std::copy(channels[0], channels[0] + c.blockSize, left[(size_t)stream]);
+                    std::copy(channels[1], channels[1] + c.blockSize, right[(size_t)stream]);
+                }
+
+                engine.process(left.data(), right.data(), c.blockSize);
+            });
+
+            timing.nsPerSample /= numStreams;
+            timing.cyclesPerSample /= numStreams;
+            return timing;
+        } });
+
+        stages.push_back(makeWaveshaperStage("1x", Waveshaper::oversampled, 0, FastMath::full));
+        stages.push_back(makeWaveshaperStage("2x", Waveshaper::oversampled, 1, FastMath::full));
+        stages.push_back(makeWaveshaperStage("4x", Waveshaper::oversampled, 2, FastMath::full));
+        stages.push_back(makeWaveshaperStage("8x", Waveshaper::oversampled, 3, FastMath::full));
+        stages.push_back(makeWaveshaperStage("2x.draft", Waveshaper::oversampled, 1, FastMath::low));
+        stages.push_back(makeWaveshaperStage("adaa1", Waveshaper::firstOrderADAA, 0, FastMath::full));
+        stages.push_back(makeWaveshaperStage("adaa2", Waveshaper::secondOrderADAA, 0, FastMath::full));
+        stages.push_back(makeWaveshaperStage("2x.draft.2band", Waveshaper::oversampled, 1, FastMath::low, 2));
+        stages.push_back(makeWaveshaperStage("2x.draft.4band", Waveshaper::oversampled, 1, FastMath::low, 4));
+        stages.push_back(makeWaveshaperStage<double>("2x", Waveshaper::oversampled, 1, FastMath::full));
+        stages.push_back(makeWaveshaperStage<double>("2x.draft", Waveshaper::oversampled, 1, FastMath::low));
+        stages.push_back(makeWaveshaperStage<double>("adaa2", Waveshaper::secondOrderADAA, 0, FastMath::full));
+
+        stages.push_back(makeLimiterStage<float>());
+        stages.push_back(makeLimiterStage<double>());
+
+        // One meter; with metering on the engine runs two, on its input and output
+        stages.push_back({ "loudnessMeter", [](const Case& c)
+        {
+            LoudnessMeter meter;
+            meter.prepare(c.sampleRate);
+
+            return timeCase(c, [&] { meter.reset(); }, [&](int, float** channels)
+            {
+                meter.process(channels[0], channels[1], c.blockSize);
+            });
+        } });
+
+        // A silent track once the engine has gone to sleep. The clearing of the
+        // input is timed too, the sleeping engine costs less than that
+        stages.push_back({ "engine.silent", [](const Case& c)
+        {
+            SpatialSaturatorEngine engine;
+            std::vector<float> silence((size_t)c.blockSize, 0.0f);
+
+            auto fallAsleep = [&]
+            {
+                engine.prepare(c.sampleRate, c.blockSize);
+
+                for (int n = 0; !engine.isSleeping() && n < 2 * (engine.getTailLengthInSamples() + c.blockSize); n += c.blockSize)
+                    engine.process(silence.data(), silence.data(), c.blockSize);
+            };
+
+            return timeCase(c, fallAsleep, [&](int, float** channels)
+            {
+                std::fill(channels[0], channels[0] + c.blockSize, 0.0f);
+                std::fill(channels[1], channels[1] + c.blockSize, 0.0f);
+                engine.process(channels[0], channels[1], c.blockSize);
+            });
+        } });
+
+        // A mono track, one channel through processMono() as the plug-in runs a mono bus
+        stages.push_back({ "engine.mono", [](const Case& c)
+        {
+            SpatialSaturatorEngine engine;
+
+            return timeCase(c, [&] { engine.prepare(c.sampleRate, c.blockSize); }, [&](int, float** channels)
+            {
+                engine.processMono(channels[0], c.blockSize);
+            });
+        } });
+
+        stages.push_back(makeProcessBlockStage<float>());
+        stages.push_back(makeProcessBlockStage<double>());
+
+        return stages;
+    }
+
+    juce::String formatSampleRate(double sampleRate)
+    {
+        return juce::String(sampleRate / 1000.0, 1) + "k";
+    }
+}
+
+//==============================================================================
+juce::String StageResult::getKey() const
+{
+    return stage + "/" + juce::String(blockSize) + "/" + juce::String(juce::roundToInt(sampleRate))
+         + "/" + (automated ? "automated" : "static") + "/" + precision;
+}
+
+std::vector<StageResult> runStageSuite(const SuiteOptions& options)
+{
+    auto stages = createStages();
+
+    // White noise, long enough for the largest block size
+    const int maxBlockSize = options.blockSizes.isEmpty() ? 0 : *std::max_element(options.blockSizes.begin(), options.blockSizes.end());
+    const int numSamples = juce::jmax(options.samplesPerCase, maxBlockSize);
+
+    juce::Random random;
+    juce::AudioBuffer<float> source(2, numSamples);
+    for (int ch = 0; ch < 2; ++ch)
+        for (int n = 0; n < numSamples; ++n)
+            source.setSample(ch, n, random.nextFloat() * 2.0f - 1.0f);
+
+    // The same noise for the double precision stages
+    juce::AudioBuffer<double> doubleSource;
+    doubleSource.makeCopyOf(source);
+
+    std::vector<StageResult> results;
+    SpatialSaturatorAudioProcessor processor;
+
+    for (auto sampleRate : options.sampleRates)
+    {
+        Case c;
+        c.sampleRate = sampleRate;
+        c.repeats = options.repeats;
+        c.source = &source;
+        c.doubleSource = &doubleSource;
+        c.processor = &processor;
+
+        // Built once per sample rate, the processor picks up the same tables from the cache
+        c.tables = CoefficientTables::getShared((float)sampleRate, 20.0f, 20000.0f, 1.0f, 0.0f, 12.0f, 0.5f);
+
+        for (auto& stage : stages)
+        {
+            if (!options.stages.isEmpty() && !std::any_of(options.stages.begin(), options.stages.end(),
+                                                           [&](const juce::String& prefix) { return stage.name.startsWith(prefix); }))
+                continue;
+
+            for (auto blockSize : options.blockSizes)
+            {
+                for (auto automated : { false, true })
+                {
+                    c.blockSize = blockSize;
+                    c.numBlocks = numSamples / blockSize;
+                    c.automated = automated;
+
+                    StageResult result;
+                    result.stage = stage.name;
+                    result.blockSize = blockSize;
+                    result.sampleRate = sampleRate;
+                    result.automated = automated;
+                    result.precision = stage.precision;
+                    result.timing = stage.run(c);
+                    results.push_back(result);
+                }
+            }
+
+            std::cerr << "." << std::flush;
+        }
+    }
+
+    std::cerr << std::endl;
+    return results;
+}
+
+//==============================================================================
+void printStageResults(const std::vector<StageResult>& results)
+{
+    juce::Array<double> sampleRates;
+    juce::Array<int> blockSizes;
+    std::vector<std::pair<juce::String, juce::String>> rows;
+
+    for (auto& result : results)
+    {
+        sampleRates.addIfNotAlreadyThere(result.sampleRate);
+        blockSizes.addIfNotAlreadyThere(result.blockSize);
+
+        // One row per stage and precision
+        std::pair<juce::String, juce::String> row(result.stage, result.precision);
+        if (std::find(rows.begin(), rows.end(), row) == rows.end())
+            rows.push_back(row);
+    }
+
+    std::map<juce::String, double> nsPerSample;
+    for (auto& result : results)
+        nsPerSample[result.getKey()] = result.timing.nsPerSample;
+
+    for (auto sampleRate : sampleRates)
+    {
+        for (auto automated : { false, true })
+        {
+            std::cout << std::endl << "ns/smp at " << formatSampleRate(sampleRate) << ", " << (automated ? "automated" : "static") << std::endl;
+            std::printf("%-30s", "stage");
+
+            for (auto blockSize : blockSizes)
+                std::printf("  %7d", blockSize);
+
+            std::printf("\n");
+
+            for (auto& row : rows)
+            {
+                auto name = row.second == "float" ? row.first : row.first + " (" + row.second + ")";
+                std::printf("%-30s", name.toRawUTF8());
+
+                for (auto blockSize : blockSizes)
+                {
+                    StageResult key;
+                    key.stage = row.first;
+                    key.blockSize = blockSize;
+                    key.sampleRate = sampleRate;
+                    key.automated = automated;
+                    key.precision = row.second;
+
+                    auto found = nsPerSample.find(key.getKey());
+                    if (found != nsPerSample.end())
+                        std::printf("  %7.2f", found->second);
+                    else
+                        std::printf("  %7s", "-");
+                }
+
+                std::printf("\n");
+            }
+        }
+    }
+}
+
+juce::var resultsToJson(const std::vector<StageResult>& results)
+{
+    juce::Array<juce::var> entries;
+
+    for (auto& result : results)
+    {
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty("stage", result.stage);
+        entry->setProperty("blockSize", result.blockSize);
+        entry->setProperty("sampleRate", result.sampleRate);
+        entry->setProperty("automation", result.automated ? "automated" : "static");
+        entry->setProperty("precision", result.precision);
+        entry->setProperty("nsPerSample", result.timing.nsPerSample);
+        entry->setProperty("cyclesPerSample", result.timing.cyclesPerSample);
+        entries.add(juce::var(entry));
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("version", 1);
+    root->setProperty("date", juce::Time::getCurrentTime().toISO8601(true));
+    root->setProperty("cpu", juce::SystemStats::getCpuModel());
+   #if JUCE_DEBUG
+    root->setProperty("configuration", "Debug");
+   #else
+    root->setProperty("configuration", "Release");
+   #endif
+    root->setProperty("results", entries);
+    return juce::var(root);
+}
+
+bool compareWithBaseline(const std::vector<StageResult>& results, const juce::var& baseline, double tolerance)
+{
+    std::map<juce::String, double> baselineNsPerSample;
+
+    if (auto* entries = baseline["results"].getArray())
+    {
+        for (auto& entry : *entries)
+        {
+            StageResult key;
+            key.stage = entry["stage"].toString();
+            key.blockSize = (int)entry["blockSize"];
+            key.sampleRate = (double)entry["sampleRate"];
+            key.automated = entry["automation"].toString() == "automated";
+            key.precision = entry["precision"].toString();
+            baselineNsPerSample[key.getKey()] = (double)entry["nsPerSample"];
+        }
+    }
+
+    int numCompared = 0, numFaster = 0;
+    std::vector<std::pair<double, juce::String>> regressions;
+
+    for (auto& result : results)
+    {
+        auto found = baselineNsPerSample.find(result.getKey());
+        if (found == baselineNsPerSample.end() || found->second <= 0.0)
+            continue;
+
+        const double ratio = result.timing.nsPerSample / found->second;
+        ++numCompared;
+
+        if (ratio > 1.0 + tolerance)
+            regressions.push_back({ ratio, result.getKey() });
+        else if (ratio < 1.0 - tolerance)
+            ++numFaster;
+    }
+
+    std::sort(regressions.begin(), regressions.end(), [](auto& a, auto& b) { return a.first > b.first; });
+
+    std::cout << std::endl << "compared " << numCompared << " cases with the baseline: " << regressions.size()
+              << " slower, " << numFaster << " faster (tolerance " << juce::roundToInt(tolerance * 100.0) << "%)" << std::endl;
+
+    for (auto& regression : regressions)
+        std::printf("  %-50s  %+6.1f%%\n", regression.second.toRawUTF8(), (regression.first - 1.0) * 100.0);
+
+    return regressions.empty();
+}
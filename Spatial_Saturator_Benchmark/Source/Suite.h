@@ -0,0 +1,57 @@
+/*
+  ==============================================================================
+
+    This file contains the stage suite of the benchmark.
+
+    Every DSP stage (the legacy chain's M/S encode, filter passes and L/R
+    decode, the fused filter chain, the waveshaper in each anti-aliasing mode,
+    the limiter) and the full processBlock are timed over a sweep of block
+    sizes, sample rates and static versus automated parameters. The results can
+    be written as JSON and compared with an earlier run to catch regressions.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Timing.h"
+
+//==============================================================================
+struct StageResult
+{
+    juce::String stage;
+    int blockSize = 0;
+    double sampleRate = 0.0;
+    bool automated = false;
+    juce::String precision;
+    Timing timing;
+
+    // Identifies the case when comparing runs, e.g. "waveshaper.4x/256/48000/static/float"
+    juce::String getKey() const;
+};
+
+struct SuiteOptions
+{
+    juce::Array<int> blockSizes{ 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+    juce::Array<double> sampleRates{ 44100.0, 48000.0, 88200.0, 96000.0, 192000.0 };
+
+    // Samples processed per timed run, and the number of runs (the fastest is kept)
+    int samplesPerCase = 1 << 17;
+    int repeats = 3;
+
+    // Stage name prefixes to run, all stages when empty
+    juce::StringArray stages;
+};
+
+//==============================================================================
+std::vector<StageResult> runStageSuite(const SuiteOptions& options);
+
+// Stage x block size tables for each sample rate and automation setting
+void printStageResults(const std::vector<StageResult>& results);
+
+juce::var resultsToJson(const std::vector<StageResult>& results);
+
+// Prints every case that got slower than the baseline by more than tolerance
+// (a fraction, 0.1 = 10%) and returns false if there was any
+bool compareWithBaseline(const std::vector<StageResult>& results, const juce::var& baseline, double tolerance);
@@ -0,0 +1,39 @@
+/*
+  ==============================================================================
+
+    This file contains the timing helpers shared by the benchmarks
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <chrono>
+#include "../../Spatial_Saturator/Source/SpatialSaturatorProfiler.h"
+
+//==============================================================================
+struct Timing
+{
+    double nsPerSample = 0.0;
+    double cyclesPerSample = 0.0;
+};
+
+template <typename Function>
+inline Timing timeBlocks(Function&& processOneBlock, int numBlocks, int blockSize)
+{
+    auto startTime = std::chrono::steady_clock::now();
+    auto startCycles = readCycleCounter();
+
+    for (int i = 0; i < numBlocks; ++i)
+        processOneBlock(i);
+
+    auto endCycles = readCycleCounter();
+    auto endTime = std::chrono::steady_clock::now();
+
+    const double totalSamples = (double)numBlocks * blockSize;
+
+    Timing t;
+    t.nsPerSample = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count() / totalSamples;
+    t.cyclesPerSample = (double)(endCycles - startCycles) / totalSamples;
+    return t;
+}
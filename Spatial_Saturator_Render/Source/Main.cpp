@@ -0,0 +1,492 @@
+/*
+  ==============================================================================
+
+    This file contains the headless offline renderer for the Spatial Saturator.
+
+    It runs SpatialSaturatorAudioProcessor (without an editor) over a WAV, AIFF
+    or FLAC file as fast as the CPU allows and reports the realtime factor.
+    Built with SPATIAL_SATURATOR_PROFILING, it also reports the time each
+    stage took per block in the serial render.
+
+        Spatial_Saturator_Render input output [options]
+        Spatial_Saturator_Render --save-preset name [--bank file] [--state file] [--set id=value ...]
+
+            --state file        load a state saved by the plug-in (binary) or
+                                an XML state file
+            --save-state file   write the final state (binary, as the plug-in
+                                saves it)
+            --save-preset name  add the settings to a preset bank as name (or
+                                replace the preset of that name); without
+                                input and output, only that is done
+            --bank file         the bank for --save-preset (default: the one
+                                the plug-in opens)
+            --set id=value      set a parameter, e.g. --set midGainID=4.5 or
+                                --set oversamplingID=4x (repeatable)
+            --block samples     processBlock size (default 8192)
+            --bits n            output bit depth (default: the input's)
+            --keep-latency      do not trim the plug-in latency
+            --threads n         render chunks of the file on n threads (0 for
+                                one per core, default 1: one serial pass)
+            --chunk seconds     length of those chunks (default 30)
+            --preroll seconds   input run before each chunk to settle the
+                                filters and the limiter (default: the plug-in
+                                tail plus 20 limiter release times)
+            --verify            also render serially and report the largest
+                                difference of the chunked render from it
+            --list              list the parameters and exit
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Spatial_Saturator/Source/PluginProcessor.h"
+#include "RenderStreams.h"
+#include <chrono>
+
+//==============================================================================
+static void printUsage()
+{
+    std::cout << "Usage: Spatial_Saturator_Render input output [--state file] [--save-state file]" << std::endl
+              << "                                [--set id=value ...] [--block samples] [--bits n]" << std::endl
+              << "                                [--keep-latency] [--threads n] [--chunk seconds]" << std::endl
+              << "                                [--preroll seconds] [--verify] [--list]" << std::endl
+              << "                                [--save-preset name [--bank file]]" << std::endl;
+}
+
+static void listParameters(juce::AudioProcessor& processor)
+{
+    for (auto* parameter : processor.getParameters())
+    {
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+        {
+            auto range = ranged->getNormalisableRange();
+            std::cout << ranged->getParameterID() << "  \"" << ranged->getName(64) << "\"  "
+                      << range.start << " .. " << range.end << "  default "
+                      << ranged->getText(ranged->getDefaultValue(), 64) << std::endl;
+        }
+    }
+}
+
+// Numbers are taken in parameter units (choice index for choices), anything
+// else as the parameter's text, e.g. "4x" or "Linear Phase"
+static bool setParameter(juce::AudioProcessor& processor, const juce::String& assignment)
+{
+    auto id = assignment.upToFirstOccurrenceOf("=", false, false).trim();
+    auto value = assignment.fromFirstOccurrenceOf("=", false, false).trim();
+
+    for (auto* parameter : processor.getParameters())
+    {
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+        {
+            if (ranged->getParameterID() != id)
+                continue;
+
+            if (value.containsOnly("0123456789.-+eE") && value.isNotEmpty())
+                ranged->setValueNotifyingHost(ranged->convertTo0to1(value.getFloatValue()));
+            else
+                ranged->setValueNotifyingHost(ranged->getValueForText(value));
+
+            return true;
+        }
+    }
+
+    std::cerr << "Unknown parameter: " << id << " (see --list)" << std::endl;
+    return false;
+}
+
+static bool loadState(juce::AudioProcessor& processor, const juce::File& file)
+{
+    juce::MemoryBlock data;
+
+    if (!file.loadFileAsData(data))
+    {
+        std::cerr << "Cannot read state file: " << file.getFullPathName() << std::endl;
+        return false;
+    }
+
+    // Plain XML is wrapped the way getStateInformation() stores it
+    if (auto xml = juce::parseXML(data.toString()))
+    {
+        data.reset();
+        juce::AudioProcessor::copyXmlToBinary(*xml, data);
+    }
+
+    processor.setStateInformation(data.getData(), (int)data.getSize());
+    return true;
+}
+
+// Input memory mapped where the format supports it (WAV, AIFF)
+static std::unique_ptr<juce::AudioFormatReader> openReader(juce::AudioFormatManager& formatManager, const juce::File& file)
+{
+    if (auto* format = formatManager.findFormatForFileExtension(file.getFileExtension()))
+    {
+        std::unique_ptr<juce::MemoryMappedAudioFormatReader> mappedReader(format->createMemoryMappedReader(file));
+
+        if (mappedReader != nullptr && mappedReader->mapEntireFile())
+            return mappedReader;
+    }
+
+    return std::unique_ptr<juce::AudioFormatReader>(formatManager.createReaderFor(file));
+}
+
+static bool savePreset(SpatialSaturatorAudioProcessor& processor, const juce::File& bankFile, const juce::String& name)
+{
+    if (!PresetBank::addPreset(bankFile, processor.getParameterState(), name))
+    {
+        std::cerr << "Cannot add the preset to " << bankFile.getFullPathName() << " (not a bank of this version, or not writable)" << std::endl;
+        return false;
+    }
+
+    std::cout << "Saved preset \"" << name << "\" to " << bankFile.getFullPathName() << std::endl;
+    return true;
+}
+
+static void prepareProcessor(juce::AudioProcessor& processor, double sampleRate, int blockSize)
+{
+    processor.setNonRealtime(true);
+    processor.setPlayConfigDetails(2, 2, sampleRate, blockSize);
+    processor.prepareToPlay(sampleRate, blockSize);
+}
+
+// Long enough for the filter, oversampler and FIR states to decay below the
+// float floor, and for the limiter's gain to recover from any reduction
+static double getDefaultPreRollSeconds(juce::AudioProcessor& processor)
+{
+    double seconds = processor.getTailLengthSeconds();
+
+    for (auto* parameter : processor.getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+            if (ranged->getParameterID() == "limiterReleaseID")
+                seconds += 20.0 * 0.001 * ranged->convertFrom0to1(ranged->getValue());
+
+    return seconds;
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    // The parameter tree needs a message manager, but no display
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add(juce::CharPointer_UTF8(argv[i]));
+
+    std::unique_ptr<SpatialSaturatorAudioProcessor> processor(new SpatialSaturatorAudioProcessor());
+
+    if (args.contains("--list"))
+    {
+        listParameters(*processor);
+        return 0;
+    }
+
+    juce::StringArray positional;
+    juce::File saveStateFile;
+    juce::String presetName;
+    juce::File bankFile = PresetBank::getDefaultFile();
+    int blockSize = 8192;
+    int bitsPerSample = 0;
+    bool trimLatency = true;
+    int numThreads = 1;
+    double chunkSeconds = 30.0;
+    double preRollSeconds = -1.0;
+    bool verify = false;
+
+    for (int i = 0; i < args.size(); ++i)
+    {
+        const auto& arg = args[i];
+        const bool hasValue = i + 1 < args.size();
+
+        if (arg == "--state" && hasValue)
+        {
+            if (!loadState(*processor, juce::File::getCurrentWorkingDirectory().getChildFile(args[++i])))
+                return 1;
+        }
+        else if (arg == "--save-state" && hasValue)
+        {
+            saveStateFile = juce::File::getCurrentWorkingDirectory().getChildFile(args[++i]);
+        }
+        else if (arg == "--save-preset" && hasValue)
+        {
+            presetName = args[++i];
+        }
+        else if (arg == "--bank" && hasValue)
+        {
+            bankFile = juce::File::getCurrentWorkingDirectory().getChildFile(args[++i]);
+        }
+        else if (arg == "--set" && hasValue)
+        {
+            if (!setParameter(*processor, args[++i]))
+                return 1;
+        }
+        else if (arg == "--block" && hasValue)
+        {
+            blockSize = juce::jmax(1, args[++i].getIntValue());
+        }
+        else if (arg == "--bits" && hasValue)
+        {
+            bitsPerSample = args[++i].getIntValue();
+        }
+        else if (arg == "--keep-latency")
+        {
+            trimLatency = false;
+        }
+        else if (arg == "--threads" && hasValue)
+        {
+            numThreads = args[++i].getIntValue();
+
+            if (numThreads <= 0)
+                numThreads = juce::jmax(1, (int)std::thread::hardware_concurrency());
+        }
+        else if (arg == "--chunk" && hasValue)
+        {
+            chunkSeconds = juce::jmax(0.1, args[++i].getDoubleValue());
+        }
+        else if (arg == "--preroll" && hasValue)
+        {
+            preRollSeconds = juce::jmax(0.0, args[++i].getDoubleValue());
+        }
+        else if (arg == "--verify")
+        {
+            verify = true;
+        }
+        else if (arg.startsWith("--"))
+        {
+            printUsage();
+            return 1;
+        }
+        else
+        {
+            positional.add(arg);
+        }
+    }
+
+    // Settings from --state and --set straight into a bank, nothing rendered
+    if (positional.isEmpty() && presetName.isNotEmpty())
+        return savePreset(*processor, bankFile, presetName) ? 0 : 1;
+
+    if (positional.size() != 2)
+    {
+        printUsage();
+        return 1;
+    }
+
+    const auto inputFile = juce::File::getCurrentWorkingDirectory().getChildFile(positional[0]);
+    const auto outputFile = juce::File::getCurrentWorkingDirectory().getChildFile(positional[1]);
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    if (verify && numThreads < 2)
+    {
+        std::cerr << "--verify compares a chunked render with a serial one, it needs --threads 2 or more" << std::endl;
+        return 1;
+    }
+
+    //==============================================================================
+    auto reader = openReader(formatManager, inputFile);
+
+    if (reader == nullptr)
+    {
+        std::cerr << "Cannot open input: " << inputFile.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    if (reader->numChannels < 1 || reader->numChannels > 2)
+    {
+        std::cerr << "Only mono and stereo input is supported" << std::endl;
+        return 1;
+    }
+
+    //==============================================================================
+    // Output: format from the extension, behind a large write buffer
+    auto* outputFormat = formatManager.findFormatForFileExtension(outputFile.getFileExtension());
+
+    if (outputFormat == nullptr)
+    {
+        std::cerr << "Unknown output format: " << outputFile.getFileExtension() << std::endl;
+        return 1;
+    }
+
+    if (bitsPerSample == 0)
+        bitsPerSample = (int)reader->bitsPerSample;
+
+    if (!outputFormat->getPossibleBitDepths().contains(bitsPerSample))
+        bitsPerSample = outputFormat->getPossibleBitDepths().getLast();
+
+    outputFile.deleteFile();
+    auto outputStream = std::make_unique<juce::FileOutputStream>(outputFile, 1 << 20);
+
+    if (outputStream->failedToOpen())
+    {
+        std::cerr << "Cannot write output: " << outputFile.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    std::unique_ptr<juce::AudioFormatWriter> writer(outputFormat->createWriterFor(outputStream.get(), reader->sampleRate, 2,
+                                                                                   bitsPerSample, reader->metadataValues, 0));
+
+    if (writer == nullptr)
+    {
+        std::cerr << "Cannot create a " << outputFormat->getFormatName() << " writer for " << bitsPerSample << " bit" << std::endl;
+        return 1;
+    }
+
+    // The writer owns the stream now
+    outputStream.release();
+
+    //==============================================================================
+    prepareProcessor(*processor, reader->sampleRate, blockSize);
+
+    const juce::int64 totalSamples = reader->lengthInSamples;
+    const auto startTime = std::chrono::steady_clock::now();
+
+    std::unique_ptr<RenderStream> stream, serialStream;
+    juce::String mode = "serial";
+
+    if (numThreads > 1)
+    {
+        // Every worker gets its own processor with the same state and its own reader
+        juce::MemoryBlock state;
+        processor->getStateInformation(state);
+
+        std::vector<std::unique_ptr<juce::AudioProcessor>> processors;
+        std::vector<std::unique_ptr<juce::AudioFormatReader>> readers;
+
+        for (int i = 0; i < numThreads; ++i)
+        {
+            processors.emplace_back(new SpatialSaturatorAudioProcessor());
+            processors.back()->setStateInformation(state.getData(), (int)state.getSize());
+            prepareProcessor(*processors.back(), reader->sampleRate, blockSize);
+
+            readers.push_back(openReader(formatManager, inputFile));
+
+            if (readers.back() == nullptr)
+            {
+                std::cerr << "Cannot open input: " << inputFile.getFullPathName() << std::endl;
+                return 1;
+            }
+        }
+
+        if (preRollSeconds < 0.0)
+            preRollSeconds = getDefaultPreRollSeconds(*processor);
+
+        const auto chunkSamples = (juce::int64)std::ceil(chunkSeconds * reader->sampleRate);
+        const auto preRollSamples = (juce::int64)std::ceil(preRollSeconds * reader->sampleRate);
+
+        auto parallelStream = std::make_unique<ParallelRenderStream>(std::move(processors), std::move(readers), blockSize,
+                                                                     trimLatency, chunkSamples, preRollSamples);
+
+        mode = juce::String(parallelStream->getNumChunks()) + " chunks on " + juce::String(numThreads) + " threads, pre-roll "
+             + juce::String(preRollSeconds, 3) + " s";
+        stream = std::move(parallelStream);
+
+        if (verify)
+            serialStream = std::make_unique<SerialRenderStream>(*processor, *reader, blockSize, trimLatency);
+    }
+    else
+    {
+        stream = std::make_unique<SerialRenderStream>(*processor, *reader, blockSize, trimLatency);
+    }
+
+    // Stage timings of the serial render, collected after every block so the ring never fills
+    auto* profiler = processor->getStageProfiler();
+
+    juce::AudioBuffer<float> buffer(2, blockSize), reference(2, blockSize);
+    juce::int64 written = 0;
+    float maxDeviation = 0.0f;
+    juce::int64 maxDeviationPosition = 0;
+
+    for (;;)
+    {
+        int numSamples = blockSize;
+
+        // The serial render sets the pace, the chunked one can hand out any length
+        if (serialStream != nullptr)
+            numSamples = serialStream->renderNext(reference, blockSize);
+
+        numSamples = stream->renderNext(buffer, numSamples);
+
+        if (profiler != nullptr)
+            profiler->collect();
+
+        if (numSamples == 0)
+            break;
+
+        if (serialStream != nullptr)
+        {
+            for (int channel = 0; channel < 2; ++channel)
+            {
+                auto* rendered = buffer.getReadPointer(channel);
+                auto* expected = reference.getReadPointer(channel);
+
+                for (int n = 0; n < numSamples; ++n)
+                {
+                    const float deviation = std::abs(rendered[n] - expected[n]);
+
+                    if (deviation > maxDeviation)
+                    {
+                        maxDeviation = deviation;
+                        maxDeviationPosition = written + n;
+                    }
+                }
+            }
+        }
+
+        if (!writer->writeFromAudioSampleBuffer(buffer, 0, numSamples))
+        {
+            std::cerr << "Write failed" << std::endl;
+            return 1;
+        }
+
+        written += numSamples;
+    }
+
+    const double processingSeconds = stream->getProcessingSeconds();
+
+    // Stops the workers and frees their processors
+    stream.reset();
+    serialStream.reset();
+
+    processor->releaseResources();
+    writer.reset();
+
+    const double totalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    const double audioSeconds = (double)totalSamples / reader->sampleRate;
+
+    if (saveStateFile != juce::File())
+    {
+        juce::MemoryBlock state;
+        processor->getStateInformation(state);
+
+        if (!saveStateFile.replaceWithData(state.getData(), state.getSize()))
+            std::cerr << "Cannot write state file: " << saveStateFile.getFullPathName() << std::endl;
+    }
+
+    if (presetName.isNotEmpty())
+        savePreset(*processor, bankFile, presetName);
+
+    std::printf("%s: %.2f s of audio, %d Hz, block %d, latency %d, %s\n", outputFile.getFileName().toRawUTF8(),
+                audioSeconds, (int)reader->sampleRate, blockSize, processor->getLatencySamples(), mode.toRawUTF8());
+    std::printf("processing %.3f s (%.1fx realtime), total with I/O %.3f s (%.1fx realtime)\n",
+                processingSeconds, audioSeconds / processingSeconds, totalSeconds, audioSeconds / totalSeconds);
+
+    if (verify)
+        std::printf("largest difference from the serial render: %g (%.1f dBFS) at sample %lld\n", maxDeviation,
+                    juce::Decibels::gainToDecibels(maxDeviation, -300.0f), (long long)maxDeviationPosition);
+
+    if (profiler != nullptr && profiler->getStatistics(StageProfiler::wholeBlock).numBlocks > 0)
+    {
+        std::printf("\nstage          min us   mean us    p99 us    max us  (last %d blocks of the serial render)\n",
+                    profiler->getStatistics(StageProfiler::wholeBlock).numBlocks);
+
+        for (int stage = 0; stage < StageProfiler::numStages; ++stage)
+        {
+            const auto statistics = profiler->getStatistics(stage);
+            std::printf("%-12s  %8.1f  %8.1f  %8.1f  %8.1f\n", StageProfiler::getStageName(stage),
+                        statistics.min, statistics.mean, statistics.p99, statistics.max);
+        }
+    }
+
+    return 0;
+}
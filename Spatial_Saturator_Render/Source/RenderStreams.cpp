@@ -0,0 +1,218 @@
+/*
+  ==============================================================================
+
+    This file contains the render streams of the offline renderer.
+
+  ==============================================================================
+*/
+
+#include "RenderStreams.h"
+#include <chrono>
+#include <limits>
+#include <numeric>
+
+//==============================================================================
+void readStereo(juce::AudioFormatReader& reader, juce::AudioBuffer<float>& buffer, int numSamples, juce::int64 position)
+{
+    const int numToRead = (int)juce::jlimit((juce::int64)0, (juce::int64)numSamples, reader.lengthInSamples - position);
+
+    buffer.clear();
+
+    if (numToRead > 0)
+    {
+        reader.read(&buffer, 0, numToRead, position, true, true);
+
+        // Mono input feeds both sides
+        if (reader.numChannels == 1)
+            buffer.copyFrom(1, 0, buffer, 0, 0, numToRead);
+    }
+}
+
+//==============================================================================
+SerialRenderStream::SerialRenderStream(juce::AudioProcessor& processor, juce::AudioFormatReader& reader, int blockSize, bool trimLatency)
+    : m_processor(processor),
+      m_reader(reader),
+      m_buffer(2, blockSize),
+      m_totalSamples(reader.lengthInSamples),
+      m_toSkip(trimLatency ? processor.getLatencySamples() : 0)
+{
+}
+
+int SerialRenderStream::renderNext(juce::AudioBuffer<float>& output, int maxSamples)
+{
+    // The latency is trimmed from the start and flushed out with silence at
+    // the end, so the output lines up with the input and has the same length
+    while (m_pendingStart == m_pendingEnd)
+    {
+        if (m_written >= m_totalSamples)
+            return 0;
+
+        const int numSamples = m_buffer.getNumSamples();
+
+        readStereo(m_reader, m_buffer, numSamples, m_position);
+        m_position += numSamples;
+
+        const auto blockStart = std::chrono::steady_clock::now();
+        m_processor.processBlock(m_buffer, m_midi);
+        m_processingSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - blockStart).count();
+
+        const int skip = (int)juce::jmin((juce::int64)numSamples, m_toSkip);
+        m_toSkip -= skip;
+
+        m_pendingStart = skip;
+        m_pendingEnd = skip + (int)juce::jmin((juce::int64)(numSamples - skip), m_totalSamples - m_written);
+        m_written += m_pendingEnd - m_pendingStart;
+    }
+
+    const int numSamples = juce::jmin(maxSamples, m_pendingEnd - m_pendingStart);
+
+    for (int channel = 0; channel < 2; ++channel)
+        output.copyFrom(channel, 0, m_buffer, channel, m_pendingStart, numSamples);
+
+    m_pendingStart += numSamples;
+    return numSamples;
+}
+
+//==============================================================================
+ParallelRenderStream::ParallelRenderStream(std::vector<std::unique_ptr<juce::AudioProcessor>> processors,
+                                           std::vector<std::unique_ptr<juce::AudioFormatReader>> readers,
+                                           int blockSize, bool trimLatency, juce::int64 chunkSamples, juce::int64 preRollSamples)
+    : m_processors(std::move(processors)),
+      m_readers(std::move(readers)),
+      m_blockSize(blockSize),
+      m_preRollAlignment(std::lcm((juce::int64)preRollAlignment, (juce::int64)blockSize)),
+      m_totalSamples(m_readers.front()->lengthInSamples),
+      m_chunkSamples(juce::jlimit((juce::int64)1, (juce::int64)std::numeric_limits<int>::max(), chunkSamples)),
+      m_preRollSamples(juce::jmax((juce::int64)0, preRollSamples)),
+      m_latency(trimLatency ? m_processors.front()->getLatencySamples() : 0),
+      m_numChunks((int)((m_totalSamples + m_chunkSamples - 1) / m_chunkSamples)),
+      m_chunks((size_t)m_numChunks),
+      m_maxChunksAhead(2 * (int)m_processors.size())
+{
+    jassert(m_processors.size() == m_readers.size());
+
+    for (int worker = 0; worker < (int)m_processors.size(); ++worker)
+        m_workers.emplace_back([this, worker] { workerLoop(worker); });
+}
+
+ParallelRenderStream::~ParallelRenderStream()
+{
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_stopping = true;
+    }
+
+    m_chunkTaken.notify_all();
+
+    for (auto& worker : m_workers)
+        worker.join();
+}
+
+void ParallelRenderStream::workerLoop(int worker)
+{
+    for (;;)
+    {
+        int chunk;
+
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_chunkTaken.wait(lock, [this] { return m_stopping || m_nextChunk >= m_numChunks || m_nextChunk < m_readChunk + m_maxChunksAhead; });
+
+            if (m_stopping || m_nextChunk >= m_numChunks)
+                return;
+
+            chunk = m_nextChunk++;
+        }
+
+        const juce::int64 start = chunk * m_chunkSamples;
+        juce::AudioBuffer<float> output(2, (int)juce::jmin(m_chunkSamples, m_totalSamples - start));
+
+        const double seconds = renderChunk(worker, chunk, output);
+
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            m_chunks[(size_t)chunk].output = std::move(output);
+            m_chunks[(size_t)chunk].ready = true;
+            m_processingSeconds += seconds;
+        }
+
+        m_chunkDone.notify_all();
+    }
+}
+
+double ParallelRenderStream::renderChunk(int worker, int chunk, juce::AudioBuffer<float>& output)
+{
+    auto& processor = *m_processors[(size_t)worker];
+    auto& reader = *m_readers[(size_t)worker];
+
+    // From silence, like the serial render at the start of the file. Only
+    // reset, as preparing again would redo every allocation for each chunk
+    processor.reset();
+
+    // Output sample n is processed sample n + latency, which came from input
+    // sample n. The pre-roll runs before the chunk's first input sample
+    const juce::int64 start = chunk * m_chunkSamples;
+    const juce::int64 wantedStart = start + m_latency;
+    const juce::int64 wantedEnd = wantedStart + output.getNumSamples();
+    const juce::int64 preRollStart = juce::jmax((juce::int64)0, start - m_preRollSamples) / m_preRollAlignment * m_preRollAlignment;
+
+    juce::AudioBuffer<float> buffer(2, m_blockSize);
+    juce::MidiBuffer midi;
+    double processingSeconds = 0.0;
+
+    for (juce::int64 position = preRollStart; position < wantedEnd; position += m_blockSize)
+    {
+        readStereo(reader, buffer, m_blockSize, position);
+
+        const auto blockStart = std::chrono::steady_clock::now();
+        processor.processBlock(buffer, midi);
+        processingSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - blockStart).count();
+
+        const juce::int64 from = juce::jmax(position, wantedStart);
+        const juce::int64 to = juce::jmin(position + m_blockSize, wantedEnd);
+
+        if (to > from)
+            for (int channel = 0; channel < 2; ++channel)
+                output.copyFrom(channel, (int)(from - wantedStart), buffer, channel, (int)(from - position), (int)(to - from));
+    }
+
+    return processingSeconds;
+}
+
+int ParallelRenderStream::renderNext(juce::AudioBuffer<float>& output, int maxSamples)
+{
+    int numRendered = 0;
+
+    while (numRendered < maxSamples && m_readChunk < m_numChunks)
+    {
+        auto& chunk = m_chunks[(size_t)m_readChunk];
+
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_chunkDone.wait(lock, [&chunk] { return chunk.ready; });
+        }
+
+        // A ready chunk is not touched by the workers again
+        const int numSamples = juce::jmin(maxSamples - numRendered, chunk.output.getNumSamples() - m_readOffset);
+
+        for (int channel = 0; channel < 2; ++channel)
+            output.copyFrom(channel, numRendered, chunk.output, channel, m_readOffset, numSamples);
+
+        numRendered += numSamples;
+        m_readOffset += numSamples;
+
+        if (m_readOffset == chunk.output.getNumSamples())
+        {
+            {
+                std::lock_guard<std::mutex> guard(m_lock);
+                chunk.output.setSize(0, 0);
+                ++m_readChunk;
+            }
+
+            m_readOffset = 0;
+            m_chunkTaken.notify_all();
+        }
+    }
+
+    return numRendered;
+}
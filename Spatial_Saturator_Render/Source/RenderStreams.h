@@ -0,0 +1,131 @@
+/*
+  ==============================================================================
+
+    This file contains the render streams of the offline renderer.
+
+    Both produce the plug-in's output for a whole input file, in order and
+    block by block, with the latency trimmed (or kept) the same way:
+
+        SerialRenderStream    one processor over the file from start to end
+        ParallelRenderStream  the file cut into chunks that worker threads
+                              render at the same time, each with its own
+                              processor, stitched back together in order
+
+    Recursive stages (biquads, the oversampling IIR half-bands, the limiter's
+    release) depend on everything before them, so a chunk cannot simply start
+    cold. Each chunk first runs the preRollSamples of input before it and
+    throws that output away; once the pre-roll is longer than the time the
+    states take to decay, the chunk comes out as the serial render would.
+    The pre-roll starts on a multiple of both preRollAlignment and the block
+    size, so the linear phase partitions, the oversampler phases and the
+    blocks (where sleep and mono detection decide) line up with the serial
+    render too, and then the chunks are bit-identical to it.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+//==============================================================================
+class RenderStream
+{
+public:
+    virtual ~RenderStream() = default;
+
+    // Fills the start of output (two channels) with up to maxSamples of the
+    // result and returns how many, 0 once the whole file is done
+    virtual int renderNext(juce::AudioBuffer<float>& output, int maxSamples) = 0;
+
+    // Seconds spent inside processBlock, summed over every thread
+    double getProcessingSeconds() const { return m_processingSeconds; }
+
+protected:
+    double m_processingSeconds = 0.0;
+};
+
+// Reads numSamples from position into both channels of buffer, zeros past
+// the end of the file and mono copied to both sides
+void readStereo(juce::AudioFormatReader& reader, juce::AudioBuffer<float>& buffer, int numSamples, juce::int64 position);
+
+//==============================================================================
+class SerialRenderStream : public RenderStream
+{
+public:
+    // The processor must be prepared for blockSize
+    SerialRenderStream(juce::AudioProcessor& processor, juce::AudioFormatReader& reader, int blockSize, bool trimLatency);
+
+    // At most what is left of the current block
+    int renderNext(juce::AudioBuffer<float>& output, int maxSamples) override;
+
+private:
+    juce::AudioProcessor& m_processor;
+    juce::AudioFormatReader& m_reader;
+    juce::AudioBuffer<float> m_buffer;
+    juce::MidiBuffer m_midi;
+
+    const juce::int64 m_totalSamples;
+    juce::int64 m_toSkip;
+    juce::int64 m_written = 0;
+    juce::int64 m_position = 0;
+
+    // Output of the current block not handed out yet
+    int m_pendingStart = 0, m_pendingEnd = 0;
+};
+
+//==============================================================================
+class ParallelRenderStream : public RenderStream
+{
+public:
+    enum { preRollAlignment = 4096 };
+
+    // One worker per processor and reader, which must all be set up alike and
+    // prepared for blockSize; each worker renders chunkSamples at a time,
+    // resetting its processor before each chunk
+    ParallelRenderStream(std::vector<std::unique_ptr<juce::AudioProcessor>> processors,
+                         std::vector<std::unique_ptr<juce::AudioFormatReader>> readers,
+                         int blockSize, bool trimLatency, juce::int64 chunkSamples, juce::int64 preRollSamples);
+    ~ParallelRenderStream() override;
+
+    // Always maxSamples until the end of the file, across chunk boundaries
+    int renderNext(juce::AudioBuffer<float>& output, int maxSamples) override;
+
+    int getNumChunks() const { return m_numChunks; }
+
+private:
+    struct Chunk
+    {
+        juce::AudioBuffer<float> output;
+        bool ready = false;
+    };
+
+    void workerLoop(int worker);
+    // Returns the seconds spent in processBlock, pre-roll included
+    double renderChunk(int worker, int chunk, juce::AudioBuffer<float>& output);
+
+    std::vector<std::unique_ptr<juce::AudioProcessor>> m_processors;
+    std::vector<std::unique_ptr<juce::AudioFormatReader>> m_readers;
+
+    const int m_blockSize;
+    const juce::int64 m_preRollAlignment;   // lcm of preRollAlignment and the block size
+    const juce::int64 m_totalSamples, m_chunkSamples, m_preRollSamples;
+    const int m_latency;
+    const int m_numChunks;
+
+    // Chunks are handed out in order; a worker waits rather than run more than
+    // maxChunksAhead past the one being read, so memory stays bounded
+    std::mutex m_lock;
+    std::condition_variable m_chunkDone, m_chunkTaken;
+    std::vector<Chunk> m_chunks;
+    int m_nextChunk = 0;
+    int m_readChunk = 0;
+    int m_readOffset = 0;
+    bool m_stopping = false;
+    int m_maxChunksAhead;
+
+    std::vector<std::thread> m_workers;
+};